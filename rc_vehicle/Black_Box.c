@@ -0,0 +1,845 @@
+/**
+ * @file Black_Box.c
+ *
+ * @brief Source code for the black box recorder.
+ *
+ * The flash memory is erased and programmed with the Flash Memory Address (FMA), Data (FMD)
+ * and Control (FMC) registers, following the Flash Memory Programming steps in the Internal
+ * Memory section of the TM4C123G Microcontroller Datasheet: one word at a time, and one 1 KB
+ * sector at a time. The log is read back directly from the flash address space.
+ *
+ * All the recorder state is used from thread context only (the black box task and the
+ * command task), so it is not shared with any interrupt service routine.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Black_Box.h"
+#include "Scheduler.h"
+#include "Vehicle_Control.h"
+#include "Motion_Profile.h"
+#include "Deadman.h"
+#include "Watchdog.h"
+#include "Protocol.h"
+#include "UART0.h"
+#include "Latency.h"
+#include "Timebase.h"
+
+// The log fills the flash memory from BLACK_BOX_FLASH_BASE to its end (256 KB), in whole sectors.
+// The image is limited to the flash below it by keilproject/UART.sct
+#if ((BLACK_BOX_FLASH_BASE + BLACK_BOX_FLASH_SIZE) != 0x00040000) || ((BLACK_BOX_FLASH_BASE % BLACK_BOX_SECTOR_SIZE) != 0)
+#error "The black box log must end at the top of the flash memory, on a sector boundary"
+#endif
+
+// WRITE (Bit 0) and ERASE (Bit 1) bits in the FMC register
+#define BLACK_BOX_FMC_WRITE_BIT_MASK 0x01
+#define BLACK_BOX_FMC_ERASE_BIT_MASK 0x02
+
+// Write keys in the WRKEY field (Bits 31 to 16) of the FMC register. The key depends on
+// the KEY bit (Bit 4) in the BOOTCFG register
+#define BLACK_BOX_FMC_WRKEY_KEY_SET   0xA4420000
+#define BLACK_BOX_FMC_WRKEY_KEY_CLEAR 0x71D50000
+#define BLACK_BOX_BOOTCFG_KEY_BIT_MASK 0x10
+
+#define BLACK_BOX_SLOTS_PER_SECTOR (BLACK_BOX_SECTOR_SIZE / BLACK_BOX_BLOCK_SIZE)
+
+// Longest record: tag, time and every sample field, each as a 5-byte varint
+#define BLACK_BOX_MAX_RECORD_SIZE (1 + 5 + (BLACK_BOX_FIELD_COUNT * 5))
+
+// Free space in the UART0 transmit buffer needed to write one dump line or frame
+#define BLACK_BOX_DUMP_LINE_MAX 64
+
+// Largest number of dump lines or frames written by one run of the black box task, which
+// bounds its execution time however fast the transmit buffer drains
+#define BLACK_BOX_DUMP_LINES_PER_RUN 8
+
+// Log bytes carried by one PROTOCOL_BLACK_BOX_DATA frame, after the stream offset
+#define BLACK_BOX_DUMP_CHUNK (PROTOCOL_MAX_PAYLOAD - 2)
+
+#define BLACK_BOX_SAMPLE_PERIOD_CYCLES TIMEBASE_MS_TO_CYCLES(BLACK_BOX_SAMPLE_PERIOD_MS)
+
+// Small differences of either sign map to small unsigned numbers: 0, -1, 1, -2, 2 become 0, 1, 2, 3, 4
+#define BLACK_BOX_ZIGZAG(value) (((uint32_t)(value) << 1) ^ (uint32_t)((value) >> 31))
+
+// A block of the RAM ring
+typedef struct
+{
+	uint8_t data[BLACK_BOX_BLOCK_DATA_SIZE];
+	uint16_t length;
+	uint32_t base_ticks;
+} Black_Box_Block;
+
+// Header at the start of a flash slot
+typedef struct
+{
+	uint16_t magic;
+	uint16_t flush_number;
+	uint16_t length;
+	uint16_t block_number;
+	uint32_t base_ticks;
+} Black_Box_Slot_Header;
+
+// RAM ring: block_sequence counts the blocks since Black_Box_Init, the current block is
+// block_sequence % BLACK_BOX_RAM_BLOCKS. The values and the time of the latest record are
+// the references of the next differences
+static Black_Box_Block ram_blocks[BLACK_BOX_RAM_BLOCKS];
+static uint32_t block_sequence;
+static int32_t last_values[BLACK_BOX_FIELD_COUNT];
+static uint32_t last_ticks;
+
+// Flush: the blocks from flush_next_block to flush_end_block (excluded) are copied into the
+// flash log at write_slot
+static uint8_t flush_requested;
+static uint64_t flush_start_cycles;
+static uint8_t flush_active;
+static uint32_t flush_next_block;
+static uint32_t flush_end_block;
+static uint16_t flush_number;
+static uint16_t write_slot;
+static uint8_t write_sector_erased;
+static uint32_t flash_write_key;
+
+// Dump: dump_slot is the next slot to stream, from the oldest one
+static uint8_t dump_active;
+static uint8_t dump_framed;
+static uint8_t dump_started;
+static uint8_t dump_slot_started;
+static uint16_t dump_slot;
+static uint16_t dump_slots_left;
+static uint16_t dump_offset;
+static uint16_t dump_block_count;
+static uint16_t dump_stream_offset;
+static uint8_t dump_sequence;
+static int32_t dump_values[BLACK_BOX_FIELD_COUNT];
+static uint32_t dump_ticks;
+
+// Counters of the events already recorded
+static uint32_t seen_obstacle_stops;
+static uint32_t seen_deadman_trips;
+static uint64_t next_sample_cycles;
+
+static Black_Box_Statistics black_box_statistics;
+
+static uint32_t Black_Box_Now_Ticks(void)
+{
+	return (uint32_t)(Timebase_Now_Cycles() >> BLACK_BOX_TICK_SHIFT);
+}
+
+static uint32_t Black_Box_Ticks_To_MS(uint32_t ticks)
+{
+	return (uint32_t)(((uint64_t)ticks << BLACK_BOX_TICK_SHIFT) / (TIMEBASE_CYCLES_PER_US * 1000U));
+}
+
+static uint32_t Black_Box_Slot_Address(uint16_t slot)
+{
+	return BLACK_BOX_FLASH_BASE + ((uint32_t)slot * BLACK_BOX_BLOCK_SIZE);
+}
+
+static const Black_Box_Slot_Header *Black_Box_Slot_Header_At(uint16_t slot)
+{
+	return (const Black_Box_Slot_Header *)(uintptr_t)Black_Box_Slot_Address(slot);
+}
+
+static int Black_Box_Slot_Valid(uint16_t slot)
+{
+	const Black_Box_Slot_Header *header = Black_Box_Slot_Header_At(slot);
+	
+	return (header->magic == BLACK_BOX_SLOT_MAGIC) && (header->length <= BLACK_BOX_BLOCK_DATA_SIZE);
+}
+
+static int Black_Box_Slot_Erased(uint16_t slot)
+{
+	const uint32_t *word = (const uint32_t *)(uintptr_t)Black_Box_Slot_Address(slot);
+	uint16_t i;
+	
+	for (i = 0; i < (BLACK_BOX_BLOCK_SIZE / 4); i++)
+	{
+		if (word[i] != 0xFFFFFFFF)
+		{
+			return 0;
+		}
+	}
+	
+	return 1;
+}
+
+static void Black_Box_Flash_Write_Word(uint32_t address, uint32_t data)
+{
+	// Write the data to the FMD register and the word address to the FMA register
+	FLASH_CTRL->FMD = data;
+	FLASH_CTRL->FMA = address;
+	
+	// Start the write with the key and the WRITE bit (Bit 0) in the FMC register,
+	// then wait until the controller clears it
+	FLASH_CTRL->FMC = flash_write_key | BLACK_BOX_FMC_WRITE_BIT_MASK;
+	while (FLASH_CTRL->FMC & BLACK_BOX_FMC_WRITE_BIT_MASK);
+}
+
+static void Black_Box_Flash_Erase_Sector(uint32_t address)
+{
+	// Write the sector address to the FMA register
+	FLASH_CTRL->FMA = address;
+	
+	// Start the erase with the key and the ERASE bit (Bit 1) in the FMC register,
+	// then wait until the controller clears it
+	FLASH_CTRL->FMC = flash_write_key | BLACK_BOX_FMC_ERASE_BIT_MASK;
+	while (FLASH_CTRL->FMC & BLACK_BOX_FMC_ERASE_BIT_MASK);
+}
+
+static void Black_Box_Flash_Program_Block(uint16_t slot, const Black_Box_Block *block, uint16_t block_number)
+{
+	uint32_t address = Black_Box_Slot_Address(slot);
+	uint32_t word;
+	uint16_t i;
+	uint8_t k;
+	
+	// The records first, in whole words padded with erased bytes
+	for (i = 0; i < block->length; i += 4)
+	{
+		word = 0;
+		
+		for (k = 0; k < 4; k++)
+		{
+			word |= (uint32_t)(((i + k) < block->length) ? block->data[i + k] : 0xFF) << (8 * k);
+		}
+		
+		Black_Box_Flash_Write_Word(address + BLACK_BOX_HEADER_SIZE + i, word);
+	}
+	
+	// Then the header, the magic last: the slot only becomes valid once it is complete
+	Black_Box_Flash_Write_Word(address + 8, block->base_ticks);
+	Black_Box_Flash_Write_Word(address + 4, (uint32_t)block->length | ((uint32_t)block_number << 16));
+	Black_Box_Flash_Write_Word(address, BLACK_BOX_SLOT_MAGIC | ((uint32_t)flush_number << 16));
+}
+
+// Finds the newest slot of the log: the next flush continues after it
+static void Black_Box_Find_Log_End(void)
+{
+	const Black_Box_Slot_Header *header;
+	const Black_Box_Slot_Header *newest = 0;
+	uint16_t newest_slot = 0;
+	uint16_t slot;
+	
+	black_box_statistics.slots_used = 0;
+	
+	for (slot = 0; slot < BLACK_BOX_SLOT_COUNT; slot++)
+	{
+		if (!Black_Box_Slot_Valid(slot))
+		{
+			continue;
+		}
+		
+		header = Black_Box_Slot_Header_At(slot);
+		black_box_statistics.slots_used++;
+		
+		// The numbers wrap around, so they are compared by their difference
+		if ((newest == 0) || ((int16_t)(header->flush_number - newest->flush_number) > 0) ||
+			((header->flush_number == newest->flush_number) && ((int16_t)(header->block_number - newest->block_number) > 0)))
+		{
+			newest = header;
+			newest_slot = slot;
+		}
+	}
+	
+	if (newest == 0)
+	{
+		write_slot = 0;
+		flush_number = 0;
+	}
+	else
+	{
+		write_slot = (newest_slot + 1) % BLACK_BOX_SLOT_COUNT;
+		flush_number = newest->flush_number + 1;
+	}
+	
+	// A block interrupted by a reset left part of its records without a header:
+	// the log continues at the next sector, which is erased first
+	while (((write_slot % BLACK_BOX_SLOTS_PER_SECTOR) != 0) && !Black_Box_Slot_Erased(write_slot))
+	{
+		write_slot = (write_slot + 1) % BLACK_BOX_SLOT_COUNT;
+	}
+	
+	write_sector_erased = 0;
+}
+
+static Black_Box_Block *Black_Box_Next_Block(uint32_t now_ticks)
+{
+	Black_Box_Block *block;
+	uint8_t i;
+	
+	block_sequence++;
+	
+	// The oldest block is overwritten: a flush can no longer copy it
+	if ((block_sequence - flush_next_block) >= BLACK_BOX_RAM_BLOCKS)
+	{
+		if (flush_active)
+		{
+			black_box_statistics.blocks_lost++;
+		}
+		
+		flush_next_block = block_sequence - BLACK_BOX_RAM_BLOCKS + 1;
+	}
+	
+	// Each block starts from zero values and its own base time
+	block = &ram_blocks[block_sequence % BLACK_BOX_RAM_BLOCKS];
+	block->length = 0;
+	block->base_ticks = now_ticks;
+	last_ticks = now_ticks;
+	
+	for (i = 0; i < BLACK_BOX_FIELD_COUNT; i++)
+	{
+		last_values[i] = 0;
+	}
+	
+	return block;
+}
+
+// The current block, with room for one more record
+static Black_Box_Block *Black_Box_Reserve(uint32_t now_ticks)
+{
+	Black_Box_Block *block = &ram_blocks[block_sequence % BLACK_BOX_RAM_BLOCKS];
+	
+	if (block->length > (BLACK_BOX_BLOCK_DATA_SIZE - BLACK_BOX_MAX_RECORD_SIZE))
+	{
+		block = Black_Box_Next_Block(now_ticks);
+	}
+	
+	return block;
+}
+
+static uint8_t *Black_Box_Put_Varint(uint8_t *output, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		*output++ = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	
+	*output++ = (uint8_t)value;
+	
+	return output;
+}
+
+static uint8_t *Black_Box_Start_Record(Black_Box_Block *block, uint8_t tag, uint32_t now_ticks)
+{
+	uint8_t *output = &block->data[block->length];
+	
+	*output++ = tag;
+	output = Black_Box_Put_Varint(output, now_ticks - last_ticks);
+	last_ticks = now_ticks;
+	
+	return output;
+}
+
+static void Black_Box_End_Record(Black_Box_Block *block, uint8_t *output)
+{
+	block->length = (uint16_t)(output - block->data);
+	black_box_statistics.record_count++;
+}
+
+static void Black_Box_Record_Event(uint8_t event)
+{
+	uint32_t now_ticks = Black_Box_Now_Ticks();
+	Black_Box_Block *block = Black_Box_Reserve(now_ticks);
+	
+	Black_Box_End_Record(block, Black_Box_Start_Record(block, BLACK_BOX_RECORD_EVENT | event, now_ticks));
+}
+
+static void Black_Box_Capture_Sample(const int32_t *values)
+{
+	uint32_t start_cycles = LATENCY_NOW_CYCLES();
+	uint32_t now_ticks = Black_Box_Now_Ticks();
+	Black_Box_Block *block = Black_Box_Reserve(now_ticks);
+	uint8_t *output;
+	uint8_t mask = 0;
+	uint8_t i;
+	uint32_t cycles;
+	
+	for (i = 0; i < BLACK_BOX_FIELD_COUNT; i++)
+	{
+		if (values[i] != last_values[i])
+		{
+			mask |= (uint8_t)(1 << i);
+		}
+	}
+	
+	// An unchanged sample is not recorded: the time of the next record covers it
+	if (mask != 0)
+	{
+		output = Black_Box_Start_Record(block, BLACK_BOX_RECORD_SAMPLE | mask, now_ticks);
+		
+		for (i = 0; i < BLACK_BOX_FIELD_COUNT; i++)
+		{
+			if (mask & (1 << i))
+			{
+				output = Black_Box_Put_Varint(output, BLACK_BOX_ZIGZAG(values[i] - last_values[i]));
+				last_values[i] = values[i];
+			}
+		}
+		
+		Black_Box_End_Record(block, output);
+	}
+	
+	cycles = LATENCY_NOW_CYCLES() - start_cycles;
+	
+	if (cycles > black_box_statistics.max_capture_cycles)
+	{
+		black_box_statistics.max_capture_cycles = cycles;
+	}
+}
+
+static void Black_Box_Request_Flush(uint32_t delay_ms)
+{
+	if (!flush_requested)
+	{
+		flush_requested = 1;
+		flush_start_cycles = Timebase_Deadline_US(delay_ms * 1000U);
+	}
+}
+
+// Carries out one flash operation of the flush: a sector erase, or the copy of one block
+static void Black_Box_Flush_Step(void)
+{
+	uint16_t slot;
+	
+	// The flash controller stalls the CPU, and with it the motor control interrupts
+	if ((Motion_Profile_Get_Duty() != 0) || dump_active)
+	{
+		return;
+	}
+	
+	if (!flush_active)
+	{
+		if (!flush_requested || !Timebase_Deadline_Expired(flush_start_cycles))
+		{
+			return;
+		}
+		
+		flush_requested = 0;
+		
+		// Close the block being written, so that the flush includes the latest records
+		if (ram_blocks[block_sequence % BLACK_BOX_RAM_BLOCKS].length != 0)
+		{
+			Black_Box_Next_Block(Black_Box_Now_Ticks());
+		}
+		
+		flush_end_block = block_sequence;
+		flush_active = 1;
+	}
+	
+	if (flush_next_block >= flush_end_block)
+	{
+		flush_active = 0;
+		flush_number++;
+		black_box_statistics.flush_count++;
+		return;
+	}
+	
+	// The log erases each sector when it enters it, overwriting its oldest blocks
+	if (((write_slot % BLACK_BOX_SLOTS_PER_SECTOR) == 0) && !write_sector_erased)
+	{
+		for (slot = write_slot; slot < (write_slot + BLACK_BOX_SLOTS_PER_SECTOR); slot++)
+		{
+			if (Black_Box_Slot_Valid(slot))
+			{
+				black_box_statistics.slots_used--;
+			}
+		}
+		
+		Black_Box_Flash_Erase_Sector(Black_Box_Slot_Address(write_slot));
+		write_sector_erased = 1;
+		black_box_statistics.sectors_erased++;
+		return;
+	}
+	
+	Black_Box_Flash_Program_Block(write_slot, &ram_blocks[flush_next_block % BLACK_BOX_RAM_BLOCKS], (uint16_t)flush_next_block);
+	
+	flush_next_block++;
+	write_slot = (write_slot + 1) % BLACK_BOX_SLOT_COUNT;
+	write_sector_erased = 0;
+	black_box_statistics.blocks_written++;
+	black_box_statistics.slots_used++;
+}
+
+static void Black_Box_Output_Signed(int32_t value)
+{
+	if (value < 0)
+	{
+		UART0_Output_Character('-');
+		value = -value;
+	}
+	
+	UART0_Output_Unsigned_Decimal((uint32_t)value);
+}
+
+static void Black_Box_Output_Hex_Byte(uint8_t value)
+{
+	static const char digits[] = "0123456789ABCDEF";
+	
+	UART0_Output_String("0x");
+	UART0_Output_Character(digits[value >> 4]);
+	UART0_Output_Character(digits[value & 0x0F]);
+}
+
+static uint32_t Black_Box_Get_Varint(const uint8_t *data, uint16_t *offset)
+{
+	uint32_t value = 0;
+	uint8_t shift = 0;
+	uint8_t byte;
+	
+	do
+	{
+		byte = data[(*offset)++];
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		shift += 7;
+	} while ((byte & 0x80) && (shift < 35));
+	
+	return value;
+}
+
+static int32_t Black_Box_Get_Signed(const uint8_t *data, uint16_t *offset)
+{
+	uint32_t value = Black_Box_Get_Varint(data, offset);
+	
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// Names of the events in the dump, indexed by BLACK_BOX_EVENT_*
+static const char *const black_box_event_names[] =
+{
+	"?", "start", "watchdog_reset", "obstacle_stop", "deadman_trip", "flush"
+};
+
+#define BLACK_BOX_EVENT_NAME_COUNT (sizeof(black_box_event_names) / sizeof(black_box_event_names[0]))
+
+// Decodes the record at dump_offset of the current slot and prints it as one line
+static void Black_Box_Dump_Record(const Black_Box_Slot_Header *header)
+{
+	const uint8_t *data = (const uint8_t *)header + BLACK_BOX_HEADER_SIZE;
+	uint8_t tag = data[dump_offset++];
+	uint8_t event = tag & ~BLACK_BOX_RECORD_KIND_MASK;
+	uint8_t code;
+	int32_t value;
+	uint8_t i;
+	
+	dump_ticks += Black_Box_Get_Varint(data, &dump_offset);
+	
+	UART0_Output_Unsigned_Decimal(Black_Box_Ticks_To_MS(dump_ticks));
+	
+	switch (tag & BLACK_BOX_RECORD_KIND_MASK)
+	{
+		case BLACK_BOX_RECORD_SAMPLE:
+			UART0_Output_String(" S");
+			
+			for (i = 0; i < BLACK_BOX_FIELD_COUNT; i++)
+			{
+				if (tag & (1 << i))
+				{
+					dump_values[i] += Black_Box_Get_Signed(data, &dump_offset);
+				}
+				
+				UART0_Output_Character(' ');
+				Black_Box_Output_Signed(dump_values[i]);
+			}
+			break;
+		
+		case BLACK_BOX_RECORD_COMMAND:
+			code = data[dump_offset++];
+			value = Black_Box_Get_Signed(data, &dump_offset);
+			UART0_Output_String(" C ");
+			
+			// Frame types are printed in hexadecimal, with their first two payload bytes
+			if (code < 0x20)
+			{
+				Black_Box_Output_Hex_Byte(code);
+				UART0_Output_Character(' ');
+				Black_Box_Output_Signed((int8_t)(value & 0xFF));
+				UART0_Output_Character(' ');
+				Black_Box_Output_Signed((int8_t)((value >> 8) & 0xFF));
+			}
+			else
+			{
+				UART0_Output_Character((char)code);
+				UART0_Output_Character(' ');
+				Black_Box_Output_Signed(value);
+			}
+			break;
+		
+		default:
+			UART0_Output_String(" E ");
+			UART0_Output_String((char *)black_box_event_names[(event < BLACK_BOX_EVENT_NAME_COUNT) ? event : 0]);
+			break;
+	}
+	
+	UART0_Output_Newline();
+}
+
+// Writes the next line or frame of the dump, and returns 0 once the dump is complete
+static int Black_Box_Dump_Next(void)
+{
+	const Black_Box_Slot_Header *header;
+	uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+	uint8_t length;
+	uint8_t i;
+	
+	if (!dump_started)
+	{
+		dump_started = 1;
+		
+		if (!dump_framed)
+		{
+			UART0_Output_String("blackbox t_ms S distance_cm motor_duty servo_duty speed_mm_s\r\n");
+		}
+		return 1;
+	}
+	
+	// Skip the erased and unfinished slots
+	while ((dump_slots_left > 0) && !Black_Box_Slot_Valid(dump_slot))
+	{
+		dump_slot = (dump_slot + 1) % BLACK_BOX_SLOT_COUNT;
+		dump_slots_left--;
+	}
+	
+	if (dump_slots_left == 0)
+	{
+		// The end is marked by a frame without data, or by a line
+		if (dump_framed)
+		{
+			payload[0] = (uint8_t)(dump_stream_offset & 0xFF);
+			payload[1] = (uint8_t)(dump_stream_offset >> 8);
+			Protocol_Send(PROTOCOL_BLACK_BOX_DATA, dump_sequence++, payload, 2);
+		}
+		else
+		{
+			UART0_Output_String("blackbox end ");
+			UART0_Output_Unsigned_Decimal(dump_block_count);
+			UART0_Output_String(" blocks\r\n");
+		}
+		return 0;
+	}
+	
+	header = Black_Box_Slot_Header_At(dump_slot);
+	
+	if (!dump_slot_started)
+	{
+		dump_slot_started = 1;
+		dump_offset = 0;
+		dump_block_count++;
+		
+		if (!dump_framed)
+		{
+			dump_ticks = header->base_ticks;
+			
+			for (i = 0; i < BLACK_BOX_FIELD_COUNT; i++)
+			{
+				dump_values[i] = 0;
+			}
+			
+			UART0_Output_String("block ");
+			UART0_Output_Unsigned_Decimal(header->flush_number);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(header->block_number);
+			UART0_Output_Newline();
+			return 1;
+		}
+	}
+	
+	if (dump_framed)
+	{
+		// The raw slot, header included
+		length = (uint8_t)(((BLACK_BOX_BLOCK_SIZE - dump_offset) < BLACK_BOX_DUMP_CHUNK) ? (BLACK_BOX_BLOCK_SIZE - dump_offset) : BLACK_BOX_DUMP_CHUNK);
+		payload[0] = (uint8_t)(dump_stream_offset & 0xFF);
+		payload[1] = (uint8_t)(dump_stream_offset >> 8);
+		
+		for (i = 0; i < length; i++)
+		{
+			payload[2 + i] = ((const uint8_t *)header)[dump_offset + i];
+		}
+		
+		Protocol_Send(PROTOCOL_BLACK_BOX_DATA, dump_sequence++, payload, length + 2);
+		dump_offset += length;
+		dump_stream_offset += length;
+		
+		if (dump_offset < BLACK_BOX_BLOCK_SIZE)
+		{
+			return 1;
+		}
+	}
+	else if (dump_offset < header->length)
+	{
+		Black_Box_Dump_Record(header);
+		
+		if (dump_offset < header->length)
+		{
+			return 1;
+		}
+	}
+	
+	dump_slot = (dump_slot + 1) % BLACK_BOX_SLOT_COUNT;
+	dump_slots_left--;
+	dump_slot_started = 0;
+	
+	return 1;
+}
+
+static void Black_Box_Dump_Step(void)
+{
+	uint8_t lines;
+	
+	// The log is read back once the flush in progress is complete
+	if (!dump_active || flush_active)
+	{
+		return;
+	}
+	
+	for (lines = 0; (lines < BLACK_BOX_DUMP_LINES_PER_RUN) && (UART0_TX_Free() >= BLACK_BOX_DUMP_LINE_MAX); lines++)
+	{
+		if (!Black_Box_Dump_Next())
+		{
+			dump_active = 0;
+			return;
+		}
+	}
+}
+
+static void Black_Box_Task(void)
+{
+	Vehicle_Status status;
+	Deadman_Statistics deadman;
+	int32_t values[BLACK_BOX_FIELD_COUNT];
+	
+	Vehicle_Get_Status(&status);
+	Deadman_Get_Statistics(&deadman);
+	
+	if (status.obstacle_stop_count != seen_obstacle_stops)
+	{
+		seen_obstacle_stops = status.obstacle_stop_count;
+		Black_Box_Record_Event(BLACK_BOX_EVENT_OBSTACLE_STOP);
+		
+		// Keep recording the aftermath, then copy the history into flash
+		Black_Box_Request_Flush(BLACK_BOX_POST_TRIGGER_MS);
+	}
+	
+	if (deadman.trip_count != seen_deadman_trips)
+	{
+		seen_deadman_trips = deadman.trip_count;
+		Black_Box_Record_Event(BLACK_BOX_EVENT_DEADMAN_TRIP);
+	}
+	
+	if (Timebase_Deadline_Expired(next_sample_cycles))
+	{
+		next_sample_cycles += BLACK_BOX_SAMPLE_PERIOD_CYCLES;
+		
+		// Samples missed by a long stall are not made up for
+		if (Timebase_Deadline_Expired(next_sample_cycles))
+		{
+			next_sample_cycles = Timebase_Now_Cycles() + BLACK_BOX_SAMPLE_PERIOD_CYCLES;
+		}
+		
+		values[0] = (int32_t)status.distance_cm;
+		values[1] = Motion_Profile_Get_Duty();
+		values[2] = status.servo_duty;
+		values[3] = status.speed_mm_s;
+		Black_Box_Capture_Sample(values);
+	}
+	
+	Black_Box_Flush_Step();
+	Black_Box_Dump_Step();
+}
+
+void Black_Box_Init(void)
+{
+	Vehicle_Status status;
+	Deadman_Statistics deadman;
+	uint8_t i;
+	
+	Timebase_Init();
+	
+	// Select the flash write key
+	flash_write_key = (FLASH_CTRL->BOOTCFG & BLACK_BOX_BOOTCFG_KEY_BIT_MASK) ? BLACK_BOX_FMC_WRKEY_KEY_SET : BLACK_BOX_FMC_WRKEY_KEY_CLEAR;
+	
+	Black_Box_Find_Log_End();
+	
+	black_box_statistics.record_count = 0;
+	black_box_statistics.flush_count = 0;
+	black_box_statistics.blocks_written = 0;
+	black_box_statistics.sectors_erased = 0;
+	black_box_statistics.blocks_lost = 0;
+	black_box_statistics.max_capture_cycles = 0;
+	
+	block_sequence = 0;
+	flush_next_block = 0;
+	flush_requested = 0;
+	flush_active = 0;
+	dump_active = 0;
+	dump_sequence = 0;
+	
+	ram_blocks[0].length = 0;
+	ram_blocks[0].base_ticks = Black_Box_Now_Ticks();
+	last_ticks = ram_blocks[0].base_ticks;
+	
+	for (i = 0; i < BLACK_BOX_FIELD_COUNT; i++)
+	{
+		last_values[i] = 0;
+	}
+	
+	Vehicle_Get_Status(&status);
+	Deadman_Get_Statistics(&deadman);
+	seen_obstacle_stops = status.obstacle_stop_count;
+	seen_deadman_trips = deadman.trip_count;
+	
+	Black_Box_Record_Event(BLACK_BOX_EVENT_START);
+	
+	if (Watchdog_Caused_Reset())
+	{
+		Black_Box_Record_Event(BLACK_BOX_EVENT_WATCHDOG_RESET);
+	}
+	
+	next_sample_cycles = Timebase_Now_Cycles();
+	
+	Scheduler_Add_Task("blackbox", Black_Box_Task, BLACK_BOX_TASK_PERIOD_US, BLACK_BOX_TASK_PERIOD_US);
+}
+
+void Black_Box_Record_Command(uint8_t code, int16_t value)
+{
+	uint32_t now_ticks = Black_Box_Now_Ticks();
+	Black_Box_Block *block = Black_Box_Reserve(now_ticks);
+	uint8_t *output = Black_Box_Start_Record(block, BLACK_BOX_RECORD_COMMAND, now_ticks);
+	
+	*output++ = code;
+	output = Black_Box_Put_Varint(output, BLACK_BOX_ZIGZAG((int32_t)value));
+	Black_Box_End_Record(block, output);
+}
+
+void Black_Box_Flush(void)
+{
+	Black_Box_Record_Event(BLACK_BOX_EVENT_FLUSH);
+	Black_Box_Request_Flush(0);
+}
+
+int Black_Box_Dump(void)
+{
+	if (dump_active)
+	{
+		return 0;
+	}
+	
+	dump_framed = (Protocol_Get_Mode() == PROTOCOL_MODE_FRAMED);
+	dump_started = 0;
+	dump_slot_started = 0;
+	dump_slot = write_slot;
+	dump_slots_left = BLACK_BOX_SLOT_COUNT;
+	dump_block_count = 0;
+	dump_stream_offset = 0;
+	dump_active = 1;
+	
+	return 1;
+}
+
+void Black_Box_Get_Statistics(Black_Box_Statistics *stats)
+{
+	uint32_t oldest = (block_sequence >= BLACK_BOX_RAM_BLOCKS) ? (block_sequence - BLACK_BOX_RAM_BLOCKS + 1) : 0;
+	
+	*stats = black_box_statistics;
+	stats->history_ms = Black_Box_Ticks_To_MS(Black_Box_Now_Ticks() - ram_blocks[oldest % BLACK_BOX_RAM_BLOCKS].base_ticks);
+}
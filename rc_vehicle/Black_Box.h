@@ -0,0 +1,229 @@
+/**
+ * @file Black_Box.h
+ *
+ * @brief Header file for the black box recorder.
+ *
+ * The recorder keeps the recent history of the vehicle in a RAM ring, and copies it into a
+ * reserved region of the on-chip flash memory after an incident, so that it survives a reset.
+ *
+ * - Recording: every BLACK_BOX_SAMPLE_PERIOD_MS, the filtered front sonar distance, the motor
+ *   and servo duty cycles and the measured wheel speed are recorded, together with every
+ *   received command (Black_Box_Record_Command) and a few events (obstacle stops, deadman
+ *   trips, watchdog resets). Each record holds the time since the previous record and, for a
+ *   sample, only the fields that changed, as differences from their previous values. The
+ *   numbers are zigzag and varint encoded (7 bits per byte), so an unchanged sample costs
+ *   nothing and a typical sample takes 3 to 5 bytes. Capturing a sample costs a few dozen
+ *   cycles (measured with the DWT cycle counter, see Black_Box_Statistics).
+ *
+ * - RAM ring: the records are written into BLACK_BOX_RAM_BLOCKS blocks of
+ *   BLACK_BOX_BLOCK_DATA_SIZE bytes. Every block starts from zero values and its own base
+ *   time, so it can be decoded on its own, and the oldest block is overwritten as a whole.
+ *
+ * - Flush: BLACK_BOX_POST_TRIGGER_MS after an obstacle stop, or on command
+ *   (Black_Box_Flush), the blocks recorded since the previous flush are copied into flash
+ *   slots of BLACK_BOX_BLOCK_SIZE bytes. The flash region is written as a circular log: each
+ *   sector is erased when the log reaches it, so every sector is erased once per pass over the
+ *   region (wear leveling). The header of a slot is programmed last, so a slot interrupted by
+ *   a reset is never taken for a valid one. The flash controller stalls the CPU while it
+ *   erases or programs, so the flush is paced by the black box task, one sector erase or one
+ *   block per run, and only proceeds while the motor is at rest.
+ *
+ * - Readback: Black_Box_Dump streams the flash log back over UART0, oldest block first,
+ *   as decoded text lines in character mode, or as PROTOCOL_BLACK_BOX_DATA frames carrying
+ *   the raw slots in framed mode (see Protocol.h). The output is paced by the free space in
+ *   the UART0 transmit buffer.
+ *
+ * Slot layout (little-endian):
+ *
+ *   uint16 BLACK_BOX_SLOT_MAGIC | uint16 flush number | uint16 record bytes | uint16 block number |
+ *   uint32 base time in ticks | records
+ *
+ * Record layout:
+ *
+ *   tag | varint ticks since the previous record (or the base time) | fields
+ *
+ * - BLACK_BOX_RECORD_SAMPLE, the low bits of the tag select the fields that changed
+ *   (BLACK_BOX_FIELD_*), each followed by its zigzag varint difference, in bit order.
+ * - BLACK_BOX_RECORD_COMMAND, followed by the command code byte and its zigzag varint value.
+ * - BLACK_BOX_RECORD_EVENT, the low bits of the tag are the event (BLACK_BOX_EVENT_*).
+ *
+ * @note The flash region is at the top of the 256 KB flash memory: the program must not
+ * extend into it. The scatter file of the Keil project (keilproject/UART.sct) limits the
+ * image to the flash below BLACK_BOX_FLASH_BASE, and asserts it at link time. The timing is derived from the system clock frequency (SYSTEM_CLOCK_HZ, see
+ * System_Clock.h).
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef BLACK_BOX_H
+#define BLACK_BOX_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief Flash region reserved for the log: the top 32 KB of the flash memory. The limit of
+ * the load region in keilproject/UART.sct must be changed with BLACK_BOX_FLASH_BASE.
+ */
+#define BLACK_BOX_FLASH_BASE 0x00038000
+#define BLACK_BOX_FLASH_SIZE 0x8000
+
+/**
+ * @brief Size of a flash sector, the unit of erase
+ */
+#define BLACK_BOX_SECTOR_SIZE 1024
+
+/**
+ * @brief Size of a block: one RAM block is copied into one flash slot
+ */
+#define BLACK_BOX_BLOCK_SIZE 256
+
+/**
+ * @brief Size of the slot header, and of the records of a block
+ */
+#define BLACK_BOX_HEADER_SIZE 12
+#define BLACK_BOX_BLOCK_DATA_SIZE (BLACK_BOX_BLOCK_SIZE - BLACK_BOX_HEADER_SIZE)
+
+/**
+ * @brief Number of flash slots in the region
+ */
+#define BLACK_BOX_SLOT_COUNT (BLACK_BOX_FLASH_SIZE / BLACK_BOX_BLOCK_SIZE)
+
+/**
+ * @brief Number of blocks in the RAM ring (8 KB)
+ */
+#define BLACK_BOX_RAM_BLOCKS 32
+
+/**
+ * @brief First half-word of a valid slot
+ */
+#define BLACK_BOX_SLOT_MAGIC 0xB10C
+
+/**
+ * @brief One time tick is 2^BLACK_BOX_TICK_SHIFT system clock cycles (0.82 ms at 80 MHz)
+ */
+#define BLACK_BOX_TICK_SHIFT 16
+
+/**
+ * @brief Time between two samples in milliseconds
+ */
+#define BLACK_BOX_SAMPLE_PERIOD_MS 100
+
+/**
+ * @brief Time recorded after an obstacle stop before the flush starts, in milliseconds
+ */
+#define BLACK_BOX_POST_TRIGGER_MS 1000
+
+/**
+ * @brief Period and deadline of the black box task in microseconds
+ */
+#define BLACK_BOX_TASK_PERIOD_US 20000
+
+/**
+ * @brief Record kinds (bits 7 and 6 of the tag)
+ */
+#define BLACK_BOX_RECORD_SAMPLE  0x00
+#define BLACK_BOX_RECORD_COMMAND 0x40
+#define BLACK_BOX_RECORD_EVENT   0x80
+#define BLACK_BOX_RECORD_KIND_MASK 0xC0
+
+/**
+ * @brief Sample fields (bits of a sample tag)
+ */
+#define BLACK_BOX_FIELD_DISTANCE   0x01  // filtered front sonar distance in centimeters
+#define BLACK_BOX_FIELD_MOTOR_DUTY 0x02  // signed motor duty cycle in PWM counts, negative in reverse
+#define BLACK_BOX_FIELD_SERVO_DUTY 0x04  // steering servo duty cycle in PWM counts
+#define BLACK_BOX_FIELD_SPEED      0x08  // measured wheel speed in millimeters per second
+#define BLACK_BOX_FIELD_COUNT 4
+
+/**
+ * @brief Events (low bits of an event tag)
+ */
+#define BLACK_BOX_EVENT_START          1  // the recorder started after a reset
+#define BLACK_BOX_EVENT_WATCHDOG_RESET 2  // the reset was caused by the watchdog
+#define BLACK_BOX_EVENT_OBSTACLE_STOP  3  // forward motion was stopped by an obstacle
+#define BLACK_BOX_EVENT_DEADMAN_TRIP   4  // the vehicle was stopped by the deadman
+#define BLACK_BOX_EVENT_FLUSH          5  // a flush was requested by command
+
+/**
+ * @brief Recorder statistics since Black_Box_Init.
+ */
+typedef struct
+{
+	/** Number of records written into the RAM ring */
+	uint32_t record_count;
+	
+	/** Time covered by the RAM ring, from the start of its oldest block, in milliseconds */
+	uint32_t history_ms;
+	
+	/** Number of completed flushes */
+	uint32_t flush_count;
+	
+	/** Number of blocks copied into flash, and of sectors erased */
+	uint32_t blocks_written;
+	uint32_t sectors_erased;
+	
+	/** Number of blocks overwritten in the RAM ring before a flush could copy them */
+	uint32_t blocks_lost;
+	
+	/** Number of valid slots in the flash log */
+	uint16_t slots_used;
+	
+	/** Longest time taken to capture a sample, in system clock cycles */
+	uint32_t max_capture_cycles;
+} Black_Box_Statistics;
+
+/**
+ * @brief The Black_Box_Init function finds the end of the flash log and registers the black box task.
+ *
+ * Scheduler_Init, Vehicle_Control_Init, Deadman_Init and Watchdog_Init must have been called
+ * before this function.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Black_Box_Init(void);
+
+/**
+ * @brief The Black_Box_Record_Command function records a received command.
+ *
+ * @param code The command: its character in character mode, or its message type in framed mode.
+ * @param value The argument of the command, 0 if it has none.
+ *
+ * @return None
+ */
+void Black_Box_Record_Command(uint8_t code, int16_t value);
+
+/**
+ * @brief The Black_Box_Flush function requests a copy of the recent history into flash.
+ *
+ * The flush starts at the next run of the black box task once the motor is at rest.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Black_Box_Flush(void);
+
+/**
+ * @brief The Black_Box_Dump function starts streaming the flash log over UART0.
+ *
+ * The format follows the command intake mode at this call. A flush in progress completes first.
+ *
+ * @param None
+ *
+ * @return 1 if the dump was started, 0 if a dump is already in progress.
+ */
+int Black_Box_Dump(void);
+
+/**
+ * @brief The Black_Box_Get_Statistics function copies the recorder statistics.
+ *
+ * @param stats Pointer to the structure that receives the statistics.
+ *
+ * @return None
+ */
+void Black_Box_Get_Statistics(Black_Box_Statistics *stats);
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * @file Command_Parser.c
+ *
+ * @brief Source code for the incremental numeric command parser.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Command_Parser.h"
+#include "UART0.h"
+
+static int Command_Parser_Is_Letter(char character)
+{
+	return (character == 'T') || (character == 'S') || (character == 'V') || (character == '#');
+}
+
+static uint8_t Command_Parser_Max_Digits(const Command_Parser *parser)
+{
+	return (parser->letter == '#') ? COMMAND_PARSER_MAX_PARAMETER_DIGITS : COMMAND_PARSER_MAX_DIGITS;
+}
+
+static void Command_Parser_Start(Command_Parser *parser, char letter)
+{
+	parser->letter = letter;
+	parser->negative = 0;
+	parser->has_sign = 0;
+	parser->digits = 0;
+	parser->magnitude = 0;
+	parser->has_index = 0;
+	parser->index_digits = 0;
+}
+
+// Completes the numeric command in progress and returns to the idle state
+static Command_Parser_Result Command_Parser_Finish(Command_Parser *parser, int16_t *value)
+{
+	Command_Parser_Result result;
+	
+	if (parser->digits == 0)
+	{
+		result = COMMAND_PARSER_ERROR;
+	}
+	else if (parser->letter == '#')
+	{
+		if (parser->has_index)
+		{
+			parser->parameter_value = parser->negative ? -parser->magnitude : parser->magnitude;
+			result = COMMAND_PARSER_PARAMETER_SET;
+		}
+		else if (parser->magnitude > 0xFF)
+		{
+			result = COMMAND_PARSER_ERROR;
+		}
+		else
+		{
+			parser->parameter_index = (uint8_t)parser->magnitude;
+			result = COMMAND_PARSER_PARAMETER_GET;
+		}
+	}
+	else
+	{
+		*value = (int16_t)(parser->negative ? -parser->magnitude : parser->magnitude);
+		if (parser->letter == 'T')
+		{
+			result = COMMAND_PARSER_THROTTLE;
+		}
+		else if (parser->letter == 'V')
+		{
+			result = COMMAND_PARSER_SPEED;
+		}
+		else
+		{
+			result = COMMAND_PARSER_STEERING;
+		}
+	}
+	
+	parser->letter = 0;
+	
+	return result;
+}
+
+void Command_Parser_Init(Command_Parser *parser)
+{
+	Command_Parser_Start(parser, 0);
+}
+
+Command_Parser_Result Command_Parser_Feed(Command_Parser *parser, char character, int16_t *value)
+{
+	Command_Parser_Result result;
+	
+	// Idle: only the letter of a numeric command starts one
+	if (parser->letter == 0)
+	{
+		if (Command_Parser_Is_Letter(character))
+		{
+			Command_Parser_Start(parser, character);
+			return COMMAND_PARSER_NONE;
+		}
+		
+		return COMMAND_PARSER_CHARACTER;
+	}
+	
+	if ((character >= '0') && (character <= '9'))
+	{
+		if (parser->digits >= Command_Parser_Max_Digits(parser))
+		{
+			parser->letter = 0;
+			return COMMAND_PARSER_ERROR;
+		}
+		
+		parser->magnitude = (parser->magnitude * 10) + (character - '0');
+		parser->digits++;
+		return COMMAND_PARSER_NONE;
+	}
+	
+	// The index of a parameter command is complete: the value follows
+	if ((character == '=') && (parser->letter == '#') && !parser->has_index && (parser->digits > 0) &&
+		(parser->magnitude <= 0xFF))
+	{
+		parser->parameter_index = (uint8_t)parser->magnitude;
+		parser->has_index = 1;
+		parser->index_digits = parser->digits;
+		parser->digits = 0;
+		parser->magnitude = 0;
+		return COMMAND_PARSER_NONE;
+	}
+	
+	// Only the value of a parameter command is signed, not its index
+	if (((character == '+') || (character == '-')) && !parser->has_sign && (parser->digits == 0) &&
+		((parser->letter != '#') || parser->has_index))
+	{
+		parser->has_sign = 1;
+		parser->negative = (character == '-');
+		return COMMAND_PARSER_NONE;
+	}
+	
+	if (character == UART0_BS)
+	{
+		// Remove the last digit, then the sign, then the '=' of a parameter command, then the command itself
+		if (parser->digits > 0)
+		{
+			parser->magnitude /= 10;
+			parser->digits--;
+		}
+		else if (parser->has_sign)
+		{
+			parser->has_sign = 0;
+			parser->negative = 0;
+		}
+		else if (parser->has_index)
+		{
+			parser->has_index = 0;
+			parser->magnitude = parser->parameter_index;
+			parser->digits = parser->index_digits;
+		}
+		else
+		{
+			parser->letter = 0;
+		}
+		return COMMAND_PARSER_NONE;
+	}
+	
+	if ((character == UART0_CR) || (character == UART0_LF) || (character == ';') || (character == ','))
+	{
+		return Command_Parser_Finish(parser, value);
+	}
+	
+	if (Command_Parser_Is_Letter(character))
+	{
+		// The next numeric command completes the current one
+		result = Command_Parser_Finish(parser, value);
+		Command_Parser_Start(parser, character);
+		return result;
+	}
+	
+	parser->letter = 0;
+	return COMMAND_PARSER_ERROR;
+}
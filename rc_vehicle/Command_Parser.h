@@ -0,0 +1,120 @@
+/**
+ * @file Command_Parser.h
+ *
+ * @brief Header file for the incremental numeric command parser.
+ *
+ * The parser consumes one received character at a time and never waits for input,
+ * so it can be fed directly from the command task. It recognizes:
+ *
+ * - T<sign><digits>: signed throttle in percent, for example T-40 or T+75
+ * - S<sign><digits>: signed steering angle in degrees, for example S+15 or S-30
+ * - V<sign><digits>: signed wheel speed in centimeters per second, for example V60 or V-25
+ * - #<index>: read a runtime parameter, for example #3
+ * - #<index>=<sign><digits>: change a runtime parameter, for example #4=-12 (see Parameters.h)
+ *
+ * The sign is optional. A value is completed by a carriage return, a line feed, ';' or ','
+ * or by the letter of the next numeric command, so "T-40S+15\r" sets both. Backspace removes
+ * the last typed character of a value, and the '=' of a parameter command. Every other character received while no numeric command
+ * is in progress is handed back to the caller as a single-character command.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Maximum number of digits accepted in a value
+ */
+#define COMMAND_PARSER_MAX_DIGITS 3
+
+/**
+ * @brief Maximum number of digits accepted in the index and in the value of a parameter command
+ */
+#define COMMAND_PARSER_MAX_PARAMETER_DIGITS 7
+
+/**
+ * @brief Outcome of feeding one character to the parser
+ */
+typedef enum
+{
+	/** The character was consumed as part of a numeric command that is not complete yet */
+	COMMAND_PARSER_NONE,
+	
+	/** A throttle command was completed; the value is in percent */
+	COMMAND_PARSER_THROTTLE,
+	
+	/** A steering command was completed; the value is in degrees */
+	COMMAND_PARSER_STEERING,
+	
+	/** A speed command was completed; the value is in centimeters per second */
+	COMMAND_PARSER_SPEED,
+	
+	/** A parameter read was completed; the index is in parameter_index */
+	COMMAND_PARSER_PARAMETER_GET,
+	
+	/** A parameter change was completed; the index and the value are in parameter_index and parameter_value */
+	COMMAND_PARSER_PARAMETER_SET,
+	
+	/** The character is not part of a numeric command and should be handled as a single-character command */
+	COMMAND_PARSER_CHARACTER,
+	
+	/** A numeric command was malformed and has been discarded */
+	COMMAND_PARSER_ERROR
+} Command_Parser_Result;
+
+/**
+ * @brief Parser state. One instance is needed per input stream.
+ */
+typedef struct
+{
+	/** Letter of the numeric command in progress, 0 when idle */
+	char letter;
+	
+	/** 1 if a minus sign was received */
+	uint8_t negative;
+	
+	/** 1 if a sign character was received */
+	uint8_t has_sign;
+	
+	/** Number of digits received */
+	uint8_t digits;
+	
+	/** Magnitude accumulated from the digits */
+	int32_t magnitude;
+	
+	/** 1 once the '=' of a parameter command was received, and the number of digits of its index */
+	uint8_t has_index;
+	uint8_t index_digits;
+	
+	/** Index and value of the last completed parameter command */
+	uint8_t parameter_index;
+	int32_t parameter_value;
+} Command_Parser;
+
+/**
+ * @brief The Command_Parser_Init function resets a parser to the idle state.
+ *
+ * @param parser Pointer to the parser state.
+ *
+ * @return None
+ */
+void Command_Parser_Init(Command_Parser *parser);
+
+/**
+ * @brief The Command_Parser_Feed function processes one received character.
+ *
+ * The cost is constant per character.
+ *
+ * @param parser Pointer to the parser state.
+ * @param character The received character.
+ * @param value Pointer that receives the signed value when a throttle, steering or speed command is completed.
+ * The index and the value of a parameter command are left in the parser state instead.
+ *
+ * @return The outcome for this character (see Command_Parser_Result).
+ */
+Command_Parser_Result Command_Parser_Feed(Command_Parser *parser, char character, int16_t *value);
+
+#endif
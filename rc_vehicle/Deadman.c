@@ -0,0 +1,202 @@
+/**
+ * @file Deadman.c
+ *
+ * @brief Source code for the command link deadman.
+ *
+ * The deadline is a 64-bit timebase count shared with the interrupt service routine, so the
+ * application updates it with the interrupts disabled.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Deadman.h"
+#include "Vehicle_Control.h"
+#include "Motion_Profile.h"
+#include "Speed_Control.h"
+#include "Timebase.h"
+
+// TATOIM (Bit 0) in the IMR register, and TATOCINT (Bit 0) in the ICR register
+#define DEADMAN_TIMEOUT_INTERRUPT_BIT_MASK 0x01
+
+#define DEADMAN_CHECK_PERIOD_CYCLES TIMEBASE_US_TO_CYCLES(DEADMAN_CHECK_PERIOD_US)
+#define DEADMAN_RAMP_LIMIT_CYCLES TIMEBASE_MS_TO_CYCLES(DEADMAN_RAMP_LIMIT_MS)
+
+static volatile uint16_t deadman_timeout_ms;
+static volatile uint64_t deadline_cycles;
+
+// Trip in progress: the expired deadline, the time of the trip, and whether the motor is at rest
+static volatile uint8_t tripped;
+static uint8_t stopped;
+static uint64_t trip_deadline_cycles;
+static uint64_t trip_cycles;
+
+static Deadman_Statistics deadman_statistics;
+
+static uint32_t Cycles_To_US(uint64_t cycles)
+{
+	return (uint32_t)(cycles / TIMEBASE_CYCLES_PER_US);
+}
+
+// The motor is driven, ramping, or about to be driven by the speed controller
+static int Deadman_Vehicle_Moving(void)
+{
+	return (Motion_Profile_Get_Duty() != 0) || (Motion_Profile_Get_Target() != 0) || (Speed_Control_Get_Target() != 0);
+}
+
+static void Deadman_Restart(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	// The deadline is read by the handler in two halves
+	__disable_irq();
+	deadline_cycles = Timebase_Now_Cycles() + TIMEBASE_MS_TO_CYCLES(deadman_timeout_ms);
+	tripped = 0;
+	__set_PRIMASK(primask);
+}
+
+void Deadman_Init(void)
+{
+	Timebase_Init();
+	
+	deadman_timeout_ms = DEADMAN_TIMEOUT_MS;
+	stopped = 0;
+	deadman_statistics.trip_count = 0;
+	deadman_statistics.ramp_cut_count = 0;
+	deadman_statistics.max_detect_us = 0;
+	deadman_statistics.last_stop_us = 0;
+	deadman_statistics.max_stop_us = 0;
+	
+	Deadman_Restart();
+	
+	// Enable the clock to Timer 1 by setting the
+	// R1 bit (Bit 1) in the RCGCTIMER register
+	SYSCTL->RCGCTIMER |= 0x02;
+	
+	// Wait until Timer 1 is ready to be accessed
+	while ((SYSCTL->PRTIMER & 0x02) == 0);
+	
+	// Disable Timer A before configuration by clearing
+	// the TAEN bit (Bit 0) in the CTL register
+	TIMER1->CTL &= ~0x01;
+	
+	// Select the concatenated 32-bit timer configuration
+	// by writing 0x0 to the CFG register
+	TIMER1->CFG = 0x00;
+	
+	// Configure Timer A for periodic mode (TAMR = 0x2, Bits 1 to 0), counting down
+	TIMER1->TAMR = 0x02;
+	
+	// The counter reloads every DEADMAN_CHECK_PERIOD_US
+	TIMER1->TAILR = (uint32_t)DEADMAN_CHECK_PERIOD_CYCLES - 1;
+	
+	// Clear and enable the Timer A time-out interrupt
+	TIMER1->ICR = DEADMAN_TIMEOUT_INTERRUPT_BIT_MASK;
+	TIMER1->IMR |= DEADMAN_TIMEOUT_INTERRUPT_BIT_MASK;
+	
+	// The stop must not wait behind the sonar and motor ramp handlers
+	NVIC_SetPriority(TIMER1A_IRQn, 1);
+	NVIC_EnableIRQ(TIMER1A_IRQn);
+	
+	// Start counting by setting the TAEN bit (Bit 0) in the CTL register
+	TIMER1->CTL |= 0x01;
+}
+
+void Deadman_Feed(void)
+{
+	// A command after a trip releases the motor output
+	Vehicle_Link_Restored();
+	Deadman_Restart();
+}
+
+int Deadman_Set_Timeout(uint16_t timeout_ms)
+{
+	if (timeout_ms > DEADMAN_MAX_TIMEOUT_MS)
+	{
+		return 0;
+	}
+	
+	deadman_timeout_ms = timeout_ms;
+	Deadman_Restart();
+	
+	return 1;
+}
+
+uint16_t Deadman_Get_Timeout(void)
+{
+	return deadman_timeout_ms;
+}
+
+void Deadman_Get_Statistics(Deadman_Statistics *stats)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq();
+	*stats = deadman_statistics;
+	stats->tripped = tripped;
+	__set_PRIMASK(primask);
+}
+
+void TIMER1A_Handler(void)
+{
+	uint64_t now;
+	uint32_t latency_us;
+	
+	// Acknowledge the time-out interrupt by setting the TATOCINT bit (Bit 0) in the ICR register
+	TIMER1->ICR = DEADMAN_TIMEOUT_INTERRUPT_BIT_MASK;
+	
+	if (deadman_timeout_ms == 0)
+	{
+		return;
+	}
+	
+	now = Timebase_Now_Cycles();
+	
+	if (!tripped)
+	{
+		if ((now < deadline_cycles) || !Deadman_Vehicle_Moving())
+		{
+			return;
+		}
+		
+		// No command since the deadline: stop the vehicle
+		Vehicle_Link_Lost(DEADMAN_ACTION == DEADMAN_ACTION_CUT);
+		
+		tripped = 1;
+		stopped = 0;
+		trip_deadline_cycles = deadline_cycles;
+		trip_cycles = now;
+		
+		latency_us = Cycles_To_US(now - trip_deadline_cycles);
+		deadman_statistics.trip_count++;
+		
+		if (latency_us > deadman_statistics.max_detect_us)
+		{
+			deadman_statistics.max_detect_us = latency_us;
+		}
+	}
+	
+	if (stopped)
+	{
+		return;
+	}
+	
+	// A ramp that takes too long is cut
+	if ((Motion_Profile_Get_Duty() != 0) && ((now - trip_cycles) >= DEADMAN_RAMP_LIMIT_CYCLES))
+	{
+		Motion_Profile_Stop_Now();
+		deadman_statistics.ramp_cut_count++;
+	}
+	
+	// The stop holds once the motor is at rest and the speed controller can no longer drive it
+	if ((Motion_Profile_Get_Duty() == 0) && (Motion_Profile_Get_Target() == 0) && Speed_Control_Output_Held())
+	{
+		stopped = 1;
+		latency_us = Cycles_To_US(now - trip_deadline_cycles);
+		deadman_statistics.last_stop_us = latency_us;
+		
+		if (latency_us > deadman_statistics.max_stop_us)
+		{
+			deadman_statistics.max_stop_us = latency_us;
+		}
+	}
+}
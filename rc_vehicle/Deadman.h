@@ -0,0 +1,155 @@
+/**
+ * @file Deadman.h
+ *
+ * @brief Header file for the command link deadman.
+ *
+ * Every valid command feeds the deadman with Deadman_Feed: a recognized character command,
+ * or a frame accepted in framed mode (a PROTOCOL_PING is enough). When no command has arrived
+ * for the deadman timeout while the vehicle is moving, the deadman stops it with
+ * Vehicle_Link_Lost. The motor is ramped down by the motion profile (DEADMAN_ACTION_RAMP), or
+ * cut at once (DEADMAN_ACTION_CUT). A ramp that has not brought the motor to rest after
+ * DEADMAN_RAMP_LIMIT_MS is cut as well. The speed controller output is held at 0 until the
+ * next command, which clears the motion commanded before the loss and resumes normal control.
+ *
+ * The timeout is checked by the Timer 1A interrupt every DEADMAN_CHECK_PERIOD_US, not by a
+ * scheduler task, so the vehicle also stops when the scheduler loop is stuck (which the
+ * hardware watchdog then resets, see Watchdog.h). The worst-case stop latency, from the expiry
+ * of the timeout to a zero motor duty cycle, is therefore DEADMAN_CHECK_PERIOD_US with a cut,
+ * and DEADMAN_CHECK_PERIOD_US + DEADMAN_RAMP_LIMIT_MS with a ramp. The latencies are measured
+ * with the timebase at every trip (see Deadman_Statistics), to the resolution of the check period.
+ *
+ * @note The timing is derived from the system clock frequency (SYSTEM_CLOCK_HZ, see System_Clock.h).
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef DEADMAN_H
+#define DEADMAN_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief Default command timeout in milliseconds, 0 to disable the deadman.
+ * It can be changed at run time with Deadman_Set_Timeout (PROTOCOL_SET_DEADMAN).
+ */
+#ifndef DEADMAN_TIMEOUT_MS
+#define DEADMAN_TIMEOUT_MS 500
+#endif
+
+/**
+ * @brief Longest timeout accepted by Deadman_Set_Timeout, in milliseconds
+ */
+#define DEADMAN_MAX_TIMEOUT_MS 10000
+
+/**
+ * @brief Period of the Timer 1A interrupt that checks the timeout, in microseconds
+ */
+#define DEADMAN_CHECK_PERIOD_US 5000
+
+/**
+ * @brief Reaction to a lost link: ramp the motor down, or cut its output at once
+ */
+#define DEADMAN_ACTION_RAMP 0
+#define DEADMAN_ACTION_CUT  1
+
+#ifndef DEADMAN_ACTION
+#define DEADMAN_ACTION DEADMAN_ACTION_RAMP
+#endif
+
+/**
+ * @brief Longest time allowed to a ramp after a trip, in milliseconds, before the motor output
+ * is cut. The default ramp takes 400 ms from full speed (see Motion_Profile.h).
+ */
+#define DEADMAN_RAMP_LIMIT_MS 600
+
+/**
+ * @brief Deadman statistics since Deadman_Init.
+ */
+typedef struct
+{
+	/** Number of times the timeout expired while the vehicle was moving */
+	uint32_t trip_count;
+	
+	/** Number of ramps that were cut at DEADMAN_RAMP_LIMIT_MS */
+	uint32_t ramp_cut_count;
+	
+	/** Longest time from the expiry of the timeout to the stop command, in microseconds */
+	uint32_t max_detect_us;
+	
+	/** Stop latency of the latest trip: time from the expiry of the timeout to a zero duty cycle, in microseconds */
+	uint32_t last_stop_us;
+	
+	/** Longest stop latency, in microseconds */
+	uint32_t max_stop_us;
+	
+	/** 1 while the vehicle is stopped by the deadman, until the next command */
+	uint8_t tripped;
+} Deadman_Statistics;
+
+/**
+ * @brief The Deadman_Init function starts the deadman with DEADMAN_TIMEOUT_MS.
+ *
+ * It configures Timer 1A as a periodic timer and enables its interrupt. The first timeout
+ * starts at this call. Motion_Profile_Init, Speed_Control_Init and Vehicle_Control_Init must
+ * have been called before this function.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Deadman_Init(void);
+
+/**
+ * @brief The Deadman_Feed function records that a valid command has been received.
+ *
+ * It restarts the timeout, and ends a trip: the vehicle follows the commands again.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Deadman_Feed(void);
+
+/**
+ * @brief The Deadman_Set_Timeout function changes the command timeout.
+ *
+ * The new timeout starts at this call.
+ *
+ * @param timeout_ms Timeout in milliseconds, 0 to disable the deadman.
+ *
+ * @return 1 if the timeout was applied, 0 if it is above DEADMAN_MAX_TIMEOUT_MS.
+ */
+int Deadman_Set_Timeout(uint16_t timeout_ms);
+
+/**
+ * @brief The Deadman_Get_Timeout function returns the command timeout.
+ *
+ * @param None
+ *
+ * @return The timeout in milliseconds, 0 if the deadman is disabled.
+ */
+uint16_t Deadman_Get_Timeout(void);
+
+/**
+ * @brief The Deadman_Get_Statistics function copies the deadman statistics.
+ *
+ * @param stats Pointer to the structure that receives the statistics.
+ *
+ * @return None
+ */
+void Deadman_Get_Statistics(Deadman_Statistics *stats);
+
+/**
+ * @brief The TIMER1A_Handler function is the interrupt service routine of the deadman.
+ *
+ * It runs every DEADMAN_CHECK_PERIOD_US, stops the vehicle when the timeout has expired,
+ * and measures the stop latency.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void TIMER1A_Handler(void);
+
+#endif
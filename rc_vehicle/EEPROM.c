@@ -0,0 +1,121 @@
+/**
+ * @file EEPROM.c
+ *
+ * @brief Source code for the on-chip EEPROM driver.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "EEPROM.h"
+
+// WORKING bit (Bit 0) in the EEDONE register: an operation is in progress
+#define EEPROM_EEDONE_WORKING_BIT_MASK 0x01
+
+// NOPERM (Bit 4) and WRBUSY (Bit 5) bits in the EEDONE register: the last write failed
+#define EEPROM_EEDONE_ERROR_BIT_MASK 0x30
+
+// ERETRY (Bit 2) and PRETRY (Bit 3) bits in the EESUPP register: erase or programming must be retried
+#define EEPROM_EESUPP_RETRY_BIT_MASK 0x0C
+
+static void EEPROM_Wait_Done(void)
+{
+	while (EEPROM->EEDONE & EEPROM_EEDONE_WORKING_BIT_MASK);
+}
+
+// The module must not be accessed for 6 clock cycles after its clock is enabled or it is reset
+static void EEPROM_Wait_Ready(void)
+{
+	volatile int delay;
+	
+	for (delay = 0; delay < 6; delay++);
+	
+	// Wait until the EEPROM module is ready to be accessed
+	while ((SYSCTL->PREEPROM & 0x01) == 0);
+	
+	EEPROM_Wait_Done();
+}
+
+// Selects the block and the offset of a word for the following EERDWRINC accesses
+static void EEPROM_Seek(uint16_t word_address)
+{
+	EEPROM->EEBLOCK = word_address / EEPROM_BLOCK_WORDS;
+	EEPROM->EEOFFSET = word_address % EEPROM_BLOCK_WORDS;
+}
+
+int EEPROM_Init(void)
+{
+	// Enable the clock to the EEPROM module by setting the
+	// R0 bit (Bit 0) in the RCGCEEPROM register
+	SYSCTL->RCGCEEPROM |= 0x01;
+	
+	EEPROM_Wait_Ready();
+	
+	// A write interrupted by a reset may have left the module unable to recover
+	if (EEPROM->EESUPP & EEPROM_EESUPP_RETRY_BIT_MASK)
+	{
+		return 0;
+	}
+	
+	// Reset the module by setting, then clearing the R0 bit (Bit 0) in the SREEPROM register
+	SYSCTL->SREEPROM |= 0x01;
+	SYSCTL->SREEPROM &= ~0x01;
+	
+	EEPROM_Wait_Ready();
+	
+	return (EEPROM->EESUPP & EEPROM_EESUPP_RETRY_BIT_MASK) == 0;
+}
+
+int EEPROM_Read(uint16_t word_address, uint32_t *data, uint16_t count)
+{
+	uint16_t i;
+	
+	if ((uint32_t)word_address + count > EEPROM_SIZE_WORDS)
+	{
+		return 0;
+	}
+	
+	EEPROM_Seek(word_address);
+	
+	for (i = 0; i < count; i++)
+	{
+		// The offset wraps around within the block: the next block is selected explicitly
+		if ((i != 0) && (((word_address + i) % EEPROM_BLOCK_WORDS) == 0))
+		{
+			EEPROM_Seek(word_address + i);
+		}
+		
+		data[i] = EEPROM->EERDWRINC;
+	}
+	
+	return 1;
+}
+
+int EEPROM_Write(uint16_t word_address, const uint32_t *data, uint16_t count)
+{
+	uint16_t i;
+	
+	if ((uint32_t)word_address + count > EEPROM_SIZE_WORDS)
+	{
+		return 0;
+	}
+	
+	EEPROM_Seek(word_address);
+	
+	for (i = 0; i < count; i++)
+	{
+		if ((i != 0) && (((word_address + i) % EEPROM_BLOCK_WORDS) == 0))
+		{
+			EEPROM_Seek(word_address + i);
+		}
+		
+		EEPROM->EERDWRINC = data[i];
+		EEPROM_Wait_Done();
+		
+		if (EEPROM->EEDONE & EEPROM_EEDONE_ERROR_BIT_MASK)
+		{
+			return 0;
+		}
+	}
+	
+	return 1;
+}
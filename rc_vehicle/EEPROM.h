@@ -0,0 +1,73 @@
+/**
+ * @file EEPROM.h
+ *
+ * @brief Header file for the on-chip EEPROM driver.
+ *
+ * The TM4C123GH6PM has 2 KB of EEPROM, organized as EEPROM_BLOCK_COUNT blocks of
+ * EEPROM_BLOCK_WORDS 32-bit words. The driver addresses it as a flat array of words:
+ * reads and writes go through the auto-incrementing EERDWRINC register, so a sequence of
+ * words costs one register access per word, plus one block selection per block crossed.
+ *
+ * A word read is immediate. A word write takes the EEPROM module tens of microseconds, or
+ * a few milliseconds when it has to compact its internal copy buffer, and EEPROM_Write waits
+ * for each one: it is meant for occasional writes from thread context, such as saving a
+ * configuration, and never from an interrupt service routine.
+ *
+ * @note The EEPROM endurance is 500,000 writes per word.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief Size of a block in words, and number of blocks
+ */
+#define EEPROM_BLOCK_WORDS 16
+#define EEPROM_BLOCK_COUNT 32
+
+/**
+ * @brief Size of the EEPROM in words
+ */
+#define EEPROM_SIZE_WORDS (EEPROM_BLOCK_WORDS * EEPROM_BLOCK_COUNT)
+
+/**
+ * @brief The EEPROM_Init function enables the EEPROM module and checks that it is usable.
+ *
+ * This follows the initialization sequence of the EEPROM Initialization and Configuration
+ * section of the TM4C123G Microcontroller Datasheet: the module is reset once its clock is
+ * enabled, and it reports an error when a previous write was interrupted beyond recovery.
+ *
+ * @param None
+ *
+ * @return 1 if the EEPROM is ready, 0 if it reported an error.
+ */
+int EEPROM_Init(void);
+
+/**
+ * @brief The EEPROM_Read function reads consecutive words.
+ *
+ * @param word_address Index of the first word, from 0 to EEPROM_SIZE_WORDS - 1.
+ * @param data Pointer to the buffer that receives the words.
+ * @param count Number of words to read.
+ *
+ * @return 1 if the words were read, 0 if the range is outside the EEPROM.
+ */
+int EEPROM_Read(uint16_t word_address, uint32_t *data, uint16_t count);
+
+/**
+ * @brief The EEPROM_Write function writes consecutive words, and waits until they are stored.
+ *
+ * @param word_address Index of the first word, from 0 to EEPROM_SIZE_WORDS - 1.
+ * @param data Pointer to the words to write.
+ * @param count Number of words to write.
+ *
+ * @return 1 if the words were stored, 0 if the range is outside the EEPROM or a write failed.
+ */
+int EEPROM_Write(uint16_t word_address, const uint32_t *data, uint16_t count);
+
+#endif
@@ -0,0 +1,210 @@
+/**
+ * @file Idle.c
+ *
+ * @brief Source code for the idle sleep and CPU load accounting.
+ *
+ * The idle time is only updated from thread context (the scheduler loop and the blocking
+ * waits), so it needs no protection against the interrupt service routines.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Idle.h"
+#include "Timebase.h"
+#include "Trace.h"
+
+// Automatic Clock Gating (ACG) bit (Bit 27) in the RCC register
+#define IDLE_RCC_ACG_BIT_MASK 0x08000000
+
+// ENABLE (Bit 0), TICKINT (Bit 1) and CLKSOURCE (Bit 2, system clock) bits in the SysTick CTRL register
+#define IDLE_SYSTICK_START 0x07
+
+// The SysTick counter is 24 bits wide
+#define IDLE_SYSTICK_MAX_CYCLES 0x01000000UL
+
+// PENDSTCLR bit (Bit 25) and VECTACTIVE field (Bits 8 to 0) in the ICSR register
+#define IDLE_ICSR_PENDSTCLR_BIT_MASK 0x02000000
+#define IDLE_ICSR_VECTACTIVE_MASK 0x1FF
+
+// SLEEPDEEP bit (Bit 2) in the SCR register
+#define IDLE_SCR_SLEEPDEEP_BIT_MASK 0x04
+
+#define IDLE_MIN_SLEEP_CYCLES TIMEBASE_US_TO_CYCLES(IDLE_MIN_SLEEP_US)
+#define IDLE_LOAD_WINDOW_CYCLES TIMEBASE_MS_TO_CYCLES(IDLE_LOAD_WINDOW_MS)
+
+static uint64_t start_cycles;
+static uint64_t idle_cycles;
+static uint32_t sleep_count;
+
+// Current load window: its start, and the idle time already counted at that point
+static uint64_t window_start_cycles;
+static uint64_t window_start_idle_cycles;
+static uint16_t load_permille;
+static uint8_t load_valid;
+
+// The uDMA controller is clocked in run mode, and its clock enable in sleep mode (SCGCDMA)
+static uint8_t dma_enabled;
+static uint32_t sleep_dma_clock;
+
+static uint16_t Idle_Window_Load(uint64_t now)
+{
+	uint64_t window = now - window_start_cycles;
+	uint64_t idle = idle_cycles - window_start_idle_cycles;
+	
+	if (window == 0)
+	{
+		return 0;
+	}
+	
+	return (uint16_t)(1000 - ((idle * 1000) / window));
+}
+
+// Closes the load window once it is IDLE_LOAD_WINDOW_MS long
+static void Idle_Update_Load(uint64_t now)
+{
+	if ((now - window_start_cycles) < IDLE_LOAD_WINDOW_CYCLES)
+	{
+		return;
+	}
+	
+	load_permille = Idle_Window_Load(now);
+	load_valid = 1;
+	
+	window_start_cycles = now;
+	window_start_idle_cycles = idle_cycles;
+}
+
+void Idle_Init(void)
+{
+	Timebase_Init();
+	
+	// Keep the peripherals that run on their own clocked in sleep mode by copying their
+	// run mode clock enables (RCGC registers) to the sleep mode ones (SCGC registers).
+	// The other peripherals are stopped while the CPU sleeps
+	SYSCTL->SCGCWD = SYSCTL->RCGCWD;
+	SYSCTL->SCGCTIMER = SYSCTL->RCGCTIMER;
+	SYSCTL->SCGCWTIMER = SYSCTL->RCGCWTIMER;
+	SYSCTL->SCGCGPIO = SYSCTL->RCGCGPIO;
+	SYSCTL->SCGCUART = SYSCTL->RCGCUART;
+	SYSCTL->SCGCPWM = SYSCTL->RCGCPWM;
+	SYSCTL->SCGCQEI = SYSCTL->RCGCQEI;
+	
+	// The uDMA controller is only clocked in sleep mode while a transfer is in progress
+	dma_enabled = (uint8_t)(SYSCTL->RCGCDMA & 0x01);
+	sleep_dma_clock = 0;
+	SYSCTL->SCGCDMA = 0;
+	
+	// Apply the SCGC registers in sleep mode by setting the ACG bit (Bit 27) in the RCC register
+	SYSCTL->RCC |= IDLE_RCC_ACG_BIT_MASK;
+	
+	// WFI enters sleep mode, not deep sleep mode: clear the SLEEPDEEP bit (Bit 2) in the SCR register
+	SCB->SCR &= ~IDLE_SCR_SLEEPDEEP_BIT_MASK;
+	
+	// The SysTick timer is stopped until a sleep arms it. Its interrupt only wakes the CPU,
+	// so it gets the lowest priority
+	SysTick->CTRL = 0;
+	NVIC_SetPriority(SysTick_IRQn, 7);
+	
+	idle_cycles = 0;
+	sleep_count = 0;
+	load_permille = 0;
+	load_valid = 0;
+	start_cycles = Timebase_Now_Cycles();
+	window_start_cycles = start_cycles;
+	window_start_idle_cycles = 0;
+}
+
+uint64_t Idle_Sleep_Until(uint64_t wake_cycles)
+{
+	uint64_t now = Timebase_Now_Cycles();
+	uint64_t wake;
+	uint32_t dma_clock;
+	
+	if ((wake_cycles != IDLE_NO_WAKEUP) && (wake_cycles < (now + IDLE_MIN_SLEEP_CYCLES)))
+	{
+		return now;
+	}
+	
+	// Arm the SysTick timer with the time left until the wake-up. A longer sleep is
+	// cut into 24-bit intervals: the caller finds nothing to do and sleeps again
+	if (wake_cycles != IDLE_NO_WAKEUP)
+	{
+		uint64_t interval = wake_cycles - now;
+		
+		if (interval > IDLE_SYSTICK_MAX_CYCLES)
+		{
+			interval = IDLE_SYSTICK_MAX_CYCLES;
+		}
+		
+		SysTick->LOAD = (uint32_t)interval - 1;
+		SysTick->VAL = 0;
+		SysTick->CTRL = IDLE_SYSTICK_START;
+	}
+	
+	// Keep the uDMA controller clocked in sleep mode only while one of its channels is enabled
+	dma_clock = (dma_enabled && (UDMA->ENASET != 0)) ? 0x01 : 0x00;
+	
+	if (dma_clock != sleep_dma_clock)
+	{
+		SYSCTL->SCGCDMA = dma_clock;
+		sleep_dma_clock = dma_clock;
+	}
+	
+	TRACE(TRACE_IDLE_BEGIN, 0);
+	__WFI();
+	TRACE(TRACE_IDLE_END, 0);
+	
+	// Stop the SysTick timer, and drop its interrupt if it has not been taken yet
+	// by setting the PENDSTCLR bit (Bit 25) in the ICSR register
+	SysTick->CTRL = 0;
+	SCB->ICSR = IDLE_ICSR_PENDSTCLR_BIT_MASK;
+	
+	wake = Timebase_Now_Cycles();
+	idle_cycles += wake - now;
+	sleep_count++;
+	
+	Idle_Update_Load(wake);
+	
+	return wake;
+}
+
+void Idle_Wait_Until(uint64_t deadline)
+{
+	// In an interrupt service routine (VECTACTIVE is not 0) or with the interrupts disabled,
+	// the interrupts cannot be served while waiting: spin instead
+	if ((SCB->ICSR & IDLE_ICSR_VECTACTIVE_MASK) || __get_PRIMASK())
+	{
+		while (!Timebase_Deadline_Expired(deadline));
+		return;
+	}
+	
+	while (!Timebase_Deadline_Expired(deadline))
+	{
+		__disable_irq();
+		Idle_Sleep_Until(deadline);
+		__enable_irq();
+	}
+}
+
+uint16_t Idle_Get_Load_Permille(void)
+{
+	uint64_t now = Timebase_Now_Cycles();
+	
+	Idle_Update_Load(now);
+	
+	// Until the first window is complete, report the part of it that has elapsed
+	return load_valid ? load_permille : Idle_Window_Load(now);
+}
+
+void Idle_Get_Statistics(Idle_Statistics *stats)
+{
+	stats->load_permille = Idle_Get_Load_Permille();
+	stats->idle_cycles = idle_cycles;
+	stats->total_cycles = Timebase_Now_Cycles() - start_cycles;
+	stats->sleep_count = sleep_count;
+}
+
+void SysTick_Handler(void)
+{
+	// Nothing to do: the interrupt has already woken the CPU
+}
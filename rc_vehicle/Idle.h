@@ -0,0 +1,134 @@
+/**
+ * @file Idle.h
+ *
+ * @brief Header file for the idle sleep and CPU load accounting.
+ *
+ * When the scheduler finds no released task, it puts the CPU to sleep with WFI until the
+ * next periodic release or the next interrupt, whichever comes first (see Scheduler_Run).
+ * The blocking waits (SysTick_Delay1us, SysTick_Delay1ms and UART0_Input_Character) sleep
+ * in the same way instead of spinning.
+ *
+ * The SysTick timer is the wake-up timer: it is armed with the time left until the wake-up
+ * before each WFI, and stopped again after it. Waits shorter than IDLE_MIN_SLEEP_US are spun.
+ *
+ * While the CPU sleeps, only the peripherals that keep running on their own (the timers,
+ * GPIO ports, UART, PWM, QEI and watchdog modules enabled by the drivers) are clocked. The
+ * uDMA controller is only clocked while a transfer is in progress, and all the other
+ * peripherals are gated (RCC ACG bit and SCGC registers).
+ *
+ * The time spent asleep is measured with the timebase (see Timebase.h), which gives the CPU
+ * load: the share of the time the CPU was awake, over windows of IDLE_LOAD_WINDOW_MS.
+ *
+ * @note Idle_Init must be called after the drivers have enabled their peripheral clocks.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef IDLE_H
+#define IDLE_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief Wake-up time given to Idle_Sleep_Until to sleep until the next interrupt, with no timeout
+ */
+#define IDLE_NO_WAKEUP 0xFFFFFFFFFFFFFFFFULL
+
+/**
+ * @brief Shortest wait, in microseconds, for which the CPU goes to sleep
+ */
+#define IDLE_MIN_SLEEP_US 5
+
+/**
+ * @brief Length of the CPU load measurement window in milliseconds
+ */
+#define IDLE_LOAD_WINDOW_MS 1000
+
+/**
+ * @brief Sleep statistics since Idle_Init.
+ */
+typedef struct
+{
+	/** Time spent asleep, in system clock cycles */
+	uint64_t idle_cycles;
+	
+	/** Time since Idle_Init, in system clock cycles */
+	uint64_t total_cycles;
+	
+	/** Number of times the CPU went to sleep */
+	uint32_t sleep_count;
+	
+	/** CPU load over the last complete window, in 1/1000 */
+	uint16_t load_permille;
+} Idle_Statistics;
+
+/**
+ * @brief The Idle_Init function prepares the sleep mode and starts the load accounting.
+ *
+ * It selects the sleep mode clock gating (ACG) and copies the run mode clock enables of the
+ * peripherals that must keep running in sleep to the SCGC registers.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Idle_Init(void);
+
+/**
+ * @brief The Idle_Sleep_Until function puts the CPU to sleep until an interrupt or a wake-up time.
+ *
+ * It must be called with interrupts disabled (__disable_irq), right after the caller has
+ * checked that there is nothing to do: an interrupt raised after that check still wakes the
+ * CPU, and its handler runs once the caller enables interrupts again. If the wake-up time is
+ * less than IDLE_MIN_SLEEP_US away, the function returns at once.
+ *
+ * @param wake_cycles Timebase count at which to wake up, or IDLE_NO_WAKEUP.
+ *
+ * @return The timebase count when the CPU woke up.
+ */
+uint64_t Idle_Sleep_Until(uint64_t wake_cycles);
+
+/**
+ * @brief The Idle_Wait_Until function waits until a timebase count is reached, sleeping in the meantime.
+ *
+ * The interrupts are served while waiting. In an interrupt service routine, the function
+ * spins instead, since only a higher priority interrupt could wake the CPU.
+ *
+ * @param deadline Timebase count to wait for.
+ *
+ * @return None
+ */
+void Idle_Wait_Until(uint64_t deadline);
+
+/**
+ * @brief The Idle_Get_Load_Permille function returns the CPU load.
+ *
+ * @param None
+ *
+ * @return The share of the last complete IDLE_LOAD_WINDOW_MS window during which the CPU
+ *         was awake, in 1/1000.
+ */
+uint16_t Idle_Get_Load_Permille(void);
+
+/**
+ * @brief The Idle_Get_Statistics function copies the sleep statistics.
+ *
+ * @param stats Pointer to the structure that receives the statistics.
+ *
+ * @return None
+ */
+void Idle_Get_Statistics(Idle_Statistics *stats);
+
+/**
+ * @brief The SysTick_Handler function is the interrupt service routine for the SysTick timer.
+ *
+ * The SysTick interrupt only wakes the CPU at the end of a sleep; the handler has nothing to do.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void SysTick_Handler(void);
+
+#endif
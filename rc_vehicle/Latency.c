@@ -0,0 +1,334 @@
+/**
+ * @file Latency.c
+ *
+ * @brief Source code for the command-to-actuation latency instrumentation.
+ *
+ * All the functions except Latency_Init, Latency_Reset and Latency_Motor_Written are called
+ * from the main loop tasks only, and only the tasks update the histograms, so they need no
+ * protection against interrupts. Latency_Motor_Written runs in the PWM0_0 interrupt: it shares
+ * the motor_* state with the tasks, which change it with the interrupts disabled.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Latency.h"
+#include "Timebase.h"
+#include "UART0.h"
+
+// Histogram buckets: values below 8 cycles have one bucket each, then every power of two
+// from 2^3 to 2^31 is split into 8 buckets
+#define LATENCY_SUB_BUCKETS 8
+#define LATENCY_BUCKET_COUNT ((32 - 2) * LATENCY_SUB_BUCKETS)
+
+// Trace Enable bit (Bit 24) in the DEMCR register, and CYCCNTENA bit (Bit 0) in the DWT CTRL register
+#define LATENCY_DEMCR_TRCENA_BIT_MASK  0x01000000
+#define LATENCY_DWT_CYCCNTENA_BIT_MASK 0x00000001
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t min_cycles;
+	uint32_t max_cycles;
+	uint64_t sum_cycles;
+	uint16_t buckets[LATENCY_BUCKET_COUNT];
+} Latency_Histogram;
+
+static const char *const stage_names[LATENCY_STAGE_COUNT] = { "parse", "dispatch", "write", "motor", "total" };
+
+static Latency_Histogram histograms[LATENCY_STAGE_COUNT];
+
+// Receive timestamp of the byte being decoded
+static uint32_t current_rx_cycles;
+
+// Timestamps of the command waiting to be applied
+static uint8_t command_pending;
+static uint8_t command_dispatched;
+static uint32_t command_rx_cycles;
+static uint32_t command_parse_cycles;
+static uint32_t command_dispatch_cycles;
+
+// Motor write of the latest command that changed the speed target
+typedef enum
+{
+	LATENCY_MOTOR_IDLE = 0,
+	LATENCY_MOTOR_HANDED,         // handed to the speed controller
+	LATENCY_MOTOR_TARGET_SET,     // duty cycle target handed to the motion profile
+	LATENCY_MOTOR_WRITTEN         // motor register written, waiting to be recorded
+} Latency_Motor_State;
+
+static volatile uint8_t motor_state;
+static uint32_t motor_rx_cycles;
+static uint32_t motor_handoff_cycles;
+static uint32_t motor_write_cycles;
+
+static uint32_t Latency_Bucket(uint32_t cycles)
+{
+	uint32_t exponent = 31;
+	
+	if (cycles < LATENCY_SUB_BUCKETS)
+	{
+		return cycles;
+	}
+	
+	while ((cycles & (1UL << exponent)) == 0)
+	{
+		exponent--;
+	}
+	
+	// The 3 bits below the leading one select the bucket within the power of two
+	return (exponent - 2) * LATENCY_SUB_BUCKETS + ((cycles >> (exponent - 3)) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+// Largest value that falls into a bucket
+static uint32_t Latency_Bucket_Limit(uint32_t bucket)
+{
+	uint32_t exponent;
+	uint32_t sub_bucket;
+	
+	if (bucket < LATENCY_SUB_BUCKETS)
+	{
+		return bucket;
+	}
+	
+	exponent = bucket / LATENCY_SUB_BUCKETS + 2;
+	sub_bucket = bucket % LATENCY_SUB_BUCKETS;
+	
+	return (uint32_t)((((uint64_t)(LATENCY_SUB_BUCKETS + sub_bucket + 1)) << (exponent - 3)) - 1);
+}
+
+static void Latency_Record(Latency_Stage stage, uint32_t cycles)
+{
+	Latency_Histogram *histogram = &histograms[stage];
+	uint32_t bucket = Latency_Bucket(cycles);
+	
+	if ((histogram->count == 0) || (cycles < histogram->min_cycles))
+	{
+		histogram->min_cycles = cycles;
+	}
+	
+	if (cycles > histogram->max_cycles)
+	{
+		histogram->max_cycles = cycles;
+	}
+	
+	histogram->count++;
+	histogram->sum_cycles += cycles;
+	
+	// Saturate instead of wrapping, so that a busy bucket cannot hide the others
+	if (histogram->buckets[bucket] < 0xFFFF)
+	{
+		histogram->buckets[bucket]++;
+	}
+}
+
+// Prints a number of cycles as microseconds with two decimals
+static void Latency_Output_US(uint32_t cycles)
+{
+	uint32_t hundredths = (uint32_t)(((uint64_t)cycles * 100U) / TIMEBASE_CYCLES_PER_US);
+	
+	UART0_Output_Unsigned_Decimal(hundredths / 100);
+	UART0_Output_Character('.');
+	UART0_Output_Character((char)('0' + (hundredths / 10) % 10));
+	UART0_Output_Character((char)('0' + hundredths % 10));
+}
+
+// Records the motor and total latencies of a command whose motor register was written
+static void Latency_Motor_Record(void)
+{
+	if (motor_state != LATENCY_MOTOR_WRITTEN)
+	{
+		return;
+	}
+	
+	Latency_Record(LATENCY_STAGE_MOTOR, motor_write_cycles - motor_handoff_cycles);
+	Latency_Record(LATENCY_STAGE_TOTAL, motor_write_cycles - motor_rx_cycles);
+	
+	motor_state = LATENCY_MOTOR_IDLE;
+}
+
+void Latency_Init(void)
+{
+	// Power the DWT unit by setting the TRCENA bit (Bit 24) in the DEMCR register
+	CoreDebug->DEMCR |= LATENCY_DEMCR_TRCENA_BIT_MASK;
+	
+	// Start the cycle counter from 0 by clearing the CYCCNT register and then
+	// setting the CYCCNTENA bit (Bit 0) in the DWT CTRL register
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= LATENCY_DWT_CYCCNTENA_BIT_MASK;
+	
+	Latency_Reset();
+}
+
+void Latency_Set_RX_Timestamp(uint32_t rx_cycles)
+{
+	current_rx_cycles = rx_cycles;
+}
+
+void Latency_Command_Parsed(void)
+{
+	command_rx_cycles = current_rx_cycles;
+	command_parse_cycles = LATENCY_NOW_CYCLES();
+	command_dispatched = 0;
+	command_pending = 1;
+}
+
+void Latency_Command_Dispatched(void)
+{
+	Latency_Motor_Record();
+	
+	if (command_pending && !command_dispatched)
+	{
+		command_dispatch_cycles = LATENCY_NOW_CYCLES();
+		command_dispatched = 1;
+	}
+}
+
+void Latency_Command_Applied(uint8_t speed_target_changed)
+{
+	uint32_t write_cycles = LATENCY_NOW_CYCLES();
+	uint32_t primask;
+	
+	if (!command_pending || !command_dispatched)
+	{
+		return;
+	}
+	
+	// The counter is 32 bits wide, so the unsigned differences are correct across a wrap
+	Latency_Record(LATENCY_STAGE_PARSE, command_parse_cycles - command_rx_cycles);
+	Latency_Record(LATENCY_STAGE_DISPATCH, command_dispatch_cycles - command_parse_cycles);
+	Latency_Record(LATENCY_STAGE_WRITE, write_cycles - command_dispatch_cycles);
+	
+	command_pending = 0;
+	
+	if (!speed_target_changed)
+	{
+		Latency_Record(LATENCY_STAGE_TOTAL, write_cycles - command_rx_cycles);
+		return;
+	}
+	
+	// A motor write still waiting for the previous command is no longer of interest
+	primask = __get_PRIMASK();
+	__disable_irq();
+	motor_rx_cycles = command_rx_cycles;
+	motor_handoff_cycles = write_cycles;
+	motor_state = LATENCY_MOTOR_HANDED;
+	__set_PRIMASK(primask);
+}
+
+void Latency_Motor_Target_Set(uint8_t write_pending)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq();
+	
+	if (motor_state == LATENCY_MOTOR_HANDED)
+	{
+		motor_state = write_pending ? LATENCY_MOTOR_TARGET_SET : LATENCY_MOTOR_IDLE;
+	}
+	
+	__set_PRIMASK(primask);
+}
+
+void Latency_Motor_Written(void)
+{
+	if (motor_state == LATENCY_MOTOR_TARGET_SET)
+	{
+		motor_write_cycles = LATENCY_NOW_CYCLES();
+		motor_state = LATENCY_MOTOR_WRITTEN;
+	}
+}
+
+void Latency_Command_Discarded(void)
+{
+	command_pending = 0;
+}
+
+void Latency_Get_Summary(Latency_Stage stage, Latency_Summary *summary)
+{
+	const Latency_Histogram *histogram = &histograms[stage];
+	uint32_t threshold;
+	uint32_t seen = 0;
+	uint32_t bucket;
+	
+	summary->count = histogram->count;
+	summary->min_cycles = histogram->min_cycles;
+	summary->max_cycles = histogram->max_cycles;
+	summary->avg_cycles = (histogram->count > 0) ? (uint32_t)(histogram->sum_cycles / histogram->count) : 0;
+	summary->p99_cycles = 0;
+	
+	if (histogram->count == 0)
+	{
+		return;
+	}
+	
+	// Smallest bucket that holds at least 99% of the samples, rounded up
+	threshold = histogram->count - histogram->count / 100;
+	
+	for (bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++)
+	{
+		seen += histogram->buckets[bucket];
+		
+		if (seen >= threshold)
+		{
+			break;
+		}
+	}
+	
+	// The last bucket may be cut short by saturated counts; the maximum is then a tighter bound
+	summary->p99_cycles = (bucket < LATENCY_BUCKET_COUNT) ? Latency_Bucket_Limit(bucket) : histogram->max_cycles;
+	
+	if (summary->p99_cycles > histogram->max_cycles)
+	{
+		summary->p99_cycles = histogram->max_cycles;
+	}
+}
+
+void Latency_Reset(void)
+{
+	uint32_t stage;
+	uint32_t bucket;
+	
+	for (stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+	{
+		histograms[stage].count = 0;
+		histograms[stage].min_cycles = 0;
+		histograms[stage].max_cycles = 0;
+		histograms[stage].sum_cycles = 0;
+		
+		for (bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++)
+		{
+			histograms[stage].buckets[bucket] = 0;
+		}
+	}
+	
+	command_pending = 0;
+	motor_state = LATENCY_MOTOR_IDLE;
+}
+
+void Latency_Print(void)
+{
+	Latency_Summary summary;
+	int stage;
+	
+	Latency_Motor_Record();
+	
+	UART0_Output_String("stage count min_us avg_us max_us p99_us\r\n");
+	
+	for (stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+	{
+		Latency_Get_Summary((Latency_Stage)stage, &summary);
+		
+		UART0_Output_String((char *)stage_names[stage]);
+		UART0_Output_Character(' ');
+		UART0_Output_Unsigned_Decimal(summary.count);
+		UART0_Output_Character(' ');
+		Latency_Output_US(summary.min_cycles);
+		UART0_Output_Character(' ');
+		Latency_Output_US(summary.avg_cycles);
+		UART0_Output_Character(' ');
+		Latency_Output_US(summary.max_cycles);
+		UART0_Output_Character(' ');
+		Latency_Output_US(summary.p99_cycles);
+		UART0_Output_Newline();
+	}
+}
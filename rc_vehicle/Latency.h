@@ -0,0 +1,205 @@
+/**
+ * @file Latency.h
+ *
+ * @brief Header file for the command-to-actuation latency instrumentation.
+ *
+ * Every command that changes the motor or steering outputs is timestamped with the
+ * DWT cycle counter (CYCCNT) at these points:
+ *
+ * - RX: the command's last byte reached the UART0 receive FIFO. It is taken by UART0_Handler;
+ *   when the interrupt was raised by the receive timeout, the timestamp is moved back by
+ *   the receive timeout (32 bit periods), the time the byte waited in the FIFO before the timeout fired.
+ * - parse: the command was decoded and handed to Vehicle_Control (Latency_Command_Parsed).
+ * - dispatch: the actuation task started to apply it (Latency_Command_Dispatched).
+ * - write: the actuation task has written the steering PWM register and handed the new speed
+ *   target to the speed controller (Latency_Command_Applied).
+ * - motor: for a command that changed the speed target, the first write of the motor PWM
+ *   register (PWM0CMPA, in Motion_Profile_Output) after the speed task has handed the new
+ *   duty cycle target to the motion profile. It includes the wait for the next encoder sample
+ *   (up to one speed period) and for the next PWM period. The rest of the motor ramp is not
+ *   included.
+ *
+ * The intervals between them are accumulated in one histogram per stage, plus one for the
+ * total from RX to the last register write (the motor register for a speed change, else the
+ * steering register), and can be printed over UART0 with Latency_Print ('L' command).
+ * Commands that do not change any register (e.g. a repeated 'A') are not recorded.
+ *
+ * The motor write is taken in the PWM0_0 interrupt, which only stores its timestamp: the
+ * histograms are updated by the actuation task, at its next run, or by Latency_Print.
+ *
+ * The histograms have 8 buckets per power of two, so the reported p99 is an upper bound
+ * that is at most 12.5% above the true value. Minimum, average and maximum are exact.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief Current value of the DWT cycle counter, for timestamps taken by other drivers
+ */
+#define LATENCY_NOW_CYCLES() (DWT->CYCCNT)
+
+/**
+ * @brief Latency stages
+ */
+typedef enum
+{
+	LATENCY_STAGE_PARSE,      // RX to parse: receive FIFO, ring buffer and command task wait, decoding
+	LATENCY_STAGE_DISPATCH,   // parse to dispatch: wait for the actuation task
+	LATENCY_STAGE_WRITE,      // dispatch to write: steering register and speed target updates
+	LATENCY_STAGE_MOTOR,      // write to motor: speed task, motion profile and PWM period wait
+	LATENCY_STAGE_TOTAL,      // RX to the last register write
+	LATENCY_STAGE_COUNT
+} Latency_Stage;
+
+/**
+ * @brief Summary of one latency stage, in system clock cycles.
+ */
+typedef struct
+{
+	/** Number of recorded commands */
+	uint32_t count;
+	
+	/** Shortest, average and longest latency */
+	uint32_t min_cycles;
+	uint32_t avg_cycles;
+	uint32_t max_cycles;
+	
+	/** 99th percentile, rounded up to the end of its histogram bucket */
+	uint32_t p99_cycles;
+} Latency_Summary;
+
+/**
+ * @brief The Latency_Init function starts the DWT cycle counter and clears the histograms.
+ *
+ * It sets the TRCENA bit in the DEMCR register, which powers the DWT unit, and then
+ * enables CYCCNT.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Latency_Init(void);
+
+/**
+ * @brief The Latency_Set_RX_Timestamp function selects the receive timestamp of the byte being decoded.
+ *
+ * It is called by the command task before it hands each received byte to a parser.
+ *
+ * @param rx_cycles The CYCCNT value at which the byte was received (see UART0_Read_Timestamped).
+ *
+ * @return None
+ */
+void Latency_Set_RX_Timestamp(uint32_t rx_cycles);
+
+/**
+ * @brief The Latency_Command_Parsed function records that a command has been decoded.
+ *
+ * The receive timestamp is the one of the last byte given to Latency_Set_RX_Timestamp.
+ * A command that is parsed while the previous one has not been applied yet replaces it.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Latency_Command_Parsed(void);
+
+/**
+ * @brief The Latency_Command_Dispatched function records that the actuation task has started.
+ *
+ * It has no effect when no command is waiting to be applied.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Latency_Command_Dispatched(void);
+
+/**
+ * @brief The Latency_Command_Applied function records the end of the writes of the actuation task.
+ *
+ * The parse, dispatch and write latencies of the command are added to the histograms. When the
+ * command changed the speed target, the motor and total latencies are recorded once the motor
+ * register has been written (see Latency_Motor_Target_Set and Latency_Motor_Written);
+ * otherwise the total latency is recorded now.
+ *
+ * @param speed_target_changed 1 if the command handed a new target to the speed controller.
+ *
+ * @return None
+ */
+void Latency_Command_Applied(uint8_t speed_target_changed);
+
+/**
+ * @brief The Latency_Motor_Target_Set function records that the speed task has handed a duty
+ * cycle target to the motion profile.
+ *
+ * It is called by the speed task. The first one after Latency_Command_Applied carries the
+ * target of the command. If the motion profile is already at that duty cycle, no motor
+ * register write follows, and the motor latency of the command is not recorded.
+ *
+ * @param write_pending 1 if the motion profile has to write the motor register to reach the target.
+ *
+ * @return None
+ */
+void Latency_Motor_Target_Set(uint8_t write_pending);
+
+/**
+ * @brief The Latency_Motor_Written function records a write of the motor PWM register.
+ *
+ * It is called by Motion_Profile_Output, from the PWM0_0 interrupt, and only stores the
+ * timestamp of the first write after Latency_Motor_Target_Set.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Latency_Motor_Written(void);
+
+/**
+ * @brief The Latency_Command_Discarded function forgets the waiting command.
+ *
+ * It is called by the actuation task when the command did not change any register.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Latency_Command_Discarded(void);
+
+/**
+ * @brief The Latency_Get_Summary function computes the summary of one stage.
+ *
+ * @param stage The stage to summarize.
+ * @param summary Pointer to the structure that receives the summary.
+ *
+ * @return None
+ */
+void Latency_Get_Summary(Latency_Stage stage, Latency_Summary *summary);
+
+/**
+ * @brief The Latency_Reset function clears the histograms.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Latency_Reset(void);
+
+/**
+ * @brief The Latency_Print function prints the summary of every stage to UART0.
+ *
+ * Each line holds the stage name, the count and the min, avg, max and p99 latencies
+ * in microseconds with two decimals.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Latency_Print(void);
+
+#endif
@@ -0,0 +1,386 @@
+/**
+ * @file Maneuver.c
+ *
+ * @brief Source code for the on-board timed maneuver scripts.
+ *
+ * The running state is shared between the Timer 2A interrupt service routine, which owns the
+ * step sequence, and the application, which starts and aborts scripts with the interrupts
+ * disabled.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Maneuver.h"
+#include "Vehicle_Control.h"
+#include "Scheduler.h"
+#include "Deadman.h"
+#include "Timebase.h"
+
+// TATOIM (Bit 0) in the IMR register, and TATOCINT (Bit 0) in the ICR register
+#define MANEUVER_TIMEOUT_INTERRUPT_BIT_MASK 0x01
+
+// TAEN bit (Bit 0) in the CTL register
+#define MANEUVER_CTL_TAEN_BIT_MASK 0x01
+
+// Value of maneuver_condition_step when no distance condition is met
+#define MANEUVER_NO_CONDITION 0xFF
+
+// Shortest interval loaded into the timer, so that a boundary already reached still raises the interrupt
+#define MANEUVER_MIN_ARM_CYCLES TIMEBASE_CYCLES_PER_US
+
+// The stored script
+static Maneuver_Step maneuver_steps[MANEUVER_MAX_STEPS];
+static uint8_t maneuver_step_count;
+
+// Running script: the current step, and the timebase count at which it ends
+static volatile uint8_t maneuver_running;
+static volatile uint8_t maneuver_current_step;
+static uint64_t maneuver_boundary_cycles;
+static uint8_t maneuver_has_boundary;
+
+// Step whose distance condition was met, set by the maneuver task for the interrupt
+static volatile uint8_t maneuver_condition_step;
+
+// Obstacle stop count of the vehicle when the script started
+static uint32_t maneuver_obstacle_stops;
+
+static Maneuver_Report maneuver_report;
+static volatile uint8_t maneuver_report_pending;
+
+static Maneuver_Statistics maneuver_statistics;
+
+// Loads the one-shot timer with the time left to the boundary, at most its 32-bit range
+static void Maneuver_Arm(uint64_t boundary_cycles)
+{
+	uint64_t now = Timebase_Now_Cycles();
+	uint64_t interval = (boundary_cycles > now) ? (boundary_cycles - now) : 0;
+	
+	if (interval < MANEUVER_MIN_ARM_CYCLES)
+	{
+		interval = MANEUVER_MIN_ARM_CYCLES;
+	}
+	else if (interval > 0xFFFFFFFF)
+	{
+		interval = 0xFFFFFFFF;
+	}
+	
+	TIMER2->CTL &= ~MANEUVER_CTL_TAEN_BIT_MASK;
+	TIMER2->TAILR = (uint32_t)interval - 1;
+	TIMER2->CTL |= MANEUVER_CTL_TAEN_BIT_MASK;
+}
+
+// Called with the interrupts disabled, or from the interrupt service routine
+static void Maneuver_Finish(Maneuver_Result result)
+{
+	TIMER2->CTL &= ~MANEUVER_CTL_TAEN_BIT_MASK;
+	
+	maneuver_running = 0;
+	maneuver_condition_step = MANEUVER_NO_CONDITION;
+	
+	Vehicle_Script_Step(0, 0);
+	
+	maneuver_report.result = result;
+	maneuver_report_pending = 1;
+}
+
+// Applies the current step, which starts at start_cycles
+static void Maneuver_Begin_Step(uint64_t start_cycles)
+{
+	const Maneuver_Step *step;
+	
+	if (maneuver_current_step >= maneuver_step_count)
+	{
+		Maneuver_Finish(MANEUVER_RESULT_COMPLETED);
+		return;
+	}
+	
+	step = &maneuver_steps[maneuver_current_step];
+	
+	Vehicle_Script_Step(step->throttle_percent, step->steering_deg);
+	
+	maneuver_report.steps_run = maneuver_current_step + 1;
+	maneuver_statistics.step_count++;
+	
+	// A step without duration only ends on its distance condition
+	maneuver_has_boundary = (step->duration_ms != 0);
+	
+	if (maneuver_has_boundary)
+	{
+		maneuver_boundary_cycles = start_cycles + TIMEBASE_MS_TO_CYCLES(step->duration_ms);
+		Maneuver_Arm(maneuver_boundary_cycles);
+	}
+	else
+	{
+		TIMER2->CTL &= ~MANEUVER_CTL_TAEN_BIT_MASK;
+	}
+}
+
+// The filtered front distance is below the limit, or the echo of a near obstacle was lost
+static int Maneuver_Distance_Below(const Vehicle_Status *status, uint16_t limit_cm)
+{
+	if (status->sonar_state == SONAR_FILTER_LOST)
+	{
+		return 1;
+	}
+	
+	if ((status->sonar_state != SONAR_FILTER_TRACKING) && (status->sonar_state != SONAR_FILTER_COASTING))
+	{
+		return 0;
+	}
+	
+	return status->distance_cm < limit_cm;
+}
+
+static void Maneuver_Task(void)
+{
+	Vehicle_Status status;
+	uint8_t index;
+	uint32_t primask;
+	
+	if (!maneuver_running)
+	{
+		return;
+	}
+	
+	// The script stands in for the operator, who sends no command while it runs
+	Deadman_Feed();
+	
+	Vehicle_Get_Status(&status);
+	
+	// The sonar task stopped the vehicle in front of an obstacle: the script cannot go on
+	if (status.obstacle_stop_count != maneuver_obstacle_stops)
+	{
+		primask = __get_PRIMASK();
+		__disable_irq();
+		
+		if (maneuver_running)
+		{
+			Maneuver_Finish(MANEUVER_RESULT_OBSTACLE);
+		}
+		
+		__set_PRIMASK(primask);
+		return;
+	}
+	
+	// If the interrupt advances the step in the meantime, the condition no longer matches it and is ignored
+	index = maneuver_current_step;
+	
+	if (index >= maneuver_step_count)
+	{
+		return;
+	}
+	
+	if ((maneuver_steps[index].until_distance_cm != 0) && Maneuver_Distance_Below(&status, maneuver_steps[index].until_distance_cm))
+	{
+		maneuver_condition_step = index;
+		NVIC_SetPendingIRQ(TIMER2A_IRQn);
+	}
+}
+
+void Maneuver_Init(void)
+{
+	Timebase_Init();
+	
+	maneuver_step_count = 0;
+	maneuver_running = 0;
+	maneuver_current_step = 0;
+	maneuver_has_boundary = 0;
+	maneuver_condition_step = MANEUVER_NO_CONDITION;
+	maneuver_report_pending = 0;
+	maneuver_statistics.run_count = 0;
+	maneuver_statistics.step_count = 0;
+	maneuver_statistics.max_boundary_late_us = 0;
+	
+	// Enable the clock to Timer 2 by setting the
+	// R2 bit (Bit 2) in the RCGCTIMER register
+	SYSCTL->RCGCTIMER |= 0x04;
+	
+	// Wait until Timer 2 is ready to be accessed
+	while ((SYSCTL->PRTIMER & 0x04) == 0);
+	
+	// Disable Timer A before configuration by clearing
+	// the TAEN bit (Bit 0) in the CTL register
+	TIMER2->CTL &= ~MANEUVER_CTL_TAEN_BIT_MASK;
+	
+	// Select the concatenated 32-bit timer configuration
+	// by writing 0x0 to the CFG register
+	TIMER2->CFG = 0x00;
+	
+	// Configure Timer A for one-shot mode (TAMR = 0x1, Bits 1 to 0), counting down.
+	// Each step boundary loads the interval to the next one
+	TIMER2->TAMR = 0x01;
+	
+	// Clear and enable the Timer A time-out interrupt
+	TIMER2->ICR = MANEUVER_TIMEOUT_INTERRUPT_BIT_MASK;
+	TIMER2->IMR |= MANEUVER_TIMEOUT_INTERRUPT_BIT_MASK;
+	
+	// The step boundaries must not wait behind the sonar and motor ramp handlers
+	NVIC_SetPriority(TIMER2A_IRQn, 1);
+	NVIC_EnableIRQ(TIMER2A_IRQn);
+	
+	Scheduler_Add_Task("maneuver", Maneuver_Task, MANEUVER_TASK_PERIOD_US, MANEUVER_TASK_PERIOD_US);
+}
+
+int Maneuver_Clear(void)
+{
+	if (maneuver_running)
+	{
+		return 0;
+	}
+	
+	maneuver_step_count = 0;
+	
+	return 1;
+}
+
+int Maneuver_Set_Step(uint8_t index, const Maneuver_Step *step)
+{
+	if (maneuver_running || (index > maneuver_step_count) || (index >= MANEUVER_MAX_STEPS))
+	{
+		return 0;
+	}
+	
+	// A step that can never end
+	if ((step->duration_ms == 0) && (step->until_distance_cm == 0))
+	{
+		return 0;
+	}
+	
+	maneuver_steps[index] = *step;
+	
+	if (index == maneuver_step_count)
+	{
+		maneuver_step_count++;
+	}
+	
+	return 1;
+}
+
+uint8_t Maneuver_Get_Step_Count(void)
+{
+	return maneuver_step_count;
+}
+
+int Maneuver_Start(void)
+{
+	Vehicle_Status status;
+	uint32_t primask;
+	
+	if (maneuver_running || (maneuver_step_count == 0))
+	{
+		return 0;
+	}
+	
+	Vehicle_Get_Status(&status);
+	
+	primask = __get_PRIMASK();
+	__disable_irq();
+	
+	maneuver_obstacle_stops = status.obstacle_stop_count;
+	maneuver_condition_step = MANEUVER_NO_CONDITION;
+	maneuver_current_step = 0;
+	maneuver_report.steps_run = 0;
+	maneuver_report_pending = 0;
+	maneuver_statistics.run_count++;
+	maneuver_running = 1;
+	
+	Maneuver_Begin_Step(Timebase_Now_Cycles());
+	
+	__set_PRIMASK(primask);
+	
+	return 1;
+}
+
+void Maneuver_Abort(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq();
+	
+	if (maneuver_running)
+	{
+		Maneuver_Finish(MANEUVER_RESULT_ABORTED);
+	}
+	
+	__set_PRIMASK(primask);
+}
+
+int Maneuver_Is_Running(void)
+{
+	return maneuver_running;
+}
+
+int Maneuver_Take_Report(Maneuver_Report *report)
+{
+	uint32_t primask;
+	
+	if (!maneuver_report_pending)
+	{
+		return 0;
+	}
+	
+	primask = __get_PRIMASK();
+	__disable_irq();
+	*report = maneuver_report;
+	maneuver_report_pending = 0;
+	__set_PRIMASK(primask);
+	
+	return 1;
+}
+
+void Maneuver_Get_Statistics(Maneuver_Statistics *stats)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq();
+	*stats = maneuver_statistics;
+	__set_PRIMASK(primask);
+}
+
+void TIMER2A_Handler(void)
+{
+	uint64_t now;
+	uint32_t late_us;
+	
+	// Acknowledge the time-out interrupt by setting the TATOCINT bit (Bit 0) in the ICR register
+	TIMER2->ICR = MANEUVER_TIMEOUT_INTERRUPT_BIT_MASK;
+	
+	if (!maneuver_running)
+	{
+		return;
+	}
+	
+	now = Timebase_Now_Cycles();
+	
+	// The distance condition of the current step is met: the next step starts now
+	if (maneuver_condition_step == maneuver_current_step)
+	{
+		maneuver_condition_step = MANEUVER_NO_CONDITION;
+		maneuver_current_step++;
+		Maneuver_Begin_Step(now);
+		return;
+	}
+	
+	if (!maneuver_has_boundary)
+	{
+		return;
+	}
+	
+	// A step longer than the 32-bit range of the timer, or an early interrupt: wait for the rest
+	if (now < maneuver_boundary_cycles)
+	{
+		Maneuver_Arm(maneuver_boundary_cycles);
+		return;
+	}
+	
+	late_us = (uint32_t)((now - maneuver_boundary_cycles) / TIMEBASE_CYCLES_PER_US);
+	
+	if (late_us > maneuver_statistics.max_boundary_late_us)
+	{
+		maneuver_statistics.max_boundary_late_us = late_us;
+	}
+	
+	// The next step starts at the boundary, not when the interrupt was taken
+	maneuver_current_step++;
+	Maneuver_Begin_Step(maneuver_boundary_cycles);
+}
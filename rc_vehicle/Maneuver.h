@@ -0,0 +1,213 @@
+/**
+ * @file Maneuver.h
+ *
+ * @brief Header file for the on-board timed maneuver scripts.
+ *
+ * A script is a sequence of up to MANEUVER_MAX_STEPS steps, each holding a throttle and a
+ * steering angle for a duration, optionally cut short when the front obstacle comes closer
+ * than a given distance. The host uploads it over UART0 (PROTOCOL_SCRIPT_LOAD, see
+ * Protocol.h) into RAM, then starts it (PROTOCOL_SCRIPT_RUN, or 'R' in character mode). The
+ * script runs on board, so the step timing does not depend on the serial link.
+ *
+ * - Timer A of Timer 2 (TIMER2) ends the steps. The step boundaries are absolute timebase
+ *   counts (see Timebase.h): each one is the previous boundary plus the step duration, so
+ *   the interrupt latency of one boundary is never added to the next ones. The one-shot timer
+ *   is loaded with the time left to the next boundary, and an interrupt that comes early
+ *   reloads it with the remainder, so a step never ends before its boundary.
+ *
+ * - The interrupt service routine applies each step with Vehicle_Script_Step, which hands it
+ *   to the actuation task like any other command (see Vehicle_Control.h). The obstacle stop of
+ *   the sonar task therefore keeps priority over the script: a step that drives forward into
+ *   an obstacle is stopped, and the script is aborted.
+ *
+ * - A scheduler task checks the distance conditions every MANEUVER_TASK_PERIOD_US. When the
+ *   condition of the current step is met, it pends the Timer 2A interrupt, so the steps are
+ *   always advanced by the interrupt service routine. While a script runs, the task also
+ *   feeds the command link deadman (see Deadman.h), since no command is expected.
+ *
+ * At the end of the script, or when it is aborted, the motor is stopped and the steering
+ * is centered.
+ *
+ * @note The timing is derived from the system clock frequency (SYSTEM_CLOCK_HZ, see System_Clock.h).
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef MANEUVER_H
+#define MANEUVER_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief Largest number of steps in a script
+ */
+#define MANEUVER_MAX_STEPS 32
+
+/**
+ * @brief Size of a serialized Maneuver_Step in bytes (PROTOCOL_SCRIPT_LOAD)
+ */
+#define MANEUVER_STEP_SIZE 6
+
+/**
+ * @brief Period and deadline of the task that checks the distance conditions, in microseconds
+ */
+#define MANEUVER_TASK_PERIOD_US 10000
+
+/**
+ * @brief One step of a script, serialized as MANEUVER_STEP_SIZE little-endian bytes
+ * in the order of the fields below.
+ */
+typedef struct
+{
+	/** Duration of the step in milliseconds, 0 to wait for the distance condition only */
+	uint16_t duration_ms;
+	
+	/** Signed throttle from -100 to 100, in percent of VEHICLE_MAX_SPEED_MM_S (see Vehicle_Drive) */
+	int8_t throttle_percent;
+	
+	/** Steering angle in degrees, negative to the left (see Vehicle_Steer_Degrees) */
+	int8_t steering_deg;
+	
+	/** The step ends early when the front obstacle is closer than this distance in centimeters, 0 for no condition */
+	uint16_t until_distance_cm;
+} Maneuver_Step;
+
+/**
+ * @brief How the latest script ended
+ */
+typedef enum
+{
+	MANEUVER_RESULT_COMPLETED = 0,  // every step was run
+	MANEUVER_RESULT_ABORTED = 1,    // aborted by a command
+	MANEUVER_RESULT_OBSTACLE = 2    // aborted by an obstacle stop
+} Maneuver_Result;
+
+/**
+ * @brief Outcome of a script, reported once by Maneuver_Take_Report.
+ */
+typedef struct
+{
+	/** How the script ended */
+	Maneuver_Result result;
+	
+	/** Number of steps started */
+	uint8_t steps_run;
+} Maneuver_Report;
+
+/**
+ * @brief Maneuver statistics since Maneuver_Init.
+ */
+typedef struct
+{
+	/** Number of scripts started */
+	uint32_t run_count;
+	
+	/** Number of steps started */
+	uint32_t step_count;
+	
+	/** Longest time from a step boundary to the interrupt that applied the next step, in microseconds */
+	uint32_t max_boundary_late_us;
+} Maneuver_Statistics;
+
+/**
+ * @brief The Maneuver_Init function clears the script, configures Timer 2A and registers the maneuver task.
+ *
+ * Scheduler_Init and Vehicle_Control_Init must have been called before this function.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Maneuver_Init(void);
+
+/**
+ * @brief The Maneuver_Clear function deletes the stored script.
+ *
+ * @param None
+ *
+ * @return 1 if the script was deleted, 0 if a script is running.
+ */
+int Maneuver_Clear(void);
+
+/**
+ * @brief The Maneuver_Set_Step function stores one step of the script.
+ *
+ * A step can replace a stored one, or be appended right after the last one.
+ *
+ * @param index Position of the step in the script, at most the current number of steps.
+ * @param step Pointer to the step.
+ *
+ * @return 1 if the step was stored, 0 if the index or the step is invalid, or if a script is running.
+ */
+int Maneuver_Set_Step(uint8_t index, const Maneuver_Step *step);
+
+/**
+ * @brief The Maneuver_Get_Step_Count function returns the number of steps of the stored script.
+ *
+ * @param None
+ *
+ * @return The number of steps.
+ */
+uint8_t Maneuver_Get_Step_Count(void);
+
+/**
+ * @brief The Maneuver_Start function starts the stored script from its first step.
+ *
+ * @param None
+ *
+ * @return 1 if the script was started, 0 if it is empty or already running.
+ */
+int Maneuver_Start(void);
+
+/**
+ * @brief The Maneuver_Abort function stops the running script and the vehicle.
+ *
+ * It does nothing when no script is running.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Maneuver_Abort(void);
+
+/**
+ * @brief The Maneuver_Is_Running function reports whether a script is running.
+ *
+ * @param None
+ *
+ * @return 1 while a script is running, 0 otherwise.
+ */
+int Maneuver_Is_Running(void);
+
+/**
+ * @brief The Maneuver_Take_Report function returns the outcome of the latest script, once.
+ *
+ * @param report Pointer to the structure that receives the outcome.
+ *
+ * @return 1 if a script has ended since the previous call, 0 otherwise.
+ */
+int Maneuver_Take_Report(Maneuver_Report *report);
+
+/**
+ * @brief The Maneuver_Get_Statistics function copies the maneuver statistics.
+ *
+ * @param stats Pointer to the structure that receives the statistics.
+ *
+ * @return None
+ */
+void Maneuver_Get_Statistics(Maneuver_Statistics *stats);
+
+/**
+ * @brief The TIMER2A_Handler function is the interrupt service routine of the maneuver timer.
+ *
+ * It runs at each step boundary, or when the maneuver task reports that the distance
+ * condition of the current step is met, and applies the next step.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void TIMER2A_Handler(void);
+
+#endif
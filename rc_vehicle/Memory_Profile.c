@@ -0,0 +1,281 @@
+/**
+ * @file Memory_Profile.c
+ *
+ * @brief Source code for the stack and RAM usage profiler.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Memory_Profile.h"
+#include "Scheduler.h"
+#include "UART0.h"
+
+#if defined(__ARMCC_VERSION)
+
+// Input section symbols of armlink: the STACK and HEAP areas of startup_TM4C123.s, and the end
+// of the zero-initialized data in the SRAM region of the default scatter file
+extern uint32_t STACK$$Base;
+extern uint32_t STACK$$Limit;
+extern uint32_t HEAP$$Base;
+extern uint32_t HEAP$$Limit;
+extern uint32_t Image$$RW_IRAM1$$ZI$$Limit;
+
+#define MEMORY_STACK_BASE  (&STACK$$Base)
+#define MEMORY_STACK_LIMIT (&STACK$$Limit)
+#define MEMORY_HEAP_BASE   (&HEAP$$Base)
+#define MEMORY_HEAP_LIMIT  (&HEAP$$Limit)
+#define MEMORY_FREE_BASE   (&Image$$RW_IRAM1$$ZI$$Limit)
+#define MEMORY_FREE_LIMIT  ((uint32_t *)0x20008000UL)
+
+// The module table is generated from the objects of the target compiler
+#define MEMORY_MODULE_SIZES "target"
+
+#else
+
+// Host simulation: the stack is a part of the host stack, and there is no heap and no free
+// SRAM (see sim/TM4C123GH6PM.h)
+#define MEMORY_STACK_BASE  (Sim_Stack_Limit() - (SIM_STACK_SIZE / 4))
+#define MEMORY_STACK_LIMIT Sim_Stack_Limit()
+#define MEMORY_HEAP_BASE   ((uint32_t *)0)
+#define MEMORY_HEAP_LIMIT  ((uint32_t *)0)
+#define MEMORY_FREE_BASE   ((uint32_t *)0)
+#define MEMORY_FREE_LIMIT  ((uint32_t *)0)
+
+// The module table is generated from the x86-64 objects: pointers take 8 bytes, and the padding differs
+#define MEMORY_MODULE_SIZES "host"
+
+#endif
+
+// Words left unpainted below the frame of Memory_Profile_Paint, for the function it calls
+#define MEMORY_PAINT_GUARD_WORDS 32
+
+// Free space in the UART0 transmit buffer needed to write one report line
+#define MEMORY_REPORT_LINE_MAX 48
+
+// Largest number of report lines written by one run of the memory task
+#define MEMORY_REPORT_LINES_PER_RUN 8
+
+typedef enum
+{
+	MEMORY_REGION_STACK = 0,
+	MEMORY_REGION_HEAP = 1,
+	MEMORY_REGION_FREE = 2,
+	MEMORY_REGION_COUNT
+} Memory_Region_Index;
+
+typedef struct
+{
+	const char *name;
+	uint32_t *base;
+	uint32_t *limit;
+} Memory_Region;
+
+static Memory_Region memory_regions[MEMORY_REGION_COUNT] =
+{
+	{ "stack", 0, 0 },
+	{ "heap", 0, 0 },
+	{ "free", 0, 0 }
+};
+
+// Bytes of each region between its lowest overwritten word and its end, as of the last scan
+static uint32_t region_used_bytes[MEMORY_REGION_COUNT];
+
+static uint8_t stack_low;
+
+// Report: report_line is the next line to print, or -1 when no report is in progress
+static int16_t report_line = -1;
+
+static void Memory_Paint(uint32_t *base, uint32_t *limit)
+{
+	while (base < limit)
+	{
+		*base++ = MEMORY_PROFILE_PAINT;
+	}
+}
+
+// Returns the number of bytes from the lowest overwritten word of a region to its end
+static uint32_t Memory_Region_Used(const Memory_Region *region)
+{
+	const uint32_t *word = region->base;
+	
+	while ((word < region->limit) && (*word == MEMORY_PROFILE_PAINT))
+	{
+		word++;
+	}
+	
+	return (uint32_t)(region->limit - word) * 4;
+}
+
+// Number of modules in the table, 0 when the generated table is not linked: the weak
+// references of Memory_Profile.h then resolve to address 0
+static uint8_t Memory_Module_Count(void)
+{
+	return (&memory_module_count != 0) ? memory_module_count : 0;
+}
+
+static uint32_t Memory_Region_Size(const Memory_Region *region)
+{
+	return (uint32_t)(region->limit - region->base) * 4;
+}
+
+static void Memory_Scan(void)
+{
+	uint8_t i;
+	
+	for (i = 0; i < MEMORY_REGION_COUNT; i++)
+	{
+		region_used_bytes[i] = Memory_Region_Used(&memory_regions[i]);
+	}
+	
+	if (region_used_bytes[MEMORY_REGION_STACK] + MEMORY_PROFILE_STACK_MARGIN > Memory_Region_Size(&memory_regions[MEMORY_REGION_STACK]))
+	{
+		stack_low = 1;
+	}
+}
+
+static void Memory_Output_Line(const char *prefix, const char *name, uint32_t first, uint32_t second)
+{
+	UART0_Output_String((char *)prefix);
+	UART0_Output_String((char *)name);
+	UART0_Output_Character(' ');
+	UART0_Output_Unsigned_Decimal(first);
+	UART0_Output_Character(' ');
+	UART0_Output_Unsigned_Decimal(second);
+	UART0_Output_Newline();
+}
+
+// Writes the next line of the report, and returns 0 once the report is complete
+static int Memory_Report_Next(void)
+{
+	int16_t line = report_line;
+	uint32_t data_bytes = 0;
+	uint32_t bss_bytes = 0;
+	uint8_t i;
+	
+	if (line == 0)
+	{
+		UART0_Output_String("ram region size used\r\n");
+		return 1;
+	}
+	
+	line--;
+	
+	if (line < MEMORY_REGION_COUNT)
+	{
+		Memory_Output_Line("ram ", memory_regions[line].name, Memory_Region_Size(&memory_regions[line]), region_used_bytes[line]);
+		return 1;
+	}
+	
+	line -= MEMORY_REGION_COUNT;
+	
+	if (line == 0)
+	{
+		// The objects the sizes were taken from, or none without a generated table
+		UART0_Output_String("module_sizes ");
+		UART0_Output_String((Memory_Module_Count() > 0) ? MEMORY_MODULE_SIZES "\r\n" : "none\r\n");
+		return 1;
+	}
+	
+	line--;
+	
+	if (line == 0)
+	{
+		UART0_Output_String("module data bss\r\n");
+		return 1;
+	}
+	
+	line--;
+	
+	if (line < Memory_Module_Count())
+	{
+		Memory_Output_Line("module ", memory_modules[line].name, memory_modules[line].data_bytes, memory_modules[line].bss_bytes);
+		return 1;
+	}
+	
+	for (i = 0; i < Memory_Module_Count(); i++)
+	{
+		data_bytes += memory_modules[i].data_bytes;
+		bss_bytes += memory_modules[i].bss_bytes;
+	}
+	
+	Memory_Output_Line("module ", "total", data_bytes, bss_bytes);
+	
+	return 0;
+}
+
+static void Memory_Profile_Task(void)
+{
+	uint8_t lines;
+	
+	Memory_Scan();
+	
+	if (report_line < 0)
+	{
+		return;
+	}
+	
+	for (lines = 0; (lines < MEMORY_REPORT_LINES_PER_RUN) && (UART0_TX_Free() >= MEMORY_REPORT_LINE_MAX); lines++)
+	{
+		if (!Memory_Report_Next())
+		{
+			report_line = -1;
+			return;
+		}
+		
+		report_line++;
+	}
+}
+
+void Memory_Profile_Paint(void)
+{
+	uint32_t marker = 0;
+	uint32_t *paint_limit;
+	
+	memory_regions[MEMORY_REGION_STACK].base = MEMORY_STACK_BASE;
+	memory_regions[MEMORY_REGION_STACK].limit = MEMORY_STACK_LIMIT;
+	memory_regions[MEMORY_REGION_HEAP].base = MEMORY_HEAP_BASE;
+	memory_regions[MEMORY_REGION_HEAP].limit = MEMORY_HEAP_LIMIT;
+	memory_regions[MEMORY_REGION_FREE].base = MEMORY_FREE_BASE;
+	memory_regions[MEMORY_REGION_FREE].limit = MEMORY_FREE_LIMIT;
+	
+	// The stack is in use above the frame of this function: only the part below it is painted
+	paint_limit = &marker - MEMORY_PAINT_GUARD_WORDS;
+	
+	if (paint_limit > memory_regions[MEMORY_REGION_STACK].limit)
+	{
+		paint_limit = memory_regions[MEMORY_REGION_STACK].limit;
+	}
+	
+	Memory_Paint(memory_regions[MEMORY_REGION_STACK].base, paint_limit);
+	Memory_Paint(memory_regions[MEMORY_REGION_HEAP].base, memory_regions[MEMORY_REGION_HEAP].limit);
+	Memory_Paint(memory_regions[MEMORY_REGION_FREE].base, memory_regions[MEMORY_REGION_FREE].limit);
+}
+
+void Memory_Profile_Init(void)
+{
+	Scheduler_Add_Task("memory", Memory_Profile_Task, MEMORY_PROFILE_TASK_PERIOD_US, MEMORY_PROFILE_TASK_PERIOD_US);
+}
+
+int Memory_Profile_Report(void)
+{
+	if (report_line >= 0)
+	{
+		return 0;
+	}
+	
+	report_line = 0;
+	
+	return 1;
+}
+
+int Memory_Profile_Stack_Low(void)
+{
+	return stack_low;
+}
+
+void Memory_Profile_Get_Statistics(Memory_Profile_Statistics *stats)
+{
+	stats->size_bytes = Memory_Region_Size(&memory_regions[MEMORY_REGION_STACK]);
+	stats->used_bytes = region_used_bytes[MEMORY_REGION_STACK];
+	stats->stray_bytes = region_used_bytes[MEMORY_REGION_HEAP] + region_used_bytes[MEMORY_REGION_FREE];
+}
@@ -0,0 +1,153 @@
+/**
+ * @file Memory_Profile.h
+ *
+ * @brief Header file for the stack and RAM usage profiler.
+ *
+ * The 32 KB of SRAM hold the static data of the modules (.data and .bss), the heap, which the
+ * firmware does not use, and the stack. The size of the stack is fixed by Stack_Size in
+ * startup_TM4C123.s (2 KB), and the main loop and every interrupt handler run on it (MSP), so
+ * its depth is the deepest call chain of a task plus the deepest nesting of interrupts.
+ *
+ * - Painting: Memory_Profile_Paint fills the unused part of the stack, the heap and the SRAM
+ *   above the image with MEMORY_PROFILE_PAINT, first thing in main. A word that still holds
+ *   the pattern has not been written since.
+ *
+ * - High-water mark: the stack grows down, so the lowest overwritten word of the stack marks
+ *   the deepest use since reset. The memory task scans the stack from its end every
+ *   MEMORY_PROFILE_TASK_PERIOD_US, and flags it once less than MEMORY_PROFILE_STACK_MARGIN
+ *   bytes have never been used (see Memory_Profile_Stack_Low). A write into the heap or into
+ *   the free SRAM, where nothing should write, shows up in the same way.
+ *
+ * - Static usage: the .data and .bss sizes of each module come from a table generated from
+ *   the object files at build time, by tools/Memory_Modules.sh: by the sim Makefile for the
+ *   host objects, and, when it is enabled, by the Before Build command of the Keil project
+ *   (with SIZE=arm-none-eabi-size) for the target objects. The Keil command is off by default,
+ *   since it needs sh and the GNU Arm toolchain, and its table is generated from the objects of
+ *   the previous build, so it is one build behind after a change of the static data. Without a
+ *   generated table, the firmware links without the module lines of the report.
+ *
+ * Memory_Profile_Report prints the regions and the table over UART0, paced by the memory task
+ * like the black box dump:
+ *
+ *   ram region size used
+ *   ram stack 2048 612
+ *   module_sizes target
+ *   module data bss
+ *   module UART0 12 1432
+ *   module total 180 14250
+ *
+ * @note A word that the firmware writes with the value of the pattern is counted as unused.
+ * A stack overflow is only detected after the fact: the profiler shows how much margin is
+ * left, it does not prevent the overflow.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef MEMORY_PROFILE_H
+#define MEMORY_PROFILE_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief Value written into the unused RAM at reset
+ */
+#define MEMORY_PROFILE_PAINT 0xDEADBEEFUL
+
+/**
+ * @brief The stack is reported low once fewer bytes than this have never been used
+ */
+#define MEMORY_PROFILE_STACK_MARGIN 256
+
+/**
+ * @brief Period and deadline of the memory task, in microseconds
+ */
+#define MEMORY_PROFILE_TASK_PERIOD_US 100000
+
+/**
+ * @brief Static RAM of one module, in the table generated by tools/Memory_Modules.sh
+ */
+typedef struct
+{
+	/** Name of the source file, without its extension */
+	const char *name;
+	
+	/** Initialized (.data) and zero-initialized (.bss) data, in bytes */
+	uint32_t data_bytes;
+	uint32_t bss_bytes;
+} Memory_Module;
+
+/**
+ * @brief The generated table and its number of entries. They are weak references, so the
+ * firmware also links without the table: the report then has no module lines.
+ */
+extern const Memory_Module memory_modules[] __attribute__((weak));
+extern const uint8_t memory_module_count __attribute__((weak));
+
+/**
+ * @brief Stack usage.
+ */
+typedef struct
+{
+	/** Size of the stack, in bytes */
+	uint32_t size_bytes;
+	
+	/** Deepest use of the stack since reset, as of the last scan, in bytes */
+	uint32_t used_bytes;
+	
+	/** Bytes of the heap and of the free SRAM that were written since reset, as of the last scan */
+	uint32_t stray_bytes;
+} Memory_Profile_Statistics;
+
+/**
+ * @brief The Memory_Profile_Paint function paints the unused RAM.
+ *
+ * It is called first in main: the part of the stack above its caller, and the stack used by
+ * the C library startup code before main, count as used.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Memory_Profile_Paint(void);
+
+/**
+ * @brief The Memory_Profile_Init function registers the memory task, which measures the
+ * high-water mark and paces the report.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Memory_Profile_Init(void);
+
+/**
+ * @brief The Memory_Profile_Report function starts printing the RAM regions and the static
+ * data of each module over UART0.
+ *
+ * @param None
+ *
+ * @return 1 if the report was started, 0 if a report is already in progress.
+ */
+int Memory_Profile_Report(void);
+
+/**
+ * @brief The Memory_Profile_Stack_Low function tells whether the stack came within
+ * MEMORY_PROFILE_STACK_MARGIN bytes of its end since reset.
+ *
+ * @param None
+ *
+ * @return 1 if the stack is low, 0 otherwise.
+ */
+int Memory_Profile_Stack_Low(void);
+
+/**
+ * @brief The Memory_Profile_Get_Statistics function copies the stack usage of the last scan.
+ *
+ * @param stats Pointer to the structure that receives the usage.
+ *
+ * @return None
+ */
+void Memory_Profile_Get_Statistics(Memory_Profile_Statistics *stats);
+
+#endif
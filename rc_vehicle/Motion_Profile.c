@@ -0,0 +1,230 @@
+/**
+ * @file Motion_Profile.c
+ *
+ * @brief Source code for the motor motion profile generator.
+ *
+ * The limits are converted once to PWM clock cycles per period (acceleration) and per period
+ * squared (jerk), so that each update is a handful of integer additions and comparisons.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Motion_Profile.h"
+#include "PWM0_0.h"
+#include "Trace.h"
+#include "Latency.h"
+
+// Full-scale duty cycle
+static int32_t profile_max_duty;
+
+// Limits, in duty cycle counts per period and per period squared
+static volatile int32_t profile_accel_step;
+static volatile int32_t profile_jerk_step;
+
+// Target written by the application, applied duty cycle and its rate of change per period
+static volatile int32_t profile_target;
+static volatile int32_t profile_duty;
+static int32_t profile_rate;
+
+static int32_t Absolute(int32_t value)
+{
+	return (value < 0) ? -value : value;
+}
+
+// Rate of change for the next period, for an error of (target - duty)
+static int32_t Motion_Profile_Next_Rate(int32_t error, int32_t accel_step, int32_t jerk_step)
+{
+	int32_t direction = (error > 0) ? 1 : -1;
+	int32_t rate = profile_rate;
+	uint64_t braking;
+	
+	// Linear ramp
+	if (jerk_step == 0)
+	{
+		return direction * accel_step;
+	}
+	
+	// Duty cycle change while the rate is brought back to zero at the jerk limit
+	braking = ((uint64_t)Absolute(rate) * (uint64_t)(Absolute(rate) + jerk_step)) / (2 * (uint64_t)jerk_step);
+	
+	if (((rate > 0) == (direction > 0)) && (rate != 0) && ((uint64_t)Absolute(error) <= braking))
+	{
+		// Ease into the target, without reversing the rate
+		rate -= direction * jerk_step;
+		
+		if ((rate > 0) != (direction > 0))
+		{
+			rate = 0;
+		}
+	}
+	else
+	{
+		rate += direction * jerk_step;
+		
+		if (rate > accel_step)
+		{
+			rate = accel_step;
+		}
+		else if (rate < -accel_step)
+		{
+			rate = -accel_step;
+		}
+	}
+	
+	return rate;
+}
+
+static void Motion_Profile_Output(int32_t previous_duty, int32_t duty)
+{
+	// The direction pin is only switched when the duty cycle leaves zero
+	if ((duty > 0) && (previous_duty <= 0))
+	{
+		PWM0_0_Forward();
+	}
+	else if ((duty < 0) && (previous_duty >= 0))
+	{
+		PWM0_0_Reverse();
+	}
+	
+	PWM0_0_Update_Duty_Cycle((uint16_t)Absolute(duty));
+	Latency_Motor_Written();
+	
+	if ((duty == 0) && (previous_duty != 0))
+	{
+		PWM0_0_Stop();
+	}
+}
+
+void Motion_Profile_Init(uint16_t max_duty)
+{
+	profile_max_duty = max_duty;
+	profile_target = 0;
+	profile_duty = 0;
+	profile_rate = 0;
+	
+	Motion_Profile_Configure(MOTION_PROFILE_DEFAULT_ACCEL_PERCENT_S, MOTION_PROFILE_DEFAULT_JERK_PERCENT_S2);
+	
+	PWM0_0_Update_Duty_Cycle(0);
+	PWM0_0_Stop();
+	
+	// The handler only writes the next period, so it can wait behind the other interrupts
+	PWM0_0_Clear_Load_Interrupt();
+	PWM0_0_Enable_Load_Interrupt();
+	NVIC_SetPriority(PWM0_0_IRQn, 3);
+	NVIC_EnableIRQ(PWM0_0_IRQn);
+}
+
+void Motion_Profile_Configure(uint16_t accel_percent_s, uint16_t jerk_percent_s2)
+{
+	uint32_t primask = __get_PRIMASK();
+	int32_t accel_step = (int32_t)(((uint32_t)profile_max_duty * accel_percent_s) / (100U * MOTION_PROFILE_UPDATE_HZ));
+	int32_t jerk_step = (int32_t)(((uint32_t)profile_max_duty * jerk_percent_s2) / (100U * MOTION_PROFILE_UPDATE_HZ * MOTION_PROFILE_UPDATE_HZ));
+	
+	// Limits that round down to zero would stop the profile; keep them at one count
+	if ((accel_percent_s > 0) && (accel_step == 0))
+	{
+		accel_step = 1;
+	}
+	
+	if ((jerk_percent_s2 > 0) && (jerk_step == 0))
+	{
+		jerk_step = 1;
+	}
+	
+	// Both limits are read together by the handler
+	__disable_irq();
+	profile_accel_step = accel_step;
+	profile_jerk_step = jerk_step;
+	__set_PRIMASK(primask);
+}
+
+void Motion_Profile_Set_Target(int32_t duty)
+{
+	if (duty > profile_max_duty)
+	{
+		duty = profile_max_duty;
+	}
+	else if (duty < -profile_max_duty)
+	{
+		duty = -profile_max_duty;
+	}
+	
+	profile_target = duty;
+}
+
+int32_t Motion_Profile_Get_Target(void)
+{
+	return profile_target;
+}
+
+int32_t Motion_Profile_Get_Duty(void)
+{
+	return profile_duty;
+}
+
+void Motion_Profile_Stop_Now(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq();
+	
+	profile_target = 0;
+	profile_rate = 0;
+	
+	if (profile_duty != 0)
+	{
+		Motion_Profile_Output(profile_duty, 0);
+		profile_duty = 0;
+	}
+	
+	__set_PRIMASK(primask);
+}
+
+void PWM0_0_Handler(void)
+{
+	int32_t target = profile_target;
+	int32_t duty = profile_duty;
+	int32_t error = target - duty;
+	int32_t next_duty;
+	
+	TRACE(TRACE_PWM_IRQ_BEGIN, target);
+	
+	// Acknowledge the load interrupt
+	PWM0_0_Clear_Load_Interrupt();
+	
+	if (error == 0)
+	{
+		profile_rate = 0;
+		TRACE(TRACE_PWM_IRQ_END, duty);
+		return;
+	}
+	
+	if (profile_accel_step == 0)
+	{
+		profile_rate = 0;
+		next_duty = target;
+	}
+	else
+	{
+		profile_rate = Motion_Profile_Next_Rate(error, profile_accel_step, profile_jerk_step);
+		next_duty = duty + profile_rate;
+		
+		// The last step lands exactly on the target
+		if (((error > 0) && (next_duty >= target)) || ((error < 0) && (next_duty <= target)))
+		{
+			next_duty = target;
+			profile_rate = 0;
+		}
+	}
+	
+	// A change of direction stops at zero for one period
+	if (((duty > 0) && (next_duty < 0)) || ((duty < 0) && (next_duty > 0)))
+	{
+		next_duty = 0;
+	}
+	
+	Motion_Profile_Output(duty, next_duty);
+	profile_duty = next_duty;
+	
+	TRACE(TRACE_PWM_IRQ_END, next_duty);
+}
@@ -0,0 +1,127 @@
+/**
+ * @file Motion_Profile.h
+ *
+ * @brief Header file for the motor motion profile generator.
+ *
+ * The generator moves the motor duty cycle (PWM0_0) towards a target instead of switching it
+ * at once, which avoids the current spikes, wheel slip and supply dips of a hard start. It runs
+ * entirely in the PWM0_0 load interrupt, once per PWM period: the application only sets targets
+ * with Motion_Profile_Set_Target and never waits for the profile to complete.
+ *
+ * The duty cycle is signed: positive values drive forward, negative values drive in reverse.
+ * Each period, the rate of change of the duty cycle is moved by at most the jerk limit, and
+ * is kept within the acceleration limit, which gives an S-shaped ramp. The rate is brought back
+ * to zero in time to reach the target without overshoot. A change of direction always passes
+ * through zero: the duty cycle stays at zero for one period before the direction pin (PB7) is
+ * switched.
+ *
+ * @note PWM0_0_Init must be called before Motion_Profile_Init.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include "TM4C123GH6PM.h"
+#include "Vehicle_Control.h"
+#include <stdint.h>
+
+/**
+ * @brief Number of profile updates per second: the PWM0_0 frequency, whose period is
+ * VEHICLE_PWM_PERIOD. The acceleration and jerk steps are computed from it.
+ */
+#define MOTION_PROFILE_UPDATE_HZ VEHICLE_PWM_HZ
+
+/**
+ * @brief Default acceleration limit, in percent of the full duty cycle per second (0 to 100% in 400 ms).
+ * Default of the accel_pct_s parameter (see Parameters.h).
+ */
+#define MOTION_PROFILE_DEFAULT_ACCEL_PERCENT_S 250
+
+/**
+ * @brief Default jerk limit, in percent of the full duty cycle per second squared
+ * (full acceleration reached in 100 ms). Default of the jerk_pct_s2 parameter.
+ */
+#define MOTION_PROFILE_DEFAULT_JERK_PERCENT_S2 2500
+
+/**
+ * @brief The Motion_Profile_Init function starts the profile generator with the motor stopped.
+ *
+ * It selects the default limits and enables the PWM0_0 load interrupt.
+ *
+ * @param max_duty The duty cycle that corresponds to 100%, in PWM clock cycles.
+ *
+ * @return None
+ */
+void Motion_Profile_Init(uint16_t max_duty);
+
+/**
+ * @brief The Motion_Profile_Configure function changes the limits of the profile.
+ *
+ * The new limits apply from the next PWM period, including to a ramp in progress.
+ *
+ * @param accel_percent_s Largest rate of change of the duty cycle, in percent per second.
+ *                        0 removes all limits: the target is applied at once.
+ * @param jerk_percent_s2 Largest change of that rate, in percent per second squared.
+ *                        0 gives a linear ramp at the acceleration limit.
+ *
+ * @return None
+ */
+void Motion_Profile_Configure(uint16_t accel_percent_s, uint16_t jerk_percent_s2);
+
+/**
+ * @brief The Motion_Profile_Set_Target function sets the duty cycle to move towards.
+ *
+ * This function does not block.
+ *
+ * @param duty Signed target duty cycle in PWM clock cycles, clamped to +/- max_duty.
+ *             Positive drives forward, negative in reverse, 0 stops the motor.
+ *
+ * @return None
+ */
+void Motion_Profile_Set_Target(int32_t duty);
+
+/**
+ * @brief The Motion_Profile_Get_Target function returns the target duty cycle.
+ *
+ * @param None
+ *
+ * @return The signed target duty cycle in PWM clock cycles.
+ */
+int32_t Motion_Profile_Get_Target(void);
+
+/**
+ * @brief The Motion_Profile_Get_Duty function returns the duty cycle currently applied to the motor.
+ *
+ * @param None
+ *
+ * @return The signed duty cycle in PWM clock cycles.
+ */
+int32_t Motion_Profile_Get_Duty(void);
+
+/**
+ * @brief The Motion_Profile_Stop_Now function cuts the motor output without a ramp.
+ *
+ * It is meant for emergency stops: the PWM output is disabled immediately and the target
+ * is set to 0.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Motion_Profile_Stop_Now(void);
+
+/**
+ * @brief The PWM0_0_Handler function is the interrupt service routine of the profile generator.
+ *
+ * It runs at every reload of the PWM0_0 counter and writes the duty cycle and direction
+ * for the next period.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void PWM0_0_Handler(void);
+
+#endif
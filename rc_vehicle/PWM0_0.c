@@ -4,9 +4,11 @@
  * @brief Source file for the PWM0_0 driver.
  *
  * This file contains the function definitions for the PWM0_0 driver.
- * It uses the Module 0 PWM Generator 0 to generate a PWM signal using the PB6 pin.
+ * It uses the Module 0 PWM Generator 0 to generate the motor PWM signal on the PB6 pin (M0PWM0),
+ * and the PB7 pin for the direction of the motor driver. The bindings are checked at compile
+ * time, and the register addresses and masks are constants (see PWM_Channel.h).
  *
- * @note This driver assumes that the system clock's frequency is 50 MHz.
+ * @note The period and duty cycle are counted in PWM clock cycles (SYSTEM_CLOCK_PWM_HZ, see System_Clock.h).
  *
  * @note This driver assumes that the PWM_Clock_Init function has been called
  * before calling the PWM0_0_Init function.
@@ -15,112 +17,98 @@
  */
 
 #include "PWM0_0.h"
-// PB7 is forward PB6 is reverse
- 
+
+#if !PWM_CHANNEL_VALID(PWM0_0_CHANNEL)
+#error "PWM0_0_CHANNEL: the pin cannot carry the PWM signal (see Table 23-5 and PWM_Channel.h)"
+#endif
+
+#if (PWM0_0_DIRECTION_PORT != PWM_CHANNEL_PORT(PWM0_0_CHANNEL)) || (PWM0_0_DIRECTION_PIN == PWM_CHANNEL_PIN(PWM0_0_CHANNEL))
+#error "PWM0_0_DIRECTION_PIN must be another pin of the port of PWM0_0_CHANNEL"
+#endif
+
+#define PWM0_0_DIRECTION_MASK (1UL << PWM0_0_DIRECTION_PIN)
+
+// GPIODATA address that only reads and writes the direction pin
+#define PWM0_0_DIRECTION_DATA PWM_CHANNEL_GPIO(PWM0_0_CHANNEL)->DATA_Bits[PWM0_0_DIRECTION_MASK]
+
 void PWM0_0_Init(uint16_t period_constant, uint16_t duty_cycle)
 {	
 	// Return from the function if the specified duty_cycle is greater than
 	// or equal to the given period. The duty cycle cannot exceed 99%.
 	if (duty_cycle >= period_constant) return;
 	
+	// Enable the clock to the PWM module and to the GPIO port of the channel
+	// (R0 and R1, Bits 0 and 1, in the RCGCPWM and RCGCGPIO registers)
+	SYSCTL->RCGCPWM |= (1UL << PWM_CHANNEL_MODULE(PWM0_0_CHANNEL));
+	SYSCTL->RCGCGPIO |= (1UL << PWM_CHANNEL_PORT(PWM0_0_CHANNEL));
 	
-	// Enable the clock to PWM Module 0 by setting the
-	// R0 bit (Bit 0) in the RCGCPWM register
-	SYSCTL->RCGCPWM |= 0x01;
-	
-	// Enable the clock to GPIO Port B by setting the
-	// R1 bit (Bit 1) in the RCGCGPIO register
-	SYSCTL->RCGCGPIO |= 0x02;
-	
-	// Configure the PB6 pin to use the alternate function (M0PWM0)
-	// by setting Bit 6 in the AFSEL register
-	GPIOB->AFSEL |= 0x40;
-	GPIOB->AFSEL &= ~0x80; // PB7
+	// Route the PB6 pin to M0PWM0 (PMC6 = 0x4), and make the PB7 pin a GPIO output,
+	// with one access to each of the AFSEL, PCTL, DIR and DEN registers
+	PWM_Channel_Configure_Pins(PWM_CHANNEL_GPIO(PWM0_0_CHANNEL),
+		PWM_CHANNEL_PIN_MASK(PWM0_0_CHANNEL),
+		PWM_CHANNEL_PCTL_MASK(PWM0_0_CHANNEL) | (0x0FUL << (4 * PWM0_0_DIRECTION_PIN)),
+		PWM_CHANNEL_PCTL_VALUE(PWM0_0_CHANNEL),
+		PWM0_0_DIRECTION_MASK);
 	
+	// Start Generator 0 in Count-Down mode with a period of period_constant PWM clock cycles.
+	// The output is driven high when the counter matches CMPA while counting down, and low at
+	// the reload. A duty cycle of 0 is a comparator value the counter never matches
+	PWM_CHANNEL_START(PWM0_0_CHANNEL, period_constant - 1, (duty_cycle == 0) ? 0xFFFF : (duty_cycle - 1));
+}
 
-	
-	// Clear the PMC6 field (Bits 27 to 24) in the PCTL register
-	GPIOB->PCTL &= ~0x0F000000;
-	GPIOB->PCTL &= ~0xF0000000; // Clear PB7 PCTL
-	
-	// Configure the PB6 pin to operate as a Module 0 PWM0 pin (M0PWM0)
-	// by writing 0x4 to the PMC6 field (Bits 27 to 24) in the PCTL register
-	// The 0x4 value is derived from Table 23-5 in the TM4C123G Microcontroller Datasheet
-	GPIOB->PCTL |= 0x04000000;
-	GPIOB->DIR   |= 0x80;     // PB7 output
-
-	// Enable the digital functionality for the PB6 pin
-	// by setting Bit 6 in the DEN register
-	GPIOB->DEN |= 0x40;
-	GPIOB->DEN   |= 0x80;     // Digital enable PB7
-	
-	// Disable the Module 0 PWM Generator 0 block (PWM0_0) before 
-	// configuration by clearing the ENABLE bit (Bit 0) in the PWM0CTL register
-	PWM0->_0_CTL &= ~0x01;
-	
-	// Configure the counter for the PWM0_0 block to
-	// use Count-Down mode by clearing the MODE bit (Bit 1)
-	// in the PWM0CTL register. The counter will count from the load value
-	// to 0, and then wrap back to the load value
-	PWM0->_0_CTL &= ~0x02;
-	
-	// Set the ACTCMPAD field (Bits 7 to 6) to 0x3 in the PWM0GENA register
-	// to drive the PWM signal high when the counter matches 
-	// the comparator (i.e. the value in PWM0CMPA) while counting down
-	PWM0->_0_GENA |= 0xC0;
-	
-	// Set the ACTLOAD field (Bits 3 to 2) to 0x2 in the PWM0GENA register
-	// to drive the PWM signal low when the counter matches the value
-	// in the PWM0LOAD register
-	PWM0->_0_GENA |= 0x08;
-	
-	// Set the period by writing to the LOAD field (Bits 15 to 0) 
-	// in the PWM0LOAD register. This determines the number of clock
-	// cycles needed to count down to zero
-	PWM0->_0_LOAD = (period_constant - 1);
+void PWM0_0_Update_Duty_Cycle(uint16_t duty_cycle)
+{
+	// A duty cycle of 0 is produced by a comparator value above the load value,
+	// which the counter never matches, so the signal stays low
+	if (duty_cycle == 0)
+	{
+		PWM_CHANNEL_COMPARE(PWM0_0_CHANNEL) = 0xFFFF;
+		return;
+	}
 	
 	// Set the duty cycle by writing to the COMPA field (Bits 15 to 0)
 	// in the PWM0CMPA register. When the counter matches the value in this register,
 	// the PWM signal will be driven high
-	PWM0->_0_CMPA = (duty_cycle - 1);
-	//PWM0->_0_CMPA = PWM0->_0_LOAD;
-	
-	// Enable the PWM0_0 block after configuration by setting the
-	// ENABLE bit (Bit 0) in the PWM0CTL register
-	PWM0->_0_CTL |= 0x01;
+	PWM_CHANNEL_COMPARE(PWM0_0_CHANNEL) = (duty_cycle - 1);
+}
+
+void PWM0_0_Enable_Load_Interrupt(void)
+{
+	// Raise an interrupt every time the counter is reloaded by setting
+	// the INTCNTLOAD bit (Bit 1) in the PWM0INTEN register
+	PWM_CHANNEL_GENERATOR_REGS(PWM0_0_CHANNEL)->INTEN |= 0x02;
 	
-	// Enable the PWM0_0 signal to be passed to the PB6 pin (M0PWM0)
-	// by setting the PWM0EN bit (Bit 0) in the PWMENABLE register
-	PWM0->ENABLE |= 0x01;
+	// Pass the PWM0_0 interrupt to the interrupt controller by setting
+	// the INTPWM0 bit (Bit 0) in the PWMINTEN register
+	PWM_CHANNEL_MODULE_REGS(PWM0_0_CHANNEL)->INTEN |= (1UL << PWM_CHANNEL_GENERATOR(PWM0_0_CHANNEL));
 }
 
-void PWM0_0_Update_Duty_Cycle(uint16_t duty_cycle)
+void PWM0_0_Clear_Load_Interrupt(void)
 {
-	// Set the duty cycle by writing to the COMPA field (Bits 15 to 0)
-	// in the PWM0CMPA register. When the counter matches the value in this register,
-	// the PWM signal will be driven high
-	PWM0->_0_CMPA = (duty_cycle - 1);
+	// Clear the load interrupt by writing a 1 to the
+	// INTCNTLOAD bit (Bit 1) in the PWM0ISC register
+	PWM_CHANNEL_GENERATOR_REGS(PWM0_0_CHANNEL)->ISC = 0x02;
 }
 
+// The direction pin is written through its masked GPIODATA address: a single store,
+// without a read-modify-write of the other pins of the port
+
 void PWM0_0_Forward(void)
 {
-    PWM0->ENABLE |= 0x01;    // enable PWM on PB6
-    GPIOB->DATA |= 0x80;
+	PWM_CHANNEL_MODULE_REGS(PWM0_0_CHANNEL)->ENABLE |= PWM_CHANNEL_ENABLE_MASK(PWM0_0_CHANNEL);
+	PWM0_0_DIRECTION_DATA = PWM0_0_DIRECTION_MASK;
 }
 
 void PWM0_0_Reverse(void)
 {
-	 PWM0->ENABLE |= 0x01;    // enable PWM on PB6
-    GPIOB->DATA &= ~0x80;
-	  //GPIOB->DATA |= 0x80;
+	PWM_CHANNEL_MODULE_REGS(PWM0_0_CHANNEL)->ENABLE |= PWM_CHANNEL_ENABLE_MASK(PWM0_0_CHANNEL);
+	PWM0_0_DIRECTION_DATA = 0;
 }
 
 void PWM0_0_Stop(void)
 {
-     // Disable PWM output
-    //PWM0->ENABLE &= ~0x01;   // PB6 PWM disabled
-    PWM0->ENABLE &= ~0x01;
-    // Clear PB6 and PB7 GPIO just in case
-    GPIOB->DATA &= ~0xC0;
-	  //GPIOB->DATA |= 0x00; 
+	// Disable the PWM output, then clear the direction pin. The PB6 pin is driven by the
+	// generator, so its GPIODATA bit has no effect
+	PWM_CHANNEL_MODULE_REGS(PWM0_0_CHANNEL)->ENABLE &= ~PWM_CHANNEL_ENABLE_MASK(PWM0_0_CHANNEL);
+	PWM0_0_DIRECTION_DATA = 0;
 }
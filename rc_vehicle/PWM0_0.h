@@ -6,18 +6,36 @@
  * @brief Header file for the PWM0_0 driver.
  *
  * This file contains the function definitions for the PWM0_0 driver.
- * It uses the Module 0 PWM Generator 0 to generate a PWM signal with the PB6 pin.
+ * It uses the Module 0 PWM Generator 0 to generate the motor PWM signal on the PB6 pin (M0PWM0),
+ * and drives the direction input of the motor driver with the PB7 pin (GPIO output).
  *
- * @note This driver assumes that the system clock's frequency is 50 MHz.
+ * The pins are bound at compile time (see PWM_Channel.h): a binding that does not match the
+ * pin-mux table of the TM4C123GH6PM fails the build.
+ *
+ * @note The period and duty cycle are counted in PWM clock cycles (SYSTEM_CLOCK_PWM_HZ, see System_Clock.h).
  *
  * @note This driver assumes that the PWM_Clock_Init function has been called
  * before calling the PWM0_0_Init function.
  *
  * @author Aaron Nanas
  */
- 
+
 #include "TM4C123GH6PM.h"
+#include "PWM_Channel.h"
 #include <stdint.h>
+
+/**
+ * @brief Motor PWM output: Module 0, Generator 0, output A, on PB6 (M0PWM0)
+ */
+#define PWM0_0_CHANNEL PWM_CHANNEL(0, 0, PWM_OUTPUT_A, PWM_PORT_B, 6)
+
+/**
+ * @brief Direction output of the motor driver: PB7, high for forward. It must be on the port
+ * of PWM0_0_CHANNEL, so that both pins are configured by the same register writes.
+ */
+#define PWM0_0_DIRECTION_PORT PWM_PORT_B
+#define PWM0_0_DIRECTION_PIN  7
+
 /**
  * @brief Initializes the PWM Module 0 Generator 0 with the specified period and duty cycle.
  *
@@ -39,22 +57,60 @@ void PWM0_0_Init(uint16_t period_constant, uint16_t duty_cycle);
 /**
  * @brief Updates the PWM Module 0 Generator 0 duty cycle for the PWM signal on the PB6 pin (M0PWM0).
  *
+ * The new value takes effect at the start of the next PWM period.
+ *
  * @param duty_cycle The new duty cycle for the PWM signal on the PB6 pin (M0PWM0).
+ *                   0 keeps the signal low.
  *
  * @return None
  */
 void PWM0_0_Update_Duty_Cycle(uint16_t duty_cycle);
+
 /**
- * @brief Updates the PWM Module 0 Generator 0 duty cycle for the PWM signal on the PB7 pin (M0PWM1).
+ * @brief Enables the PWM Module 0 Generator 0 interrupt at every reload of the counter.
+ *
+ * The interrupt is raised once per PWM period. It must also be enabled in the NVIC.
  *
- * @param duty_cycle2 The new duty cycle for the PWM signal on the PB7 pin (M0PWM1).
+ * @param None
  *
  * @return None
  */
+void PWM0_0_Enable_Load_Interrupt(void);
 
+/**
+ * @brief Acknowledges the PWM Module 0 Generator 0 load interrupt.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void PWM0_0_Clear_Load_Interrupt(void);
+
+/**
+ * @brief Drives the motor forward: sets the PB7 direction output and enables the PB6 output.
+ *
+ * @param None
+ *
+ * @return None
+ */
 void PWM0_0_Forward(void);
+
+/**
+ * @brief Drives the motor in reverse: clears the PB7 direction output and enables the PB6 output.
+ *
+ * @param None
+ *
+ * @return None
+ */
 void PWM0_0_Reverse(void);
+
+/**
+ * @brief Stops the motor: disables the PB6 output and clears the PB7 direction output.
+ *
+ * @param None
+ *
+ * @return None
+ */
 void PWM0_0_Stop(void);
- 
-#endif
 
+#endif
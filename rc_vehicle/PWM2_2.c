@@ -3,93 +3,173 @@
  *
  * @brief Source file for the PWM2_2 driver.
  *
- * This file contains the function definitions for the PWM0_0 driver.
- * It uses the Module 1 PWM Generator 0 to generate a PWM signal using the PB6 pin.
+ * This file contains the function definitions for the PWM2_2 driver.
+ * It uses the Module 0 PWM Generator 1 to generate the servo signal using the PB4 pin.
  *
- * @note This driver assumes that the system clock's frequency is 50 MHz.
+ * The angle table is evaluated by the compiler: each entry is a constant expression of the
+ * calibration constants in PWM2_2.h, so changing them only requires a rebuild.
+ *
+ * @note The period and duty cycle are counted in PWM clock cycles (SYSTEM_CLOCK_PWM_HZ, see System_Clock.h).
  *
  * @note This driver assumes that the PWM_Clock_Init function has been called
- * before calling the PWM0_0_Init function.
+ * before calling the PWM2_2_Init function.
  *
  * @author Ricardo Zaragoza, Jonathan Penaloza
  */
 
 #include "PWM2_2.h"
-// PB4 for the servo
- 
+#include "Trace.h"
+
+#if !PWM_CHANNEL_VALID(PWM2_2_CHANNEL)
+#error "PWM2_2_CHANNEL: the pin cannot carry the PWM signal (see Table 23-5 and PWM_Channel.h)"
+#endif
+
+#if (PWM2_2_SERVO_MAX_DEG <= 0) || (PWM2_2_SERVO_MAX_DEG > PWM2_2_TABLE_MAX_DEG)
+#error "PWM2_2_SERVO_MAX_DEG must be between 1 and PWM2_2_TABLE_MAX_DEG"
+#endif
+
+#if (PWM2_2_SERVO_MIN_US > PWM2_2_SERVO_MAX_US)
+#error "PWM2_2_SERVO_MIN_US must not exceed PWM2_2_SERVO_MAX_US"
+#endif
+
+// Calibration converted to PWM clock cycles
+#define PWM2_2_US_TO_TICKS(us) (((long long)(us) * SYSTEM_CLOCK_PWM_HZ) / 1000000LL)
+#define PWM2_2_CENTER_TICKS PWM2_2_US_TO_TICKS(PWM2_2_SERVO_CENTER_US)
+#define PWM2_2_LEFT_TICKS   PWM2_2_US_TO_TICKS(PWM2_2_SERVO_LEFT_US)
+#define PWM2_2_RIGHT_TICKS  PWM2_2_US_TO_TICKS(PWM2_2_SERVO_RIGHT_US)
+#define PWM2_2_TRIM_TICKS   PWM2_2_US_TO_TICKS(PWM2_2_SERVO_TRIM_US)
+#define PWM2_2_MIN_TICKS    PWM2_2_US_TO_TICKS(PWM2_2_SERVO_MIN_US)
+#define PWM2_2_MAX_TICKS    PWM2_2_US_TO_TICKS(PWM2_2_SERVO_MAX_US)
+
+// Angle limited to the calibrated range
+#define PWM2_2_LIMIT_DEG(deg) (((deg) > PWM2_2_SERVO_MAX_DEG) ? PWM2_2_SERVO_MAX_DEG : \
+	(((deg) < -PWM2_2_SERVO_MAX_DEG) ? -PWM2_2_SERVO_MAX_DEG : (deg)))
+
+// Offset from the center for an angle and the pulse width range on its side:
+// span * x * ((1 - k) + k * x^2), with x = deg / PWM2_2_SERVO_MAX_DEG and k the cubic share
+#define PWM2_2_SHAPE_TICKS(deg, span) \
+	(((long long)(span) * (deg) * ((1000LL - PWM2_2_SERVO_CUBIC_PERMILLE) * PWM2_2_SERVO_MAX_DEG * PWM2_2_SERVO_MAX_DEG \
+	+ (long long)PWM2_2_SERVO_CUBIC_PERMILLE * (deg) * (deg))) \
+	/ (1000LL * PWM2_2_SERVO_MAX_DEG * PWM2_2_SERVO_MAX_DEG * PWM2_2_SERVO_MAX_DEG))
+
+#define PWM2_2_RAW_TICKS(deg) (PWM2_2_CENTER_TICKS + PWM2_2_TRIM_TICKS + (((deg) >= 0) \
+	? PWM2_2_SHAPE_TICKS(deg, PWM2_2_RIGHT_TICKS - PWM2_2_CENTER_TICKS) \
+	: PWM2_2_SHAPE_TICKS(deg, PWM2_2_CENTER_TICKS - PWM2_2_LEFT_TICKS)))
+
+// Pulse width limited to the mechanical stops
+#define PWM2_2_STOP_TICKS(ticks) (uint16_t)(((ticks) < PWM2_2_MIN_TICKS) ? PWM2_2_MIN_TICKS : \
+	(((ticks) > PWM2_2_MAX_TICKS) ? PWM2_2_MAX_TICKS : (ticks)))
+
+// Table entry i holds the angle i - PWM2_2_TABLE_MAX_DEG
+#define PWM2_2_ENTRY(i) PWM2_2_STOP_TICKS(PWM2_2_RAW_TICKS(PWM2_2_LIMIT_DEG((i) - PWM2_2_TABLE_MAX_DEG)))
+#define PWM2_2_ROW(i) PWM2_2_ENTRY(i), PWM2_2_ENTRY(i + 1), PWM2_2_ENTRY(i + 2), PWM2_2_ENTRY(i + 3), \
+	PWM2_2_ENTRY(i + 4), PWM2_2_ENTRY(i + 5), PWM2_2_ENTRY(i + 6), PWM2_2_ENTRY(i + 7), \
+	PWM2_2_ENTRY(i + 8), PWM2_2_ENTRY(i + 9)
+
+#define PWM2_2_TABLE_SIZE (2 * PWM2_2_TABLE_MAX_DEG + 1)
+
+// Pulse width for every angle from -PWM2_2_TABLE_MAX_DEG to PWM2_2_TABLE_MAX_DEG, in flash
+static const uint16_t angle_table[] =
+{
+	PWM2_2_ROW(0), PWM2_2_ROW(10), PWM2_2_ROW(20), PWM2_2_ROW(30), PWM2_2_ROW(40),
+	PWM2_2_ROW(50), PWM2_2_ROW(60), PWM2_2_ROW(70), PWM2_2_ROW(80), PWM2_2_ENTRY(90)
+};
+
+// The rows above cover PWM2_2_TABLE_MAX_DEG = 45: the build fails if they no longer match
+typedef char PWM2_2_Table_Size_Check[(sizeof(angle_table) / sizeof(angle_table[0]) == PWM2_2_TABLE_SIZE) ? 1 : -1];
+
+// Runtime trim (see PWM2_2_Set_Trim_US) in PWM clock cycles, and the last angle set
+static int32_t servo_trim_ticks = 0;
+static int8_t servo_angle = 0;
+
+static uint16_t PWM2_2_Limit_Duty(uint16_t duty_cycle)
+{
+	return PWM2_2_STOP_TICKS(duty_cycle);
+}
+
 void PWM2_2_Init(uint16_t period_constant, uint16_t duty_cycle)
 {	
 	// Return from the function if the specified duty_cycle is greater than
 	// or equal to the given period. The duty cycle cannot exceed 99%.
 	if (duty_cycle >= period_constant) return;
 	
-	// Enable the clock to PWM Module 0 by setting the
-	// R0 bit (Bit 0) in the RCGCPWM register
-	SYSCTL->RCGCPWM |= 0x01;                  // Port B
+	// The servo is never driven past its mechanical stops
+	duty_cycle = PWM2_2_Limit_Duty(duty_cycle);
 	
-	// Enable the clock to GPIO Port B by setting the
-	// R1 bit (Bit 1) in the RCGCGPIO register
-	SYSCTL->RCGCGPIO |= 0x02;
+	// Enable the clock to the PWM module and to the GPIO port of the channel
+	// (R0 and R1, Bits 0 and 1, in the RCGCPWM and RCGCGPIO registers)
+	SYSCTL->RCGCPWM |= (1UL << PWM_CHANNEL_MODULE(PWM2_2_CHANNEL));
+	SYSCTL->RCGCGPIO |= (1UL << PWM_CHANNEL_PORT(PWM2_2_CHANNEL));
 	
-	// Configure the PB6 pin to use the alternate function (M0PWM0)
-	// by setting Bit 4 in the AFSEL register
-	GPIOB->AFSEL |= 0x10;
+	// Route the PB4 pin to M0PWM2 (PMC4 = 0x4), with one access to each of the
+	// AFSEL, PCTL and DEN registers
+	PWM_Channel_Configure_Pins(PWM_CHANNEL_GPIO(PWM2_2_CHANNEL),
+		PWM_CHANNEL_PIN_MASK(PWM2_2_CHANNEL),
+		PWM_CHANNEL_PCTL_MASK(PWM2_2_CHANNEL),
+		PWM_CHANNEL_PCTL_VALUE(PWM2_2_CHANNEL),
+		0);
 	
-	// Clear the PMC4 field 
-	GPIOB->PCTL &= ~0x000F0000;
-	
-	// Configure the PB6 pin to operate as a Module 0 PWM0 pin (M0PWM0)
-	// by writing 0x4 to the PMC4 field (Bits 27 to 24) in the PCTL register
-	// The 0x4 value is derived from Table 23-5 in the TM4C123G Microcontroller Datasheet
-	GPIOB->PCTL |= 0x00040000;
-	
-	// Enable the digital functionality for the PB6 pin
-	// by setting Bit 6 in the DEN register
-	GPIOB->DEN |= 0x10;
+	// Start Generator 1 in Count-Down mode with a period of period_constant PWM clock cycles.
+	// The output is driven high when the counter matches CMPA while counting down, and low at
+	// the reload, so the pulse width is duty_cycle PWM clock cycles
+	PWM_CHANNEL_START(PWM2_2_CHANNEL, period_constant - 1, duty_cycle - 1);
+}
+
+void PWM2_2_Update_Duty_Cycle(uint16_t duty_cycle)
+{
+	duty_cycle = PWM2_2_Limit_Duty(duty_cycle);
 	
-	// Disable the Module 0 PWM Generator 0 block (PWM0_0) before 
-	// configuration by clearing the ENABLE bit (Bit 0) in the PWM0CTL register
-	PWM0->_1_CTL &= ~0x01;
+	// Set the pulse width by writing to the COMPA field (Bits 15 to 0)
+	// in the PWM1CMPA register. When the counter matches the value in this register,
+	// the PWM signal will be driven high
+	PWM_CHANNEL_COMPARE(PWM2_2_CHANNEL) = (duty_cycle - 1);
+}
+
+uint16_t PWM2_2_Angle_Duty(int8_t degrees)
+{
+	int32_t angle = degrees;
+	int32_t duty_cycle;
 	
-	// Configure the counter for the PWM0_0 block to
-	// use Count-Down mode by clearing the MODE bit (Bit 1)
-	// in the PWM0CTL register. The counter will count from the load value
-	// to 0, and then wrap back to the load value
-	PWM0->_1_CTL &= ~0x02;
+	if (angle > PWM2_2_SERVO_MAX_DEG)
+	{
+		angle = PWM2_2_SERVO_MAX_DEG;
+	}
+	else if (angle < -PWM2_2_SERVO_MAX_DEG)
+	{
+		angle = -PWM2_2_SERVO_MAX_DEG;
+	}
 	
-	// Set the ACTCMPAD field (Bits 7 to 6) to 0x3 in the PWM0GENA register
-	// to drive the PWM signal high when the counter matches 
-	// the comparator (i.e. the value in PWM0CMPA) while counting down
-	PWM0->_1_GENA |= 0xC0;
+	// The trimmed pulse width is limited to the mechanical stops again
+	duty_cycle = (int32_t)angle_table[angle + PWM2_2_TABLE_MAX_DEG] + servo_trim_ticks;
 	
-	// Set the ACTLOAD field (Bits 3 to 2) to 0x2 in the PWM0GENA register
-	// to drive the PWM signal low when the counter matches the value
-	// in the PWM0LOAD register
-	PWM0->_1_GENA |= 0x08;
+	if (duty_cycle < (int32_t)PWM2_2_MIN_TICKS)
+	{
+		duty_cycle = (int32_t)PWM2_2_MIN_TICKS;
+	}
+	else if (duty_cycle > (int32_t)PWM2_2_MAX_TICKS)
+	{
+		duty_cycle = (int32_t)PWM2_2_MAX_TICKS;
+	}
 	
-	// Set the period by writing to the LOAD field (Bits 15 to 0) 
-	// in the PWM0LOAD register. This determines the number of clock
-	// cycles needed to count down to zero
-	PWM0->_1_LOAD = (period_constant - 1);
+	return (uint16_t)duty_cycle;
+}
+
+void PWM2_2_Set_Angle(int8_t degrees)
+{
+	uint32_t duty = PWM2_2_Angle_Duty(degrees);
 	
-	// Set the duty cycle by writing to the COMPA field (Bits 15 to 0)
-	// in the PWM0CMPA register. When the counter matches the value in this register,
-	// the PWM signal will be driven high
-	PWM0->_1_CMPA = (duty_cycle - 1);
+	servo_angle = degrees;
 	
-	// Enable the PWM0_0 block after configuration by setting the
-	// ENABLE bit (Bit 0) in the PWM0CTL register
-	PWM0->_1_CTL |= 0x01;
+	// The pulse widths of PWM2_2_Angle_Duty are already within the mechanical stops
+	PWM_CHANNEL_COMPARE(PWM2_2_CHANNEL) = (duty - 1);
 	
-	// Enable the PWM0_0 signal to be passed to the PB6 pin (M0PWM0)
-	// by setting the PWM0EN bit (Bit 0) in the PWMENABLE register
-	PWM0->ENABLE |= 0x04;
+	TRACE(TRACE_SERVO_WRITE, duty);
 }
 
-void PWM2_2_Update_Duty_Cycle(uint16_t duty_cycle)
+void PWM2_2_Set_Trim_US(int16_t trim_us)
 {
-	// Set the duty cycle by writing to the COMPA field (Bits 15 to 0)
-	// in the PWM0CMPA register. When the counter matches the value in this register,
-	// the PWM signal will be driven high
-	PWM0->_1_CMPA = (duty_cycle - 1);
-}
\ No newline at end of file
+	servo_trim_ticks = (int32_t)(((int64_t)trim_us * (int64_t)SYSTEM_CLOCK_PWM_HZ) / 1000000);
+	
+	// Move the servo to the trimmed pulse width of its current angle
+	PWM2_2_Set_Angle(servo_angle);
+}
@@ -1,44 +1,133 @@
 /**
  * @file PWM2_2.h
  *
- * @brief Header file for the PWM0_0 driver.
+ * @brief Header file for the PWM2_2 steering servo driver.
  *
- * This file contains the function definitions for the PWM0_0 driver.
- * It uses the Module 0 PWM Generator 0 to generate a PWM signal with the PB6 pin.
+ * This file contains the function definitions for the PWM2_2 driver.
+ * It uses the Module 0 PWM Generator 1 to generate the steering servo signal on the PB4 pin (M0PWM2).
+ * The pin is bound at compile time (see PWM_Channel.h).
  *
- * @note This driver assumes that the system clock's frequency is 50 MHz.
+ * The steering is commanded in degrees. The pulse width of every angle is read from a table
+ * that the compiler builds from the calibration constants below, so a steering update is one
+ * table load and one register write. The table never holds a pulse width outside
+ * PWM2_2_SERVO_MIN_US and PWM2_2_SERVO_MAX_US, the mechanical stops of the steering linkage,
+ * and PWM2_2_Update_Duty_Cycle applies the same limits.
+ *
+ * @note The period and duty cycle are counted in PWM clock cycles (SYSTEM_CLOCK_PWM_HZ, see System_Clock.h).
  *
  * @note This driver assumes that the PWM_Clock_Init function has been called
- * before calling the PWM0_0_Init function.
+ * before calling the PWM2_2_Init function.
  *
  * @author Ricardo Zaragoza, Jonathan Penaloza
  */
- 
+
+#ifndef PWM2_2_H
+#define PWM2_2_H
+
 #include "TM4C123GH6PM.h"
+#include "PWM_Channel.h"
+#include "System_Clock.h"
+#include <stdint.h>
+
+/**
+ * @brief Servo PWM output: Module 0, Generator 1, output A, on PB4 (M0PWM2)
+ */
+#define PWM2_2_CHANNEL PWM_CHANNEL(0, 1, PWM_OUTPUT_A, PWM_PORT_B, 4)
+
+/**
+ * @brief Servo calibration, in microseconds: pulse width for straight ahead, and pulse
+ * widths at full left and full right (PWM2_2_SERVO_MAX_DEG)
+ */
+#define PWM2_2_SERVO_CENTER_US 1500
+#define PWM2_2_SERVO_LEFT_US   480
+#define PWM2_2_SERVO_RIGHT_US  2500
+
+/**
+ * @brief Offset added to every pulse width so that the wheels point straight ahead at 0 degrees, in microseconds
+ */
+#define PWM2_2_SERVO_TRIM_US 0
+
+/**
+ * @brief Mechanical stops of the steering linkage, in microseconds. No pulse width
+ * outside this range is ever written.
+ */
+#define PWM2_2_SERVO_MIN_US 480
+#define PWM2_2_SERVO_MAX_US 2500
 
 /**
- * @brief Initializes the PWM Module 0 Generator 0 with the specified period and duty cycle.
+ * @brief Steering angle, in degrees, reached at PWM2_2_SERVO_LEFT_TICKS (negative) and
+ * PWM2_2_SERVO_RIGHT_TICKS (positive). It cannot exceed PWM2_2_TABLE_MAX_DEG.
+ */
+#define PWM2_2_SERVO_MAX_DEG 45
+
+/**
+ * @brief Nonlinearity of the steering linkage, in 1/1000: share of the pulse width range that
+ * follows the cube of the angle instead of the angle itself. 0 gives a linear mapping; higher
+ * values give finer steps around the center. The end points do not move.
+ */
+#define PWM2_2_SERVO_CUBIC_PERMILLE 0
+
+/**
+ * @brief Largest angle held in the lookup table
+ */
+#define PWM2_2_TABLE_MAX_DEG 45
+
+/**
+ * @brief Initializes the PWM Module 0 Generator 1 with the specified period and duty cycle.
  *
- * This function initializes the PWM Module 0 Generator 0 with the given period constant and duty cycle.
- * It configures the PB6 pin to operate as a Module 0 PWM0 pin (M0PWM0) to output the PWM signal.
- * period_constant determines the PWM signal's frequency. The specified duty_cycle value must be less 
- * than the period_constant.
+ * This function initializes the PWM Module 0 Generator 1 with the given period constant and duty cycle.
+ * It configures the PB4 pin to operate as a Module 0 PWM2 pin (M0PWM2) to output the PWM signal.
+ * period_constant determines the PWM signal's frequency. The specified duty_cycle value must be less
+ * than the period_constant, and is limited to the mechanical stops.
  *
  * @param period_constant The period constant for the PWM signal that determines the
  *                        PWM signal's frequency.
  *
- * @param duty_cycle The duty cycle, as a percentage of period_constant, for the PWM signal.
- *                   This value controls pulse width of the PWM signal.
+ * @param duty_cycle The initial pulse width in PWM clock cycles, for example PWM2_2_Angle_Duty(0).
  *
  * @return None
  */
 void PWM2_2_Init(uint16_t period_constant, uint16_t duty_cycle);
 
 /**
- * @brief Updates the PWM Module 0 Generator 0 duty cycle for the PWM signal on the PB6 pin (M0PWM0).
+ * @brief Updates the pulse width of the servo signal on the PB4 pin (M0PWM2).
  *
- * @param duty_cycle The new duty cycle for the PWM signal on the PB6 pin (M0PWM0).
+ * @param duty_cycle The new pulse width in PWM clock cycles, limited to PWM2_2_SERVO_MIN_US
+ *                   and PWM2_2_SERVO_MAX_US.
  *
  * @return None
  */
 void PWM2_2_Update_Duty_Cycle(uint16_t duty_cycle);
+
+/**
+ * @brief Returns the calibrated pulse width for a steering angle.
+ *
+ * @param degrees Steering angle, negative to the left. Values beyond PWM2_2_SERVO_MAX_DEG are clamped.
+ *
+ * @return The pulse width in PWM clock cycles.
+ */
+uint16_t PWM2_2_Angle_Duty(int8_t degrees);
+
+/**
+ * @brief Turns the steering servo to a calibrated angle.
+ *
+ * @param degrees Steering angle, negative to the left. Values beyond PWM2_2_SERVO_MAX_DEG are clamped.
+ *
+ * @return None
+ */
+void PWM2_2_Set_Angle(int8_t degrees);
+
+/**
+ * @brief Sets the runtime trim of the steering servo, and applies it to the current angle.
+ *
+ * The trim is added to every calibrated pulse width, on top of PWM2_2_SERVO_TRIM_US. It is
+ * the servo_trim_us parameter (see Parameters.h), so that the steering can be centered
+ * without rebuilding the firmware.
+ *
+ * @param trim_us Offset in microseconds, positive to the right.
+ *
+ * @return None
+ */
+void PWM2_2_Set_Trim_US(int16_t trim_us);
+
+#endif
@@ -0,0 +1,265 @@
+/**
+ * @file PWM_Channel.h
+ *
+ * @brief Header file for the compile-time PWM output bindings.
+ *
+ * A PWM output is bound to a pin by a constant tuple:
+ *
+ *   PWM_CHANNEL(module, generator, output, port, pin)
+ *
+ * for example PWM_CHANNEL(0, 1, PWM_OUTPUT_A, PWM_PORT_B, 4) for M0PWM2 on PB4. Every field is
+ * a constant, so a driver checks its binding against the pin-mux table of the TM4C123GH6PM
+ * with the preprocessor (PWM_CHANNEL_VALID), and a pin that cannot carry the signal is a
+ * build error instead of a dead output. The register addresses, bit masks and PCTL values are
+ * derived from the same tuple, so the compiler folds them into the instructions, and the init
+ * sequence is one write or read-modify-write per register:
+ *
+ * - PWM_Channel_Configure_Pins: AFSEL, PCTL and DEN of the port, with the GPIO outputs of the
+ *   same port that the driver needs (such as a direction pin) merged into the same writes.
+ * - PWM_CHANNEL_START: CTL, GENA or GENB, LOAD, CMPA or CMPB written once each, without
+ *   reading them back, then the output enabled.
+ *
+ * The duty cycle register of a channel is PWM_CHANNEL_COMPARE, a single store.
+ *
+ * @note The table is Table 23-5 of the TM4C123G Microcontroller Datasheet: module 0 signals
+ * use the PCTL value 4 and module 1 signals the value 5. The NMI-locked pins PD7 and PF0
+ * would also need to be unlocked through GPIOLOCK and GPIOCR; no driver uses them.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef PWM_CHANNEL_H
+#define PWM_CHANNEL_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief GPIO ports, numbered like the bits of the RCGCGPIO register
+ */
+#define PWM_PORT_A 0
+#define PWM_PORT_B 1
+#define PWM_PORT_C 2
+#define PWM_PORT_D 3
+#define PWM_PORT_E 4
+#define PWM_PORT_F 5
+
+/**
+ * @brief Outputs of a PWM generator
+ */
+#define PWM_OUTPUT_A 0
+#define PWM_OUTPUT_B 1
+
+/**
+ * @brief Binds a PWM output to a pin. module is 0 or 1 and generator 0 to 3; the generator
+ * drives the signals M<module>PWM<2 * generator> (output A) and M<module>PWM<2 * generator + 1> (output B).
+ */
+#define PWM_CHANNEL(module, generator, output, port, pin) (module, generator, output, port, pin)
+
+// Applies a macro to the fields of a binding
+#define PWM_CHANNEL_APPLY(macro, channel) macro channel
+
+#define PWM_CHANNEL_FIELD_MODULE(module, generator, output, port, pin)    (module)
+#define PWM_CHANNEL_FIELD_GENERATOR(module, generator, output, port, pin) (generator)
+#define PWM_CHANNEL_FIELD_OUTPUT(module, generator, output, port, pin)    (output)
+#define PWM_CHANNEL_FIELD_PORT(module, generator, output, port, pin)      (port)
+#define PWM_CHANNEL_FIELD_PIN(module, generator, output, port, pin)       (pin)
+
+/**
+ * @brief Fields of a binding
+ */
+#define PWM_CHANNEL_MODULE(channel)    PWM_CHANNEL_APPLY(PWM_CHANNEL_FIELD_MODULE, channel)
+#define PWM_CHANNEL_GENERATOR(channel) PWM_CHANNEL_APPLY(PWM_CHANNEL_FIELD_GENERATOR, channel)
+#define PWM_CHANNEL_OUTPUT(channel)    PWM_CHANNEL_APPLY(PWM_CHANNEL_FIELD_OUTPUT, channel)
+#define PWM_CHANNEL_PORT(channel)      PWM_CHANNEL_APPLY(PWM_CHANNEL_FIELD_PORT, channel)
+#define PWM_CHANNEL_PIN(channel)       PWM_CHANNEL_APPLY(PWM_CHANNEL_FIELD_PIN, channel)
+
+/**
+ * @brief Number of the M<module>PWM<signal> signal of a binding
+ */
+#define PWM_CHANNEL_SIGNAL(channel) ((2 * PWM_CHANNEL_GENERATOR(channel)) + PWM_CHANNEL_OUTPUT(channel))
+
+// One row of the pin-mux table
+#define PWM_CHANNEL_ROW(channel, module, signal, port, pin) \
+	((PWM_CHANNEL_MODULE(channel) == (module)) && (PWM_CHANNEL_SIGNAL(channel) == (signal)) && \
+	(PWM_CHANNEL_PORT(channel) == (port)) && (PWM_CHANNEL_PIN(channel) == (pin)))
+
+/**
+ * @brief 1 if the pin of a binding can carry its signal (Table 23-5), 0 otherwise. It can be
+ * used in #if.
+ */
+#define PWM_CHANNEL_VALID(channel) \
+	((PWM_CHANNEL_GENERATOR(channel) >= 0) && (PWM_CHANNEL_GENERATOR(channel) <= 3) && \
+	((PWM_CHANNEL_OUTPUT(channel) == PWM_OUTPUT_A) || (PWM_CHANNEL_OUTPUT(channel) == PWM_OUTPUT_B)) && ( \
+	PWM_CHANNEL_ROW(channel, 0, 0, PWM_PORT_B, 6) || \
+	PWM_CHANNEL_ROW(channel, 0, 1, PWM_PORT_B, 7) || \
+	PWM_CHANNEL_ROW(channel, 0, 2, PWM_PORT_B, 4) || \
+	PWM_CHANNEL_ROW(channel, 0, 3, PWM_PORT_B, 5) || \
+	PWM_CHANNEL_ROW(channel, 0, 4, PWM_PORT_E, 4) || \
+	PWM_CHANNEL_ROW(channel, 0, 5, PWM_PORT_E, 5) || \
+	PWM_CHANNEL_ROW(channel, 0, 6, PWM_PORT_C, 4) || \
+	PWM_CHANNEL_ROW(channel, 0, 6, PWM_PORT_D, 0) || \
+	PWM_CHANNEL_ROW(channel, 0, 7, PWM_PORT_C, 5) || \
+	PWM_CHANNEL_ROW(channel, 0, 7, PWM_PORT_D, 1) || \
+	PWM_CHANNEL_ROW(channel, 1, 0, PWM_PORT_D, 0) || \
+	PWM_CHANNEL_ROW(channel, 1, 1, PWM_PORT_D, 1) || \
+	PWM_CHANNEL_ROW(channel, 1, 2, PWM_PORT_A, 6) || \
+	PWM_CHANNEL_ROW(channel, 1, 2, PWM_PORT_E, 4) || \
+	PWM_CHANNEL_ROW(channel, 1, 3, PWM_PORT_A, 7) || \
+	PWM_CHANNEL_ROW(channel, 1, 3, PWM_PORT_E, 5) || \
+	PWM_CHANNEL_ROW(channel, 1, 4, PWM_PORT_F, 0) || \
+	PWM_CHANNEL_ROW(channel, 1, 5, PWM_PORT_F, 1) || \
+	PWM_CHANNEL_ROW(channel, 1, 6, PWM_PORT_F, 2) || \
+	PWM_CHANNEL_ROW(channel, 1, 7, PWM_PORT_F, 3)))
+
+/**
+ * @brief Pin bit of a binding, in the GPIO registers of its port
+ */
+#define PWM_CHANNEL_PIN_MASK(channel) (1UL << PWM_CHANNEL_PIN(channel))
+
+/**
+ * @brief PMCn field of the pin of a binding in the GPIOPCTL register, and the value that
+ * selects the PWM signal in it
+ */
+#define PWM_CHANNEL_PCTL_MASK(channel)  (0x0FUL << (4 * PWM_CHANNEL_PIN(channel)))
+#define PWM_CHANNEL_PCTL_VALUE(channel) ((PWM_CHANNEL_MODULE(channel) ? 0x05UL : 0x04UL) << (4 * PWM_CHANNEL_PIN(channel)))
+
+/**
+ * @brief Signal bit of a binding in the PWMENABLE register
+ */
+#define PWM_CHANNEL_ENABLE_MASK(channel) (1UL << PWM_CHANNEL_SIGNAL(channel))
+
+/**
+ * @brief Registers of one PWM generator. The four generators of a module are 0x40 bytes apart,
+ * from offset 0x40 (PWMnCTL, see the _0_ to _3_ registers of PWM0_Type).
+ */
+typedef struct
+{
+	__IO uint32_t CTL;
+	__IO uint32_t INTEN;
+	__IO uint32_t RIS;
+	__IO uint32_t ISC;
+	__IO uint32_t LOAD;
+	__IO uint32_t COUNT;
+	__IO uint32_t CMPA;
+	__IO uint32_t CMPB;
+	__IO uint32_t GENA;
+	__IO uint32_t GENB;
+	__IO uint32_t DBCTL;
+	__IO uint32_t DBRISE;
+	__IO uint32_t DBFALL;
+	__IO uint32_t FLTSRC0;
+	__IO uint32_t FLTSRC1;
+	__IO uint32_t MINFLTPER;
+} PWM_Generator_Type;
+
+typedef char PWM_Generator_Layout_Check[(sizeof(PWM_Generator_Type) == 0x40) ? 1 : -1];
+
+/**
+ * @brief Module, generator and GPIO port registers of a binding
+ */
+#define PWM_CHANNEL_MODULE_REGS(channel)    ((PWM0_Type *)(PWM_CHANNEL_MODULE(channel) ? PWM1_BASE : PWM0_BASE))
+#define PWM_CHANNEL_GENERATOR_REGS(channel) \
+	((PWM_Generator_Type *)((PWM_CHANNEL_MODULE(channel) ? PWM1_BASE : PWM0_BASE) + 0x40UL + (0x40UL * PWM_CHANNEL_GENERATOR(channel))))
+#define PWM_CHANNEL_GPIO(channel) \
+	((GPIOA_Type *)((PWM_CHANNEL_PORT(channel) == PWM_PORT_A) ? GPIOA_BASE : \
+	(PWM_CHANNEL_PORT(channel) == PWM_PORT_B) ? GPIOB_BASE : \
+	(PWM_CHANNEL_PORT(channel) == PWM_PORT_C) ? GPIOC_BASE : \
+	(PWM_CHANNEL_PORT(channel) == PWM_PORT_D) ? GPIOD_BASE : \
+	(PWM_CHANNEL_PORT(channel) == PWM_PORT_E) ? GPIOE_BASE : GPIOF_BASE))
+
+/**
+ * @brief Comparator register of a binding: CMPA for output A, CMPB for output B
+ */
+#define PWM_CHANNEL_COMPARE(channel) \
+	(*((PWM_CHANNEL_OUTPUT(channel) == PWM_OUTPUT_A) ? &PWM_CHANNEL_GENERATOR_REGS(channel)->CMPA : &PWM_CHANNEL_GENERATOR_REGS(channel)->CMPB))
+
+/**
+ * @brief The PWM_Channel_Configure_Pins function routes the pins of a port to their PWM signals,
+ * and makes other pins of the same port digital outputs, with one access to each register.
+ *
+ * @param gpio Registers of the port (PWM_CHANNEL_GPIO).
+ *
+ * @param pwm_pins Pins that carry a PWM signal (PWM_CHANNEL_PIN_MASK).
+ *
+ * @param pctl_mask PMCn fields of the PWM pins and of the outputs in the GPIOPCTL register.
+ *
+ * @param pctl_value Values of the PMCn fields (PWM_CHANNEL_PCTL_VALUE, 0 for the outputs).
+ *
+ * @param output_pins Pins that become digital outputs driven through GPIODATA, 0 for none.
+ *
+ * @return None
+ */
+static inline void PWM_Channel_Configure_Pins(GPIOA_Type *gpio, uint32_t pwm_pins, uint32_t pctl_mask, uint32_t pctl_value, uint32_t output_pins)
+{
+	// Select the alternate function of the PWM pins, and the GPIO function of the outputs
+	gpio->AFSEL = (gpio->AFSEL & ~output_pins) | pwm_pins;
+	
+	// Write the PMCn fields of all the pins at once
+	gpio->PCTL = (gpio->PCTL & ~pctl_mask) | pctl_value;
+	
+	if (output_pins != 0)
+	{
+		gpio->DIR |= output_pins;
+	}
+	
+	// Enable the digital functionality of all the pins
+	gpio->DEN |= pwm_pins | output_pins;
+}
+
+/**
+ * @brief The PWM_Channel_Start function starts a generator in Count-Down mode and enables one of
+ * its outputs. CTL, the action register, LOAD and the comparator are written without being read.
+ *
+ * @param module Registers of the PWM module (PWM_CHANNEL_MODULE_REGS).
+ *
+ * @param generator Registers of the generator (PWM_CHANNEL_GENERATOR_REGS).
+ *
+ * @param output PWM_OUTPUT_A or PWM_OUTPUT_B.
+ *
+ * @param enable_mask Bit of the output in the PWMENABLE register (PWM_CHANNEL_ENABLE_MASK).
+ *
+ * @param load Value of the LOAD register: the period is load + 1 PWM clock cycles.
+ *
+ * @param compare Value of the comparator of the output.
+ *
+ * @return None
+ */
+static inline void PWM_Channel_Start(PWM0_Type *module, PWM_Generator_Type *generator, uint8_t output, uint32_t enable_mask, uint16_t load, uint16_t compare)
+{
+	// Stop the generator while it is configured. Clearing the whole register also selects
+	// Count-Down mode (MODE, Bit 1), and locally synchronized updates (LOADUPD, CMPAUPD and
+	// CMPBUPD = 0): a new LOAD or comparator value takes effect when the counter reaches
+	// zero, at the end of the current period, never in the middle of a pulse
+	generator->CTL = 0;
+	
+	// Drive the output high when the counter matches its comparator while counting down
+	// (ACTCMPAD or ACTCMPBD = 0x3), and low when the counter is reloaded (ACTLOAD = 0x2)
+	if (output == PWM_OUTPUT_A)
+	{
+		generator->GENA = 0x00C8;
+		generator->CMPA = compare;
+	}
+	else
+	{
+		generator->GENB = 0x0C08;
+		generator->CMPB = compare;
+	}
+	
+	generator->LOAD = load;
+	
+	// Start the generator (ENABLE, Bit 0)
+	generator->CTL = 0x01;
+	
+	// Pass the signal to its pin. PWMENABLE is shared by the generators of the module
+	module->ENABLE |= enable_mask;
+}
+
+/**
+ * @brief Starts the generator and enables the output of a binding
+ */
+#define PWM_CHANNEL_START(channel, load, compare) \
+	PWM_Channel_Start(PWM_CHANNEL_MODULE_REGS(channel), PWM_CHANNEL_GENERATOR_REGS(channel), \
+	PWM_CHANNEL_OUTPUT(channel), PWM_CHANNEL_ENABLE_MASK(channel), (load), (compare))
+
+#endif
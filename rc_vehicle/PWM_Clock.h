@@ -9,19 +9,20 @@
  *
  * When the PWM divisor is used, it is applied to the clock for both PWM modules.
  *
- * @note This driver assumes that the system clock's frequency is 50 MHz.
+ * The divider is selected by the clock configuration (SYSTEM_CLOCK_PWM_DIVIDER, see System_Clock.h).
  *
  * @author Aaron Nanas
  */
 
 #include "TM4C123GH6PM.h"
+#include "System_Clock.h"
 
 /**
  * @brief Initializes the PWM clock source.
  *
  * This function configures the PWM modules to use a divided PWM clock. 
  * It enables the PWM clock divisor using the RCC register and sets 
- * the divisor to divide the PWM clock frequency by 16.
+ * the divisor to SYSTEM_CLOCK_PWM_DIVIDER (16 at 50 MHz, 32 at 80 MHz).
  *
  * @param None
  *
@@ -9,7 +9,7 @@
  *
  * When the PWM divisor is used, it is applied to the clock for both PWM modules.
  *
- * @note This driver assumes that the system clock's frequency is 50 MHz.
+ * The divider is selected by the clock configuration (SYSTEM_CLOCK_PWM_DIVIDER, see System_Clock.h).
  *
  * @author Jonathan Penaloza
  */
@@ -25,9 +25,8 @@ void PWM_Clock_Init(void)
 	// Clear the PWMDIV field (Bits 19 to 17) in the RCC register
 	SYSCTL->RCC &= ~0x000E0000;
 	
-	// Divide the PWM clock frequency by 16 by writing 0x3
-	// to the PWMDIV field (Bits 19 to 17)
-	// Note: Only the upper 3 bits are read/write. 0110 (0x6) -> 011 (0x3)
+	// Divide the PWM clock frequency by SYSTEM_CLOCK_PWM_DIVIDER by writing its
+	// encoding to the PWMDIV field (Bits 19 to 17): 0x3 divides by 16, 0x4 by 32
 	// Refer to page 255 of the TM4C123G Microcontroller Datasheet
-	SYSCTL->RCC |= 0x00060000;
+	SYSCTL->RCC |= ((uint32_t)SYSTEM_CLOCK_PWMDIV_FIELD << 17);
 }
@@ -0,0 +1,254 @@
+/**
+ * @file Parameters.c
+ *
+ * @brief Source code for the runtime parameter store.
+ *
+ * The parameters are used from thread context only (the scheduler tasks), except for the
+ * motor ramp limits, which Motion_Profile_Configure hands to the PWM0_0 interrupt itself.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Parameters.h"
+#include "EEPROM.h"
+#include "Protocol.h"
+#include "Latency.h"
+#include "Vehicle_Control.h"
+#include "Speed_Control.h"
+#include "Motion_Profile.h"
+#include "PWM2_2.h"
+#include <stddef.h>
+
+// Largest servo trim in microseconds, either way
+#define PARAMETERS_MAX_TRIM_US 200
+
+// Storage type of a field of Parameter_Values
+typedef enum
+{
+	PARAMETER_UINT16,
+	PARAMETER_INT16,
+	PARAMETER_UINT32
+} Parameter_Type;
+
+// A parameter: its description, its field, and the function that hands a new value to the
+// module that does not read the field directly, or 0
+typedef struct
+{
+	Parameter_Info info;
+	Parameter_Type type;
+	uint8_t offset;
+	void (*apply)(void);
+} Parameter_Entry;
+
+#define PARAMETER_FIELD(field) ((uint8_t)offsetof(Parameter_Values, field))
+
+Parameter_Values parameters;
+
+static void Parameters_Apply_Trim(void)
+{
+	PWM2_2_Set_Trim_US(parameters.servo_trim_us);
+}
+
+static void Parameters_Apply_Ramp(void)
+{
+	Motion_Profile_Configure(parameters.accel_percent_s, parameters.jerk_percent_s2);
+}
+
+// The parameter table. New parameters go at the end, so that saved images keep loading
+static const Parameter_Entry parameter_table[] =
+{
+	{ { "stop_cm", VEHICLE_STOP_DISTANCE_CM, 0, 100 }, PARAMETER_UINT16, PARAMETER_FIELD(stop_distance_cm), 0 },
+	{ { "ttc_min_ms", VEHICLE_TTC_MIN_MS, 0, 2000 }, PARAMETER_UINT16, PARAMETER_FIELD(ttc_min_ms), 0 },
+	{ { "ttc_max_ms", VEHICLE_TTC_MAX_MS, 0, 2000 }, PARAMETER_UINT16, PARAMETER_FIELD(ttc_max_ms), 0 },
+	{ { "cruise_mm_s", VEHICLE_CRUISE_SPEED_MM_S, 0, VEHICLE_MAX_SPEED_MM_S }, PARAMETER_UINT16, PARAMETER_FIELD(cruise_speed_mm_s), 0 },
+	{ { "servo_trim_us", 0, -PARAMETERS_MAX_TRIM_US, PARAMETERS_MAX_TRIM_US }, PARAMETER_INT16, PARAMETER_FIELD(servo_trim_us), Parameters_Apply_Trim },
+	{ { "accel_pct_s", MOTION_PROFILE_DEFAULT_ACCEL_PERCENT_S, 0, 10000 }, PARAMETER_UINT16, PARAMETER_FIELD(accel_percent_s), Parameters_Apply_Ramp },
+	{ { "jerk_pct_s2", MOTION_PROFILE_DEFAULT_JERK_PERCENT_S2, 0, 60000 }, PARAMETER_UINT16, PARAMETER_FIELD(jerk_percent_s2), Parameters_Apply_Ramp },
+	{ { "speed_kp_q8", SPEED_CONTROL_KP_Q8, 0, 1000000 }, PARAMETER_UINT32, PARAMETER_FIELD(speed_kp_q8), 0 },
+	{ { "speed_ki_q8", SPEED_CONTROL_KI_Q8, 0, 1000000 }, PARAMETER_UINT32, PARAMETER_FIELD(speed_ki_q8), 0 }
+};
+
+#define PARAMETERS_COUNT (sizeof(parameter_table) / sizeof(parameter_table[0]))
+
+// The image (header, values and CRC) must fit in the EEPROM block read at boot
+typedef char Parameters_Count_Check[(PARAMETERS_COUNT <= PARAMETERS_MAX_COUNT) ? 1 : -1];
+typedef char Parameters_Image_Check[(PARAMETERS_MAX_COUNT + 2 <= EEPROM_BLOCK_WORDS) ? 1 : -1];
+
+static Parameters_Source parameters_source;
+static uint32_t parameters_load_cycles;
+
+static int32_t Parameters_Read_Field(const Parameter_Entry *entry)
+{
+	const uint8_t *field = (const uint8_t *)&parameters + entry->offset;
+	
+	switch (entry->type)
+	{
+		case PARAMETER_INT16:
+			return *(const int16_t *)field;
+		
+		case PARAMETER_UINT32:
+			return (int32_t)*(const uint32_t *)field;
+		
+		default:
+			return *(const uint16_t *)field;
+	}
+}
+
+static void Parameters_Write_Field(const Parameter_Entry *entry, int32_t value)
+{
+	uint8_t *field = (uint8_t *)&parameters + entry->offset;
+	
+	switch (entry->type)
+	{
+		case PARAMETER_INT16:
+			*(int16_t *)field = (int16_t)value;
+			break;
+		
+		case PARAMETER_UINT32:
+			*(uint32_t *)field = (uint32_t)value;
+			break;
+		
+		default:
+			*(uint16_t *)field = (uint16_t)value;
+			break;
+	}
+}
+
+static int Parameters_In_Range(const Parameter_Entry *entry, int32_t value)
+{
+	return (value >= entry->info.minimum) && (value <= entry->info.maximum);
+}
+
+static uint16_t Parameters_Image_CRC(const uint32_t *image, uint8_t words)
+{
+	return Protocol_CRC16((const uint8_t *)image, (uint16_t)(words * 4));
+}
+
+// Loads the values of a valid image, and returns 0 if the image is not valid
+static int Parameters_Load_Image(const uint32_t *image)
+{
+	uint8_t count = (uint8_t)(image[0] & 0xFF);
+	uint8_t i;
+	
+	if (((image[0] >> 16) != PARAMETERS_MAGIC) || (count > PARAMETERS_MAX_COUNT) ||
+		(image[count + 1] != Parameters_Image_CRC(image, count + 1)))
+	{
+		return 0;
+	}
+	
+	// A value out of the range of the current firmware keeps its default
+	for (i = 0; (i < count) && (i < PARAMETERS_COUNT); i++)
+	{
+		if (Parameters_In_Range(&parameter_table[i], (int32_t)image[i + 1]))
+		{
+			Parameters_Write_Field(&parameter_table[i], (int32_t)image[i + 1]);
+		}
+	}
+	
+	return 1;
+}
+
+void Parameters_Init(void)
+{
+	uint32_t image[EEPROM_BLOCK_WORDS];
+	uint32_t start_cycles;
+	uint8_t i;
+	
+	for (i = 0; i < PARAMETERS_COUNT; i++)
+	{
+		Parameters_Write_Field(&parameter_table[i], parameter_table[i].info.default_value);
+	}
+	
+	if (!EEPROM_Init())
+	{
+		parameters_source = PARAMETERS_SOURCE_NO_EEPROM;
+		parameters_load_cycles = 0;
+	}
+	else
+	{
+		// The whole image is read in one pass over its block, whatever the number of values it holds
+		start_cycles = LATENCY_NOW_CYCLES();
+		
+		parameters_source = (EEPROM_Read(0, image, EEPROM_BLOCK_WORDS) && Parameters_Load_Image(image)) ?
+			PARAMETERS_SOURCE_EEPROM : PARAMETERS_SOURCE_DEFAULTS;
+		
+		parameters_load_cycles = LATENCY_NOW_CYCLES() - start_cycles;
+	}
+	
+	for (i = 0; i < PARAMETERS_COUNT; i++)
+	{
+		if (parameter_table[i].apply != 0)
+		{
+			parameter_table[i].apply();
+		}
+	}
+}
+
+uint8_t Parameters_Count(void)
+{
+	return PARAMETERS_COUNT;
+}
+
+const Parameter_Info *Parameters_Get_Info(uint8_t index)
+{
+	if (index >= PARAMETERS_COUNT)
+	{
+		return 0;
+	}
+	
+	return &parameter_table[index].info;
+}
+
+int32_t Parameters_Get(uint8_t index)
+{
+	return Parameters_Read_Field(&parameter_table[index]);
+}
+
+int Parameters_Set(uint8_t index, int32_t value)
+{
+	if ((index >= PARAMETERS_COUNT) || !Parameters_In_Range(&parameter_table[index], value))
+	{
+		return 0;
+	}
+	
+	Parameters_Write_Field(&parameter_table[index], value);
+	
+	if (parameter_table[index].apply != 0)
+	{
+		parameter_table[index].apply();
+	}
+	
+	return 1;
+}
+
+int Parameters_Save(void)
+{
+	uint32_t image[PARAMETERS_COUNT + 2];
+	uint8_t i;
+	
+	if (parameters_source == PARAMETERS_SOURCE_NO_EEPROM)
+	{
+		return 0;
+	}
+	
+	image[0] = ((uint32_t)PARAMETERS_MAGIC << 16) | PARAMETERS_COUNT;
+	
+	for (i = 0; i < PARAMETERS_COUNT; i++)
+	{
+		image[i + 1] = (uint32_t)Parameters_Read_Field(&parameter_table[i]);
+	}
+	
+	image[PARAMETERS_COUNT + 1] = Parameters_Image_CRC(image, PARAMETERS_COUNT + 1);
+	
+	return EEPROM_Write(0, image, PARAMETERS_COUNT + 2);
+}
+
+Parameters_Source Parameters_Get_Source(void)
+{
+	return parameters_source;
+}
+
+uint32_t Parameters_Get_Load_Cycles(void)
+{
+	return parameters_load_cycles;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file Parameters.h
+ *
+ * @brief Header file for the runtime parameter store.
+ *
+ * The tuning constants that used to require a rebuild are held in one structure,
+ * Parameter_Values, which the control code reads directly as plain fields of the global
+ * `parameters` (no lookup, no function call). Each field is described by an entry of the
+ * parameter table in Parameters.c: name, type, default value and range. The defaults are the
+ * compile-time constants of the modules that use them.
+ *
+ * - Parameters_Init loads the saved values from the on-chip EEPROM (see EEPROM.h) in a single
+ *   sequential read at boot. When the EEPROM holds no valid image, the defaults are kept.
+ * - The values are read and changed by index over UART0, in character mode ('#' commands,
+ *   see Command_Parser.h) or in framed mode (PROTOCOL_PARAM_GET and PROTOCOL_PARAM_SET, see
+ *   Protocol.h). A change applies at once, and is kept across resets only once it is saved
+ *   (Parameters_Save).
+ *
+ * EEPROM image, from word 0:
+ *
+ *   PARAMETERS_MAGIC << 16 | number of values | the values, one word each, in table order |
+ *   CRC-16 of the previous words (see Protocol_CRC16)
+ *
+ * New parameters must be added at the end of the table: an image saved by an older firmware
+ * still loads, and the new parameters keep their defaults.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef PARAMETERS_H
+#define PARAMETERS_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief Largest number of parameters: the image fits in one EEPROM block
+ */
+#define PARAMETERS_MAX_COUNT 14
+
+/**
+ * @brief Longest parameter name in characters
+ */
+#define PARAMETERS_NAME_MAX 14
+
+/**
+ * @brief First half-word of a valid EEPROM image
+ */
+#define PARAMETERS_MAGIC 0x5041
+
+/**
+ * @brief The parameter values. Every field is read-only outside Parameters.c: use
+ * Parameters_Set to change one.
+ */
+typedef struct
+{
+	/** Forward motion is stopped when an obstacle is closer, in centimeters (VEHICLE_STOP_DISTANCE_CM) */
+	uint16_t stop_distance_cm;
+	
+	/** Time-to-collision thresholds at a commanded speed of 0 and of VEHICLE_MAX_SPEED_MM_S, in milliseconds (VEHICLE_TTC_MIN_MS, VEHICLE_TTC_MAX_MS) */
+	uint16_t ttc_min_ms;
+	uint16_t ttc_max_ms;
+	
+	/** Wheel speed of the 'A' and 'B' commands, in millimeters per second (VEHICLE_CRUISE_SPEED_MM_S) */
+	uint16_t cruise_speed_mm_s;
+	
+	/** Offset added to the steering servo pulse width, in microseconds (see PWM2_2_Set_Trim_US) */
+	int16_t servo_trim_us;
+	
+	/** Motor ramp limits, in percent per second and per second squared (see Motion_Profile_Configure) */
+	uint16_t accel_percent_s;
+	uint16_t jerk_percent_s2;
+	
+	/** Speed controller gains, in duty cycle counts per mm/s and per mm/s per second, in 1/256 units (SPEED_CONTROL_KP_Q8, SPEED_CONTROL_KI_Q8) */
+	uint32_t speed_kp_q8;
+	uint32_t speed_ki_q8;
+} Parameter_Values;
+
+/**
+ * @brief Description of one parameter.
+ */
+typedef struct
+{
+	/** Name printed and sent to the host, at most PARAMETERS_NAME_MAX characters */
+	const char *name;
+	
+	/** Default value and accepted range */
+	int32_t default_value;
+	int32_t minimum;
+	int32_t maximum;
+} Parameter_Info;
+
+/**
+ * @brief Where the current values were loaded from at boot
+ */
+typedef enum
+{
+	PARAMETERS_SOURCE_DEFAULTS = 0,  // no valid image in the EEPROM
+	PARAMETERS_SOURCE_EEPROM = 1,    // the saved image
+	PARAMETERS_SOURCE_NO_EEPROM = 2  // the EEPROM module reported an error
+} Parameters_Source;
+
+/**
+ * @brief The current parameter values
+ */
+extern Parameter_Values parameters;
+
+/**
+ * @brief The Parameters_Init function loads the saved parameters, or the defaults, and applies them.
+ *
+ * Motion_Profile_Init and PWM2_2_Init must have been called before this function, and it
+ * must be called before the modules that read the parameters are initialized.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Parameters_Init(void);
+
+/**
+ * @brief The Parameters_Count function returns the number of parameters.
+ *
+ * @param None
+ *
+ * @return The number of parameters.
+ */
+uint8_t Parameters_Count(void);
+
+/**
+ * @brief The Parameters_Get_Info function returns the description of a parameter.
+ *
+ * @param index Index of the parameter in the table.
+ *
+ * @return Pointer to the description, or 0 if the index is invalid.
+ */
+const Parameter_Info *Parameters_Get_Info(uint8_t index);
+
+/**
+ * @brief The Parameters_Get function returns the current value of a parameter.
+ *
+ * @param index Index of the parameter in the table, which must be valid.
+ *
+ * @return The value.
+ */
+int32_t Parameters_Get(uint8_t index);
+
+/**
+ * @brief The Parameters_Set function changes a parameter and applies it.
+ *
+ * @param index Index of the parameter in the table.
+ * @param value The new value.
+ *
+ * @return 1 if the value was changed, 0 if the index is invalid or the value is out of range.
+ */
+int Parameters_Set(uint8_t index, int32_t value);
+
+/**
+ * @brief The Parameters_Save function writes the current values to the EEPROM.
+ *
+ * It waits until the image is stored, for up to a few milliseconds.
+ *
+ * @param None
+ *
+ * @return 1 if the image was stored, 0 if the EEPROM reported an error.
+ */
+int Parameters_Save(void);
+
+/**
+ * @brief The Parameters_Get_Source function reports where the values were loaded from at boot.
+ *
+ * @param None
+ *
+ * @return The Parameters_Source.
+ */
+Parameters_Source Parameters_Get_Source(void);
+
+/**
+ * @brief The Parameters_Get_Load_Cycles function returns the time taken by Parameters_Init
+ * to read and check the EEPROM image.
+ *
+ * @param None
+ *
+ * @return The time in system clock cycles.
+ */
+uint32_t Parameters_Get_Load_Cycles(void);
+
+#endif
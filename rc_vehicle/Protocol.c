@@ -0,0 +1,517 @@
+/**
+ * @file Protocol.c
+ *
+ * @brief Source code for the framed binary command protocol.
+ *
+ * Received bytes are collected until the 0x00 delimiter, then the frame is
+ * COBS-decoded in place, its CRC is checked, and the message is executed.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Protocol.h"
+#include "UART0.h"
+#include "Vehicle_Control.h"
+#include "Telemetry.h"
+#include "Deadman.h"
+#include "Maneuver.h"
+#include "Black_Box.h"
+#include "Parameters.h"
+
+// CRC-16/CCITT-FALSE lookup table (polynomial 0x1021), one entry per value of the next byte
+static const uint16_t crc16_table[256] =
+{
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+	0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+	0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+	0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+	0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+	0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+	0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+	0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+	0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+	0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+	0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+	0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+	0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+	0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+	0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+	0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+	0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+	0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+	0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+	0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+	0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+	0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+	0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+	0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+	0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+	0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+	0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+	0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+	0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+	0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+	0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+static Protocol_Mode protocol_mode = PROTOCOL_DEFAULT_MODE;
+
+// Bytes of the frame being received, still COBS-encoded
+static uint8_t rx_frame[PROTOCOL_MAX_ENCODED_FRAME];
+static uint16_t rx_length = 0;
+
+// Set when the frame being received has grown too long; the rest of it is discarded
+static uint8_t rx_discarding = 0;
+
+// Sequence number of the previously executed command, valid once has_last_sequence is set
+static uint8_t last_sequence;
+static uint8_t has_last_sequence = 0;
+
+static Protocol_Statistics protocol_statistics;
+
+static void Protocol_Acknowledge(uint8_t sequence, uint8_t status)
+{
+	Protocol_Send(PROTOCOL_ACK, sequence, &status, 1);
+}
+
+// Stores the steps of a PROTOCOL_SCRIPT_LOAD frame and returns the status to acknowledge it with
+static uint8_t Protocol_Load_Script(const uint8_t *payload, uint16_t length)
+{
+	Maneuver_Step step;
+	uint8_t index;
+	uint16_t offset;
+	
+	if ((length < 1 + MANEUVER_STEP_SIZE) || (length > 1 + PROTOCOL_SCRIPT_LOAD_MAX_STEPS * MANEUVER_STEP_SIZE) ||
+		(((length - 1) % MANEUVER_STEP_SIZE) != 0))
+	{
+		return PROTOCOL_STATUS_BAD_LENGTH;
+	}
+	
+	index = payload[0];
+	
+	if ((index == 0) && !Maneuver_Clear())
+	{
+		return PROTOCOL_STATUS_BAD_VALUE;
+	}
+	
+	for (offset = 1; offset < length; offset += MANEUVER_STEP_SIZE)
+	{
+		step.duration_ms = (uint16_t)payload[offset] | ((uint16_t)payload[offset + 1] << 8);
+		step.throttle_percent = (int8_t)payload[offset + 2];
+		step.steering_deg = (int8_t)payload[offset + 3];
+		step.until_distance_cm = (uint16_t)payload[offset + 4] | ((uint16_t)payload[offset + 5] << 8);
+		
+		if (!Maneuver_Set_Step(index++, &step))
+		{
+			return PROTOCOL_STATUS_BAD_VALUE;
+		}
+	}
+	
+	return PROTOCOL_STATUS_OK;
+}
+
+static void Protocol_Put_Int32(uint8_t *output, int32_t value)
+{
+	output[0] = (uint8_t)(value & 0xFF);
+	output[1] = (uint8_t)((value >> 8) & 0xFF);
+	output[2] = (uint8_t)((value >> 16) & 0xFF);
+	output[3] = (uint8_t)((value >> 24) & 0xFF);
+}
+
+// Answers a PROTOCOL_PARAM_GET with a PROTOCOL_PARAM_VALUE frame, and returns the status to acknowledge it with
+static uint8_t Protocol_Send_Parameter(uint8_t sequence, uint8_t index)
+{
+	const Parameter_Info *info = Parameters_Get_Info(index);
+	uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+	uint8_t length = 18;
+	
+	if (info == 0)
+	{
+		return PROTOCOL_STATUS_BAD_VALUE;
+	}
+	
+	payload[0] = index;
+	payload[1] = Parameters_Count();
+	Protocol_Put_Int32(&payload[2], Parameters_Get(index));
+	Protocol_Put_Int32(&payload[6], info->default_value);
+	Protocol_Put_Int32(&payload[10], info->minimum);
+	Protocol_Put_Int32(&payload[14], info->maximum);
+	
+	while ((length < PROTOCOL_MAX_PAYLOAD) && (info->name[length - 18] != '\0'))
+	{
+		payload[length] = (uint8_t)info->name[length - 18];
+		length++;
+	}
+	
+	Protocol_Send(PROTOCOL_PARAM_VALUE, sequence, payload, length);
+	return PROTOCOL_STATUS_OK;
+}
+
+// Executes a decoded message and returns the status to acknowledge it with
+static uint8_t Protocol_Execute(uint8_t type, uint8_t sequence, const uint8_t *payload, uint16_t length)
+{
+	switch (type)
+	{
+		case PROTOCOL_DRIVE:
+			if (length != 2)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			Maneuver_Abort();
+			Vehicle_Drive((int8_t)payload[0]);
+			Vehicle_Steer_Degrees((int8_t)payload[1]);
+			return PROTOCOL_STATUS_OK;
+		
+		case PROTOCOL_STOP:
+			if (length != 0)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			Maneuver_Abort();
+			Vehicle_Stop();
+			return PROTOCOL_STATUS_OK;
+		
+		case PROTOCOL_PING:
+			return PROTOCOL_STATUS_OK;
+		
+		case PROTOCOL_SET_MODE:
+			if (length != 1)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			if (payload[0] > PROTOCOL_MODE_FRAMED)
+			{
+				return PROTOCOL_STATUS_BAD_VALUE;
+			}
+			Protocol_Set_Mode((Protocol_Mode)payload[0]);
+			return PROTOCOL_STATUS_OK;
+		
+		case PROTOCOL_SET_TELEMETRY:
+			if (length != 1)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			if (!Telemetry_Set_Rate(payload[0]))
+			{
+				return PROTOCOL_STATUS_BAD_VALUE;
+			}
+			return PROTOCOL_STATUS_OK;
+		
+		case PROTOCOL_SET_DEADMAN:
+			if (length != 2)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			if (!Deadman_Set_Timeout((uint16_t)payload[0] | ((uint16_t)payload[1] << 8)))
+			{
+				return PROTOCOL_STATUS_BAD_VALUE;
+			}
+			return PROTOCOL_STATUS_OK;
+		
+		case PROTOCOL_SCRIPT_LOAD:
+			return Protocol_Load_Script(payload, length);
+		
+		case PROTOCOL_SCRIPT_RUN:
+			if (length != 0)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			if (!Maneuver_Start())
+			{
+				return PROTOCOL_STATUS_BAD_VALUE;
+			}
+			return PROTOCOL_STATUS_OK;
+		
+		case PROTOCOL_SCRIPT_ABORT:
+			if (length != 0)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			Maneuver_Abort();
+			return PROTOCOL_STATUS_OK;
+		
+		case PROTOCOL_BLACK_BOX_FLUSH:
+			if (length != 0)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			Black_Box_Flush();
+			return PROTOCOL_STATUS_OK;
+		
+		case PROTOCOL_BLACK_BOX_READ:
+			if (length != 0)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			if (!Black_Box_Dump())
+			{
+				return PROTOCOL_STATUS_BAD_VALUE;
+			}
+			return PROTOCOL_STATUS_OK;
+		
+		case PROTOCOL_PARAM_GET:
+			if (length != 1)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			return Protocol_Send_Parameter(sequence, payload[0]);
+		
+		case PROTOCOL_PARAM_SET:
+			if (length != 5)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			if (!Parameters_Set(payload[0], (int32_t)((uint32_t)payload[1] | ((uint32_t)payload[2] << 8) |
+				((uint32_t)payload[3] << 16) | ((uint32_t)payload[4] << 24))))
+			{
+				return PROTOCOL_STATUS_BAD_VALUE;
+			}
+			return PROTOCOL_STATUS_OK;
+		
+		case PROTOCOL_PARAM_SAVE:
+			if (length != 0)
+			{
+				return PROTOCOL_STATUS_BAD_LENGTH;
+			}
+			if (!Parameters_Save())
+			{
+				return PROTOCOL_STATUS_BAD_VALUE;
+			}
+			return PROTOCOL_STATUS_OK;
+		
+		default:
+			return PROTOCOL_STATUS_UNKNOWN_TYPE;
+	}
+}
+
+static void Protocol_Handle_Frame(void)
+{
+	uint16_t length = Protocol_COBS_Decode(rx_frame, rx_length, rx_frame);
+	uint16_t received_crc;
+	uint8_t type;
+	uint8_t sequence;
+	uint8_t status;
+	
+	// The smallest frame is type, sequence and CRC
+	if (length < 4)
+	{
+		protocol_statistics.framing_errors++;
+		return;
+	}
+	
+	received_crc = (uint16_t)rx_frame[length - 2] | ((uint16_t)rx_frame[length - 1] << 8);
+	
+	if (Protocol_CRC16(rx_frame, length - 2) != received_crc)
+	{
+		protocol_statistics.crc_errors++;
+		return;
+	}
+	
+	protocol_statistics.frames_accepted++;
+	
+	// The link is alive, even if the frame is a retransmission or cannot be executed
+	Deadman_Feed();
+	
+	type = rx_frame[0];
+	sequence = rx_frame[1];
+	
+	// A repeated sequence number means the acknowledgement was lost and the
+	// sender retransmitted. Acknowledge again without executing twice
+	if (has_last_sequence && (sequence == last_sequence))
+	{
+		protocol_statistics.duplicates++;
+		Protocol_Acknowledge(sequence, PROTOCOL_STATUS_OK);
+		return;
+	}
+	
+	// The black box keeps the type and the first two payload bytes of every command
+	Black_Box_Record_Command(type, (int16_t)(((length > 4) ? rx_frame[2] : 0) | ((length > 5) ? (rx_frame[3] << 8) : 0)));
+	
+	status = Protocol_Execute(type, sequence, &rx_frame[2], length - 4);
+	
+	if (status == PROTOCOL_STATUS_OK)
+	{
+		last_sequence = sequence;
+		has_last_sequence = 1;
+	}
+	
+	Protocol_Acknowledge(sequence, status);
+}
+
+void Protocol_Init(void)
+{
+	protocol_mode = PROTOCOL_DEFAULT_MODE;
+	rx_length = 0;
+	rx_discarding = 0;
+	has_last_sequence = 0;
+}
+
+Protocol_Mode Protocol_Get_Mode(void)
+{
+	return protocol_mode;
+}
+
+void Protocol_Set_Mode(Protocol_Mode mode)
+{
+	protocol_mode = mode;
+	rx_length = 0;
+	rx_discarding = 0;
+	has_last_sequence = 0;
+}
+
+void Protocol_Receive_Byte(uint8_t data)
+{
+	if (data == 0x00)
+	{
+		if (rx_discarding)
+		{
+			protocol_statistics.framing_errors++;
+		}
+		else if (rx_length > 0)
+		{
+			Protocol_Handle_Frame();
+		}
+		
+		rx_length = 0;
+		rx_discarding = 0;
+	}
+	else if (rx_length < sizeof(rx_frame))
+	{
+		rx_frame[rx_length++] = data;
+	}
+	else
+	{
+		rx_discarding = 1;
+	}
+}
+
+uint16_t Protocol_Encode(uint8_t type, uint8_t sequence, const uint8_t *payload, uint8_t length, uint8_t *output)
+{
+	uint8_t frame[PROTOCOL_MAX_FRAME];
+	uint16_t encoded_length;
+	uint16_t crc;
+	uint8_t i;
+	
+	if (length > PROTOCOL_MAX_PAYLOAD)
+	{
+		return 0;
+	}
+	
+	frame[0] = type;
+	frame[1] = sequence;
+	
+	for (i = 0; i < length; i++)
+	{
+		frame[2 + i] = payload[i];
+	}
+	
+	crc = Protocol_CRC16(frame, length + 2);
+	frame[length + 2] = (uint8_t)(crc & 0xFF);
+	frame[length + 3] = (uint8_t)(crc >> 8);
+	
+	encoded_length = Protocol_COBS_Encode(frame, length + 4, output);
+	output[encoded_length++] = 0x00;
+	
+	return encoded_length;
+}
+
+int Protocol_Send(uint8_t type, uint8_t sequence, const uint8_t *payload, uint8_t length)
+{
+	uint8_t encoded[PROTOCOL_MAX_ENCODED_FRAME];
+	uint16_t encoded_length = Protocol_Encode(type, sequence, payload, length, encoded);
+	
+	if (encoded_length == 0)
+	{
+		return 0;
+	}
+	
+	return (UART0_Write((const char *)encoded, encoded_length) == encoded_length);
+}
+
+uint16_t Protocol_CRC16(const uint8_t *data, uint16_t length)
+{
+	uint16_t crc = 0xFFFF;
+	
+	while (length--)
+	{
+		crc = (uint16_t)(crc << 8) ^ crc16_table[((crc >> 8) ^ *data++) & 0xFF];
+	}
+	
+	return crc;
+}
+
+uint16_t Protocol_COBS_Encode(const uint8_t *input, uint16_t length, uint8_t *output)
+{
+	uint16_t read_index = 0;
+	uint16_t write_index = 1;
+	uint16_t code_index = 0;
+	uint8_t code = 1;
+	
+	while (read_index < length)
+	{
+		if (input[read_index] == 0x00)
+		{
+			// Close the current block: its code byte is the distance to this zero
+			output[code_index] = code;
+			code_index = write_index++;
+			code = 1;
+		}
+		else
+		{
+			output[write_index++] = input[read_index];
+			code++;
+			
+			// A block holds at most 254 data bytes
+			if ((code == 0xFF) && (read_index + 1 < length))
+			{
+				output[code_index] = code;
+				code_index = write_index++;
+				code = 1;
+			}
+		}
+		
+		read_index++;
+	}
+	
+	output[code_index] = code;
+	
+	return write_index;
+}
+
+uint16_t Protocol_COBS_Decode(const uint8_t *input, uint16_t length, uint8_t *output)
+{
+	uint16_t read_index = 0;
+	uint16_t write_index = 0;
+	
+	while (read_index < length)
+	{
+		uint8_t code = input[read_index];
+		uint8_t i;
+		
+		if ((code == 0x00) || (read_index + code > length))
+		{
+			return 0;
+		}
+		
+		read_index++;
+		
+		for (i = 1; i < code; i++)
+		{
+			output[write_index++] = input[read_index++];
+		}
+		
+		// Every block except a full one (and the last one) stands for a zero byte
+		if ((code != 0xFF) && (read_index < length))
+		{
+			output[write_index++] = 0x00;
+		}
+	}
+	
+	return write_index;
+}
+
+void Protocol_Get_Statistics(Protocol_Statistics *stats)
+{
+	*stats = protocol_statistics;
+}
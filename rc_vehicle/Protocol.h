@@ -0,0 +1,253 @@
+/**
+ * @file Protocol.h
+ *
+ * @brief Header file for the framed binary command protocol.
+ *
+ * Each message is sent as one frame:
+ *
+ *   COBS( type | sequence | payload (0 to PROTOCOL_MAX_PAYLOAD bytes) | CRC-16 low | CRC-16 high ) | 0x00
+ *
+ * - COBS (Consistent Overhead Byte Stuffing) removes every 0x00 byte from the frame,
+ *   so 0x00 marks the end of a frame and the receiver resynchronizes after any corruption.
+ * - The CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF) covers the type,
+ *   sequence and payload bytes. Frames with a bad CRC are dropped without being acted on.
+ * - Every accepted command is answered with a PROTOCOL_ACK frame carrying the same sequence
+ *   number. A command that repeats the sequence number of the previous one is treated as a
+ *   retransmission: it is acknowledged again but not executed twice.
+ *
+ * A drive command (throttle and steering) is 8 bytes on the wire, including the COBS overhead
+ * and the delimiter.
+ *
+ * A maneuver script (see Maneuver.h) is uploaded with PROTOCOL_SCRIPT_LOAD frames of a few
+ * steps each. The steps of a frame are stored from the given index, which must be at most the
+ * number of steps already stored; index 0 starts a new script. PROTOCOL_SCRIPT_RUN starts the
+ * script, and PROTOCOL_SCRIPT_DONE reports its end. A PROTOCOL_DRIVE or PROTOCOL_STOP aborts it.
+ *
+ * The black box log (see Black_Box.h) is read back with PROTOCOL_BLACK_BOX_READ: the vehicle
+ * streams its flash slots, oldest first, as PROTOCOL_BLACK_BOX_DATA frames whose offsets count
+ * the bytes sent before them, and marks the end with a frame without data. PROTOCOL_BLACK_BOX_FLUSH
+ * copies the recent history into flash.
+ *
+ * The runtime parameters (see Parameters.h) are addressed by index. PROTOCOL_PARAM_GET is
+ * answered with a PROTOCOL_PARAM_VALUE frame, sent before the acknowledgement with the same
+ * sequence number, which also gives the number of parameters: a host lists them by reading
+ * index 0, then every index below the count. PROTOCOL_PARAM_SET applies a value at once, and
+ * PROTOCOL_PARAM_SAVE keeps the current values across resets. An unknown index or a value out
+ * of range is refused with PROTOCOL_STATUS_BAD_VALUE.
+ *
+ * Every frame that passes the CRC check feeds the command link deadman (see Deadman.h): while
+ * the vehicle moves, the host must send a frame, for example a PROTOCOL_PING, at least once
+ * per deadman timeout.
+ *
+ * The single-character commands remain available: the vehicle starts in PROTOCOL_DEFAULT_MODE,
+ * the 'F' character switches from the character mode to framed mode, and a PROTOCOL_SET_MODE
+ * message switches back.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+
+/**
+ * @brief Largest payload carried by one frame
+ */
+#define PROTOCOL_MAX_PAYLOAD 32
+
+/**
+ * @brief Largest frame before COBS encoding: type, sequence, payload and CRC
+ */
+#define PROTOCOL_MAX_FRAME (PROTOCOL_MAX_PAYLOAD + 4)
+
+/**
+ * @brief Largest frame after COBS encoding, including the 0x00 delimiter
+ */
+#define PROTOCOL_MAX_ENCODED_FRAME (PROTOCOL_MAX_FRAME + (PROTOCOL_MAX_FRAME / 254) + 2)
+
+/**
+ * @brief Message types sent to the vehicle
+ */
+#define PROTOCOL_DRIVE       0x01  // payload: int8 throttle percent, int8 steering degrees
+#define PROTOCOL_STOP        0x02  // no payload
+#define PROTOCOL_PING        0x03  // no payload
+#define PROTOCOL_SET_MODE    0x04  // payload: uint8 Protocol_Mode
+#define PROTOCOL_SET_TELEMETRY 0x05  // payload: uint8 telemetry rate in Hz, 0 to stop (see Telemetry.h)
+#define PROTOCOL_SET_DEADMAN 0x06  // payload: uint16 command timeout in milliseconds (little-endian), 0 to disable (see Deadman.h)
+#define PROTOCOL_SCRIPT_LOAD 0x07  // payload: uint8 index of the first step, then 1 to PROTOCOL_SCRIPT_LOAD_MAX_STEPS Maneuver_Step (see Maneuver.h)
+#define PROTOCOL_SCRIPT_RUN  0x08  // no payload
+#define PROTOCOL_SCRIPT_ABORT 0x09  // no payload
+#define PROTOCOL_BLACK_BOX_FLUSH 0x0A  // no payload
+#define PROTOCOL_BLACK_BOX_READ 0x0B  // no payload
+#define PROTOCOL_PARAM_GET   0x0C  // payload: uint8 parameter index
+#define PROTOCOL_PARAM_SET   0x0D  // payload: uint8 parameter index, int32 value (little-endian)
+#define PROTOCOL_PARAM_SAVE  0x0E  // no payload
+
+/**
+ * @brief Message types sent by the vehicle
+ */
+#define PROTOCOL_ACK         0x80  // payload: uint8 status
+#define PROTOCOL_OBSTACLE    0x81  // payload: uint16 distance in centimeters (little-endian)
+#define PROTOCOL_TELEMETRY   0x82  // payload: Telemetry_Record (see Telemetry.h)
+#define PROTOCOL_SCRIPT_DONE 0x83  // payload: uint8 Maneuver_Result, uint8 number of steps run (see Maneuver.h)
+#define PROTOCOL_BLACK_BOX_DATA 0x84  // payload: uint16 stream offset (little-endian), then up to PROTOCOL_MAX_PAYLOAD - 2 bytes of the flash log (see Black_Box.h)
+#define PROTOCOL_PARAM_VALUE 0x85  // payload: uint8 index, uint8 number of parameters, int32 value, default, minimum and maximum (little-endian), then the name without terminator
+
+/**
+ * @brief Largest number of script steps carried by one PROTOCOL_SCRIPT_LOAD frame
+ */
+#define PROTOCOL_SCRIPT_LOAD_MAX_STEPS 5
+
+/**
+ * @brief Status codes carried by PROTOCOL_ACK
+ */
+#define PROTOCOL_STATUS_OK             0x00
+#define PROTOCOL_STATUS_UNKNOWN_TYPE   0x01
+#define PROTOCOL_STATUS_BAD_LENGTH     0x02
+#define PROTOCOL_STATUS_BAD_VALUE      0x03
+
+/**
+ * @brief Command intake modes
+ */
+typedef enum
+{
+	PROTOCOL_MODE_CHARACTER = 0,
+	PROTOCOL_MODE_FRAMED = 1
+} Protocol_Mode;
+
+/**
+ * @brief Mode selected at reset
+ */
+#ifndef PROTOCOL_DEFAULT_MODE
+#define PROTOCOL_DEFAULT_MODE PROTOCOL_MODE_CHARACTER
+#endif
+
+/**
+ * @brief Counters maintained by the frame decoder.
+ */
+typedef struct
+{
+	/** Frames that passed the CRC check */
+	uint32_t frames_accepted;
+	
+	/** Frames dropped because of a CRC mismatch */
+	uint32_t crc_errors;
+	
+	/** Frames dropped because of invalid COBS encoding, or because they were too short or too long */
+	uint32_t framing_errors;
+	
+	/** Accepted frames that repeated the previous sequence number */
+	uint32_t duplicates;
+} Protocol_Statistics;
+
+/**
+ * @brief The Protocol_Init function resets the frame decoder and selects PROTOCOL_DEFAULT_MODE.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Protocol_Init(void);
+
+/**
+ * @brief The Protocol_Get_Mode function returns the current command intake mode.
+ *
+ * @param None
+ *
+ * @return The current Protocol_Mode.
+ */
+Protocol_Mode Protocol_Get_Mode(void);
+
+/**
+ * @brief The Protocol_Set_Mode function selects the command intake mode.
+ *
+ * @param mode The new Protocol_Mode.
+ *
+ * @return None
+ */
+void Protocol_Set_Mode(Protocol_Mode mode);
+
+/**
+ * @brief The Protocol_Receive_Byte function feeds one received byte to the frame decoder.
+ *
+ * When the byte completes a frame, the frame is checked and, if valid, executed and acknowledged.
+ * The cost per byte is constant, except for the delimiter, which costs one pass over the frame.
+ *
+ * @param data The received byte.
+ *
+ * @return None
+ */
+void Protocol_Receive_Byte(uint8_t data);
+
+/**
+ * @brief The Protocol_Encode function encodes a message as a complete frame, including the delimiter.
+ *
+ * @param type The message type.
+ * @param sequence The sequence number.
+ * @param payload Pointer to the payload bytes (may be 0 if length is 0).
+ * @param length Number of payload bytes, at most PROTOCOL_MAX_PAYLOAD.
+ * @param output Pointer to a buffer of at least PROTOCOL_MAX_ENCODED_FRAME bytes.
+ *
+ * @return The number of bytes written to output, or 0 if the payload was too long.
+ */
+uint16_t Protocol_Encode(uint8_t type, uint8_t sequence, const uint8_t *payload, uint8_t length, uint8_t *output);
+
+/**
+ * @brief The Protocol_Send function encodes a message as a frame and queues it on UART0.
+ *
+ * @param type The message type.
+ * @param sequence The sequence number.
+ * @param payload Pointer to the payload bytes (may be 0 if length is 0).
+ * @param length Number of payload bytes, at most PROTOCOL_MAX_PAYLOAD.
+ *
+ * @return 1 if the frame was queued, 0 if it was too long or the transmit buffer was full.
+ */
+int Protocol_Send(uint8_t type, uint8_t sequence, const uint8_t *payload, uint8_t length);
+
+/**
+ * @brief The Protocol_CRC16 function computes the CRC-16/CCITT-FALSE of a block of bytes.
+ *
+ * @param data Pointer to the bytes.
+ * @param length Number of bytes.
+ *
+ * @return The CRC-16 value.
+ */
+uint16_t Protocol_CRC16(const uint8_t *data, uint16_t length);
+
+/**
+ * @brief The Protocol_COBS_Encode function COBS-encodes a block of bytes.
+ *
+ * The delimiter is not appended.
+ *
+ * @param input Pointer to the bytes to encode.
+ * @param length Number of bytes to encode.
+ * @param output Pointer to a buffer of at least length + (length / 254) + 1 bytes.
+ *
+ * @return The number of encoded bytes written to output.
+ */
+uint16_t Protocol_COBS_Encode(const uint8_t *input, uint16_t length, uint8_t *output);
+
+/**
+ * @brief The Protocol_COBS_Decode function decodes a COBS-encoded block of bytes.
+ *
+ * The delimiter must not be included. Decoding in place (output == input) is allowed.
+ *
+ * @param input Pointer to the encoded bytes.
+ * @param length Number of encoded bytes.
+ * @param output Pointer to a buffer of at least length bytes.
+ *
+ * @return The number of decoded bytes, or 0 if the encoding is invalid.
+ */
+uint16_t Protocol_COBS_Decode(const uint8_t *input, uint16_t length, uint8_t *output);
+
+/**
+ * @brief The Protocol_Get_Statistics function copies the frame decoder counters.
+ *
+ * @param stats Pointer to the structure that receives the counters.
+ *
+ * @return None
+ */
+void Protocol_Get_Statistics(Protocol_Statistics *stats);
+
+#endif
@@ -0,0 +1,307 @@
+/**
+ * @file Scheduler.c
+ *
+ * @brief Source code for the cooperative task scheduler.
+ *
+ * Release times and deadlines are absolute timebase counts (see Timebase.h).
+ * A periodic task's next release is advanced by exactly one period each time
+ * it runs, so the release times do not drift with the execution time.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Scheduler.h"
+#include "Timebase.h"
+#include "Idle.h"
+#include "Trace.h"
+
+typedef struct
+{
+	const char *name;
+	Scheduler_Task_Function function;
+	uint64_t period_cycles;
+	uint64_t deadline_cycles;
+	
+	// Next periodic release, or 0 for an event-triggered task
+	uint64_t next_release_cycles;
+	
+	// Time of the pending event release, valid while signaled is set
+	volatile uint64_t signal_cycles;
+	volatile uint8_t signaled;
+	
+	uint32_t run_count;
+	uint32_t deadline_miss_count;
+	uint32_t max_latency_cycles;
+	uint32_t max_execution_cycles;
+} Scheduler_Task;
+
+static Scheduler_Task tasks[SCHEDULER_MAX_TASKS];
+static int task_count = 0;
+static int rejected_task_count = 0;
+
+// Start of the previous dispatch and the longest interval between two dispatches
+static uint64_t last_dispatch_cycles = 0;
+static uint32_t max_loop_cycles = 0;
+
+void Scheduler_Init(void)
+{
+	Timebase_Init();
+	
+	task_count = 0;
+	rejected_task_count = 0;
+	last_dispatch_cycles = 0;
+	max_loop_cycles = 0;
+}
+
+int Scheduler_Add_Task(const char *name, Scheduler_Task_Function function, uint32_t period_us, uint32_t deadline_us)
+{
+	Scheduler_Task *task;
+	
+	if (task_count >= SCHEDULER_MAX_TASKS)
+	{
+		rejected_task_count++;
+		return -1;
+	}
+	
+	task = &tasks[task_count];
+	
+	task->name = name;
+	task->function = function;
+	task->period_cycles = TIMEBASE_US_TO_CYCLES(period_us);
+	task->deadline_cycles = TIMEBASE_US_TO_CYCLES(deadline_us);
+	task->next_release_cycles = (period_us > 0) ? (Timebase_Now_Cycles() + task->period_cycles) : 0;
+	task->signaled = 0;
+	task->run_count = 0;
+	task->deadline_miss_count = 0;
+	task->max_latency_cycles = 0;
+	task->max_execution_cycles = 0;
+	
+	return task_count++;
+}
+
+void Scheduler_Signal(int task_id)
+{
+	Scheduler_Task *task;
+	
+	if ((task_id < 0) || (task_id >= task_count))
+	{
+		return;
+	}
+	
+	task = &tasks[task_id];
+	
+	// Keep the time of the first pending signal so that the latency is measured from it
+	if (!task->signaled)
+	{
+		task->signal_cycles = Timebase_Now_Cycles();
+		task->signaled = 1;
+	}
+}
+
+// Returns the release time of a task that is ready to run at time now, or 0 if it is not ready
+static uint64_t Scheduler_Release_Time(Scheduler_Task *task, uint64_t now)
+{
+	uint64_t release = 0;
+	
+	if ((task->next_release_cycles != 0) && (now >= task->next_release_cycles))
+	{
+		release = task->next_release_cycles;
+	}
+	
+	if (task->signaled && ((release == 0) || (task->signal_cycles < release)))
+	{
+		release = task->signal_cycles;
+	}
+	
+	return release;
+}
+
+int Scheduler_Dispatch(void)
+{
+	uint64_t now = Timebase_Now_Cycles();
+	Scheduler_Task *selected = 0;
+	uint64_t selected_release = 0;
+	uint64_t selected_deadline = 0;
+	uint64_t finish;
+	uint32_t latency;
+	uint32_t execution;
+	int i;
+	
+	if (last_dispatch_cycles != 0)
+	{
+		uint32_t loop = (uint32_t)(now - last_dispatch_cycles);
+		
+		if (loop > max_loop_cycles)
+		{
+			max_loop_cycles = loop;
+		}
+	}
+	
+	last_dispatch_cycles = now;
+	
+	// Select the released task with the earliest absolute deadline
+	for (i = 0; i < task_count; i++)
+	{
+		uint64_t release = Scheduler_Release_Time(&tasks[i], now);
+		
+		if (release != 0)
+		{
+			uint64_t deadline = release + tasks[i].deadline_cycles;
+			
+			if ((selected == 0) || (deadline < selected_deadline))
+			{
+				selected = &tasks[i];
+				selected_release = release;
+				selected_deadline = deadline;
+			}
+		}
+	}
+	
+	if (selected == 0)
+	{
+		return 0;
+	}
+	
+	// Consume the release before running, so that a signal raised by the task itself
+	// (or by an interrupt while it runs) releases it again
+	selected->signaled = 0;
+	
+	if ((selected->next_release_cycles != 0) && (now >= selected->next_release_cycles))
+	{
+		selected->next_release_cycles += selected->period_cycles;
+		
+		// If the task fell more than a period behind, skip the missed releases
+		// instead of running it back-to-back, and count them as missed deadlines
+		while (selected->next_release_cycles <= now)
+		{
+			selected->next_release_cycles += selected->period_cycles;
+			selected->deadline_miss_count++;
+		}
+	}
+	
+	TRACE(TRACE_TASK_BEGIN, selected - tasks);
+	selected->function();
+	TRACE(TRACE_TASK_END, selected - tasks);
+	
+	finish = Timebase_Now_Cycles();
+	latency = (now > selected_release) ? (uint32_t)(now - selected_release) : 0;
+	execution = (uint32_t)(finish - now);
+	
+	selected->run_count++;
+	
+	if (finish > selected_deadline)
+	{
+		selected->deadline_miss_count++;
+	}
+	
+	if (latency > selected->max_latency_cycles)
+	{
+		selected->max_latency_cycles = latency;
+	}
+	
+	if (execution > selected->max_execution_cycles)
+	{
+		selected->max_execution_cycles = execution;
+	}
+	
+	return 1;
+}
+
+// Sleeps until the next periodic release, unless a task has been signaled since the last
+// dispatch. The interrupts are disabled while deciding, so that a signal raised just before
+// the WFI still wakes the CPU
+static void Scheduler_Idle(void)
+{
+	uint64_t wake_cycles = IDLE_NO_WAKEUP;
+	int i;
+	
+	__disable_irq();
+	
+	for (i = 0; i < task_count; i++)
+	{
+		if (tasks[i].signaled)
+		{
+			wake_cycles = 0;
+			break;
+		}
+		
+		if ((tasks[i].next_release_cycles != 0) && (tasks[i].next_release_cycles < wake_cycles))
+		{
+			wake_cycles = tasks[i].next_release_cycles;
+		}
+	}
+	
+	if (wake_cycles != 0)
+	{
+		// The loop time is measured from the wake-up
+		last_dispatch_cycles = Idle_Sleep_Until(wake_cycles);
+	}
+	
+	__enable_irq();
+}
+
+void Scheduler_Run(void)
+{
+	while (1)
+	{
+		if (!Scheduler_Dispatch())
+		{
+			Scheduler_Idle();
+		}
+	}
+}
+
+void Scheduler_Set_Period(int task_id, uint32_t period_us, uint32_t deadline_us)
+{
+	Scheduler_Task *task;
+	
+	if ((task_id < 0) || (task_id >= task_count))
+	{
+		return;
+	}
+	
+	task = &tasks[task_id];
+	
+	task->period_cycles = TIMEBASE_US_TO_CYCLES(period_us);
+	task->deadline_cycles = TIMEBASE_US_TO_CYCLES(deadline_us);
+	task->next_release_cycles = (period_us > 0) ? (Timebase_Now_Cycles() + task->period_cycles) : 0;
+}
+
+uint32_t Scheduler_Take_Max_Loop_US(void)
+{
+	uint32_t max_loop_us = max_loop_cycles / TIMEBASE_CYCLES_PER_US;
+	
+	max_loop_cycles = 0;
+	
+	return max_loop_us;
+}
+
+int Scheduler_Task_Count(void)
+{
+	return task_count;
+}
+
+int Scheduler_Rejected_Task_Count(void)
+{
+	return rejected_task_count;
+}
+
+void Scheduler_Get_Task_Statistics(int task_id, Scheduler_Task_Statistics *stats)
+{
+	Scheduler_Task *task;
+	
+	if ((task_id < 0) || (task_id >= task_count))
+	{
+		return;
+	}
+	
+	task = &tasks[task_id];
+	
+	stats->name = task->name;
+	stats->period_us = (uint32_t)(task->period_cycles / TIMEBASE_CYCLES_PER_US);
+	stats->deadline_us = (uint32_t)(task->deadline_cycles / TIMEBASE_CYCLES_PER_US);
+	stats->run_count = task->run_count;
+	stats->deadline_miss_count = task->deadline_miss_count;
+	stats->max_latency_us = task->max_latency_cycles / TIMEBASE_CYCLES_PER_US;
+	stats->max_execution_us = task->max_execution_cycles / TIMEBASE_CYCLES_PER_US;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file Scheduler.h
+ *
+ * @brief Header file for the cooperative task scheduler.
+ *
+ * The scheduler runs a small, fixed set of run-to-completion tasks from the main loop.
+ * A task is released either periodically (every period_us microseconds) or by an event
+ * (Scheduler_Signal, which may be called from an interrupt service routine), or both.
+ *
+ * Released tasks are dispatched earliest-deadline-first. Since tasks are never preempted
+ * by each other, the latency from release to start of any task is bounded by the sum of
+ * the worst-case execution times of the other tasks. Each task must therefore return
+ * quickly and never busy-wait.
+ *
+ * For every task the scheduler records the number of runs, the worst release-to-start
+ * latency, the worst execution time and the number of missed deadlines. It also records
+ * the loop time, the longest interval between two consecutive dispatches.
+ *
+ * When no task is released, the CPU sleeps until the next periodic release or the next
+ * interrupt (see Idle.h). An interrupt that signals a task therefore wakes the scheduler.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Maximum number of tasks that can be registered.
+ *
+ * The firmware registers 12 tasks with every build option, which leaves room for 4 more.
+ * A task that does not fit is not registered: main refuses to start (see
+ * Scheduler_Rejected_Task_Count).
+ */
+#define SCHEDULER_MAX_TASKS 16
+
+/**
+ * @brief A task function. It must run to completion without blocking.
+ */
+typedef void (*Scheduler_Task_Function)(void);
+
+/**
+ * @brief Run-time statistics of a task.
+ */
+typedef struct
+{
+	/** Name given to Scheduler_Add_Task */
+	const char *name;
+	
+	/** Release period in microseconds, 0 for a purely event-triggered task */
+	uint32_t period_us;
+	
+	/** Relative deadline in microseconds */
+	uint32_t deadline_us;
+	
+	/** Number of completed runs */
+	uint32_t run_count;
+	
+	/** Number of runs that finished after their deadline, plus periodic releases that were skipped */
+	uint32_t deadline_miss_count;
+	
+	/** Longest time between release and start, in microseconds */
+	uint32_t max_latency_us;
+	
+	/** Longest execution time, in microseconds */
+	uint32_t max_execution_us;
+} Scheduler_Task_Statistics;
+
+/**
+ * @brief The Scheduler_Init function clears the task table.
+ *
+ * It also starts the timebase used to release and time the tasks.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Scheduler_Init(void);
+
+/**
+ * @brief The Scheduler_Add_Task function registers a task.
+ *
+ * A periodic task is first released one period after it is added.
+ *
+ * @param name Short name used in reports.
+ * @param function The function to run each time the task is released.
+ * @param period_us Release period in microseconds, or 0 for an event-triggered task.
+ * @param deadline_us Deadline relative to each release, in microseconds.
+ *
+ * @return The task identifier to be passed to Scheduler_Signal, or -1 if the table is full.
+ * The task is then counted by Scheduler_Rejected_Task_Count.
+ */
+int Scheduler_Add_Task(const char *name, Scheduler_Task_Function function, uint32_t period_us, uint32_t deadline_us);
+
+/**
+ * @brief The Scheduler_Signal function releases a task as soon as possible.
+ *
+ * Signals that arrive while the task is already released are merged into one run.
+ * This function may be called from an interrupt service routine.
+ *
+ * @param task_id The identifier returned by Scheduler_Add_Task.
+ *
+ * @return None
+ */
+void Scheduler_Signal(int task_id);
+
+/**
+ * @brief The Scheduler_Dispatch function runs at most one released task.
+ *
+ * @param None
+ *
+ * @return 1 if a task was run, 0 if no task was released.
+ */
+int Scheduler_Dispatch(void);
+
+/**
+ * @brief The Scheduler_Run function dispatches released tasks forever.
+ *
+ * Between the tasks, it sleeps with Idle_Sleep_Until.
+ *
+ * @param None
+ *
+ * @return This function does not return.
+ */
+void Scheduler_Run(void);
+
+/**
+ * @brief The Scheduler_Set_Period function changes the release period of a task.
+ *
+ * The next release is one new period from now. A period of 0 stops the periodic
+ * releases, leaving only the event releases by Scheduler_Signal.
+ *
+ * @param task_id The identifier returned by Scheduler_Add_Task.
+ * @param period_us New release period in microseconds.
+ * @param deadline_us New deadline relative to each release, in microseconds.
+ *
+ * @return None
+ */
+void Scheduler_Set_Period(int task_id, uint32_t period_us, uint32_t deadline_us);
+
+/**
+ * @brief The Scheduler_Take_Max_Loop_US function returns the loop time and starts a new measurement.
+ *
+ * The loop time is the longest interval between two consecutive calls to Scheduler_Dispatch,
+ * which is the worst delay before a newly released task is noticed. The time spent asleep
+ * is not part of it, since any release wakes the CPU.
+ *
+ * @param None
+ *
+ * @return The longest loop time in microseconds since the previous call.
+ */
+uint32_t Scheduler_Take_Max_Loop_US(void);
+
+/**
+ * @brief The Scheduler_Task_Count function returns the number of registered tasks.
+ *
+ * @param None
+ *
+ * @return The number of registered tasks.
+ */
+int Scheduler_Task_Count(void);
+
+/**
+ * @brief The Scheduler_Rejected_Task_Count function returns the number of tasks that did not fit in the table.
+ *
+ * Most modules do not check the result of Scheduler_Add_Task, so their task would silently
+ * never run: main checks this count once every module is initialized.
+ *
+ * @param None
+ *
+ * @return The number of Scheduler_Add_Task calls that returned -1 since Scheduler_Init.
+ */
+int Scheduler_Rejected_Task_Count(void);
+
+/**
+ * @brief The Scheduler_Get_Task_Statistics function copies the statistics of a task.
+ *
+ * @param task_id The identifier returned by Scheduler_Add_Task.
+ * @param stats Pointer to the structure that receives the statistics.
+ *
+ * @return None
+ */
+void Scheduler_Get_Task_Statistics(int task_id, Scheduler_Task_Statistics *stats);
+
+#endif
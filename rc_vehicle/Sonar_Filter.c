@@ -0,0 +1,269 @@
+/**
+ * @file Sonar_Filter.c
+ *
+ * @brief Source code for the ultrasonic range filter.
+ *
+ * The tracker keeps the range in micrometers and the range rate in micrometers per second,
+ * so that the gains can be applied with integer arithmetic without losing the small
+ * corrections of a slow approach.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Sonar_Filter.h"
+#include "Timebase.h"
+
+#define SONAR_FILTER_UM_PER_MM 1000
+#define SONAR_FILTER_US_PER_S  1000000
+
+static void Sonar_Filter_Restart(Sonar_Filter *filter)
+{
+	filter->window_next = 0;
+	filter->window_count = 0;
+	filter->range_um = 0;
+	filter->rate_um_s = 0;
+	filter->range_cycles = 0;
+	filter->gate_misses = 0;
+	filter->latest_valid = 0;
+}
+
+// Median of the ring, together with the timestamp of the sample it selects. The slots are
+// sorted by insertion into a list of indices, which takes a bounded number of steps
+static void Sonar_Filter_Median(const Sonar_Filter *filter, uint32_t *median_mm, uint64_t *median_cycles)
+{
+	uint8_t order[SONAR_FILTER_MEDIAN_WINDOW];
+	uint8_t slot;
+	uint8_t i;
+	int j;
+	
+	for (i = 0; i < SONAR_FILTER_MEDIAN_WINDOW; i++)
+	{
+		slot = i;
+		
+		for (j = i - 1; (j >= 0) && (filter->window_mm[order[j]] > filter->window_mm[slot]); j--)
+		{
+			order[j + 1] = order[j];
+		}
+		
+		order[j + 1] = slot;
+	}
+	
+	slot = order[SONAR_FILTER_MEDIAN_WINDOW / 2];
+	*median_mm = filter->window_mm[slot];
+	*median_cycles = filter->window_cycles[slot];
+}
+
+// Change of the tracked range after a given time, in micrometers
+static int32_t Sonar_Filter_Travel_UM(const Sonar_Filter *filter, uint32_t interval_us)
+{
+	return (int32_t)(((int64_t)filter->rate_um_s * interval_us) / SONAR_FILTER_US_PER_S);
+}
+
+static void Sonar_Filter_Track(Sonar_Filter *filter, uint32_t median_mm, uint64_t median_cycles)
+{
+	int32_t median_um = (int32_t)(median_mm * SONAR_FILTER_UM_PER_MM);
+	uint32_t interval_us;
+	int32_t predicted_um;
+	int32_t residual_um;
+	
+	// The first estimate starts at rest. A rate taken from the first few samples
+	// would be thrown off by a single spurious echo among them
+	if (!Sonar_Filter_Has_Estimate(filter))
+	{
+		filter->range_um = median_um;
+		filter->rate_um_s = 0;
+		filter->range_cycles = median_cycles;
+		return;
+	}
+	
+	// The median may select a sample that was already used
+	if (median_cycles <= filter->range_cycles)
+	{
+		return;
+	}
+	
+	interval_us = (uint32_t)((median_cycles - filter->range_cycles) / TIMEBASE_CYCLES_PER_US);
+	
+	if (interval_us == 0)
+	{
+		interval_us = 1;
+	}
+	
+	predicted_um = filter->range_um + Sonar_Filter_Travel_UM(filter, interval_us);
+	residual_um = median_um - predicted_um;
+	
+	if ((residual_um > (SONAR_FILTER_GATE_MM * SONAR_FILTER_UM_PER_MM)) || (residual_um < -(SONAR_FILTER_GATE_MM * SONAR_FILTER_UM_PER_MM)))
+	{
+		filter->gate_misses++;
+		
+		// A burst of spurious echoes can take over the median once, but not twice in a row
+		if (filter->gate_misses < SONAR_FILTER_GATE_CONFIRM)
+		{
+			return;
+		}
+		
+		// Another object: jump to it. The rate is kept, since the closing speed of a
+		// standing object is mostly the speed of the vehicle
+		filter->range_um = median_um;
+	}
+	else
+	{
+		filter->range_um = predicted_um + (int32_t)(((int64_t)residual_um * SONAR_FILTER_ALPHA_Q8) / 256);
+		filter->rate_um_s += (int32_t)(((int64_t)residual_um * SONAR_FILTER_BETA_Q8 * SONAR_FILTER_US_PER_S) / ((int64_t)256 * interval_us));
+	}
+	
+	filter->gate_misses = 0;
+	filter->range_cycles = median_cycles;
+}
+
+void Sonar_Filter_Init(Sonar_Filter *filter)
+{
+	Sonar_Filter_Restart(filter);
+	filter->state = SONAR_FILTER_NO_TARGET;
+	filter->missed_echoes = 0;
+}
+
+Sonar_Filter_State Sonar_Filter_Update(Sonar_Filter *filter, const Ultrasonic_Sample *sample)
+{
+	uint32_t median_mm;
+	uint64_t median_cycles;
+	uint32_t sample_mm;
+	uint32_t predicted_mm;
+	
+	if (!sample->valid)
+	{
+		if (filter->missed_echoes < 0xFF)
+		{
+			filter->missed_echoes++;
+		}
+		
+		if (filter->missed_echoes <= SONAR_FILTER_MAX_MISSES)
+		{
+			if (Sonar_Filter_Has_Estimate(filter))
+			{
+				filter->state = SONAR_FILTER_COASTING;
+			}
+		}
+		else if (filter->state != SONAR_FILTER_LOST)
+		{
+			// Close to a target the echo is more likely lost than gone
+			if (Sonar_Filter_Has_Estimate(filter) &&
+				(Sonar_Filter_Predict_MM(filter, sample->timestamp_cycles) < (SONAR_FILTER_NEAR_CM * 10)))
+			{
+				filter->state = SONAR_FILTER_LOST;
+			}
+			else
+			{
+				filter->state = SONAR_FILTER_NO_TARGET;
+			}
+			
+			Sonar_Filter_Restart(filter);
+		}
+		
+		return filter->state;
+	}
+	
+	filter->missed_echoes = 0;
+	
+	// The pulse width gives millimeters, finer than the distance_cm field
+	sample_mm = (sample->pulse_us * 10) / ULTRASONIC_US_PER_CM;
+	
+	// Only samples close to the tracked range are trusted without the median
+	if (Sonar_Filter_Has_Estimate(filter))
+	{
+		predicted_mm = Sonar_Filter_Predict_MM(filter, sample->timestamp_cycles);
+		
+		if (((sample_mm > predicted_mm) ? (sample_mm - predicted_mm) : (predicted_mm - sample_mm)) <= SONAR_FILTER_GATE_MM)
+		{
+			filter->latest_mm = sample_mm;
+			filter->latest_cycles = sample->timestamp_cycles;
+			filter->latest_valid = 1;
+		}
+	}
+	
+	filter->window_mm[filter->window_next] = sample_mm;
+	filter->window_cycles[filter->window_next] = sample->timestamp_cycles;
+	filter->window_next = (uint8_t)((filter->window_next + 1) % SONAR_FILTER_MEDIAN_WINDOW);
+	
+	if (filter->window_count < SONAR_FILTER_MEDIAN_WINDOW)
+	{
+		filter->window_count++;
+	}
+	
+	if (filter->window_count < SONAR_FILTER_MEDIAN_WINDOW)
+	{
+		// A lost target stays lost until it is seen reliably again
+		if (filter->state != SONAR_FILTER_LOST)
+		{
+			filter->state = SONAR_FILTER_ACQUIRING;
+		}
+		
+		return filter->state;
+	}
+	
+	Sonar_Filter_Median(filter, &median_mm, &median_cycles);
+	Sonar_Filter_Track(filter, median_mm, median_cycles);
+	filter->state = SONAR_FILTER_TRACKING;
+	
+	return filter->state;
+}
+
+Sonar_Filter_State Sonar_Filter_Get_State(const Sonar_Filter *filter)
+{
+	return filter->state;
+}
+
+uint8_t Sonar_Filter_Has_Estimate(const Sonar_Filter *filter)
+{
+	return (filter->state == SONAR_FILTER_TRACKING) || (filter->state == SONAR_FILTER_COASTING);
+}
+
+uint32_t Sonar_Filter_Predict_MM(const Sonar_Filter *filter, uint64_t now_cycles)
+{
+	uint32_t interval_us = 0;
+	int32_t predicted_um;
+	
+	if (!Sonar_Filter_Has_Estimate(filter))
+	{
+		return 0;
+	}
+	
+	if (now_cycles > filter->range_cycles)
+	{
+		interval_us = (uint32_t)((now_cycles - filter->range_cycles) / TIMEBASE_CYCLES_PER_US);
+	}
+	
+	predicted_um = filter->range_um + Sonar_Filter_Travel_UM(filter, interval_us);
+	
+	return (predicted_um > 0) ? (uint32_t)(predicted_um / SONAR_FILTER_UM_PER_MM) : 0;
+}
+
+int32_t Sonar_Filter_Closing_Speed_MM_S(const Sonar_Filter *filter)
+{
+	if (!Sonar_Filter_Has_Estimate(filter))
+	{
+		return 0;
+	}
+	
+	return -(filter->rate_um_s / SONAR_FILTER_UM_PER_MM);
+}
+
+uint32_t Sonar_Filter_Latest_MM(const Sonar_Filter *filter, uint64_t now_cycles, int32_t closing_speed_mm_s)
+{
+	uint32_t interval_us = 0;
+	int64_t latest_um;
+	
+	if (!Sonar_Filter_Has_Estimate(filter) || !filter->latest_valid)
+	{
+		return Sonar_Filter_Predict_MM(filter, now_cycles);
+	}
+	
+	if (now_cycles > filter->latest_cycles)
+	{
+		interval_us = (uint32_t)((now_cycles - filter->latest_cycles) / TIMEBASE_CYCLES_PER_US);
+	}
+	
+	latest_um = ((int64_t)filter->latest_mm * SONAR_FILTER_UM_PER_MM) - (((int64_t)closing_speed_mm_s * interval_us) / SONAR_FILTER_UM_PER_MM);
+	
+	return (latest_um > 0) ? (uint32_t)(latest_um / SONAR_FILTER_UM_PER_MM) : 0;
+}
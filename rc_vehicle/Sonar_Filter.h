@@ -0,0 +1,208 @@
+/**
+ * @file Sonar_Filter.h
+ *
+ * @brief Header file for the ultrasonic range filter.
+ *
+ * The filter turns the raw samples of the ultrasonic driver (see Ultra_Sonic.h) into a
+ * range estimate with a validity state, in two stages:
+ *
+ * - A sliding median over the last SONAR_FILTER_MEDIAN_WINDOW valid samples. Spurious
+ *   echoes (short reflections from the floor or crosstalk pulses) do not reach the output
+ *   unless they fill half of the window. The median keeps the timestamp of the sample it
+ *   selects, so on a steady approach it adds no bias, only the delay of two pings.
+ *
+ * - An alpha-beta tracker on the median output, which estimates the range and the range
+ *   rate. The estimate can be extrapolated to any time, which bridges pings without echo.
+ *   A median that falls further than SONAR_FILTER_GATE_MM from the prediction is ignored,
+ *   unless SONAR_FILTER_GATE_CONFIRM of them come in a row: another object is then in front
+ *   of the sensor, and the tracker restarts from it.
+ *
+ * The median and the tracker smooth the range, but lag it by a few pings while the vehicle
+ * accelerates. Safety checks can use Sonar_Filter_Latest_MM instead: the latest sample that
+ * fell within SONAR_FILTER_GATE_MM of the tracked range, extrapolated with a closing speed
+ * supplied by the caller (for example the wheel speed), which has no median delay.
+ *
+ * Pings without echo do not enter the median. Up to SONAR_FILTER_MAX_MISSES consecutive
+ * misses are bridged by extrapolation. After that, the echo is considered lost if the target
+ * was closer than SONAR_FILTER_NEAR_CM (soft or slanted surface, or an obstacle too close to
+ * measure), or gone otherwise (nothing within range).
+ *
+ * All the arithmetic is integer and every update runs in constant time.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef SONAR_FILTER_H
+#define SONAR_FILTER_H
+
+#include "Ultra_Sonic.h"
+#include <stdint.h>
+
+/**
+ * @brief Number of valid samples in the sliding median (odd)
+ */
+#define SONAR_FILTER_MEDIAN_WINDOW 5
+
+/**
+ * @brief Tracker gains in 1/256 units.
+ *
+ * They follow beta = alpha^2 / (2 - alpha), which gives a critically damped response
+ * (alpha = 0.5, beta = 0.167).
+ */
+#define SONAR_FILTER_ALPHA_Q8 128
+#define SONAR_FILTER_BETA_Q8  43
+
+/**
+ * @brief Largest difference between a median and the prediction that is tracked, in millimeters
+ */
+#define SONAR_FILTER_GATE_MM 250
+
+/**
+ * @brief Number of consecutive medians outside the gate that move the tracker to another object
+ */
+#define SONAR_FILTER_GATE_CONFIRM 2
+
+/**
+ * @brief Number of consecutive pings without echo that are bridged by extrapolation
+ */
+#define SONAR_FILTER_MAX_MISSES 2
+
+/**
+ * @brief Distance below which a lost echo is reported as SONAR_FILTER_LOST instead of SONAR_FILTER_NO_TARGET
+ */
+#define SONAR_FILTER_NEAR_CM 50
+
+/**
+ * @brief Validity of the range estimate
+ */
+typedef enum
+{
+	/** No echo was received recently: nothing is within range */
+	SONAR_FILTER_NO_TARGET,
+	
+	/** A target was seen, but fewer than SONAR_FILTER_MEDIAN_WINDOW samples were received; no estimate yet */
+	SONAR_FILTER_ACQUIRING,
+	
+	/** The estimate is based on the latest ping */
+	SONAR_FILTER_TRACKING,
+	
+	/** The latest pings had no echo; the estimate is extrapolated from the previous ones */
+	SONAR_FILTER_COASTING,
+	
+	/** The echo of a near target was lost. It stays lost until the median is filled again */
+	SONAR_FILTER_LOST
+} Sonar_Filter_State;
+
+/**
+ * @brief Filter state. One instance is needed per sensor.
+ */
+typedef struct
+{
+	/** Ring of the latest valid samples: distance in millimeters and timebase count */
+	uint32_t window_mm[SONAR_FILTER_MEDIAN_WINDOW];
+	uint64_t window_cycles[SONAR_FILTER_MEDIAN_WINDOW];
+	
+	/** Next ring slot to write, and number of slots written since the last restart */
+	uint8_t window_next;
+	uint8_t window_count;
+	
+	/** Validity of the estimate */
+	Sonar_Filter_State state;
+	
+	/** Number of consecutive pings without echo */
+	uint8_t missed_echoes;
+	
+	/** Number of consecutive medians outside the gate */
+	uint8_t gate_misses;
+	
+	/** Tracked range in micrometers and range rate in micrometers per second (negative when closing) */
+	int32_t range_um;
+	int32_t rate_um_s;
+	
+	/** Timebase count of the sample the tracked range refers to */
+	uint64_t range_cycles;
+	
+	/** Latest sample within the gate of the tracked range, in millimeters, and its timebase count */
+	uint32_t latest_mm;
+	uint64_t latest_cycles;
+	
+	/** 1 once a sample has passed the gate since the last restart */
+	uint8_t latest_valid;
+} Sonar_Filter;
+
+/**
+ * @brief The Sonar_Filter_Init function clears a filter.
+ *
+ * @param filter Pointer to the filter state.
+ *
+ * @return None
+ */
+void Sonar_Filter_Init(Sonar_Filter *filter);
+
+/**
+ * @brief The Sonar_Filter_Update function adds one ping to the filter.
+ *
+ * It must be called once for every sample of the sensor, including the ones without echo.
+ *
+ * @param filter Pointer to the filter state.
+ * @param sample The new sample (see Ultrasonic_Get_Sample).
+ *
+ * @return The validity of the estimate after the update.
+ */
+Sonar_Filter_State Sonar_Filter_Update(Sonar_Filter *filter, const Ultrasonic_Sample *sample);
+
+/**
+ * @brief The Sonar_Filter_Get_State function returns the validity of the estimate.
+ *
+ * @param filter Pointer to the filter state.
+ *
+ * @return The validity of the estimate.
+ */
+Sonar_Filter_State Sonar_Filter_Get_State(const Sonar_Filter *filter);
+
+/**
+ * @brief The Sonar_Filter_Has_Estimate function checks if the filter holds a range estimate.
+ *
+ * @param filter Pointer to the filter state.
+ *
+ * @return 1 in the SONAR_FILTER_TRACKING and SONAR_FILTER_COASTING states, 0 otherwise.
+ */
+uint8_t Sonar_Filter_Has_Estimate(const Sonar_Filter *filter);
+
+/**
+ * @brief The Sonar_Filter_Predict_MM function extrapolates the range to a given time.
+ *
+ * @param filter Pointer to the filter state.
+ * @param now_cycles Timebase count to extrapolate to (see Timebase_Now_Cycles).
+ *
+ * @return The predicted range in millimeters, never negative. 0 if there is no estimate.
+ */
+uint32_t Sonar_Filter_Predict_MM(const Sonar_Filter *filter, uint64_t now_cycles);
+
+/**
+ * @brief The Sonar_Filter_Closing_Speed_MM_S function returns the estimated closing speed.
+ *
+ * @param filter Pointer to the filter state.
+ *
+ * @return The closing speed in millimeters per second, positive when the target gets closer.
+ * 0 if there is no estimate.
+ */
+int32_t Sonar_Filter_Closing_Speed_MM_S(const Sonar_Filter *filter);
+
+/**
+ * @brief The Sonar_Filter_Latest_MM function extrapolates the latest gated sample to a given time.
+ *
+ * The latest valid sample within SONAR_FILTER_GATE_MM of the tracked range is moved closer at
+ * the given closing speed. It follows the vehicle about two pings sooner than
+ * Sonar_Filter_Predict_MM, at the cost of the noise of a single sample. Before the first gated
+ * sample, it returns Sonar_Filter_Predict_MM.
+ *
+ * @param filter Pointer to the filter state.
+ * @param now_cycles Timebase count to extrapolate to (see Timebase_Now_Cycles).
+ * @param closing_speed_mm_s Closing speed since the sample in millimeters per second, positive when the target gets closer.
+ *
+ * @return The range in millimeters, never negative. 0 if there is no estimate.
+ */
+uint32_t Sonar_Filter_Latest_MM(const Sonar_Filter *filter, uint64_t now_cycles, int32_t closing_speed_mm_s);
+
+#endif
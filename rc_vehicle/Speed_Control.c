@@ -0,0 +1,247 @@
+/**
+ * @file Speed_Control.c
+ *
+ * @brief Source code for the closed-loop wheel speed controller.
+ *
+ * The integral is kept in 1/256 duty cycle counts, so that the small corrections made at
+ * low speed errors are not lost to rounding. All the functions are called from the main
+ * loop tasks, except Speed_Control_Hold, which the deadman interrupt calls (see
+ * Vehicle_Link_Lost). It only sets the output_held latch: the target, the integral and the
+ * output stay owned by the tasks, and the latch is checked with the interrupts disabled where
+ * the output is handed to the motion profile, so a duty cycle computed before the latch was
+ * set is never written after it.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "TM4C123GH6PM.h"
+#include "Speed_Control.h"
+#include "Wheel_Encoder.h"
+#include "Motion_Profile.h"
+#include "Scheduler.h"
+#include "Parameters.h"
+#include "Latency.h"
+
+#define SPEED_CONTROL_STALL_SAMPLES ((SPEED_CONTROL_STALL_MS * WHEEL_ENCODER_SAMPLE_HZ) / 1000)
+
+// The integral is held while the motor ramp still has to deliver more
+// than this part of the previous output
+#define SPEED_CONTROL_LAG_PERCENT 2
+
+static int32_t control_max_duty;
+
+static int32_t control_target_mm_s;
+static int32_t control_measured_mm_s;
+static int32_t control_output_duty;
+static int32_t control_integral_q8;
+
+// Encoder fault detection: consecutive samples without edges at a high output
+static uint32_t stall_samples;
+static uint8_t encoder_fault;
+
+static uint32_t last_sample_sequence;
+
+// Set by Speed_Control_Hold (deadman interrupt), cleared by Speed_Control_Release (next command)
+static volatile uint8_t output_held;
+
+static int32_t Speed_Control_Clamp(int32_t value, int32_t minimum, int32_t maximum)
+{
+	if (value < minimum)
+	{
+		return minimum;
+	}
+	
+	if (value > maximum)
+	{
+		return maximum;
+	}
+	
+	return value;
+}
+
+static int32_t Speed_Control_Feed_Forward(int32_t target_mm_s)
+{
+	int32_t duty = (int32_t)(((int64_t)target_mm_s * control_max_duty) / SPEED_CONTROL_FF_MAX_SPEED_MM_S);
+	int32_t start_duty = (control_max_duty * SPEED_CONTROL_FF_START_DUTY_PERCENT) / 100;
+	
+	return (target_mm_s > 0) ? (duty + start_duty) : (duty - start_duty);
+}
+
+static void Speed_Control_Apply(int32_t output_duty)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint8_t write_pending;
+	
+	// The latch can be set at any point of the task: it is checked and the output written
+	// without an interrupt in between
+	__disable_irq();
+	
+	if (output_held)
+	{
+		output_duty = 0;
+	}
+	
+	control_output_duty = output_duty;
+	Motion_Profile_Set_Target(output_duty);
+	write_pending = (Motion_Profile_Get_Duty() != output_duty);
+	__set_PRIMASK(primask);
+	
+	Latency_Motor_Target_Set(write_pending);
+}
+
+static void Speed_Control_Update_Fault(const Wheel_Encoder_Sample *sample)
+{
+	int32_t stall_duty = (control_max_duty * SPEED_CONTROL_STALL_DUTY_PERCENT) / 100;
+	
+	if (sample->edges > 0)
+	{
+		stall_samples = 0;
+		encoder_fault = 0;
+	}
+	else if ((control_output_duty >= stall_duty) || (control_output_duty <= -stall_duty))
+	{
+		stall_samples++;
+		
+		if (stall_samples >= SPEED_CONTROL_STALL_SAMPLES)
+		{
+			encoder_fault = 1;
+		}
+	}
+}
+
+static void Speed_Control_Task(void)
+{
+	Wheel_Encoder_Sample sample;
+	int32_t target_mm_s = control_target_mm_s;
+	int32_t lag_limit = (control_max_duty * SPEED_CONTROL_LAG_PERCENT) / 100;
+	int32_t minimum_duty;
+	int32_t maximum_duty;
+	int32_t error_mm_s;
+	int32_t lag_duty;
+	int32_t output_duty;
+	uint8_t hold_integral;
+	
+	Wheel_Encoder_Get_Sample(&sample);
+	
+	// Periodic runs without a new sample have nothing to do
+	if (sample.sequence == last_sample_sequence)
+	{
+		return;
+	}
+	
+	last_sample_sequence = sample.sequence;
+	control_measured_mm_s = sample.speed_mm_s;
+	
+	Speed_Control_Update_Fault(&sample);
+	
+	// The motor coasts to a stop, or is held at rest after a loss of the command link
+	if ((target_mm_s == 0) || output_held)
+	{
+		control_integral_q8 = 0;
+		Speed_Control_Apply(0);
+		return;
+	}
+	
+	if (encoder_fault)
+	{
+		control_integral_q8 = 0;
+		Speed_Control_Apply(Speed_Control_Clamp(Speed_Control_Feed_Forward(target_mm_s), -control_max_duty, control_max_duty));
+		return;
+	}
+	
+	// The motor is never driven against the target direction: it slows down by coasting
+	minimum_duty = (target_mm_s > 0) ? 0 : -control_max_duty;
+	maximum_duty = (target_mm_s > 0) ? control_max_duty : 0;
+	
+	error_mm_s = target_mm_s - control_measured_mm_s;
+	
+	// Anti-windup: the integral is held while the output cannot follow it, either because
+	// it is saturated or because the motor ramp has not delivered the previous output yet
+	lag_duty = control_output_duty - Motion_Profile_Get_Duty();
+	hold_integral = ((error_mm_s > 0) && ((control_output_duty >= maximum_duty) || (lag_duty > lag_limit))) ||
+	                ((error_mm_s < 0) && ((control_output_duty <= minimum_duty) || (lag_duty < -lag_limit)));
+	
+	if (!hold_integral)
+	{
+		control_integral_q8 += (int32_t)(((int64_t)error_mm_s * parameters.speed_ki_q8) / WHEEL_ENCODER_SAMPLE_HZ);
+		control_integral_q8 = Speed_Control_Clamp(control_integral_q8, -control_max_duty * 256, control_max_duty * 256);
+	}
+	
+	output_duty = Speed_Control_Feed_Forward(target_mm_s)
+		+ (int32_t)(((int64_t)error_mm_s * parameters.speed_kp_q8) / 256)
+		+ (control_integral_q8 / 256);
+	
+	Speed_Control_Apply(Speed_Control_Clamp(output_duty, minimum_duty, maximum_duty));
+}
+
+void Speed_Control_Init(uint16_t max_duty)
+{
+	control_max_duty = max_duty;
+	control_target_mm_s = 0;
+	control_measured_mm_s = 0;
+	control_output_duty = 0;
+	control_integral_q8 = 0;
+	stall_samples = 0;
+	encoder_fault = 0;
+	last_sample_sequence = 0;
+	output_held = 0;
+	
+	Wheel_Encoder_Set_Sample_Task(Scheduler_Add_Task("speed", Speed_Control_Task,
+		SPEED_CONTROL_TASK_PERIOD_US, SPEED_CONTROL_TASK_DEADLINE_US));
+}
+
+void Speed_Control_Set_Target(int32_t speed_mm_s)
+{
+	// A change of direction starts the integral over
+	if ((speed_mm_s > 0) != (control_target_mm_s > 0))
+	{
+		control_integral_q8 = 0;
+	}
+	
+	control_target_mm_s = speed_mm_s;
+}
+
+int32_t Speed_Control_Get_Target(void)
+{
+	return control_target_mm_s;
+}
+
+void Speed_Control_Stop_Now(void)
+{
+	control_target_mm_s = 0;
+	control_integral_q8 = 0;
+	control_output_duty = 0;
+	Motion_Profile_Stop_Now();
+}
+
+void Speed_Control_Hold(void)
+{
+	output_held = 1;
+}
+
+void Speed_Control_Release(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	// The motion commanded before the loss is not resumed: the next command sets a new target
+	control_target_mm_s = 0;
+	control_integral_q8 = 0;
+	
+	__disable_irq();
+	output_held = 0;
+	__set_PRIMASK(primask);
+}
+
+int Speed_Control_Output_Held(void)
+{
+	return output_held;
+}
+
+void Speed_Control_Get_Status(Speed_Control_Status *status)
+{
+	status->target_mm_s = control_target_mm_s;
+	status->measured_mm_s = control_measured_mm_s;
+	status->output_duty = control_output_duty;
+	status->integral_duty = control_integral_q8 / 256;
+	status->encoder_fault = encoder_fault;
+}
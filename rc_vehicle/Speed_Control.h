@@ -0,0 +1,167 @@
+/**
+ * @file Speed_Control.h
+ *
+ * @brief Header file for the closed-loop wheel speed controller.
+ *
+ * A scheduler task runs once per wheel encoder sample (see Wheel_Encoder.h), at
+ * WHEEL_ENCODER_SAMPLE_HZ, and computes the motor duty cycle that holds the target speed:
+ *
+ *   duty = feed-forward + Kp * error + integral
+ *
+ * - The feed-forward term is the duty cycle that gives the target speed on a charged battery
+ *   and a flat floor, so the loop only corrects the difference.
+ * - The integral removes the remaining error (battery charge, load, floor surface). It is held
+ *   while the output is saturated, or while the motor ramp (see Motion_Profile.h) has not yet
+ *   delivered the previous output, so that it does not wind up during accelerations.
+ *
+ * The duty cycle is handed to the motion profile generator, which keeps the acceleration and
+ * jerk limits. A target of 0 lets the motor coast to a stop.
+ *
+ * If the output stays above SPEED_CONTROL_STALL_DUTY_PERCENT for SPEED_CONTROL_STALL_MS while the
+ * encoder reports no edge at all, the encoder is assumed to be disconnected: the controller
+ * falls back to the feed-forward term alone until edges are seen again.
+ *
+ * The gains are tuned for a motor time constant of about 150 ms and a full-duty speed of
+ * SPEED_CONTROL_FF_MAX_SPEED_MM_S (the simulator defaults).
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef SPEED_CONTROL_H
+#define SPEED_CONTROL_H
+
+#include <stdint.h>
+
+/**
+ * @brief Proportional gain in duty cycle counts per mm/s, in 1/256 units (62.5).
+ * Default of the speed_kp_q8 parameter (see Parameters.h).
+ */
+#define SPEED_CONTROL_KP_Q8 16000
+
+/**
+ * @brief Integral gain in duty cycle counts per mm/s per second, in 1/256 units (417).
+ * Default of the speed_ki_q8 parameter (see Parameters.h).
+ */
+#define SPEED_CONTROL_KI_Q8 106667
+
+/**
+ * @brief Feed-forward model: speed reached at full duty cycle, and duty cycle needed to start moving
+ */
+#define SPEED_CONTROL_FF_MAX_SPEED_MM_S 1500
+#define SPEED_CONTROL_FF_START_DUTY_PERCENT 0
+
+/**
+ * @brief Encoder fault detection: output level and duration without any edge
+ */
+#define SPEED_CONTROL_STALL_DUTY_PERCENT 25
+#define SPEED_CONTROL_STALL_MS 300
+
+/**
+ * @brief Period and deadline of the speed task in microseconds.
+ * The task is also released immediately by every new encoder sample.
+ */
+#define SPEED_CONTROL_TASK_PERIOD_US 20000
+#define SPEED_CONTROL_TASK_DEADLINE_US 5000
+
+/**
+ * @brief Snapshot of the controller state.
+ */
+typedef struct
+{
+	/** Target speed in millimeters per second, positive forward */
+	int32_t target_mm_s;
+	
+	/** Latest measured wheel speed in millimeters per second */
+	int32_t measured_mm_s;
+	
+	/** Latest duty cycle handed to the motion profile generator, signed */
+	int32_t output_duty;
+	
+	/** Integral term in duty cycle counts */
+	int32_t integral_duty;
+	
+	/** 1 while the encoder is considered disconnected and the controller runs open-loop */
+	uint8_t encoder_fault;
+} Speed_Control_Status;
+
+/**
+ * @brief The Speed_Control_Init function resets the controller and registers its task.
+ *
+ * Scheduler_Init, Motion_Profile_Init and Wheel_Encoder_Init must be called first.
+ *
+ * @param max_duty The duty cycle that corresponds to 100%, in PWM clock cycles.
+ *
+ * @return None
+ */
+void Speed_Control_Init(uint16_t max_duty);
+
+/**
+ * @brief The Speed_Control_Set_Target function sets the speed to hold.
+ *
+ * This function does not block. The new target is used from the next encoder sample.
+ *
+ * @param speed_mm_s Target speed in millimeters per second, positive forward, 0 to stop.
+ *
+ * @return None
+ */
+void Speed_Control_Set_Target(int32_t speed_mm_s);
+
+/**
+ * @brief The Speed_Control_Get_Target function returns the target speed.
+ *
+ * @param None
+ *
+ * @return The target speed in millimeters per second.
+ */
+int32_t Speed_Control_Get_Target(void);
+
+/**
+ * @brief The Speed_Control_Stop_Now function sets the target to 0 and cuts the motor output at once.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Speed_Control_Stop_Now(void);
+
+/**
+ * @brief The Speed_Control_Hold function holds the motor output at 0 until Speed_Control_Release.
+ *
+ * It is called from the deadman interrupt, and only sets a latch: the speed task sees it at
+ * its next run, and no duty cycle other than 0 is handed to the motion profile while it is set.
+ * The caller stops or ramps down the motion profile itself.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Speed_Control_Hold(void);
+
+/**
+ * @brief The Speed_Control_Release function ends a hold, with a target of 0.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Speed_Control_Release(void);
+
+/**
+ * @brief The Speed_Control_Output_Held function tells whether the output is held at 0.
+ *
+ * @param None
+ *
+ * @return 1 while the output is held, 0 otherwise.
+ */
+int Speed_Control_Output_Held(void);
+
+/**
+ * @brief The Speed_Control_Get_Status function copies the controller state.
+ *
+ * @param status Pointer to the structure that receives the state.
+ *
+ * @return None
+ */
+void Speed_Control_Get_Status(Speed_Control_Status *status);
+
+#endif
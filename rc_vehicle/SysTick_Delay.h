@@ -4,25 +4,29 @@
  * @brief Header file for the SysTick_Delay driver.
  *
  * It provides two blocking functions, SysTick_Delay1ms and SysTick_Delay1us,
- * to create a delay with a busy-wait loop. It uses the SysTick timer with 
- * a specified reload value to generate interrupts every 1 us.
- * 
- * In addition, it uses the Peripheral Internal Oscillator (PIOSC) 
- * as the clock source. The PIOSC provides 16 MHz which is then divided by 4. 
- * The timer is used for creating delays in either microseconds or milliseconds.
+ * to create a delay. The delays are measured against the free-running 64-bit
+ * timebase (see Timebase.h), and the CPU sleeps until the deadline with
+ * Idle_Wait_Until (see Idle.h), which uses the SysTick timer as its wake-up timer.
+ * Called from an interrupt service routine, the delays spin instead.
+ *
+ * Each call computes its own absolute deadline, so delays started from different
+ * contexts (for example, the main loop and an interrupt service routine) do not
+ * corrupt each other.
  *
  * @author Aaron Nanas
  */
- 
+
+#ifndef SYSTICK_DELAY_H
+#define SYSTICK_DELAY_H
+
 #include "TM4C123GH6PM.h"
+#include "Timebase.h"
 
 /**
- * @brief The SysTick_Delay_Init function initializes the SysTick timer to be used for a blocking delay function.
+ * @brief The SysTick_Delay_Init function initializes the timebase used by the blocking delay functions.
  *
- * This function configures the SysTick timer and its interrupt with a specified reload value to 
- * generate interrupts every 1 us. It uses the Peripheral Internal Oscillator (PIOSC) as the clock source.
- * The PIOSC provides 16 MHz which is then divided by 4. The timer is used for creating delays in either 
- * microseconds or milliseconds.
+ * This function starts the free-running timebase with Timebase_Init and makes sure
+ * the SysTick timer and its interrupt are disabled.
  *
  * @param None
  *
@@ -31,10 +35,10 @@
 void SysTick_Delay_Init(void);
 
 /**
- * @brief The SysTick_Delay1us function provides a blocking delay in microseconds using the SysTick timer.
+ * @brief The SysTick_Delay1us function provides a blocking delay in microseconds.
  *
- * This function resets the global variable, us_elapsed, to zero and waits until us_elapsed reaches 
- * the specified delay_in_us.
+ * This function computes a deadline delay_in_us microseconds from now and sleeps until
+ * the timebase reaches it.
  *
  * @param delay_in_us The delay time in microseconds.
  *
@@ -43,11 +47,10 @@ void SysTick_Delay_Init(void);
 void SysTick_Delay1us(uint32_t delay_in_us);
 
 /**
- * @brief The SysTick_Delay1ms function provides a blocking delay in milliseconds using the SysTick timer.
+ * @brief The SysTick_Delay1ms function provides a blocking delay in milliseconds.
  *
- * This function clears the global variables, us_elapsed and ms_elapsed, to zero and sets ms_active flag to 0x01 
- * indicating that milliseconds delay is active. It then waits until ms_elapsed reaches the specified delay_in_ms.
- * After the delay, it clears ms_active flag back to 0x00.
+ * This function computes a deadline delay_in_ms milliseconds from now and sleeps until
+ * the timebase reaches it.
  *
  * @param delay_in_ms The delay time in milliseconds.
  *
@@ -55,15 +58,4 @@ void SysTick_Delay1us(uint32_t delay_in_us);
  */
 void SysTick_Delay1ms(uint32_t delay_in_ms);
 
-/**
- * @brief The SysTick_Handler function is the interrupt service routine for the SysTick timer.
- *
- * This function is called whenever the SysTick timer generates an interrupt. It increments the global variable
- * us_elapsed by 1, indicating that 1 microsecond has passed. Additionally, if us_elapsed reaches 1000 and ms_active
- * flag is set to 0x01, it resets us_elapsed and increments ms_elapsed by 1, indicating that 1 millisecond has passed.
- *
- * @param None
- *
- * @return None
- */
-void SysTick_Handler(void);
+#endif
@@ -0,0 +1,121 @@
+/**
+ * @file System_Clock.c
+ *
+ * @brief Source file for the system clock configuration.
+ *
+ * The PLL is configured with the RCC2 register, which is the only one that can select the
+ * 400 MHz PLL output (DIV400) and therefore 80 MHz. The sequence follows the
+ * Initialization and Configuration steps of the System Control section
+ * in the TM4C123G Microcontroller Datasheet.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "System_Clock.h"
+
+// Fields of the RCC register
+#define SYSTEM_CLOCK_RCC_USESYSDIV 0x00400000
+#define SYSTEM_CLOCK_RCC_BYPASS    0x00000800
+#define SYSTEM_CLOCK_RCC_XTAL      0x000007C0
+#define SYSTEM_CLOCK_RCC_MOSCDIS   0x00000001
+
+// Fields of the RCC2 register
+#define SYSTEM_CLOCK_RCC2_USERCC2  0x80000000
+#define SYSTEM_CLOCK_RCC2_DIV400   0x40000000
+#define SYSTEM_CLOCK_RCC2_SYSDIV   0x1FC00000  // SYSDIV2 and SYSDIV2LSB, used together with DIV400
+#define SYSTEM_CLOCK_RCC2_PWRDN2   0x00002000
+#define SYSTEM_CLOCK_RCC2_BYPASS2  0x00000800
+#define SYSTEM_CLOCK_RCC2_OSCSRC2  0x00000070
+
+// PLLLRIS bit (Bit 6) in the RIS register: the PLL has locked
+#define SYSTEM_CLOCK_PLL_LOCK_BIT_MASK 0x40
+
+// Frequencies of the other oscillator sources
+#define SYSTEM_CLOCK_PIOSC_HZ 16000000UL
+
+void System_Clock_Init(void)
+{
+	// Use the RCC2 register by setting the USERCC2 bit (Bit 31), then run from the
+	// oscillator directly while the PLL is configured by setting the BYPASS2 bit (Bit 11)
+	// and clearing the USESYSDIV bit (Bit 22) in the RCC register
+	SYSCTL->RCC2 |= SYSTEM_CLOCK_RCC2_USERCC2;
+	SYSCTL->RCC2 |= SYSTEM_CLOCK_RCC2_BYPASS2;
+	SYSCTL->RCC &= ~SYSTEM_CLOCK_RCC_USESYSDIV;
+	
+	// Enable the main oscillator by clearing the MOSCDIS bit (Bit 0) and select the
+	// 16 MHz crystal by writing 0x15 to the XTAL field (Bits 10 to 6) in the RCC register
+	SYSCTL->RCC &= ~(SYSTEM_CLOCK_RCC_XTAL | SYSTEM_CLOCK_RCC_MOSCDIS);
+	SYSCTL->RCC |= (SYSTEM_CLOCK_XTAL_FIELD << 6);
+	
+	// Select the main oscillator as the source by clearing the OSCSRC2 field (Bits 6 to 4),
+	// and power up the PLL by clearing the PWRDN2 bit (Bit 13) in the RCC2 register
+	SYSCTL->RCC2 &= ~SYSTEM_CLOCK_RCC2_OSCSRC2;
+	SYSCTL->RCC2 &= ~SYSTEM_CLOCK_RCC2_PWRDN2;
+	
+	// Use the 400 MHz PLL output by setting the DIV400 bit (Bit 30), and write the divisor
+	// minus one to the SYSDIV2 and SYSDIV2LSB fields (Bits 28 to 22) in the RCC2 register
+	SYSCTL->RCC2 |= SYSTEM_CLOCK_RCC2_DIV400;
+	SYSCTL->RCC2 = (SYSCTL->RCC2 & ~SYSTEM_CLOCK_RCC2_SYSDIV) | ((uint32_t)(SYSTEM_CLOCK_PLL_DIVISOR - 1) << 22);
+	
+	// Enable the system clock divider by setting the USESYSDIV bit (Bit 22) in the RCC register
+	SYSCTL->RCC |= SYSTEM_CLOCK_RCC_USESYSDIV;
+	
+	// Wait until the PLL has locked
+	while ((SYSCTL->RIS & SYSTEM_CLOCK_PLL_LOCK_BIT_MASK) == 0);
+	
+	// Switch the system clock to the PLL by clearing the BYPASS2 bit (Bit 11) in the RCC2 register
+	SYSCTL->RCC2 &= ~SYSTEM_CLOCK_RCC2_BYPASS2;
+	
+	SystemCoreClock = SYSTEM_CLOCK_HZ;
+}
+
+uint32_t System_Clock_Get_Hz(void)
+{
+	uint32_t rcc = SYSCTL->RCC;
+	uint32_t rcc2 = SYSCTL->RCC2;
+	uint32_t use_rcc2 = rcc2 & SYSTEM_CLOCK_RCC2_USERCC2;
+	uint32_t bypass = use_rcc2 ? (rcc2 & SYSTEM_CLOCK_RCC2_BYPASS2) : (rcc & SYSTEM_CLOCK_RCC_BYPASS);
+	uint32_t source = use_rcc2 ? ((rcc2 >> 4) & 0x07) : ((rcc >> 4) & 0x03);
+	uint32_t divisor = 1;
+	uint32_t frequency;
+	
+	if (!bypass)
+	{
+		frequency = (use_rcc2 && (rcc2 & SYSTEM_CLOCK_RCC2_DIV400)) ? SYSTEM_CLOCK_PLL_HZ : (SYSTEM_CLOCK_PLL_HZ / 2);
+	}
+	else if (source == 0)
+	{
+		frequency = SYSTEM_CLOCK_XTAL_HZ;
+	}
+	else if (source == 1)
+	{
+		frequency = SYSTEM_CLOCK_PIOSC_HZ;
+	}
+	else if (source == 2)
+	{
+		frequency = SYSTEM_CLOCK_PIOSC_HZ / 4;
+	}
+	else
+	{
+		// Low-frequency oscillators (30 kHz internal or 32.768 kHz hibernation)
+		frequency = (source == 7) ? 32768 : 30000;
+	}
+	
+	if (rcc & SYSTEM_CLOCK_RCC_USESYSDIV)
+	{
+		if (use_rcc2 && (rcc2 & SYSTEM_CLOCK_RCC2_DIV400))
+		{
+			divisor = ((rcc2 >> 22) & 0x7F) + 1;
+		}
+		else if (use_rcc2)
+		{
+			divisor = ((rcc2 >> 23) & 0x3F) + 1;
+		}
+		else
+		{
+			divisor = ((rcc >> 23) & 0x0F) + 1;
+		}
+	}
+	
+	return frequency / divisor;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file System_Clock.h
+ *
+ * @brief Header file for the system clock configuration.
+ *
+ * This is the single place where the clock frequencies are decided. System_Clock_Init runs the
+ * main oscillator (16 MHz crystal) through the PLL and divides the 400 MHz PLL output by
+ * SYSTEM_CLOCK_PLL_DIVISOR, which gives the 80 MHz system clock.
+ *
+ * The drivers derive their timing from the constants below at compile time instead of
+ * assuming a frequency:
+ *
+ * - SYSTEM_CLOCK_HZ and SYSTEM_CLOCK_CYCLES_PER_US: timers, the timebase (see Timebase.h),
+ *   the QEI velocity window and the UART baud rate divisors (see UART0.h).
+ * - SYSTEM_CLOCK_PWM_HZ: the PWM load and compare values (see PWM_Clock.h and PWM2_2.h).
+ *   The PWM divider is the smallest one that lets a SYSTEM_CLOCK_PWM_MIN_HZ period fit in
+ *   the 16-bit PWM counter.
+ *
+ * Changing SYSTEM_CLOCK_PLL_DIVISOR therefore retunes every driver with a rebuild.
+ *
+ * @note System_Clock_Init must be the first function called by main, before any driver is
+ * initialized.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef SYSTEM_CLOCK_H
+#define SYSTEM_CLOCK_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief Frequency of the crystal connected to the main oscillator, and its XTAL field value in RCC
+ */
+#define SYSTEM_CLOCK_XTAL_HZ 16000000UL
+#define SYSTEM_CLOCK_XTAL_FIELD 0x15
+
+/**
+ * @brief Frequency of the PLL output
+ */
+#define SYSTEM_CLOCK_PLL_HZ 400000000UL
+
+/**
+ * @brief Divisor applied to the PLL output: 5 gives 80 MHz, the highest supported frequency
+ */
+#define SYSTEM_CLOCK_PLL_DIVISOR 5
+
+/**
+ * @brief System clock frequency in Hz
+ */
+#define SYSTEM_CLOCK_HZ (SYSTEM_CLOCK_PLL_HZ / SYSTEM_CLOCK_PLL_DIVISOR)
+
+/**
+ * @brief Number of system clock cycles per microsecond
+ */
+#define SYSTEM_CLOCK_CYCLES_PER_US (SYSTEM_CLOCK_HZ / 1000000UL)
+
+/**
+ * @brief Lowest PWM frequency that the drivers need (the 50 Hz servo and motor period)
+ */
+#define SYSTEM_CLOCK_PWM_MIN_HZ 50
+
+// The PWM period must fit in the 16-bit counter
+#define SYSTEM_CLOCK_PWM_FITS(divider) ((SYSTEM_CLOCK_HZ / (divider) / SYSTEM_CLOCK_PWM_MIN_HZ) <= 65536UL)
+
+/**
+ * @brief Divider between the system clock and the PWM clock (2 to 64), and its PWMDIV field value in RCC
+ */
+#define SYSTEM_CLOCK_PWM_DIVIDER (SYSTEM_CLOCK_PWM_FITS(2) ? 2 : SYSTEM_CLOCK_PWM_FITS(4) ? 4 : \
+	SYSTEM_CLOCK_PWM_FITS(8) ? 8 : SYSTEM_CLOCK_PWM_FITS(16) ? 16 : SYSTEM_CLOCK_PWM_FITS(32) ? 32 : 64)
+
+#define SYSTEM_CLOCK_PWMDIV_FIELD (SYSTEM_CLOCK_PWM_FITS(2) ? 0x0 : SYSTEM_CLOCK_PWM_FITS(4) ? 0x1 : \
+	SYSTEM_CLOCK_PWM_FITS(8) ? 0x2 : SYSTEM_CLOCK_PWM_FITS(16) ? 0x3 : SYSTEM_CLOCK_PWM_FITS(32) ? 0x4 : 0x5)
+
+/**
+ * @brief PWM clock frequency in Hz
+ */
+#define SYSTEM_CLOCK_PWM_HZ (SYSTEM_CLOCK_HZ / SYSTEM_CLOCK_PWM_DIVIDER)
+
+/**
+ * @brief Converts a duration in microseconds to PWM clock cycles
+ */
+#define SYSTEM_CLOCK_PWM_US_TO_TICKS(us) ((uint32_t)(((uint64_t)(us) * SYSTEM_CLOCK_PWM_HZ) / 1000000UL))
+
+#if (SYSTEM_CLOCK_PLL_DIVISOR < 5) || (SYSTEM_CLOCK_PLL_DIVISOR > 128)
+#error "SYSTEM_CLOCK_PLL_DIVISOR must be between 5 (80 MHz) and 128"
+#endif
+
+#if ((SYSTEM_CLOCK_HZ / 64 / SYSTEM_CLOCK_PWM_MIN_HZ) > 65536UL)
+#error "SYSTEM_CLOCK_PWM_MIN_HZ is too low for the 16-bit PWM counter"
+#endif
+
+/**
+ * @brief The System_Clock_Init function switches the system clock to the PLL.
+ *
+ * This function selects the main oscillator as the PLL input, powers up the PLL, waits
+ * until it locks and then runs the system clock at SYSTEM_CLOCK_HZ. It also updates
+ * the CMSIS SystemCoreClock variable.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void System_Clock_Init(void);
+
+/**
+ * @brief The System_Clock_Get_Hz function returns the system clock frequency set in the hardware.
+ *
+ * The frequency is decoded from the RCC and RCC2 registers, so it also reflects a
+ * configuration that was not made by System_Clock_Init.
+ *
+ * @param None
+ *
+ * @return The system clock frequency in Hz.
+ */
+uint32_t System_Clock_Get_Hz(void);
+
+#endif
@@ -0,0 +1,232 @@
+/**
+ * @file Telemetry.c
+ *
+ * @brief Source code for the periodic binary telemetry stream.
+ *
+ * The fault flags that report events (lost data, missed deadlines, dropped frames)
+ * are derived by comparing the counters of the other modules with their values at
+ * the previous record.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Telemetry.h"
+#include "Protocol.h"
+#include "Scheduler.h"
+#include "Timebase.h"
+#include "UART0.h"
+#include "Ultra_Sonic.h"
+#include "Vehicle_Control.h"
+
+// Period of the telemetry task for a given rate, in microseconds
+#define TELEMETRY_PERIOD_US(rate_hz) (1000000U / (rate_hz))
+
+static int telemetry_task_id = -1;
+
+// The frame being transmitted by the uDMA controller. It is only rewritten
+// once UART0_DMA_Busy reports that the previous frame has been sent
+static uint8_t telemetry_frame[PROTOCOL_MAX_ENCODED_FRAME];
+
+static uint32_t telemetry_sequence = 0;
+static Telemetry_Statistics telemetry_statistics;
+
+// Counter values at the previous record
+static uint32_t last_uart_errors = 0;
+static uint32_t last_deadline_misses = 0;
+static uint32_t last_frame_errors = 0;
+static uint32_t last_records_dropped = 0;
+
+static void Put_U16(uint8_t *output, uint16_t value)
+{
+	output[0] = (uint8_t)(value & 0xFF);
+	output[1] = (uint8_t)(value >> 8);
+}
+
+static void Put_U32(uint8_t *output, uint32_t value)
+{
+	Put_U16(output, (uint16_t)(value & 0xFFFF));
+	Put_U16(output + 2, (uint16_t)(value >> 16));
+}
+
+static uint32_t Total_UART_Errors(void)
+{
+	UART0_Statistics stats;
+	
+	UART0_Get_Statistics(&stats);
+	
+	return stats.rx_overflow_count + stats.rx_overrun_count + stats.rx_framing_error_count + stats.tx_overflow_count;
+}
+
+static uint32_t Total_Deadline_Misses(void)
+{
+	Scheduler_Task_Statistics stats;
+	uint32_t total = 0;
+	int i;
+	
+	for (i = 0; i < Scheduler_Task_Count(); i++)
+	{
+		Scheduler_Get_Task_Statistics(i, &stats);
+		total += stats.deadline_miss_count;
+	}
+	
+	return total;
+}
+
+static uint32_t Total_Frame_Errors(void)
+{
+	Protocol_Statistics stats;
+	
+	Protocol_Get_Statistics(&stats);
+	
+	return stats.crc_errors + stats.framing_errors;
+}
+
+// Sets flag in the fault flags if counter changed since the previous record
+static uint8_t Counter_Fault(uint32_t counter, uint32_t *last_counter, uint8_t flag)
+{
+	uint8_t fault = (counter != *last_counter) ? flag : 0;
+	
+	*last_counter = counter;
+	
+	return fault;
+}
+
+static void Telemetry_Take_Record(Telemetry_Record *record)
+{
+	Ultrasonic_Sample sample;
+	Vehicle_Status status;
+	uint64_t now = Timebase_Now_Cycles();
+	uint32_t loop_time_us = Scheduler_Take_Max_Loop_US();
+	
+	Ultrasonic_Get_Sample(ULTRASONIC_FRONT, &sample);
+	Vehicle_Get_Status(&status);
+	
+	record->timestamp_us = (uint32_t)(now / TIMEBASE_CYCLES_PER_US);
+	record->sequence = telemetry_sequence;
+	record->distance_cm = (sample.distance_cm > 0xFFFF) ? 0xFFFF : (uint16_t)sample.distance_cm;
+	record->distance_age_ms = 0xFFFF;
+	
+	if (sample.sequence != 0)
+	{
+		uint32_t age_ms = Timebase_Elapsed_US(sample.timestamp_cycles) / 1000;
+		
+		if (age_ms < 0xFFFF)
+		{
+			record->distance_age_ms = (uint16_t)age_ms;
+		}
+	}
+	
+	record->motor_duty = status.motor_duty;
+	record->servo_duty = status.servo_duty;
+	record->loop_time_us = (loop_time_us > 0xFFFF) ? 0xFFFF : (uint16_t)loop_time_us;
+	record->direction = (uint8_t)status.direction;
+	
+	record->fault_flags = 0;
+	
+	if (status.obstacle_detected)
+	{
+		record->fault_flags |= TELEMETRY_FAULT_OBSTACLE;
+	}
+	
+	if ((sample.sequence != 0) && !sample.valid)
+	{
+		record->fault_flags |= TELEMETRY_FAULT_SONAR_INVALID;
+	}
+	
+	if (status.sonar_state == SONAR_FILTER_LOST)
+	{
+		record->fault_flags |= TELEMETRY_FAULT_SONAR_LOST;
+	}
+	
+	if (status.encoder_fault)
+	{
+		record->fault_flags |= TELEMETRY_FAULT_ENCODER;
+	}
+	
+	record->fault_flags |= Counter_Fault(Total_UART_Errors(), &last_uart_errors, TELEMETRY_FAULT_UART_OVERFLOW);
+	record->fault_flags |= Counter_Fault(Total_Deadline_Misses(), &last_deadline_misses, TELEMETRY_FAULT_DEADLINE_MISS);
+	record->fault_flags |= Counter_Fault(Total_Frame_Errors(), &last_frame_errors, TELEMETRY_FAULT_FRAME_ERROR);
+	record->fault_flags |= Counter_Fault(telemetry_statistics.records_dropped, &last_records_dropped, TELEMETRY_FAULT_RECORD_DROPPED);
+}
+
+static void Telemetry_Task(void)
+{
+	Telemetry_Record record;
+	uint8_t payload[TELEMETRY_RECORD_SIZE];
+	uint16_t frame_length;
+	
+	// The stream would corrupt the output of the character mode
+	if (Protocol_Get_Mode() != PROTOCOL_MODE_FRAMED)
+	{
+		return;
+	}
+	
+	// Never rewrite the frame while the uDMA controller is still reading it
+	if (UART0_DMA_Busy())
+	{
+		telemetry_sequence++;
+		telemetry_statistics.records_dropped++;
+		return;
+	}
+	
+	Telemetry_Take_Record(&record);
+	Telemetry_Serialize(&record, payload);
+	
+	frame_length = Protocol_Encode(PROTOCOL_TELEMETRY, (uint8_t)(telemetry_sequence & 0xFF), payload, TELEMETRY_RECORD_SIZE, telemetry_frame);
+	telemetry_sequence++;
+	
+	if (UART0_Write_DMA(telemetry_frame, frame_length))
+	{
+		telemetry_statistics.records_sent++;
+	}
+	else
+	{
+		telemetry_statistics.records_dropped++;
+	}
+}
+
+void Telemetry_Init(void)
+{
+	telemetry_sequence = 0;
+	telemetry_statistics.records_sent = 0;
+	telemetry_statistics.records_dropped = 0;
+	
+	telemetry_task_id = Scheduler_Add_Task("telemetry", Telemetry_Task,
+		TELEMETRY_PERIOD_US(TELEMETRY_DEFAULT_RATE_HZ), TELEMETRY_PERIOD_US(TELEMETRY_DEFAULT_RATE_HZ));
+}
+
+int Telemetry_Set_Rate(uint8_t rate_hz)
+{
+	if (rate_hz == 0)
+	{
+		Scheduler_Set_Period(telemetry_task_id, 0, 0);
+		return 1;
+	}
+	
+	if ((rate_hz < TELEMETRY_MIN_RATE_HZ) || (rate_hz > TELEMETRY_MAX_RATE_HZ))
+	{
+		return 0;
+	}
+	
+	Scheduler_Set_Period(telemetry_task_id, TELEMETRY_PERIOD_US(rate_hz), TELEMETRY_PERIOD_US(rate_hz));
+	
+	return 1;
+}
+
+void Telemetry_Serialize(const Telemetry_Record *record, uint8_t *output)
+{
+	Put_U32(&output[0], record->timestamp_us);
+	Put_U32(&output[4], record->sequence);
+	Put_U16(&output[8], record->distance_cm);
+	Put_U16(&output[10], record->distance_age_ms);
+	Put_U16(&output[12], record->motor_duty);
+	Put_U16(&output[14], record->servo_duty);
+	Put_U16(&output[16], record->loop_time_us);
+	output[18] = record->direction;
+	output[19] = record->fault_flags;
+}
+
+void Telemetry_Get_Statistics(Telemetry_Statistics *stats)
+{
+	*stats = telemetry_statistics;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file Telemetry.h
+ *
+ * @brief Header file for the periodic binary telemetry stream.
+ *
+ * While the command intake is in framed mode (see Protocol.h), a telemetry task sends
+ * one PROTOCOL_TELEMETRY frame at a fixed rate. Each frame carries a Telemetry_Record,
+ * serialized as TELEMETRY_RECORD_SIZE little-endian bytes in the order of the fields below.
+ *
+ * The frame is encoded into a static buffer and handed to the uDMA controller with
+ * UART0_Write_DMA, so the CPU is not involved in transmitting each byte. A frame takes
+ * about 27 bytes on the wire, which is less than half of the UART0 bandwidth at 115200 baud
+ * and 200 Hz.
+ * If the previous frame is still being transmitted when a new one is due, the new one is
+ * skipped and TELEMETRY_FAULT_RECORD_DROPPED is set in the next record.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+/**
+ * @brief Telemetry rate at reset, in Hz
+ */
+#ifndef TELEMETRY_DEFAULT_RATE_HZ
+#define TELEMETRY_DEFAULT_RATE_HZ 100
+#endif
+
+/**
+ * @brief Range of telemetry rates accepted by Telemetry_Set_Rate, in Hz
+ */
+#define TELEMETRY_MIN_RATE_HZ 50
+#define TELEMETRY_MAX_RATE_HZ 200
+
+/**
+ * @brief Size of a serialized Telemetry_Record in bytes
+ */
+#define TELEMETRY_RECORD_SIZE 20
+
+/**
+ * @brief Bits of Telemetry_Record.fault_flags
+ */
+#define TELEMETRY_FAULT_OBSTACLE        0x01  // forward motion is blocked by an obstacle (see Vehicle_Control.h)
+#define TELEMETRY_FAULT_SONAR_INVALID   0x02  // the latest sonar sample had no echo
+#define TELEMETRY_FAULT_UART_OVERFLOW   0x04  // UART0 lost data since the previous record
+#define TELEMETRY_FAULT_DEADLINE_MISS   0x08  // a scheduler task missed a deadline since the previous record
+#define TELEMETRY_FAULT_FRAME_ERROR     0x10  // a received frame was dropped since the previous record
+#define TELEMETRY_FAULT_RECORD_DROPPED  0x20  // records were skipped since the previous record
+#define TELEMETRY_FAULT_SONAR_LOST      0x40  // the echo of a near obstacle was lost (see Sonar_Filter.h)
+#define TELEMETRY_FAULT_ENCODER         0x80  // the wheel encoder reports no edge, speed control is open-loop (see Speed_Control.h)
+
+/**
+ * @brief One telemetry record.
+ */
+typedef struct
+{
+	/** Time at which the record was taken, in microseconds since reset (wraps every 71 minutes) */
+	uint32_t timestamp_us;
+	
+	/** Record number, incremented for every record including the skipped ones */
+	uint32_t sequence;
+	
+	/** Latest distance of the front sonar in centimeters, 0 if there was no echo */
+	uint16_t distance_cm;
+	
+	/** Age of the latest sonar sample in milliseconds, 0xFFFF if none is available */
+	uint16_t distance_age_ms;
+	
+	/** Motor PWM duty cycle, in PWM clock cycles */
+	uint16_t motor_duty;
+	
+	/** Steering servo PWM duty cycle, in PWM clock cycles */
+	uint16_t servo_duty;
+	
+	/** Longest scheduler loop time since the previous record, in microseconds (saturates at 0xFFFF) */
+	uint16_t loop_time_us;
+	
+	/** Vehicle_Direction */
+	uint8_t direction;
+	
+	/** TELEMETRY_FAULT_ bits */
+	uint8_t fault_flags;
+} Telemetry_Record;
+
+/**
+ * @brief Counters maintained by the telemetry task.
+ */
+typedef struct
+{
+	/** Records handed to the uDMA controller */
+	uint32_t records_sent;
+	
+	/** Records skipped because the previous one was still being transmitted */
+	uint32_t records_dropped;
+} Telemetry_Statistics;
+
+/**
+ * @brief The Telemetry_Init function registers the telemetry task at TELEMETRY_DEFAULT_RATE_HZ.
+ *
+ * @note UART0_Init and Scheduler_Init must be called first.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Telemetry_Init(void);
+
+/**
+ * @brief The Telemetry_Set_Rate function changes the telemetry rate.
+ *
+ * @param rate_hz New rate in Hz, from TELEMETRY_MIN_RATE_HZ to TELEMETRY_MAX_RATE_HZ, or 0 to stop the stream.
+ *
+ * @return 1 if the rate was changed, 0 if it was out of range.
+ */
+int Telemetry_Set_Rate(uint8_t rate_hz);
+
+/**
+ * @brief The Telemetry_Serialize function writes a record in its wire format.
+ *
+ * @param record Pointer to the record.
+ * @param output Pointer to a buffer of at least TELEMETRY_RECORD_SIZE bytes.
+ *
+ * @return None
+ */
+void Telemetry_Serialize(const Telemetry_Record *record, uint8_t *output);
+
+/**
+ * @brief The Telemetry_Get_Statistics function copies the telemetry counters.
+ *
+ * @param stats Pointer to the structure that receives the counters.
+ *
+ * @return None
+ */
+void Telemetry_Get_Statistics(Telemetry_Statistics *stats);
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * @file Timebase.c
+ *
+ * @brief Source code for the Timebase driver.
+ *
+ * It provides a monotonic 64-bit timebase that counts system clock cycles
+ * using Wide Timer 5 (WTIMER5) in concatenated 64-bit periodic up-count mode.
+ * No interrupts are used to maintain the count.
+ *
+ * @note The timing is derived from the system clock frequency (SYSTEM_CLOCK_HZ, see System_Clock.h).
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Timebase.h"
+
+// Set once the timer is running so that repeated calls to Timebase_Init are harmless
+static uint8_t timebase_initialized = 0;
+
+void Timebase_Init(void)
+{
+	if (timebase_initialized)
+	{
+		return;
+	}
+	
+	// Enable the clock to Wide Timer 5 by setting the
+	// R5 bit (Bit 5) in the RCGCWTIMER register
+	SYSCTL->RCGCWTIMER |= 0x20;
+	
+	// Wait until Wide Timer 5 is ready to be accessed
+	while ((SYSCTL->PRWTIMER & 0x20) == 0);
+	
+	// Disable Timer A before configuration by clearing
+	// the TAEN bit (Bit 0) in the CTL register
+	WTIMER5->CTL &= ~0x01;
+	
+	// Select the concatenated 64-bit timer configuration
+	// by writing 0x0 to the CFG register
+	WTIMER5->CFG = 0x00;
+	
+	// Configure Timer A for periodic mode (TAMR = 0x2, Bits 1 to 0)
+	// counting up (TACDIR, Bit 4) in the TAMR register
+	WTIMER5->TAMR = 0x12;
+	
+	// Use the largest 64-bit interval. In concatenated mode, TAILR holds the
+	// lower 32 bits of the interval and TBILR holds the upper 32 bits
+	WTIMER5->TAILR = 0xFFFFFFFF;
+	WTIMER5->TBILR = 0xFFFFFFFF;
+	
+	// Disable all Wide Timer 5 interrupts
+	WTIMER5->IMR = 0x00;
+	
+	// Start counting by setting the TAEN bit (Bit 0) in the CTL register
+	WTIMER5->CTL |= 0x01;
+	
+	timebase_initialized = 1;
+}
+
+uint64_t Timebase_Now_Cycles(void)
+{
+	uint32_t upper;
+	uint32_t lower;
+	uint32_t upper_check;
+	
+	// Re-read the upper half until it is unchanged around the read of the lower half,
+	// so that a carry out of the lower half cannot produce a torn value
+	do
+	{
+		upper = WTIMER5->TBV;
+		lower = WTIMER5->TAV;
+		upper_check = WTIMER5->TBV;
+	} while (upper != upper_check);
+	
+	return ((uint64_t)upper << 32) | lower;
+}
+
+uint64_t Timebase_Now_US(void)
+{
+	return Timebase_Now_Cycles() / TIMEBASE_CYCLES_PER_US;
+}
+
+uint64_t Timebase_Deadline_US(uint32_t delay_in_us)
+{
+	return Timebase_Now_Cycles() + TIMEBASE_US_TO_CYCLES(delay_in_us);
+}
+
+int Timebase_Deadline_Expired(uint64_t deadline)
+{
+	return (Timebase_Now_Cycles() >= deadline);
+}
+
+uint64_t Timebase_Elapsed_Cycles(uint64_t start_cycles)
+{
+	return Timebase_Now_Cycles() - start_cycles;
+}
+
+uint32_t Timebase_Elapsed_US(uint64_t start_cycles)
+{
+	uint64_t elapsed = Timebase_Elapsed_Cycles(start_cycles);
+	
+	if (elapsed > 0xFFFFFFFF)
+	{
+		return 0xFFFFFFFF;
+	}
+	
+	return (uint32_t)elapsed / TIMEBASE_CYCLES_PER_US;
+}
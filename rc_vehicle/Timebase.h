@@ -0,0 +1,116 @@
+/**
+ * @file Timebase.h
+ *
+ * @brief Header file for the Timebase driver.
+ *
+ * It provides a monotonic 64-bit timebase that counts system clock cycles.
+ * Wide Timer 5 (WTIMER5) is configured as a single 64-bit periodic timer that counts up
+ * from the system clock, so the count never needs an interrupt to be maintained and will
+ * not wrap for more than 7,000 years at 80 MHz.
+ *
+ * Timestamps are kept in cycles. They are converted to microseconds only when needed,
+ * and deadlines are absolute cycle counts, so any number of independent (or nested) waits
+ * can be in progress at the same time without interfering with each other.
+ *
+ * @note The timing is derived from the system clock frequency (SYSTEM_CLOCK_HZ, see System_Clock.h).
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include "TM4C123GH6PM.h"
+#include "System_Clock.h"
+#include <stdint.h>
+
+/**
+ * @brief Number of timebase cycles (system clock cycles) per microsecond
+ */
+#define TIMEBASE_CYCLES_PER_US SYSTEM_CLOCK_CYCLES_PER_US
+
+/**
+ * @brief Converts a duration in microseconds to timebase cycles
+ */
+#define TIMEBASE_US_TO_CYCLES(us) ((uint64_t)(us) * TIMEBASE_CYCLES_PER_US)
+
+/**
+ * @brief Converts a duration in milliseconds to timebase cycles
+ */
+#define TIMEBASE_MS_TO_CYCLES(ms) ((uint64_t)(ms) * 1000U * TIMEBASE_CYCLES_PER_US)
+
+/**
+ * @brief The Timebase_Init function starts the free-running 64-bit timebase.
+ *
+ * This function configures Wide Timer 5 in concatenated 64-bit periodic mode, counting up
+ * from 0 with the largest possible interval and no interrupts. Calling it more than once
+ * has no effect, so every driver that depends on the timebase may call it.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Timebase_Init(void);
+
+/**
+ * @brief The Timebase_Now_Cycles function returns the current timebase count.
+ *
+ * The two 32-bit halves of the counter are read in a way that is consistent even if
+ * the lower half rolls over between the reads. It is safe to call from interrupt
+ * service routines.
+ *
+ * @param None
+ *
+ * @return The number of system clock cycles since Timebase_Init was called.
+ */
+uint64_t Timebase_Now_Cycles(void);
+
+/**
+ * @brief The Timebase_Now_US function returns the current time in microseconds.
+ *
+ * @param None
+ *
+ * @return The number of microseconds since Timebase_Init was called.
+ */
+uint64_t Timebase_Now_US(void);
+
+/**
+ * @brief The Timebase_Deadline_US function computes an absolute deadline.
+ *
+ * @param delay_in_us The time from now until the deadline, in microseconds.
+ *
+ * @return The deadline as an absolute timebase count, to be passed to Timebase_Deadline_Expired.
+ */
+uint64_t Timebase_Deadline_US(uint32_t delay_in_us);
+
+/**
+ * @brief The Timebase_Deadline_Expired function checks if a deadline has been reached.
+ *
+ * @param deadline The absolute timebase count returned by Timebase_Deadline_US.
+ *
+ * @return 1 if the deadline has been reached or passed, 0 otherwise.
+ */
+int Timebase_Deadline_Expired(uint64_t deadline);
+
+/**
+ * @brief The Timebase_Elapsed_Cycles function returns the cycles elapsed since a timestamp.
+ *
+ * @param start_cycles A timestamp previously returned by Timebase_Now_Cycles.
+ *
+ * @return The number of system clock cycles elapsed since start_cycles.
+ */
+uint64_t Timebase_Elapsed_Cycles(uint64_t start_cycles);
+
+/**
+ * @brief The Timebase_Elapsed_US function returns the microseconds elapsed since a timestamp.
+ *
+ * Intervals longer than 2^32 cycles (about 53 seconds at 80 MHz) saturate to 0xFFFFFFFF,
+ * which keeps the conversion to a single 32-bit division.
+ *
+ * @param start_cycles A timestamp previously returned by Timebase_Now_Cycles.
+ *
+ * @return The number of microseconds elapsed since start_cycles.
+ */
+uint32_t Timebase_Elapsed_US(uint64_t start_cycles);
+
+#endif
@@ -0,0 +1,257 @@
+/**
+ * @file Trace.c
+ *
+ * @brief Source code for the binary event trace.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Trace.h"
+
+#if TRACE_ENABLED
+
+#include "TM4C123GH6PM.h"
+#include "Latency.h"
+#include "Scheduler.h"
+#include "System_Clock.h"
+#include "UART0.h"
+
+#define TRACE_BUFFER_MASK (TRACE_BUFFER_RECORDS - 1)
+
+typedef char Trace_Buffer_Size_Check[((TRACE_BUFFER_RECORDS & TRACE_BUFFER_MASK) == 0) ? 1 : -1];
+
+// Period and deadline of the trace task while a dump is in progress, in microseconds
+#define TRACE_TASK_PERIOD_US 5000
+
+// Free space in the UART0 transmit buffer needed to write one dump line
+#define TRACE_DUMP_LINE_MAX 48
+
+// Largest number of dump lines written by one run of the trace task
+#define TRACE_DUMP_LINES_PER_RUN 8
+
+static Trace_Record trace_buffer[TRACE_BUFFER_RECORDS];
+
+// Index of the next record to write, and number of valid records (at most TRACE_BUFFER_RECORDS)
+static uint16_t trace_head;
+static uint16_t trace_count;
+
+// Set while a dump is in progress: no event is recorded
+static volatile uint8_t trace_frozen;
+
+static Trace_Statistics trace_statistics;
+
+static int trace_task_id = -1;
+
+// Dump: dump_line is the next line to print, from -2 and -1 (header) and the task names
+static int16_t dump_line;
+static uint16_t dump_tail;
+static uint16_t dump_records_left;
+
+#if TRACE_ITM
+// Writes a word to an ITM stimulus port if tracing is enabled on it and its FIFO has room
+static int Trace_ITM_Write(uint8_t port, uint32_t value)
+{
+	if (((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0) || ((ITM->TER & (1UL << port)) == 0))
+	{
+		return 1;
+	}
+	
+	// A stimulus port reads as 1 when its FIFO can accept a word
+	if (ITM->PORT[port].u32 == 0)
+	{
+		return 0;
+	}
+	
+	ITM->PORT[port].u32 = value;
+	return 1;
+}
+#endif
+
+void Trace_Event_Record(Trace_Event event, uint32_t argument)
+{
+	uint32_t primask = __get_PRIMASK();
+	Trace_Record *record;
+	
+	__disable_irq();
+	
+	if (!trace_frozen)
+	{
+		record = &trace_buffer[trace_head];
+		record->cycles = LATENCY_NOW_CYCLES();
+		record->argument = argument;
+		record->event = (uint16_t)event;
+		record->context = (uint16_t)__get_IPSR();
+		
+		trace_head = (trace_head + 1) & TRACE_BUFFER_MASK;
+		
+		if (trace_count < TRACE_BUFFER_RECORDS)
+		{
+			trace_count++;
+		}
+		else
+		{
+			trace_statistics.overwritten_count++;
+		}
+		
+		trace_statistics.event_count++;
+
+#if TRACE_ITM
+		// The argument is written last: the decoder drops a record whose argument is missing
+		if (!Trace_ITM_Write(TRACE_ITM_PORT_EVENT, ((uint32_t)record->context << 16) | record->event) ||
+			!Trace_ITM_Write(TRACE_ITM_PORT_CYCLES, record->cycles) ||
+			!Trace_ITM_Write(TRACE_ITM_PORT_ARGUMENT, argument))
+		{
+			trace_statistics.itm_drop_count++;
+		}
+#endif
+	}
+	
+	__set_PRIMASK(primask);
+}
+
+// Writes value as 8 hexadecimal digits, and returns the position after them
+static char *Trace_Put_Hex(char *output, uint32_t value)
+{
+	static const char digits[] = "0123456789abcdef";
+	int shift;
+	
+	for (shift = 28; shift >= 0; shift -= 4)
+	{
+		*output++ = digits[(value >> shift) & 0x0F];
+	}
+	
+	return output;
+}
+
+// Writes the next line of the dump, and returns 0 once the dump is complete
+static int Trace_Dump_Next(void)
+{
+	Scheduler_Task_Statistics task;
+	const Trace_Record *record;
+	char line[TRACE_DUMP_LINE_MAX];
+	char *end = line;
+	
+	if (dump_line == -2)
+	{
+		UART0_Output_String("trace_dump clock_hz records overwritten\r\n");
+		dump_line++;
+		return 1;
+	}
+	
+	if (dump_line == -1)
+	{
+		UART0_Output_String("trace_dump ");
+		UART0_Output_Unsigned_Decimal(System_Clock_Get_Hz());
+		UART0_Output_Character(' ');
+		UART0_Output_Unsigned_Decimal(dump_records_left);
+		UART0_Output_Character(' ');
+		UART0_Output_Unsigned_Decimal(trace_statistics.overwritten_count);
+		UART0_Output_Newline();
+		dump_line++;
+		return 1;
+	}
+	
+	// The task names, for the task_begin and task_end arguments
+	if (dump_line < Scheduler_Task_Count())
+	{
+		Scheduler_Get_Task_Statistics(dump_line, &task);
+		UART0_Output_String("trace_task ");
+		UART0_Output_Unsigned_Decimal((uint32_t)dump_line);
+		UART0_Output_Character(' ');
+		UART0_Output_String((char *)task.name);
+		UART0_Output_Newline();
+		dump_line++;
+		return 1;
+	}
+	
+	if (dump_records_left == 0)
+	{
+		UART0_Output_String("trace_end\r\n");
+		return 0;
+	}
+	
+	record = &trace_buffer[dump_tail];
+	
+	*end++ = '@';
+	*end++ = ' ';
+	end = Trace_Put_Hex(end, record->cycles);
+	*end++ = ' ';
+	end = Trace_Put_Hex(end, record->event);
+	*end++ = ' ';
+	end = Trace_Put_Hex(end, record->context);
+	*end++ = ' ';
+	end = Trace_Put_Hex(end, record->argument);
+	*end++ = '\r';
+	*end++ = '\n';
+	UART0_Write(line, (uint16_t)(end - line));
+	
+	dump_tail = (dump_tail + 1) & TRACE_BUFFER_MASK;
+	dump_records_left--;
+	
+	return 1;
+}
+
+static void Trace_Task(void)
+{
+	uint8_t lines;
+	
+	if (!trace_frozen)
+	{
+		return;
+	}
+	
+	for (lines = 0; (lines < TRACE_DUMP_LINES_PER_RUN) && (UART0_TX_Free() >= TRACE_DUMP_LINE_MAX); lines++)
+	{
+		if (!Trace_Dump_Next())
+		{
+			// Start over with an empty ring, so that the next dump only holds new events
+			trace_head = 0;
+			trace_count = 0;
+			trace_statistics.overwritten_count = 0;
+			trace_frozen = 0;
+			Scheduler_Set_Period(trace_task_id, 0, TRACE_TASK_PERIOD_US);
+			return;
+		}
+	}
+}
+
+void Trace_Init(void)
+{
+	uint32_t start_cycles = LATENCY_NOW_CYCLES();
+	
+	TRACE(TRACE_START, 0);
+	trace_statistics.event_cycles = LATENCY_NOW_CYCLES() - start_cycles;
+	
+	// Released only while a dump is in progress
+	trace_task_id = Scheduler_Add_Task("trace", Trace_Task, 0, TRACE_TASK_PERIOD_US);
+}
+
+int Trace_Dump(void)
+{
+	if (trace_frozen || (trace_task_id < 0))
+	{
+		return 0;
+	}
+	
+	// Recording stops here: the ring no longer changes
+	trace_frozen = 1;
+	
+	dump_line = -2;
+	dump_records_left = trace_count;
+	dump_tail = (trace_head - trace_count) & TRACE_BUFFER_MASK;
+	
+	Scheduler_Set_Period(trace_task_id, TRACE_TASK_PERIOD_US, TRACE_TASK_PERIOD_US);
+	
+	return 1;
+}
+
+void Trace_Get_Statistics(Trace_Statistics *stats)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq();
+	*stats = trace_statistics;
+	__set_PRIMASK(primask);
+}
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file Trace.h
+ *
+ * @brief Header file for the binary event trace.
+ *
+ * The trace shows what the firmware does between its messages, without changing the timing
+ * that is being observed the way a print would. Each event is one record:
+ *
+ *   uint32 DWT cycle count (CYCCNT) | uint32 argument | uint16 event (Trace_Event) |
+ *   uint16 context: the exception number of the running handler (IPSR), 0 in thread mode
+ *
+ * The records are written into a RAM ring of TRACE_BUFFER_RECORDS entries, where the oldest
+ * record is overwritten. Recording an event costs a few dozen cycles with the interrupts
+ * disabled, and no UART0 traffic (see Trace_Statistics). With TRACE_ITM set to 1, each record
+ * is also written to the ITM stimulus ports, for a debug probe that captures the SWO output.
+ *
+ * Trace_Dump freezes the ring and prints it over UART0 as text, one record per line, paced by
+ * the trace task like the black box dump. The host tool tools/Trace_Decode.c turns a capture
+ * of the dump (or of the SWO output) into a timeline and a Chrome trace JSON file.
+ *
+ * Instrumentation points use the TRACE macro. With TRACE_ENABLED set to 0, every point, the
+ * ring and the trace task compile out completely.
+ *
+ * Dump lines: a header (trace_dump clock_hz records overwritten), the scheduler task names
+ * (trace_task id name), one line per record with hexadecimal fields, then trace_end:
+ *
+ *   @ cycles event context argument
+ *
+ * @note The cycle count wraps around every 53 seconds at 80 MHz. The decoder unwraps it,
+ * assuming that consecutive records are less than one wrap apart.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Build options: the trace is compiled in unless TRACE_ENABLED is 0, and only copied
+ * to the ITM when TRACE_ITM is 1
+ */
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#ifndef TRACE_ITM
+#define TRACE_ITM 0
+#endif
+
+/**
+ * @brief Number of records in the RAM ring (12 bytes each). It must be a power of two.
+ */
+#define TRACE_BUFFER_RECORDS 256
+
+/**
+ * @brief ITM stimulus ports used when TRACE_ITM is 1: event and context, cycle count, argument.
+ * A record is complete once its argument is received.
+ */
+#define TRACE_ITM_PORT_EVENT    1
+#define TRACE_ITM_PORT_CYCLES   2
+#define TRACE_ITM_PORT_ARGUMENT 3
+
+/**
+ * @brief Events. An event whose name ends in BEGIN opens an interval that the next END
+ * event of the same context closes.
+ */
+typedef enum
+{
+	TRACE_START = 0,           // argument: 0, first record after Trace_Init
+	TRACE_TASK_BEGIN = 1,      // argument: task identifier (see Scheduler_Add_Task)
+	TRACE_TASK_END = 2,        // argument: task identifier
+	TRACE_IDLE_BEGIN = 3,      // argument: 0, the CPU goes to sleep (see Idle.h)
+	TRACE_IDLE_END = 4,        // argument: 0, the CPU woke up
+	TRACE_UART_IRQ_BEGIN = 5,  // argument: UART0 masked interrupt status (MIS)
+	TRACE_UART_IRQ_END = 6,    // argument: number of bytes received and not read yet
+	TRACE_UART_WRITE = 7,      // argument: number of bytes queued by UART0_Write
+	TRACE_UART_DROP = 8,       // argument: number of bytes refused by UART0_Write (buffer full)
+	TRACE_SONAR_TRIGGER = 9,   // argument: slot whose sensors are triggered
+	TRACE_SONAR_SAMPLE = 10,   // argument: sensor << 24 | echo pulse width in microseconds (0: no echo)
+	TRACE_PWM_IRQ_BEGIN = 11,  // argument: target motor duty cycle
+	TRACE_PWM_IRQ_END = 12,    // argument: motor duty cycle applied
+	TRACE_SERVO_WRITE = 13,    // argument: steering servo pulse width in PWM clock cycles
+	TRACE_MARK = 14,           // argument: free, for temporary instrumentation points
+	TRACE_EVENT_COUNT
+} Trace_Event;
+
+/**
+ * @brief Names of the events, indexed by Trace_Event, shared with the host decoder
+ */
+#define TRACE_EVENT_NAMES \
+{ \
+	"start", "task_begin", "task_end", "idle_begin", "idle_end", "uart_irq_begin", \
+	"uart_irq_end", "uart_write", "uart_drop", "sonar_trigger", "sonar_sample", \
+	"pwm_irq_begin", "pwm_irq_end", "servo_write", "mark" \
+}
+
+/**
+ * @brief One trace record, as stored in the RAM ring
+ */
+typedef struct
+{
+	uint32_t cycles;
+	uint32_t argument;
+	uint16_t event;
+	uint16_t context;
+} Trace_Record;
+
+/**
+ * @brief Trace counters.
+ */
+typedef struct
+{
+	/** Events recorded since the reset */
+	uint32_t event_count;
+	
+	/** Events overwritten before they could be dumped */
+	uint32_t overwritten_count;
+	
+	/** Events written to the ITM only in part, because a stimulus port was busy */
+	uint32_t itm_drop_count;
+	
+	/** Cost of recording one event, in system clock cycles, measured by Trace_Init */
+	uint32_t event_cycles;
+} Trace_Statistics;
+
+/**
+ * @brief Records an event when the trace is compiled in, and compiles to nothing otherwise.
+ */
+#if TRACE_ENABLED
+#define TRACE(event, argument) Trace_Event_Record((event), (uint32_t)(argument))
+#else
+#define TRACE(event, argument) ((void)0)
+#endif
+
+#if TRACE_ENABLED
+
+/**
+ * @brief The Trace_Init function measures the cost of an event and registers the trace task,
+ * which paces the dump.
+ *
+ * Events can be recorded before this function is called, but they are timestamped with the DWT
+ * cycle counter, which only counts once Latency_Init has been called.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Trace_Init(void);
+
+/**
+ * @brief The Trace_Event_Record function records an event. Use the TRACE macro instead.
+ *
+ * It may be called from any context, including interrupt service routines.
+ *
+ * @param event The Trace_Event.
+ * @param argument Value stored with the event.
+ *
+ * @return None
+ */
+void Trace_Event_Record(Trace_Event event, uint32_t argument);
+
+/**
+ * @brief The Trace_Dump function starts printing the ring over UART0, oldest record first.
+ *
+ * Recording stops until the dump is complete, so that the dump is a consistent snapshot and
+ * does not trace itself, and the ring is then cleared.
+ *
+ * @param None
+ *
+ * @return 1 if the dump was started, 0 if a dump is already in progress.
+ */
+int Trace_Dump(void);
+
+/**
+ * @brief The Trace_Get_Statistics function copies the trace counters.
+ *
+ * @param stats Pointer to the structure that receives the counters.
+ *
+ * @return None
+ */
+void Trace_Get_Statistics(Trace_Statistics *stats);
+
+#endif
+
+#endif
@@ -10,14 +10,216 @@
  * of the TM4C123GH6PM Microcontroller Datasheet.
  * Link: https://www.ti.com/lit/gpn/TM4C123GH6PM
  *
- * @note Assumes that the system clock (50 MHz) is used.
+ * @note Assumes that the system clock (SYSTEM_CLOCK_HZ) is used.
+ *
+ * @note Received bytes are moved into rx_buffer and queued bytes are moved out
+ * of tx_buffer by UART0_Handler. Each ring buffer has a single producer and a
+ * single consumer, so the head and tail indices are only ever written by one side.
  *
  * @author Aaron Nanas
  */
 
 #include "UART0.h"
+#include "UDMA.h"
+#include "Latency.h"
+#include "Idle.h"
+#include "Trace.h"
+#include <string.h>
+
+#define UART0_RX_BUFFER_MASK (UART0_RX_BUFFER_SIZE - 1)
+#define UART0_TX_BUFFER_MASK (UART0_TX_BUFFER_SIZE - 1)
+
+// Interrupt mask bits shared by the IM, RIS, MIS and ICR registers
+#define UART0_RX_INTERRUPT_BIT_MASK         0x0010
+#define UART0_TX_INTERRUPT_BIT_MASK         0x0020
+#define UART0_RX_TIMEOUT_INTERRUPT_BIT_MASK 0x0040
+#define UART0_OVERRUN_INTERRUPT_BIT_MASK    0x0400
+
+// Overrun Error (OE) flag (Bit 11) returned with each character read from the DR register
+#define UART0_DATA_OVERRUN_BIT_MASK         0x0800
+
+// Framing Error (FE) flag (Bit 8) returned with each character read from the DR register
+#define UART0_DATA_FRAMING_BIT_MASK         0x0100
+
+// Transmit DMA Enable (TXDMAE) bit (Bit 1) in the DMACTL register
+#define UART0_TX_DMA_ENABLE_BIT_MASK        0x0002
+
+// UARTEN (Bit 0) and HSE (Bit 5) bits in the CTL register
+#define UART0_ENABLE_BIT_MASK               0x0001
+#define UART0_HIGH_SPEED_BIT_MASK           0x0020
+
+// PA0 (U0RX) in the GPIO Port A registers
+#define UART0_RX_PIN_BIT_MASK               0x01
+
+// Progress of a block handed to UART0_Write_DMA
+typedef enum
+{
+	TX_DMA_IDLE,
+	TX_DMA_PENDING,   // waiting for the ring buffer bytes queued before it to reach the FIFO
+	TX_DMA_ACTIVE     // the uDMA controller is feeding the transmit FIFO
+} TX_DMA_State;
+
+// Receive ring buffer: written by UART0_Handler (head), read by the main loop (tail)
+static char rx_buffer[UART0_RX_BUFFER_SIZE];
+static uint32_t rx_cycles_buffer[UART0_RX_BUFFER_SIZE];
+static volatile uint16_t rx_head = 0;
+static volatile uint16_t rx_tail = 0;
+
+// Transmit ring buffer: written by the main loop (head), read by UART0_Handler (tail)
+static char tx_buffer[UART0_TX_BUFFER_SIZE];
+static volatile uint16_t tx_head = 0;
+static volatile uint16_t tx_tail = 0;
+
+static volatile UART0_Statistics uart0_statistics;
+
+// Current baud rate (0 while it is being detected), and the receive timeout
+// of 32 bit periods in system clock cycles
+static volatile uint32_t uart0_baud_rate = 0;
+static uint32_t rx_timeout_cycles;
+
+// Progress of the automatic baud rate detection
+typedef enum
+{
+	AUTO_BAUD_OFF,
+	AUTO_BAUD_WAIT_START,   // waiting for the falling edge of the sync byte's start bit
+	AUTO_BAUD_WAIT_END      // waiting for the rising edge after its last data bit
+} Auto_Baud_State;
+
+static volatile Auto_Baud_State auto_baud_state = AUTO_BAUD_OFF;
+static uint32_t auto_baud_start_cycles;
+
+// Measured rates close to one of these are rounded to it
+static const uint32_t standard_baud_rates[] =
+{
+	1200, 2400, 4800, 9600, 14400, 19200, 38400, 57600, 115200,
+	230400, 460800, 921600, 1000000, 1500000, 2000000
+};
+
+// Block handed to UART0_Write_DMA. It is transmitted once the transmit ring buffer
+// has been emptied up to tx_dma_boundary, the value of tx_head when it was handed over
+static volatile TX_DMA_State tx_dma_state = TX_DMA_IDLE;
+static const void *tx_dma_source;
+static uint16_t tx_dma_length;
+static uint16_t tx_dma_boundary;
+
+static void UART0_Start_DMA(void)
+{
+	tx_dma_state = TX_DMA_ACTIVE;
+	
+	// Move 4 bytes per burst request from the uDMA controller
+	UDMA_Start_Memory_To_Peripheral(UDMA_CHANNEL_UART0_TX, tx_dma_source, &UART0->DR, tx_dma_length, 2);
+	
+	// Let UART0 request transfers from the uDMA controller by setting
+	// the TXDMAE bit (Bit 1) in the DMACTL register
+	UART0->DMACTL |= UART0_TX_DMA_ENABLE_BIT_MASK;
+}
+
+// Moves bytes from the transmit ring buffer into the hardware transmit FIFO until
+// either the ring buffer is empty or the FIFO is full. While a DMA block is pending,
+// only the bytes queued before it are moved, and then the DMA transfer is started
+static void UART0_Fill_Transmit_FIFO(void)
+{
+	uint16_t tail = tx_tail;
+	uint16_t end;
+	
+	// The uDMA controller owns the FIFO until its transfer is done
+	if (tx_dma_state == TX_DMA_ACTIVE)
+	{
+		return;
+	}
+	
+	end = (tx_dma_state == TX_DMA_PENDING) ? tx_dma_boundary : tx_head;
+	
+	while ((tail != end) && ((UART0->FR & UART0_TRANSMIT_FIFO_FULL_BIT_MASK) == 0))
+	{
+		UART0->DR = tx_buffer[tail];
+		tail = (tail + 1) & UART0_TX_BUFFER_MASK;
+	}
+	
+	tx_tail = tail;
+	
+	if ((tx_dma_state == TX_DMA_PENDING) && (tail == tx_dma_boundary))
+	{
+		UART0_Start_DMA();
+	}
+}
+
+// Primes the hardware transmit FIFO from thread context. The transmit interrupt
+// is masked while doing so, which keeps UART0_Handler from refilling the FIFO concurrently
+static void UART0_Start_Transmit(void)
+{
+	UART0->IM &= ~UART0_TX_INTERRUPT_BIT_MASK;
+	
+	UART0_Fill_Transmit_FIFO();
+	
+	UART0->IM |= UART0_TX_INTERRUPT_BIT_MASK;
+}
+
+// Rounds a measured baud rate to the nearest standard rate within UART0_AUTO_BAUD_TOLERANCE_PERCENT
+static uint32_t UART0_Round_Baud_Rate(uint32_t measured_rate)
+{
+	uint32_t rounded_rate = measured_rate;
+	uint32_t smallest_difference = 0xFFFFFFFF;
+	uint32_t i;
+	
+	for (i = 0; i < (sizeof(standard_baud_rates) / sizeof(standard_baud_rates[0])); i++)
+	{
+		uint32_t standard_rate = standard_baud_rates[i];
+		uint32_t difference = (measured_rate > standard_rate) ? (measured_rate - standard_rate) : (standard_rate - measured_rate);
+		
+		if (((difference * 100U) <= (standard_rate * UART0_AUTO_BAUD_TOLERANCE_PERCENT)) && (difference < smallest_difference))
+		{
+			rounded_rate = standard_rate;
+			smallest_difference = difference;
+		}
+	}
+	
+	return rounded_rate;
+}
+
+// Turns PA0 into a GPIO input that interrupts on the falling edge of the sync byte's start bit
+static void UART0_Start_Auto_Baud(void)
+{
+	auto_baud_state = AUTO_BAUD_WAIT_START;
+	
+	// Configure the PA0 pin as a GPIO input by clearing Bit 0
+	// in the AFSEL and DIR registers
+	GPIOA->AFSEL &= ~UART0_RX_PIN_BIT_MASK;
+	GPIOA->DIR &= ~UART0_RX_PIN_BIT_MASK;
+	
+	// Detect single edges on PA0 by clearing Bit 0 in the IS and IBE registers,
+	// and start with the falling edge by clearing Bit 0 in the IEV register
+	GPIOA->IS &= ~UART0_RX_PIN_BIT_MASK;
+	GPIOA->IBE &= ~UART0_RX_PIN_BIT_MASK;
+	GPIOA->IEV &= ~UART0_RX_PIN_BIT_MASK;
+	
+	// Clear any stale edge, then unmask the PA0 interrupt by setting Bit 0 in the IM register
+	GPIOA->ICR = UART0_RX_PIN_BIT_MASK;
+	GPIOA->IM |= UART0_RX_PIN_BIT_MASK;
+	
+	// The edge timestamps set the accuracy of the measurement: give Port A (IRQ 0)
+	// the highest priority and enable it in the NVIC
+	NVIC_SetPriority(GPIOA_IRQn, 0);
+	NVIC_EnableIRQ(GPIOA_IRQn);
+}
+
+// Programs the measured baud rate and hands PA0 back to UART0
+static void UART0_Finish_Auto_Baud(uint32_t baud_rate)
+{
+	// Mask the PA0 interrupt by clearing Bit 0 in the IM register
+	GPIOA->IM &= ~UART0_RX_PIN_BIT_MASK;
+	NVIC_DisableIRQ(GPIOA_IRQn);
+	
+	// Also enables UART0
+	UART0_Set_Baud_Rate(baud_rate);
+	
+	// Configure the PA0 pin to operate as a U0RX pin again by setting Bit 0 in the AFSEL register
+	GPIOA->AFSEL |= UART0_RX_PIN_BIT_MASK;
+	
+	auto_baud_state = AUTO_BAUD_OFF;
+}
 
-void UART0_Init(void)
+void UART0_Init(uint32_t baud_rate)
 {
 	// Enable the clock to the UART0 module by setting the 
 	// R0 bit (Bit 0) in the RCGCUART register
@@ -29,21 +231,7 @@ void UART0_Init(void)
 	
 	// Disable the UART0 module before configuration by clearing
 	// the UARTEN bit (Bit 0) in the CTL register
-	UART0->CTL &= ~0x0001;
-	
-	// Configure the UART0 module to use the system clock (50 MHz)
-	// divided by 16 by clearing the HSE bit (Bit 5) in the CTL register
-	UART0->CTL &= ~0x0020;
-	
-	// Set the baud rate by writing to the DIVINT field (Bits 15 to 0)
-	// and the DIVFRAC field (Bits 5 to 0) in the IBRD and FBRD registers, respectively.
-	// The integer part of the calculated constant will be written to the IBRD register,
-	// while the fractional part will be written to the FBRD register.
-	// BRD = (System Clock Frequency) / (16 * Baud Rate)
-	// BRDI = (50,000,000) / (16 * 115200) = 27.12673611 (IBRD = 27)
-	// BRDF = ((0.12673611 * 64) + 0.5) = 8.611 (FBRD = 8)
-	UART0->IBRD = 27;
-	UART0->FBRD = 8;
+	UART0->CTL &= ~UART0_ENABLE_BIT_MASK;
 	
 	// Configure the data word length of the UART packet to be 8 bits by 
 	// writing a value of 0x3 to the WLEN field (Bits 6 to 5) in the LCRH register
@@ -59,13 +247,31 @@ void UART0_Init(void)
 	// Disable the parity bit by clearing the PEN bit (Bit 1) in the LCRH register
 	UART0->LCRH &= ~0x02;
 	
-	// Enable the UART0 module after configuration by setting
-	// the UARTEN bit (Bit 0) in the CTL register
-	UART0->CTL |= 0x01;
+	// Reset the ring buffers before any interrupt can be raised
+	rx_head = 0;
+	rx_tail = 0;
+	tx_head = 0;
+	tx_tail = 0;
+	tx_dma_state = TX_DMA_IDLE;
+	
+	// Assign uDMA channel 9 to UART0 TX (encoding 0) for UART0_Write_DMA
+	UDMA_Init();
+	UDMA_Configure_Channel(UDMA_CHANNEL_UART0_TX, 0);
+	UART0->DMACTL = 0x00;
+	
+	// Raise the receive interrupt when the receive FIFO is at least 1/8 full (RXIFLSEL = 0x0, Bits 5 to 3)
+	// and the transmit interrupt when the transmit FIFO drops to 1/8 full (TXIFLSEL = 0x0, Bits 2 to 0).
+	// Characters that do not reach the receive level are collected by the receive timeout interrupt
+	UART0->IFLS = 0x00;
 	
-	// Configure the PA1 (U0TX) and PA0 (U0RX) pins to use the alternate function
-	// by setting Bits 1 to 0 in the AFSEL register
-	GPIOA->AFSEL |= 0x03;
+	// Clear any stale interrupt, then unmask the receive (RXIM, Bit 4), transmit (TXIM, Bit 5),
+	// receive timeout (RTIM, Bit 6) and overrun error (OEIM, Bit 10) interrupts in the IM register
+	UART0->ICR = 0x07FF;
+	UART0->IM = UART0_RX_INTERRUPT_BIT_MASK | UART0_TX_INTERRUPT_BIT_MASK
+							| UART0_RX_TIMEOUT_INTERRUPT_BIT_MASK | UART0_OVERRUN_INTERRUPT_BIT_MASK;
+	
+	// Enable the UART0 interrupt (IRQ 5) in the NVIC
+	NVIC_EnableIRQ(UART0_IRQn);
 	
 	// Clear the PMC1 (Bits 7 to 4) and PMC0 (Bits 3 to 0) fields in the PCTL register before configuration
 	GPIOA->PCTL &= ~0x000000FF;
@@ -83,20 +289,115 @@ void UART0_Init(void)
 	// Enable the digital functionality for the PA1 and PA0 pins
 	// by setting Bits 1 to 0 in the DEN register
 	GPIOA->DEN |= 0x03;
+	
+	// Configure the PA1 pin to use the alternate function (U0TX) by setting Bit 1 in the AFSEL register
+	GPIOA->AFSEL |= 0x02;
+	
+	if (baud_rate == UART0_AUTO_BAUD)
+	{
+		// UART0 stays disabled until the sync byte has been measured
+		uart0_baud_rate = 0;
+		UART0_Start_Auto_Baud();
+		return;
+	}
+	
+	// Set the divisor and enable the UART0 module by setting the UARTEN bit (Bit 0) in the CTL register
+	if (!UART0_Set_Baud_Rate(baud_rate))
+	{
+		UART0_Set_Baud_Rate(UART0_DEFAULT_BAUD_RATE);
+	}
+	
+	// Configure the PA0 pin to use the alternate function (U0RX) by setting Bit 0 in the AFSEL register
+	GPIOA->AFSEL |= UART0_RX_PIN_BIT_MASK;
+}
+
+int UART0_Set_Baud_Rate(uint32_t baud_rate)
+{
+	uint32_t clocks_per_bit = 16;
+	uint32_t divisor_64ths;
+	
+	if ((baud_rate == 0) || (baud_rate > UART0_MAX_BAUD_RATE))
+	{
+		return 0;
+	}
+	
+	// Above SYSTEM_CLOCK_HZ / 16, each bit can only be sampled 8 times (HSE)
+	if (baud_rate > (SYSTEM_CLOCK_HZ / 16))
+	{
+		clocks_per_bit = 8;
+	}
+	
+	// BRD = (System Clock Frequency) / (16 * Baud Rate), or / (8 * Baud Rate) with HSE,
+	// computed in 1/64 units and rounded. The integer part (BRDI) is written to the DIVINT
+	// field (Bits 15 to 0) of the IBRD register, and the fractional part (BRDF) to the
+	// DIVFRAC field (Bits 5 to 0) of the FBRD register. At 80 MHz and 115200 baud:
+	// BRDI = (80,000,000) / (16 * 115200) = 43.40277778 (IBRD = 43)
+	// BRDF = ((0.40277778 * 64) + 0.5) = 26.278 (FBRD = 26)
+	divisor_64ths = (uint32_t)((((uint64_t)SYSTEM_CLOCK_HZ * 64U / clocks_per_bit) + (baud_rate / 2)) / baud_rate);
+	
+	if ((divisor_64ths >> 6) > 0xFFFF)
+	{
+		return 0;
+	}
+	
+	// Disable the UART0 module while the divisor changes by clearing
+	// the UARTEN bit (Bit 0) in the CTL register
+	UART0->CTL &= ~UART0_ENABLE_BIT_MASK;
+	
+	// Divide the system clock by 8 by setting the HSE bit (Bit 5) in the CTL register,
+	// or by 16 by clearing it
+	if (clocks_per_bit == 8)
+	{
+		UART0->CTL |= UART0_HIGH_SPEED_BIT_MASK;
+	}
+	else
+	{
+		UART0->CTL &= ~UART0_HIGH_SPEED_BIT_MASK;
+	}
+	
+	UART0->IBRD = divisor_64ths >> 6;
+	UART0->FBRD = divisor_64ths & 0x3F;
+	
+	// The new divisor takes effect with the next write to the LCRH register
+	UART0->LCRH = UART0->LCRH;
+	
+	rx_timeout_cycles = (32U * clocks_per_bit * divisor_64ths) / 64U;
+	uart0_baud_rate = baud_rate;
+	
+	// Enable the UART0 module by setting the UARTEN bit (Bit 0) in the CTL register
+	UART0->CTL |= UART0_ENABLE_BIT_MASK;
+	
+	return 1;
+}
+
+uint32_t UART0_Get_Baud_Rate(void)
+{
+	return uart0_baud_rate;
 }
 
 char UART0_Input_Character(void)
 {
-	while((UART0->FR & UART0_RECEIVE_FIFO_EMPTY_BIT_MASK) != 0);
+	char character;
 	
-	return (char)(UART0->DR & 0xFF);
+	while (UART0_Read(&character, 1) == 0)
+	{
+		// Sleep until the next interrupt, unless a character arrived since the read
+		__disable_irq();
+		
+		if (!UART0_Available())
+		{
+			Idle_Sleep_Until(IDLE_NO_WAKEUP);
+		}
+		
+		__enable_irq();
+	}
+	
+	return character;
 }
 
 void UART0_Output_Character(char data)
 {
-	while((UART0->FR & UART0_TRANSMIT_FIFO_FULL_BIT_MASK) != 0);
-	
-	UART0->DR = data;
+	UART0_Write(&data, 1);
 }
 
 void UART0_Input_String(char *buffer_pointer, uint16_t buffer_size) 
@@ -129,11 +430,7 @@ void UART0_Input_String(char *buffer_pointer, uint16_t buffer_size)
 
 void UART0_Output_String(char *pt)
 {
-	while(*pt)
-	{
-		UART0_Output_Character(*pt);
-		pt++;
-	}
+	UART0_Write(pt, (uint16_t)strlen(pt));
 }
 
 uint32_t UART0_Input_Unsigned_Decimal(void)
@@ -141,7 +438,7 @@ uint32_t UART0_Input_Unsigned_Decimal(void)
 	uint32_t number = 0;
 	uint32_t length = 0;
   char character = UART0_Input_Character();
-	
+
 	// Accepts until <enter> is typed
 	// The next line checks that the input is a digit, 0-9.
 	// If the character is not 0-9, it is ignored and not echoed
@@ -172,16 +469,20 @@ uint32_t UART0_Input_Unsigned_Decimal(void)
 
 void UART0_Output_Unsigned_Decimal(uint32_t n)
 {
-	// Use recursion to convert decimal number
-	// of unspecified length as an ASCII string
-  if (n >= 10)
+	// A 32-bit number has at most 10 digits
+	char digits[10];
+	uint8_t position = sizeof(digits);
+	
+	// Convert from the least significant digit, filling the buffer from its end,
+	// then queue the number as a whole (no recursion: the stack use is fixed)
+	do
 	{
-    UART0_Output_Unsigned_Decimal(n / 10);
-    n = n % 10;
-  }
+		digits[--position] = (char)('0' + (n % 10));
+		n /= 10;
+	}
+	while (n != 0);
 	
-	// n is between 0 and 9
-  UART0_Output_Character(n + '0');
+	UART0_Write(&digits[position], (uint16_t)(sizeof(digits) - position));
 }
 
 uint32_t UART0_Input_Unsigned_Hexadecimal(void)
@@ -190,7 +491,7 @@ uint32_t UART0_Input_Unsigned_Hexadecimal(void)
 	uint32_t digit = 0;
 	uint32_t length = 0;
   char character = UART0_Input_Character();
-	
+
 	while(character != UART0_CR)
 	{
 		// Initialize digit and assume that the hexadecimal character is invalid
@@ -208,7 +509,7 @@ uint32_t UART0_Input_Unsigned_Hexadecimal(void)
 		{
 			digit = (character - 'a') + 0xA;
 		}
-	
+		
 		// If the character is not 0-9 or A-F, it is ignored and not echoed
     if (digit <= 0xF)
 		{
@@ -216,7 +517,7 @@ uint32_t UART0_Input_Unsigned_Hexadecimal(void)
       length++;
       UART0_Output_Character(character);
     }
-		
+
 		// Backspace outputted and return value changed if a backspace is inputted
 		else if((character == UART0_BS) && length)
 		{
@@ -234,13 +535,229 @@ uint32_t UART0_Input_Unsigned_Hexadecimal(void)
 
 void UART0_Output_Newline(void)
 {
-	UART0_Output_Character(UART0_CR);
-	UART0_Output_Character(UART0_LF);
+	UART0_Write("\r\n", 2);
+}
+
+int UART0_Available(void)
+{
+	return (rx_head != rx_tail);
+}
+
+uint16_t UART0_Write(const char *data, uint16_t length)
+{
+	uint16_t head = tx_head;
+	uint16_t free_space = (tx_tail - head - 1) & UART0_TX_BUFFER_MASK;
+	uint16_t first_chunk;
+	
+	if (length > free_space)
+	{
+		uart0_statistics.tx_overflow_count += length;
+		TRACE(TRACE_UART_DROP, length);
+		return 0;
+	}
+	
+	// Copy up to the end of the ring buffer, then wrap around to the beginning
+	first_chunk = UART0_TX_BUFFER_SIZE - head;
+	if (first_chunk > length)
+	{
+		first_chunk = length;
+	}
+	
+	memcpy(&tx_buffer[head], data, first_chunk);
+	memcpy(&tx_buffer[0], data + first_chunk, length - first_chunk);
+	
+	// Publish the new bytes to UART0_Handler only after they have been copied
+	tx_head = (head + length) & UART0_TX_BUFFER_MASK;
+	
+	UART0_Start_Transmit();
+	
+	TRACE(TRACE_UART_WRITE, length);
+	
+	return length;
 }
-	int UART0_Available(void)
+
+int UART0_Write_DMA(const void *data, uint16_t length)
+{
+	if ((tx_dma_state != TX_DMA_IDLE) || (length == 0) || (length > UDMA_MAX_TRANSFER))
 	{
-		return ((UART0->FR & 0x10) == 0);
+		return 0;
 	}
+	
+	// Mask the transmit interrupt so that UART0_Handler cannot observe a half-recorded block
+	UART0->IM &= ~UART0_TX_INTERRUPT_BIT_MASK;
+	
+	tx_dma_source = data;
+	tx_dma_length = length;
+	tx_dma_boundary = tx_head;
+	tx_dma_state = TX_DMA_PENDING;
+	
+	// Starts the transfer right away if the bytes queued before the block are already in the FIFO
+	UART0_Fill_Transmit_FIFO();
+	
+	UART0->IM |= UART0_TX_INTERRUPT_BIT_MASK;
+	
+	return 1;
+}
 
+int UART0_DMA_Busy(void)
+{
+	return (tx_dma_state != TX_DMA_IDLE);
+}
 
+uint16_t UART0_Read(char *buffer, uint16_t length)
+{
+	return UART0_Read_Timestamped(buffer, 0, length);
+}
 
+uint16_t UART0_Read_Timestamped(char *buffer, uint32_t *rx_cycles, uint16_t length)
+{
+	uint16_t tail = rx_tail;
+	uint16_t available = (rx_head - tail) & UART0_RX_BUFFER_MASK;
+	uint16_t first_chunk;
+	
+	if (length > available)
+	{
+		length = available;
+	}
+	
+	first_chunk = UART0_RX_BUFFER_SIZE - tail;
+	if (first_chunk > length)
+	{
+		first_chunk = length;
+	}
+	
+	memcpy(buffer, &rx_buffer[tail], first_chunk);
+	memcpy(buffer + first_chunk, &rx_buffer[0], length - first_chunk);
+	
+	if (rx_cycles != 0)
+	{
+		memcpy(rx_cycles, &rx_cycles_buffer[tail], first_chunk * sizeof(uint32_t));
+		memcpy(rx_cycles + first_chunk, &rx_cycles_buffer[0], (length - first_chunk) * sizeof(uint32_t));
+	}
+	
+	// Release the slots to UART0_Handler only after they have been copied
+	rx_tail = (tail + length) & UART0_RX_BUFFER_MASK;
+	
+	return length;
+}
+
+uint16_t UART0_TX_Free(void)
+{
+	return (tx_tail - tx_head - 1) & UART0_TX_BUFFER_MASK;
+}
+
+void UART0_Get_Statistics(UART0_Statistics *stats)
+{
+	stats->rx_overflow_count = uart0_statistics.rx_overflow_count;
+	stats->rx_overrun_count = uart0_statistics.rx_overrun_count;
+	stats->rx_framing_error_count = uart0_statistics.rx_framing_error_count;
+	stats->tx_overflow_count = uart0_statistics.tx_overflow_count;
+}
+
+void UART0_Handler(void)
+{
+	uint32_t status = UART0->MIS;
+	
+	TRACE(TRACE_UART_IRQ_BEGIN, status);
+	
+	// Acknowledge the interrupts that are about to be serviced
+	UART0->ICR = status;
+	
+	if (status & (UART0_RX_INTERRUPT_BIT_MASK | UART0_RX_TIMEOUT_INTERRUPT_BIT_MASK | UART0_OVERRUN_INTERRUPT_BIT_MASK))
+	{
+		uint16_t head = rx_head;
+		uint32_t rx_cycles = LATENCY_NOW_CYCLES();
+		
+		// A byte collected by the receive timeout has been waiting in the FIFO for the whole timeout
+		if ((status & (UART0_RX_TIMEOUT_INTERRUPT_BIT_MASK | UART0_RX_INTERRUPT_BIT_MASK)) == UART0_RX_TIMEOUT_INTERRUPT_BIT_MASK)
+		{
+			rx_cycles -= rx_timeout_cycles;
+		}
+		
+		// Drain the receive FIFO (at most UART0_HARDWARE_FIFO_DEPTH characters)
+		while ((UART0->FR & UART0_RECEIVE_FIFO_EMPTY_BIT_MASK) == 0)
+		{
+			uint32_t data = UART0->DR;
+			uint16_t next_head = (head + 1) & UART0_RX_BUFFER_MASK;
+			
+			if (data & UART0_DATA_OVERRUN_BIT_MASK)
+			{
+				uart0_statistics.rx_overrun_count++;
+			}
+			
+			// A character without a valid stop bit is garbage, typically sent at another baud rate
+			if (data & UART0_DATA_FRAMING_BIT_MASK)
+			{
+				uart0_statistics.rx_framing_error_count++;
+			}
+			else if (next_head == rx_tail)
+			{
+				uart0_statistics.rx_overflow_count++;
+			}
+			else
+			{
+				rx_buffer[head] = (char)(data & 0xFF);
+				rx_cycles_buffer[head] = rx_cycles;
+				head = next_head;
+			}
+		}
+		
+		rx_head = head;
+	}
+	
+	// The uDMA controller signals the end of a transfer on the UART0 interrupt vector
+	if ((tx_dma_state == TX_DMA_ACTIVE) && UDMA_Transfer_Done(UDMA_CHANNEL_UART0_TX))
+	{
+		UART0->DMACTL &= ~UART0_TX_DMA_ENABLE_BIT_MASK;
+		tx_dma_state = TX_DMA_IDLE;
+		
+		// Resume with the bytes queued in the ring buffer after the block
+		UART0_Fill_Transmit_FIFO();
+	}
+	
+	if (status & UART0_TX_INTERRUPT_BIT_MASK)
+	{
+		UART0_Fill_Transmit_FIFO();
+	}
+	
+	TRACE(TRACE_UART_IRQ_END, (rx_head - rx_tail) & UART0_RX_BUFFER_MASK);
+}
+
+void GPIOA_Handler(void)
+{
+	uint32_t now = LATENCY_NOW_CYCLES();
+	uint32_t width;
+	uint32_t baud_rate;
+	
+	// Acknowledge the PA0 edge by setting Bit 0 in the ICR register
+	GPIOA->ICR = UART0_RX_PIN_BIT_MASK;
+	
+	if (auto_baud_state == AUTO_BAUD_WAIT_START)
+	{
+		// Start bit: wait for the rising edge by setting Bit 0 in the IEV register
+		auto_baud_start_cycles = now;
+		GPIOA->IEV |= UART0_RX_PIN_BIT_MASK;
+		auto_baud_state = AUTO_BAUD_WAIT_END;
+		return;
+	}
+	
+	if (auto_baud_state != AUTO_BAUD_WAIT_END)
+	{
+		return;
+	}
+	
+	// The low pulse of the sync byte lasts UART0_AUTO_BAUD_SYNC_BITS bit periods
+	width = now - auto_baud_start_cycles;
+	baud_rate = (width > 0) ? (uint32_t)((((uint64_t)SYSTEM_CLOCK_HZ * UART0_AUTO_BAUD_SYNC_BITS) + (width / 2)) / width) : 0;
+	baud_rate = UART0_Round_Baud_Rate(baud_rate);
+	
+	if ((baud_rate < UART0_AUTO_BAUD_MIN_RATE) || (baud_rate > UART0_MAX_BAUD_RATE))
+	{
+		// Not a sync byte (noise, or a character with a shorter low pulse): wait for the next one
+		GPIOA->IEV &= ~UART0_RX_PIN_BIT_MASK;
+		auto_baud_state = AUTO_BAUD_WAIT_START;
+		return;
+	}
+	
+	UART0_Finish_Auto_Baud(baud_rate);
+}
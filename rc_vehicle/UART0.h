@@ -10,16 +10,65 @@
  * of the TM4C123GH6PM Microcontroller Datasheet.
  *   - Link: https://www.ti.com/lit/gpn/TM4C123GH6PM
  *
- * @note Assumes that the frequency of the system clock is 50 MHz.
+ * @note The baud rate divisors are computed from SYSTEM_CLOCK_HZ (see System_Clock.h) when
+ * the baud rate is set, so any rate up to SYSTEM_CLOCK_HZ / 8 can be selected at run time.
+ * The rate can also be detected from a sync byte sent by the host (UART0_AUTO_BAUD).
+ *
+ * @note Reception and transmission are interrupt-driven. The UART0_Handler
+ * interrupt service routine moves bytes between the hardware FIFOs and two
+ * software ring buffers, so the output functions only copy bytes into the
+ * transmit ring and never wait for the serial line.
+ *
+ * @note Larger binary blocks can be handed to the uDMA controller with UART0_Write_DMA
+ * (uDMA channel 9). They are transmitted in order with the ring buffer contents,
+ * without the CPU touching each byte.
  *
  * @author Jonathan Penaloza
  */
 
+#ifndef UART0_H
+#define UART0_H
+
 #include "TM4C123GH6PM.h"
+#include "System_Clock.h"
+#include <stdint.h>
 
 #define UART0_RECEIVE_FIFO_EMPTY_BIT_MASK 0x10
 #define UART0_TRANSMIT_FIFO_FULL_BIT_MASK 0x20
 
+/**
+ * @brief Size of the receive ring buffer in bytes (must be a power of two)
+ */
+#define UART0_RX_BUFFER_SIZE 128
+
+/**
+ * @brief Size of the transmit ring buffer in bytes (must be a power of two)
+ */
+#define UART0_TX_BUFFER_SIZE 512
+
+/**
+ * @brief Depth of the UART0 hardware transmit and receive FIFOs
+ */
+#define UART0_HARDWARE_FIFO_DEPTH 16
+
+/**
+ * @brief Error counters maintained by the UART0 driver.
+ */
+typedef struct
+{
+	/** Number of received bytes dropped because the receive ring buffer was full */
+	uint32_t rx_overflow_count;
+	
+	/** Number of received bytes lost in hardware because the receive FIFO overran */
+	uint32_t rx_overrun_count;
+	
+	/** Number of received bytes dropped because they had no valid stop bit (e.g. a baud rate mismatch) */
+	uint32_t rx_framing_error_count;
+	
+	/** Number of bytes rejected because the transmit ring buffer was full */
+	uint32_t tx_overflow_count;
+} UART0_Statistics;
+
 /**
  * @brief Carriage return character
  */
@@ -45,6 +94,52 @@
  */
 #define UART0_DEL  0x7F
 
+/**
+ * @brief Baud rate used when UART0_Init is given a rate that the divisors cannot produce
+ */
+#define UART0_DEFAULT_BAUD_RATE 115200
+
+/**
+ * @brief Baud rate selected by main. Define it as UART0_AUTO_BAUD to detect the rate of the host instead.
+ */
+#ifndef UART0_BAUD_RATE
+#define UART0_BAUD_RATE UART0_DEFAULT_BAUD_RATE
+#endif
+
+/**
+ * @brief Value of the baud_rate argument of UART0_Init that selects automatic baud rate detection
+ */
+#define UART0_AUTO_BAUD 0
+
+/**
+ * @brief Highest baud rate: SYSTEM_CLOCK_HZ / 8, with the UART sampling each bit 8 times (HSE)
+ */
+#define UART0_MAX_BAUD_RATE (SYSTEM_CLOCK_HZ / 8)
+
+/**
+ * @brief Byte that the host sends first when the baud rate is detected automatically.
+ *
+ * A 0x00 byte holds the line low for 9 bit periods (the start bit and the 8 data bits),
+ * so its low pulse gives the bit period. It is also the frame delimiter of the binary
+ * protocol, and it is consumed by the detection: it never reaches the receive ring buffer.
+ * The host must leave the line idle for a few character times after it, while PA0 is
+ * handed back to UART0.
+ */
+#define UART0_AUTO_BAUD_SYNC_BYTE 0x00
+#define UART0_AUTO_BAUD_SYNC_BITS 9
+
+/**
+ * @brief Lowest baud rate accepted by the automatic detection. Shorter or longer low
+ * pulses are ignored and the detection waits for the next sync byte.
+ */
+#define UART0_AUTO_BAUD_MIN_RATE 1200
+
+/**
+ * @brief A measured baud rate within this distance of a standard rate (9600, 115200,
+ * 921600, 2000000, ...) is rounded to it
+ */
+#define UART0_AUTO_BAUD_TOLERANCE_PERCENT 5
+
 /**
  * @brief The UART0_Init function initializes the UART0 module.
  *
@@ -54,20 +149,58 @@
  * - Bit Order: Least Significant Bit (LSB) first
  * - Character Length: 8 data bits
  * - Stop Bits: 1
- * - UART Clock Source: System Clock (50 MHz) Divided By 16
- * - Baud Rate: 115200
+ * - UART Clock Source: System Clock (SYSTEM_CLOCK_HZ) Divided By 16, or by 8 (HSE) for
+ *   baud rates above SYSTEM_CLOCK_HZ / 16
+ * - Baud Rate: baud_rate (see UART0_Set_Baud_Rate)
+ * - Interrupts: Receive (1/8 full), Receive Timeout, Overrun and Transmit (1/8 full)
+ *
+ * With UART0_AUTO_BAUD, PA0 is left as a GPIO input and GPIOA_Handler times the low pulse
+ * of the first UART0_AUTO_BAUD_SYNC_BYTE sent by the host with the DWT cycle counter. UART0
+ * is then programmed with the measured rate and PA0 is handed back to it. The function does
+ * not wait for the host: bytes written in the meantime stay queued and are transmitted
+ * once the rate is known.
  *
  * @note The PA1 (TX) and PA0 (RX) pins are used for UART communication via USB.
  *
+ * @note Latency_Init must be called first when UART0_AUTO_BAUD is used.
+ *
+ * @param baud_rate The baud rate (up to UART0_MAX_BAUD_RATE), or UART0_AUTO_BAUD. A rate that
+ *                  cannot be produced is replaced by UART0_DEFAULT_BAUD_RATE.
+ *
  * @return None
  */
-void UART0_Init(void);
+void UART0_Init(uint32_t baud_rate);
 
 /**
- * @brief The UART0_Input_Character function reads a character from the UART data register.
+ * @brief The UART0_Set_Baud_Rate function changes the baud rate of UART0.
  *
- * This function waits until a character is available in the UART receive buffer
- * from the serial terminal input and returns the received character as a char type.
+ * The divisor BRD = SYSTEM_CLOCK_HZ / (16 * baud_rate) is written to the IBRD (integer part)
+ * and FBRD (fractional part, in 1/64) registers. Above SYSTEM_CLOCK_HZ / 16, the high-speed
+ * mode (HSE) is selected and the divisor becomes SYSTEM_CLOCK_HZ / (8 * baud_rate).
+ * UART0 is disabled while the divisor is changed and enabled again afterwards; the
+ * characters still in the transmit FIFO are sent at the new rate.
+ *
+ * @param baud_rate The new baud rate, from SYSTEM_CLOCK_HZ / (16 * 65535) to UART0_MAX_BAUD_RATE.
+ *
+ * @return 1 if the baud rate was changed, 0 if it cannot be produced.
+ */
+int UART0_Set_Baud_Rate(uint32_t baud_rate);
+
+/**
+ * @brief The UART0_Get_Baud_Rate function returns the baud rate of UART0.
+ *
+ * @param None
+ *
+ * @return The baud rate, or 0 while the automatic detection is still waiting for the sync byte.
+ */
+uint32_t UART0_Get_Baud_Rate(void);
+
+/**
+ * @brief The UART0_Input_Character function reads a character from the receive ring buffer.
+ *
+ * This function sleeps until a character is available in the receive ring buffer
+ * and returns the received character as a char type. Use UART0_Available or UART0_Read
+ * when the caller must not block.
  *
  * @param None
  *
@@ -76,10 +209,11 @@ void UART0_Init(void);
 char UART0_Input_Character(void);
 
 /**
- * @brief The UART0_Output_Character function transmits a character via UART to the serial terminal.
+ * @brief The UART0_Output_Character function queues a character for transmission to the serial terminal.
  *
- * This function waits until the UART transmit buffer is ready to accept
- * a new character and then writes the specified character in the transmit buffer to the serial terminal.
+ * This function copies the specified character into the transmit ring buffer and returns
+ * immediately. If the ring buffer is full, the character is dropped and counted in
+ * UART0_Statistics.tx_overflow_count.
  *
  * @param data The character to be transmitted to the serial terminal.
  *
@@ -103,10 +237,10 @@ void UART0_Output_Character(char data);
 void UART0_Input_String(char *buffer_pointer, uint16_t buffer_size);
 
 /**
- * @brief The UART0_Output_String function transmits a null-terminated string via UART to the serial terminal.
+ * @brief The UART0_Output_String function queues a null-terminated string for transmission to the serial terminal.
  *
- * This function transmits characters from the provided string (pt) via UART to the serial terminal
- * until a null character is encountered.
+ * This function copies the characters from the provided string (pt) into the transmit ring buffer
+ * with UART0_Write. The string is queued as a whole or, if it does not fit, dropped as a whole.
  *
  * @param pt Pointer to the null-terminated string to be transmitted.
  *
@@ -126,9 +260,156 @@ void UART0_Output_String(char *pt);
  *
  * @return The received unsigned decimal number from the serial terminal as a uint32_t type.
  */
+uint32_t UART0_Input_Unsigned_Decimal(void);
+
+/**
+ * @brief The UART0_Output_Unsigned_Decimal function transmits an unsigned decimal number as an ASCII string.
+ *
+ * The digits are queued as a whole or, if they do not fit, dropped as a whole.
+ *
+ * @param n The number to be transmitted.
+ *
+ * @return None
+ */
+void UART0_Output_Unsigned_Decimal(uint32_t n);
 
+/**
+ * @brief The UART0_Output_Newline function transmits a carriage return and a line feed.
+ *
+ * @param None
+ *
+ * @return None
+ */
 void UART0_Output_Newline(void);
 
+/**
+ * @brief The UART0_Available function checks if received data is waiting in the receive ring buffer.
+ *
+ * @param None
+ *
+ * @return 1 if at least one character can be read without blocking, 0 otherwise.
+ */
 int UART0_Available(void);
 
+/**
+ * @brief The UART0_Write function queues a block of bytes for transmission without blocking.
+ *
+ * The bytes are copied into the transmit ring buffer (at most two memcpy calls) and the
+ * hardware transmit FIFO is primed if it is idle. The remaining bytes are moved to the FIFO
+ * by UART0_Handler. The block is accepted as a whole or rejected as a whole, so a partially
+ * transmitted message can never appear on the line.
+ *
+ * Worst-case cost: copying length bytes, plus at most UART0_HARDWARE_FIFO_DEPTH writes to the
+ * data register and four other register accesses. The call never waits for the serial line.
+ *
+ * @note This function must be called from thread context only, not from an interrupt service routine.
+ *
+ * @param data Pointer to the bytes to transmit.
+ * @param length Number of bytes to transmit.
+ *
+ * @return The number of bytes queued: either length, or 0 if the transmit ring buffer
+ *         did not have enough room (the bytes are counted in tx_overflow_count).
+ */
+uint16_t UART0_Write(const char *data, uint16_t length);
+
+/**
+ * @brief The UART0_Write_DMA function transmits a block of bytes with the uDMA controller.
+ *
+ * The block is transmitted after the bytes already queued with UART0_Write and before
+ * any bytes queued after this call, so messages never interleave. The CPU does not touch
+ * the bytes; UART0_Handler only re-arms the ring buffer when the transfer completes.
+ * Only one block can be in progress at a time.
+ *
+ * @note The buffer must stay unchanged until UART0_DMA_Busy returns 0.
+ * This function must be called from thread context only.
+ *
+ * @param data Pointer to the bytes to transmit. It must be a static buffer.
+ * @param length Number of bytes to transmit (1 to UDMA_MAX_TRANSFER).
+ *
+ * @return 1 if the block was accepted, 0 if another block is still in progress.
+ */
+int UART0_Write_DMA(const void *data, uint16_t length);
+
+/**
+ * @brief The UART0_DMA_Busy function checks if a block handed to UART0_Write_DMA is still in progress.
+ *
+ * @param None
+ *
+ * @return 1 if the block is waiting or being transmitted, 0 otherwise.
+ */
+int UART0_DMA_Busy(void);
+
+/**
+ * @brief The UART0_Read function copies received bytes out of the receive ring buffer without blocking.
+ *
+ * Worst-case cost: copying length bytes (at most two memcpy calls).
+ *
+ * @param buffer Pointer to the buffer where the received bytes will be stored.
+ * @param length Maximum number of bytes to copy.
+ *
+ * @return The number of bytes copied, which may be 0.
+ */
+uint16_t UART0_Read(char *buffer, uint16_t length);
+
+/**
+ * @brief The UART0_Read_Timestamped function reads received bytes together with their receive timestamps.
+ *
+ * The timestamps are DWT cycle counter values (see Latency.h) taken by UART0_Handler.
+ * For bytes collected by the receive timeout interrupt, they are moved back by the
+ * receive timeout (32 bit periods) to approximate the time the bytes reached the FIFO.
+ *
+ * @param buffer Pointer to the buffer where the received bytes will be stored.
+ * @param rx_cycles Pointer to the buffer where the timestamps will be stored (one per byte).
+ * @param length Maximum number of bytes to copy.
+ *
+ * @return The number of bytes copied, which may be 0.
+ */
+uint16_t UART0_Read_Timestamped(char *buffer, uint32_t *rx_cycles, uint16_t length);
+
+/**
+ * @brief The UART0_TX_Free function returns the free space in the transmit ring buffer.
+ *
+ * @param None
+ *
+ * @return The number of bytes that UART0_Write can currently accept.
+ */
+uint16_t UART0_TX_Free(void);
+
+/**
+ * @brief The UART0_Get_Statistics function copies the driver's error counters.
+ *
+ * @param stats Pointer to the structure that receives the counters.
+ *
+ * @return None
+ */
+void UART0_Get_Statistics(UART0_Statistics *stats);
+
+/**
+ * @brief The UART0_Handler function is the interrupt service routine for UART0.
+ *
+ * On a receive, receive timeout or overrun interrupt, it drains the hardware receive FIFO
+ * into the receive ring buffer. On a transmit interrupt, it refills the hardware transmit FIFO
+ * from the transmit ring buffer. It also handles the completion of uDMA transfers on UART0 TX. Each invocation touches at most UART0_HARDWARE_FIFO_DEPTH
+ * bytes in each direction.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void UART0_Handler(void);
+
+/**
+ * @brief The GPIOA_Handler function is the interrupt service routine for Port A.
+ *
+ * It is only enabled during the automatic baud rate detection. It timestamps the falling
+ * edge of the sync byte's start bit and the rising edge after its last data bit on PA0,
+ * computes the baud rate from the time between them, and completes the UART0 configuration.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void GPIOA_Handler(void);
+
+#endif
 
@@ -0,0 +1,99 @@
+/**
+ * @file UDMA.c
+ *
+ * @brief Source code for the Micro Direct Memory Access (uDMA) driver.
+ *
+ * Only the primary control structures of the channel control table are used,
+ * so the table holds 32 entries of 16 bytes. The controller requires the table
+ * to be aligned on a 1024-byte boundary.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "UDMA.h"
+
+// Channel control structure, as read by the uDMA controller
+typedef struct
+{
+	volatile uint32_t source_end;
+	volatile uint32_t destination_end;
+	volatile uint32_t control;
+	uint32_t unused;
+} UDMA_Control_Structure;
+
+static UDMA_Control_Structure udma_control_table[32] __attribute__((aligned(1024)));
+
+static uint8_t udma_initialized = 0;
+
+void UDMA_Init(void)
+{
+	if (udma_initialized)
+	{
+		return;
+	}
+	
+	// Enable the clock to the uDMA controller by setting the
+	// R0 bit (Bit 0) in the RCGCDMA register
+	SYSCTL->RCGCDMA |= 0x01;
+	
+	// Wait until the uDMA controller is ready to be accessed
+	while ((SYSCTL->PRDMA & 0x01) == 0);
+	
+	// Enable the uDMA controller by setting the MASTEN bit (Bit 0) in the CFG register
+	UDMA->CFG = 0x01;
+	
+	// Set the base address of the channel control table
+	UDMA->CTLBASE = (uint32_t)(uintptr_t)udma_control_table;
+	
+	udma_initialized = 1;
+}
+
+void UDMA_Configure_Channel(uint8_t channel, uint8_t encoding)
+{
+	uint32_t channel_bit = 1UL << channel;
+	volatile uint32_t *channel_map = &UDMA->CHMAP0 + (channel / 8);
+	uint32_t shift = (channel % 8) * 4;
+	
+	// Select the peripheral for the channel in the CHMAPn register (4 bits per channel)
+	*channel_map = (*channel_map & ~(0xFUL << shift)) | ((uint32_t)encoding << shift);
+	
+	// Use the primary control structure, default priority, and accept
+	// single requests as well as burst requests from the peripheral
+	UDMA->ALTCLR = channel_bit;
+	UDMA->PRIOCLR = channel_bit;
+	UDMA->USEBURSTCLR = channel_bit;
+	UDMA->REQMASKCLR = channel_bit;
+}
+
+void UDMA_Start_Memory_To_Peripheral(uint8_t channel, const void *source, volatile void *destination,
+                                     uint16_t count, uint8_t arbitration_size)
+{
+	UDMA_Control_Structure *entry = &udma_control_table[channel];
+	
+	// The control structure holds the address of the last item, not the first
+	entry->source_end = (uint32_t)(uintptr_t)((const uint8_t *)source + (count - 1));
+	entry->destination_end = (uint32_t)(uintptr_t)destination;
+	
+	// DSTINC = 0x3 (no increment, Bits 31 to 30), DSTSIZE = 0x0 (byte, Bits 29 to 28),
+	// SRCINC = 0x0 (byte, Bits 27 to 26), SRCSIZE = 0x0 (byte, Bits 25 to 24),
+	// ARBSIZE (Bits 17 to 14), XFERSIZE = count - 1 (Bits 13 to 4), XFERMODE = 0x1 (basic, Bits 2 to 0)
+	entry->control = (0x3UL << 30) | ((uint32_t)arbitration_size << 14)
+	                 | ((uint32_t)(count - 1) << 4) | 0x01;
+	
+	// Clear a stale completion flag, then enable the channel
+	UDMA->CHIS = 1UL << channel;
+	UDMA->ENASET = 1UL << channel;
+}
+
+int UDMA_Transfer_Done(uint8_t channel)
+{
+	uint32_t channel_bit = 1UL << channel;
+	
+	if (UDMA->CHIS & channel_bit)
+	{
+		UDMA->CHIS = channel_bit;
+		return 1;
+	}
+	
+	return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file UDMA.h
+ *
+ * @brief Header file for the Micro Direct Memory Access (uDMA) driver.
+ *
+ * This driver sets up the uDMA controller and its channel control table, and starts
+ * basic-mode transfers from memory to a peripheral data register. The completion of a
+ * transfer is signalled on the interrupt vector of the peripheral that owns the channel,
+ * and can be checked with UDMA_Transfer_Done.
+ *
+ * @note For more information regarding the uDMA controller, refer to the
+ * Micro Direct Memory Access (uDMA) section of the TM4C123GH6PM Microcontroller Datasheet.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef UDMA_H
+#define UDMA_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief uDMA channel assigned to UART0 TX (channel 9, encoding 0)
+ */
+#define UDMA_CHANNEL_UART0_TX 9
+
+/**
+ * @brief Largest number of items moved by one basic-mode transfer
+ */
+#define UDMA_MAX_TRANSFER 1024
+
+/**
+ * @brief The UDMA_Init function enables the uDMA controller.
+ *
+ * It enables the clock to the controller, sets the base of the channel control table
+ * and enables the controller. Calling it more than once has no effect.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void UDMA_Init(void);
+
+/**
+ * @brief The UDMA_Configure_Channel function prepares a channel for peripheral requests.
+ *
+ * It assigns the channel to the given peripheral encoding, selects the primary control
+ * structure and the default priority, and allows both single and burst requests.
+ *
+ * @param channel The uDMA channel number (0 to 31).
+ * @param encoding The channel assignment encoding (0 to 4) from the channel assignment table.
+ *
+ * @return None
+ */
+void UDMA_Configure_Channel(uint8_t channel, uint8_t encoding);
+
+/**
+ * @brief The UDMA_Start_Memory_To_Peripheral function starts a byte transfer to a peripheral register.
+ *
+ * The source address is incremented after each byte and the destination address is fixed.
+ * The buffer must stay unchanged until the transfer is done.
+ *
+ * @param channel The uDMA channel number (0 to 31).
+ * @param source Pointer to the first byte to transfer.
+ * @param destination Address of the peripheral data register.
+ * @param count Number of bytes to transfer (1 to UDMA_MAX_TRANSFER).
+ * @param arbitration_size Number of bytes moved per peripheral request, as a power of two exponent (0 to 10).
+ *
+ * @return None
+ */
+void UDMA_Start_Memory_To_Peripheral(uint8_t channel, const void *source, volatile void *destination,
+                                     uint16_t count, uint8_t arbitration_size);
+
+/**
+ * @brief The UDMA_Transfer_Done function checks and clears the completion flag of a channel.
+ *
+ * @param channel The uDMA channel number (0 to 31).
+ *
+ * @return 1 if the channel completed a transfer since the last call, 0 otherwise.
+ */
+int UDMA_Transfer_Done(uint8_t channel);
+
+#endif
@@ -1,66 +1,533 @@
 /**
  * @file Ultra_Sonic.c
  *
- * @brief Source file for the Ultra_Sonic.
+ * @brief Source file for the Ultra Sonic Sensor (HC-SR04) array driver.
+ *
+ * Wide Timer 0 Timer A runs in periodic mode with its time-out and match interrupts to pace
+ * the slots and time the trigger pulses, which are driven on GPIO pins. The echo of each
+ * sensor is timed by a wide timer half in edge-time capture mode. All the timers are clocked
+ * by the system clock, and all the interrupt service routines share the priority 2.
  *
- 
  * @author Jonathan Penaloza, Ricardo Zaragoza
  */
 
+#include "Ultra_Sonic.h"
+#include "Timebase.h"
+#include "Scheduler.h"
+#include "Trace.h"
+
+// Time-out (TATOIM, Bit 0) and match (TAMIM, Bit 4) interrupt bits of Timer A in the IMR, MIS and ICR registers
+#define ULTRASONIC_SLOT_TIMEOUT_BIT_MASK 0x0001
+#define ULTRASONIC_SLOT_MATCH_BIT_MASK   0x0010
+
+// Capture mode event interrupt bit of a timer half in the IMR, RIS and ICR registers:
+// CAEIM (Bit 2) for Timer A, CBEIM (Bit 10) for Timer B
+#define ULTRASONIC_ECHO_EVENT_BIT_MASK(half) (0x0004UL << ((half) * 8))
+
+#define ULTRASONIC_SLOT_CYCLES          ((uint32_t)TIMEBASE_US_TO_CYCLES(ULTRASONIC_SLOT_US))
+#define ULTRASONIC_TRIGGER_PULSE_CYCLES ((uint32_t)TIMEBASE_US_TO_CYCLES(ULTRASONIC_TRIGGER_PULSE_US))
+
+// Number of slots needed to keep ULTRASONIC_MIN_PING_PERIOD_MS between two pings of a sensor
+#define ULTRASONIC_MIN_ROUND_SLOTS (((ULTRASONIC_MIN_PING_PERIOD_MS * 1000) + ULTRASONIC_SLOT_US - 1) / ULTRASONIC_SLOT_US)
+
+// The echo captures are Timer A and Timer B of Wide Timers 0 to 4, numbered 2 * timer + half
+#define ULTRASONIC_CAPTURE_COUNT 10
+#define ULTRASONIC_NO_CAPTURE    0xFF
+#define ULTRASONIC_NO_SENSOR     0xFF
+
+#define ULTRASONIC_PORT_COUNT 6
+
+// Pins and slot of each sensor, in the order of Ultrasonic_Sensor. Sensors that face away
+// from each other share a slot, so that the four sensors range in two slots
+static const Ultrasonic_Sensor_Config ultrasonic_sensors[ULTRASONIC_SENSOR_COUNT] =
+{
+	// name,   trigger pin,           echo pin,              slot
+	{ "front", ULTRASONIC_PORT_C, 4,  ULTRASONIC_PORT_C, 5,  0 },
+	{ "rear",  ULTRASONIC_PORT_E, 1,  ULTRASONIC_PORT_C, 6,  0 },
+	{ "left",  ULTRASONIC_PORT_E, 2,  ULTRASONIC_PORT_C, 7,  1 },
+	{ "right", ULTRASONIC_PORT_E, 3,  ULTRASONIC_PORT_D, 2,  1 }
+};
+
+static GPIOA_Type * const ultrasonic_ports[ULTRASONIC_PORT_COUNT] =
+{
+	GPIOA, GPIOB, GPIOC, GPIOD, GPIOE, GPIOF
+};
+
+static WTIMER0_Type * const capture_timers[ULTRASONIC_CAPTURE_COUNT / 2] =
+{
+	WTIMER0, WTIMER1, WTIMER2, WTIMER3, WTIMER4
+};
+
+static const IRQn_Type capture_irqs[ULTRASONIC_CAPTURE_COUNT] =
+{
+	WTIMER0A_IRQn, WTIMER0B_IRQn, WTIMER1A_IRQn, WTIMER1B_IRQn, WTIMER2A_IRQn,
+	WTIMER2B_IRQn, WTIMER3A_IRQn, WTIMER3B_IRQn, WTIMER4A_IRQn, WTIMER4B_IRQn
+};
+
+// Progress of the echo measurement for the current ping of a sensor
+typedef enum
+{
+	ECHO_IDLE,
+	ECHO_WAIT_RISE,
+	ECHO_WAIT_FALL,
+	ECHO_DONE
+} Echo_State;
+
+typedef struct
+{
+	volatile Echo_State echo_state;
+	
+	// Capture of the echo rising edge
+	uint32_t echo_rise_capture;
+	
+	// Number of pings completed since initialization
+	uint32_t ping_count;
+	
+	// Latest sample, written only by the interrupt service routines
+	Ultrasonic_Sample latest_sample;
+	
+	// Task released for every new sample, -1 for none
+	int sample_task_id;
+	
+	// 1 if the sensor has an echo capture and a slot, 0 if it is left out
+	uint8_t active;
+} Ultrasonic_Sensor_State;
+
+static Ultrasonic_Sensor_State sensor_states[ULTRASONIC_SENSOR_COUNT];
 
+// Sensor timed by each echo capture, ULTRASONIC_NO_SENSOR for none
+static uint8_t capture_sensors[ULTRASONIC_CAPTURE_COUNT];
 
+// Trigger pins of the sensors of each slot, as a bit mask for every GPIO port
+static uint8_t slot_trigger_pins[ULTRASONIC_MAX_SLOTS][ULTRASONIC_PORT_COUNT];
+
+// Slots in a round, including the idle ones, and the slot in progress
+static uint8_t round_slots;
+static uint8_t current_slot;
+
+// Timer A count at which the trigger pins of the current slot were raised
+static uint32_t trigger_start_count;
+
+// Echo capture of a sensor: PC5 to PC7 are WT0CCP1 to WT1CCP1 (captures 1 to 3),
+// and PD2 to PD5 are WT3CCP0 to WT4CCP1 (captures 6 to 9)
+static uint8_t Ultrasonic_Echo_Capture(const Ultrasonic_Sensor_Config *config)
+{
+	if ((config->echo_port == ULTRASONIC_PORT_C) && (config->echo_pin >= 5) && (config->echo_pin <= 7))
+	{
+		return config->echo_pin - 4;
+	}
+	
+	if ((config->echo_port == ULTRASONIC_PORT_D) && (config->echo_pin >= 2) && (config->echo_pin <= 5))
+	{
+		return config->echo_pin + 4;
+	}
+	
+	return ULTRASONIC_NO_CAPTURE;
+}
+
+static void Ultrasonic_Store_Sample(uint8_t sensor, uint32_t pulse_us, uint64_t timestamp_cycles)
+{
+	Ultrasonic_Sensor_State *state = &sensor_states[sensor];
+	uint8_t valid = (pulse_us > 0) && (pulse_us <= ULTRASONIC_MAX_PULSE_US);
+	
+	TRACE(TRACE_SONAR_SAMPLE, ((uint32_t)sensor << 24) | (pulse_us & 0x00FFFFFF));
+	
+	state->ping_count++;
+	
+	state->latest_sample.timestamp_cycles = timestamp_cycles;
+	state->latest_sample.pulse_us = valid ? pulse_us : 0;
+	state->latest_sample.distance_cm = valid ? (pulse_us / ULTRASONIC_US_PER_CM) : 0;
+	state->latest_sample.sequence = state->ping_count;
+	state->latest_sample.valid = valid;
+	
+	if (state->sample_task_id >= 0)
+	{
+		Scheduler_Signal(state->sample_task_id);
+	}
+}
 
-#include "TM4C123GH6PM.h"   // TM4C123 register definitions
-#include "SysTick_Delay.h"   // SysTick delay functions
+// Drives the trigger pins of a slot through the address-masked DATA register, so that the
+// other pins of the ports are left untouched without a read-modify-write
+static void Ultrasonic_Set_Triggers(uint8_t slot, uint8_t level)
+{
+	int port;
+	
+	for (port = 0; port < ULTRASONIC_PORT_COUNT; port++)
+	{
+		uint8_t pins = slot_trigger_pins[slot][port];
+		
+		if (pins != 0)
+		{
+			ultrasonic_ports[port]->DATA_Bits[pins] = level ? pins : 0;
+		}
+	}
+}
 
-// Initialize PC4 (Trigger) and PC5 (Echo)
-void Ultrasonic_Init(void) {
-    SYSCTL->RCGCGPIO |= 0x04;            // Enable clock to Port C using GPIO
-    while(!(SYSCTL->PRGPIO & 0x04));     // Wait until ready
+// Configures the echo pin of a sensor and its capture in edge-time mode
+static void Ultrasonic_Init_Echo(const Ultrasonic_Sensor_Config *config, uint8_t capture)
+{
+	GPIOA_Type *port = ultrasonic_ports[config->echo_port];
+	WTIMER0_Type *timer = capture_timers[capture / 2];
+	uint8_t half = capture % 2;
+	uint8_t pin = (uint8_t)(0x01 << config->echo_pin);
+	
+	// Select the alternate function of the pin, and write 0x7 (WTnCCPm) to its PMCn field
+	// in the PCTL register. The 0x7 value is derived from Table 23-5 in the TM4C123G Microcontroller Datasheet
+	port->AFSEL |= pin;
+	port->PCTL = (port->PCTL & ~(0x0FUL << (config->echo_pin * 4))) | (0x07UL << (config->echo_pin * 4));
+	
+	// Enable a weak pull-down so that a disconnected sensor reads as no echo
+	port->PDR |= pin;
+	port->DEN |= pin;
+	
+	if (half == 0)
+	{
+		// Configure Timer A for edge-time capture mode: capture (TAMR = 0x3, Bits 1 to 0),
+		// edge-time (TACMR, Bit 2) and counting up (TACDIR, Bit 4)
+		timer->TAMR = 0x0017;
+		
+		// Capture both edges of the echo (TAEVENT = 0x3, Bits 3 to 2)
+		timer->CTL |= 0x000C;
+		
+		// Let the counter run through the full 32-bit range so that the
+		// difference between two captures is correct across a wrap
+		timer->TAPR = 0;
+		timer->TAILR = 0xFFFFFFFF;
+	}
+	else
+	{
+		// Same configuration for Timer B (TBMR, Bits 1 to 0, and TBEVENT, Bits 11 to 10)
+		timer->TBMR = 0x0017;
+		timer->CTL |= 0x0C00;
+		timer->TBPR = 0;
+		timer->TBILR = 0xFFFFFFFF;
+	}
+	
+	// Clear and enable the capture mode event interrupt
+	timer->ICR = ULTRASONIC_ECHO_EVENT_BIT_MASK(half);
+	timer->IMR |= ULTRASONIC_ECHO_EVENT_BIT_MASK(half);
+	
+	NVIC_SetPriority(capture_irqs[capture], 2);
+	NVIC_EnableIRQ(capture_irqs[capture]);
+	
+	// Start the capture by setting TAEN (Bit 0) or TBEN (Bit 8) in the CTL register
+	timer->CTL |= 0x0001UL << (half * 8);
+}
 
-    GPIOC->DIR |= 0x10;      // PC4 output
-    GPIOC->DIR &= ~0x20;     // PC5 input  
+void Ultrasonic_Init(void)
+{
+	uint8_t used_slots = 0;
+	uint8_t gpio_clocks = 0;
+	uint8_t timer_clocks = 0x01;
+	int sensor;
+	int i;
+	
+	// The sample timestamps are taken from the timebase
+	Timebase_Init();
+	
+	for (i = 0; i < ULTRASONIC_CAPTURE_COUNT; i++)
+	{
+		capture_sensors[i] = ULTRASONIC_NO_SENSOR;
+	}
+	
+	for (i = 0; i < ULTRASONIC_MAX_SLOTS; i++)
+	{
+		int port;
+		
+		for (port = 0; port < ULTRASONIC_PORT_COUNT; port++)
+		{
+			slot_trigger_pins[i][port] = 0;
+		}
+	}
+	
+	// Assign the captures and the slots. A sensor with no usable capture, a capture
+	// already taken, or a slot out of range is left out
+	for (sensor = 0; sensor < ULTRASONIC_SENSOR_COUNT; sensor++)
+	{
+		const Ultrasonic_Sensor_Config *config = &ultrasonic_sensors[sensor];
+		uint8_t capture = Ultrasonic_Echo_Capture(config);
+		
+		sensor_states[sensor].echo_state = ECHO_IDLE;
+		sensor_states[sensor].ping_count = 0;
+		sensor_states[sensor].sample_task_id = -1;
+		sensor_states[sensor].active = 0;
+		
+		if ((capture != ULTRASONIC_NO_CAPTURE) && (capture_sensors[capture] != ULTRASONIC_NO_SENSOR))
+		{
+			capture = ULTRASONIC_NO_CAPTURE;
+		}
+		
+		if ((capture == ULTRASONIC_NO_CAPTURE) || (config->slot >= ULTRASONIC_MAX_SLOTS))
+		{
+			continue;
+		}
+		
+		sensor_states[sensor].active = 1;
+		capture_sensors[capture] = (uint8_t)sensor;
+		slot_trigger_pins[config->slot][config->trigger_port] |= (uint8_t)(0x01 << config->trigger_pin);
+		
+		if (config->slot >= used_slots)
+		{
+			used_slots = config->slot + 1;
+		}
+		
+		gpio_clocks |= (uint8_t)((0x01 << config->trigger_port) | (0x01 << config->echo_port));
+		timer_clocks |= (uint8_t)(0x01 << (capture / 2));
+	}
+	
+	round_slots = (used_slots > ULTRASONIC_MIN_ROUND_SLOTS) ? used_slots : ULTRASONIC_MIN_ROUND_SLOTS;
+	
+	// Enable the clocks to the GPIO ports (RCGCGPIO register) and the wide timers
+	// (RCGCWTIMER register) of the sensors, and to Wide Timer 0 for the slots
+	SYSCTL->RCGCGPIO |= gpio_clocks;
+	SYSCTL->RCGCWTIMER |= timer_clocks;
+	
+	// Wait until the ports and the timers are ready
+	while ((SYSCTL->PRGPIO & gpio_clocks) != gpio_clocks);
+	while ((SYSCTL->PRWTIMER & timer_clocks) != timer_clocks);
+	
+	// Disable both halves of the timers before configuration, and select the 32-bit
+	// individual timer configuration by writing 0x4 to the CFG register
+	for (i = 0; i < ULTRASONIC_CAPTURE_COUNT / 2; i++)
+	{
+		if (timer_clocks & (0x01 << i))
+		{
+			capture_timers[i]->CTL &= ~0x0101;
+			capture_timers[i]->CFG = 0x04;
+		}
+	}
+	
+	// Configure the trigger pins as digital outputs, driven low
+	for (sensor = 0; sensor < ULTRASONIC_SENSOR_COUNT; sensor++)
+	{
+		const Ultrasonic_Sensor_Config *config = &ultrasonic_sensors[sensor];
+		GPIOA_Type *port = ultrasonic_ports[config->trigger_port];
+		uint8_t pin = (uint8_t)(0x01 << config->trigger_pin);
+		
+		if (!sensor_states[sensor].active)
+		{
+			continue;
+		}
+		
+		port->DATA_Bits[pin] = 0;
+		port->AFSEL &= ~pin;
+		port->DIR |= pin;
+		port->DEN |= pin;
+	}
+	
+	// Start the echo captures first so that no edge of the first echo is missed
+	for (i = 0; i < ULTRASONIC_CAPTURE_COUNT; i++)
+	{
+		if (capture_sensors[i] != ULTRASONIC_NO_SENSOR)
+		{
+			Ultrasonic_Init_Echo(&ultrasonic_sensors[capture_sensors[i]], (uint8_t)i);
+		}
+	}
+	
+	// Configure Timer A for periodic mode (TAMR = 0x2, Bits 1 to 0), counting down,
+	// with the match interrupt enabled (TAMIE, Bit 5)
+	WTIMER0->TAMR = 0x0022;
+	
+	// The counter reloads from TAILR at the start of each slot, and reaches TAMATCHR
+	// at the end of the trigger pulse, (TAILR - TAMATCHR) cycles later
+	WTIMER0->TAPR = 0;
+	WTIMER0->TAILR = ULTRASONIC_SLOT_CYCLES - 1;
+	WTIMER0->TAPMR = 0;
+	WTIMER0->TAMATCHR = (ULTRASONIC_SLOT_CYCLES - 1) - ULTRASONIC_TRIGGER_PULSE_CYCLES;
+	
+	// The first time-out starts slot 0
+	current_slot = round_slots - 1;
+	
+	// Clear and enable the Timer A time-out and match interrupts
+	WTIMER0->ICR = ULTRASONIC_SLOT_TIMEOUT_BIT_MASK | ULTRASONIC_SLOT_MATCH_BIT_MASK;
+	WTIMER0->IMR |= ULTRASONIC_SLOT_TIMEOUT_BIT_MASK | ULTRASONIC_SLOT_MATCH_BIT_MASK;
+	
+	// All the handlers share the sensor states, so they are given the same priority
+	// and can never preempt each other
+	NVIC_SetPriority(WTIMER0A_IRQn, 2);
+	NVIC_EnableIRQ(WTIMER0A_IRQn);
+	
+	// Start the slots by setting the TAEN bit (Bit 0) in the CTL register
+	WTIMER0->CTL |= 0x0001;
+}
 
-    GPIOC->DEN |= 0x30;      // digital enable PC4 + PC5
-    GPIOC->PDR |= 0x20;      // weak pull-down on PC5 (Echo)
-    GPIOC->AFSEL &= ~0x30;   // GPIO function for PC4 & PC5
+const Ultrasonic_Sensor_Config *Ultrasonic_Get_Config(Ultrasonic_Sensor sensor)
+{
+	return &ultrasonic_sensors[sensor];
 }
 
-// Send trigger and read pulse width in microseconds
-uint32_t Ultrasonic_ReadPulse(void) {
-    uint32_t count = 0;
-    uint32_t timeout = 30000;   // ~30ms max wait
+uint32_t Ultrasonic_Get_Ping_Period_US(void)
+{
+	return (uint32_t)round_slots * ULTRASONIC_SLOT_US;
+}
 
-    GPIOC->DATA |= 0x10;        // Trigger HIGH
-    SysTick_Delay1us(10);
-    GPIOC->DATA &= ~0x10;       // Trigger LOW
+uint32_t Ultrasonic_ReadPulse(Ultrasonic_Sensor sensor)
+{
+	Ultrasonic_Sample sample;
+	
+	Ultrasonic_Get_Sample(sensor, &sample);
+	
+	return sample.pulse_us;
+}
 
-    // Wait for Echo HIGH with timeout
-    while(!(GPIOC->DATA & 0x20)) 
-    {
-        if(timeout == 0) return 0;  // No echo
-        timeout--;
-    }
+uint32_t Ultrasonic_ReadDistanceCM(Ultrasonic_Sensor sensor)
+{
+	Ultrasonic_Sample sample;
+	
+	Ultrasonic_Get_Sample(sensor, &sample);
+	
+	return sample.distance_cm;
+}
 
-    // Measure pulse width
-    count = 0;
-    while(GPIOC->DATA & 0x20) 
-    {
-        count++;
-        SysTick_Delay1us(1);
-    }
+void Ultrasonic_Get_Sample(Ultrasonic_Sensor sensor, Ultrasonic_Sample *sample)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq();
+	*sample = sensor_states[sensor].latest_sample;
+	__set_PRIMASK(primask);
+}
 
-    return count;
+void Ultrasonic_Set_Sample_Task(Ultrasonic_Sensor sensor, int task_id)
+{
+	sensor_states[sensor].sample_task_id = task_id;
 }
 
-    
-// Convert pulse width to distance in cm
-uint32_t Ultrasonic_ReadDistanceCM(void) 
+void WTIMER0A_Handler(void)
+{
+	uint32_t status = WTIMER0->MIS;
+	int sensor;
+	
+	if (status & ULTRASONIC_SLOT_TIMEOUT_BIT_MASK)
 	{
-    uint32_t pulse = Ultrasonic_ReadPulse();
-    return pulse / 58;  // approximate distance in cm
+		// Acknowledge the time-out interrupt
+		WTIMER0->ICR = ULTRASONIC_SLOT_TIMEOUT_BIT_MASK;
+		
+		// The previous slot is over. A ping that never saw a falling edge timed out
+		// and is reported as a no-echo sample
+		for (sensor = 0; sensor < ULTRASONIC_SENSOR_COUNT; sensor++)
+		{
+			Echo_State echo_state = sensor_states[sensor].echo_state;
+			
+			if ((echo_state == ECHO_WAIT_RISE) || (echo_state == ECHO_WAIT_FALL))
+			{
+				Ultrasonic_Store_Sample((uint8_t)sensor, 0, Timebase_Now_Cycles());
+				sensor_states[sensor].echo_state = ECHO_DONE;
+			}
+		}
 		
+		current_slot = (current_slot + 1 < round_slots) ? (current_slot + 1) : 0;
+		
+		// Idle slots only let the sensors rest
+		if (current_slot < ULTRASONIC_MAX_SLOTS)
+		{
+			trigger_start_count = WTIMER0->TAV;
+			Ultrasonic_Set_Triggers(current_slot, 1);
+			TRACE(TRACE_SONAR_TRIGGER, current_slot);
+			
+			for (sensor = 0; sensor < ULTRASONIC_SENSOR_COUNT; sensor++)
+			{
+				if (sensor_states[sensor].active && (ultrasonic_sensors[sensor].slot == current_slot))
+				{
+					sensor_states[sensor].echo_state = ECHO_WAIT_RISE;
+				}
+			}
+		}
+	}
+	
+	if (status & ULTRASONIC_SLOT_MATCH_BIT_MASK)
+	{
+		// Acknowledge the match interrupt
+		WTIMER0->ICR = ULTRASONIC_SLOT_MATCH_BIT_MASK;
 		
+		if (current_slot < ULTRASONIC_MAX_SLOTS)
+		{
+			uint32_t count = WTIMER0->TAV;
+			
+			// If the time-out was served late, the match is already pending:
+			// hold the trigger pins until the pulse is long enough
+			while ((count <= trigger_start_count) && ((trigger_start_count - count) < ULTRASONIC_TRIGGER_PULSE_CYCLES))
+			{
+				count = WTIMER0->TAV;
+			}
+			
+			// The sensors start their measurement on this falling edge
+			Ultrasonic_Set_Triggers(current_slot, 0);
+		}
+	}
 }
+
+// Handles an edge of the echo timed by a capture
+static void Ultrasonic_Echo_Edge(uint8_t capture)
+{
+	WTIMER0_Type *timer = capture_timers[capture / 2];
+	uint8_t half = capture % 2;
+	uint8_t sensor = capture_sensors[capture];
+	uint32_t capture_value = (half == 0) ? timer->TAR : timer->TBR;
+	Ultrasonic_Sensor_State *state;
 	
+	// Acknowledge the echo capture event
+	timer->ICR = ULTRASONIC_ECHO_EVENT_BIT_MASK(half);
+	
+	if (sensor == ULTRASONIC_NO_SENSOR)
+	{
+		return;
+	}
+	
+	state = &sensor_states[sensor];
+	
+	if (state->echo_state == ECHO_WAIT_RISE)
+	{
+		state->echo_rise_capture = capture_value;
+		state->echo_state = ECHO_WAIT_FALL;
+	}
+	else if (state->echo_state == ECHO_WAIT_FALL)
+	{
+		uint32_t pulse_cycles = capture_value - state->echo_rise_capture;
+		
+		// Back-date the timestamp to the captured falling edge using the
+		// number of counts since the capture
+		uint32_t latency_cycles = ((half == 0) ? timer->TAV : timer->TBV) - capture_value;
+		
+		Ultrasonic_Store_Sample(sensor, pulse_cycles / TIMEBASE_CYCLES_PER_US, Timebase_Now_Cycles() - latency_cycles);
+		
+		state->echo_state = ECHO_DONE;
+	}
 	
+	// Edges outside of a measurement window are ignored
+}
+
+void WTIMER0B_Handler(void)
+{
+	Ultrasonic_Echo_Edge(1);
+}
+
+void WTIMER1A_Handler(void)
+{
+	Ultrasonic_Echo_Edge(2);
+}
+
+void WTIMER1B_Handler(void)
+{
+	Ultrasonic_Echo_Edge(3);
+}
+
+void WTIMER3A_Handler(void)
+{
+	Ultrasonic_Echo_Edge(6);
+}
+
+void WTIMER3B_Handler(void)
+{
+	Ultrasonic_Echo_Edge(7);
+}
+
+void WTIMER4A_Handler(void)
+{
+	Ultrasonic_Echo_Edge(8);
+}
+
+void WTIMER4B_Handler(void)
+{
+	Ultrasonic_Echo_Edge(9);
+}
@@ -1,21 +1,261 @@
 /**
- * @file PWM2_2.c
+ * @file Ultra_Sonic.h
  *
- * @brief Source file for the Ultra Soncic Sensor driver.
+ * @brief Header file for the Ultra Sonic Sensor (HC-SR04) array driver.
  *
- * @note This driver assumes that the system clock's frequency is 50 MHz.
+ * Up to ULTRASONIC_SENSOR_COUNT sensors range continuously in the background. Each one is
+ * described by a pin pair (see Ultrasonic_Sensor_Config): a trigger pin, which can be any
+ * GPIO pin, and an echo pin, which must be a wide timer capture pin (WTnCCPm).
  *
- * @note 
+ * - Timer A of Wide Timer 0 (WTIMER0) paces the pings. Time is divided into slots of
+ *   ULTRASONIC_SLOT_US, and each sensor belongs to one slot. At the start of a slot, the
+ *   time-out interrupt raises the trigger pins of the sensors of that slot, and the match
+ *   interrupt lowers them ULTRASONIC_TRIGGER_PULSE_US later. The slots are served round-robin.
  *
- * @author Jonathan Penaloza, Ricardo ZaragozaS
+ * - The echo pin of each sensor is captured by its own wide timer half in edge-time mode.
+ *   The pulse width is the difference between the falling and rising edge captures, so it is
+ *   exact to one system clock cycle regardless of interrupt latency.
+ *
+ * A slot lasts the longest accepted echo (ULTRASONIC_MAX_PULSE_US) plus a guard interval in
+ * which the late echoes of the slot die out, so the bursts of one slot are never heard by the
+ * sensors of the next one. Sensors that share a slot fire at the same time: they must face
+ * away from each other (front and rear, left and right). Each sensor pings once per round of
+ * slots, and no more often than ULTRASONIC_MIN_PING_PERIOD_MS: the ranging throughput grows
+ * with the number of sensors that share a slot, and a sensor without echo never delays another.
+ *
+ * Each ping produces exactly one sample. The interrupt service routines store the sample,
+ * together with the timebase count at which the echo ended, into the latest-sample slot of its
+ * sensor, which the application reads without blocking.
+ *
+ * @note The timing is derived from the system clock frequency (SYSTEM_CLOCK_HZ, see System_Clock.h).
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
  */
+
 #ifndef ULTRASONIC_H
 #define ULTRASONIC_H
-#include "Ultra_Sonic.h"
 
+#include "TM4C123GH6PM.h"
 #include <stdint.h>
 
+/**
+ * @brief The sensors of the array. The pins and the slot of each one are given by the
+ * sensor table in Ultra_Sonic.c, in the same order.
+ */
+typedef enum
+{
+	ULTRASONIC_FRONT,
+	ULTRASONIC_REAR,
+	ULTRASONIC_LEFT,
+	ULTRASONIC_RIGHT,
+	ULTRASONIC_SENSOR_COUNT
+} Ultrasonic_Sensor;
+
+/**
+ * @brief GPIO port indexes used in the sensor table
+ */
+#define ULTRASONIC_PORT_A 0
+#define ULTRASONIC_PORT_B 1
+#define ULTRASONIC_PORT_C 2
+#define ULTRASONIC_PORT_D 3
+#define ULTRASONIC_PORT_E 4
+#define ULTRASONIC_PORT_F 5
+
+/**
+ * @brief Pins and slot of a sensor.
+ *
+ * The echo pin selects the wide timer half that captures it: PC4 to PC7 (WT0CCP0 to WT1CCP1)
+ * and PD2 to PD5 (WT3CCP0 to WT4CCP1). PC4 is excluded, since Timer A of Wide Timer 0 paces the
+ * pings, and so are PD0 and PD1, which are tied to PB6 and PB7 (motor) on the LaunchPad.
+ */
+typedef struct
+{
+	/** Name printed in the statistics */
+	const char *name;
+	
+	/** Trigger pin: GPIO port index (ULTRASONIC_PORT_A to ULTRASONIC_PORT_F) and pin number */
+	uint8_t trigger_port;
+	uint8_t trigger_pin;
+	
+	/** Echo pin: ULTRASONIC_PORT_C or ULTRASONIC_PORT_D, and pin number */
+	uint8_t echo_port;
+	uint8_t echo_pin;
+	
+	/** Slot in which the sensor fires, from 0 to ULTRASONIC_MAX_SLOTS - 1 */
+	uint8_t slot;
+} Ultrasonic_Sensor_Config;
+
+/**
+ * @brief Largest number of slots in a round
+ */
+#define ULTRASONIC_MAX_SLOTS 4
+
+/**
+ * @brief Width of the trigger pulse in microseconds
+ */
+#define ULTRASONIC_TRIGGER_PULSE_US 10
+
+/**
+ * @brief Longest echo pulse accepted as a valid reading (about 4.3 m)
+ */
+#define ULTRASONIC_MAX_PULSE_US 25000
+
+/**
+ * @brief Time left after the longest echo for the late echoes of a slot to die out, in microseconds
+ */
+#define ULTRASONIC_GUARD_US 5000
+
+/**
+ * @brief Length of a slot in microseconds: the longest echo and the guard interval
+ */
+#define ULTRASONIC_SLOT_US (ULTRASONIC_MAX_PULSE_US + ULTRASONIC_GUARD_US)
+
+/**
+ * @brief Shortest time between two pings of the same sensor in milliseconds
+ *
+ * The HC-SR04 holds the echo pin high for up to 38 ms when no obstacle is in range,
+ * so a round lasts at least this long, even with a single slot.
+ */
+#define ULTRASONIC_MIN_PING_PERIOD_MS 60
+
+/**
+ * @brief Echo pulse width per centimeter of distance (round trip at 343 m/s)
+ */
+#define ULTRASONIC_US_PER_CM 58
+
+/**
+ * @brief A single ranging result.
+ */
+typedef struct
+{
+	/** Timebase count (see Timebase.h) at which the echo ended or the ping timed out */
+	uint64_t timestamp_cycles;
+	
+	/** Width of the echo pulse in microseconds, 0 if no echo was received */
+	uint32_t pulse_us;
+	
+	/** Distance to the obstacle in centimeters, 0 if no echo was received */
+	uint32_t distance_cm;
+	
+	/** Number of pings of the sensor completed since Ultrasonic_Init, 0 if no sample is available yet */
+	uint32_t sequence;
+	
+	/** 1 if an echo was received within ULTRASONIC_MAX_PULSE_US, 0 otherwise */
+	uint8_t valid;
+} Ultrasonic_Sample;
+
+/**
+ * @brief The Ultrasonic_Init function starts background ranging on every sensor of the table.
+ *
+ * This function configures the trigger pins as outputs and the echo pins as wide timer
+ * captures in edge-time mode, then starts the slot timer (Timer A of Wide Timer 0). A sensor
+ * whose echo pin has no usable capture is left out and never produces a sample.
+ * It also starts the timebase.
+ *
+ * @param None
+ *
+ * @return None
+ */
 void Ultrasonic_Init(void);
-uint32_t Ultrasonic_ReadPulse(void);
-uint32_t Ultrasonic_ReadDistanceCM(void);
-#endif
\ No newline at end of file
+
+/**
+ * @brief The Ultrasonic_Get_Config function returns the pins and slot of a sensor.
+ *
+ * @param sensor The sensor.
+ *
+ * @return Pointer to the entry of the sensor table.
+ */
+const Ultrasonic_Sensor_Config *Ultrasonic_Get_Config(Ultrasonic_Sensor sensor);
+
+/**
+ * @brief The Ultrasonic_Get_Ping_Period_US function returns the time between two pings of a sensor.
+ *
+ * It is the length of a round: the number of slots times ULTRASONIC_SLOT_US, and at least
+ * ULTRASONIC_MIN_PING_PERIOD_MS.
+ *
+ * @param None
+ *
+ * @return The ping period in microseconds.
+ */
+uint32_t Ultrasonic_Get_Ping_Period_US(void);
+
+/**
+ * @brief The Ultrasonic_ReadPulse function returns the echo pulse width of the latest sample of a sensor.
+ *
+ * This function does not block.
+ *
+ * @param sensor The sensor.
+ *
+ * @return The echo pulse width in microseconds, 0 if the latest ping received no echo.
+ */
+uint32_t Ultrasonic_ReadPulse(Ultrasonic_Sensor sensor);
+
+/**
+ * @brief The Ultrasonic_ReadDistanceCM function returns the distance of the latest sample of a sensor.
+ *
+ * This function does not block.
+ *
+ * @param sensor The sensor.
+ *
+ * @return The distance in centimeters, 0 if the latest ping received no echo.
+ */
+uint32_t Ultrasonic_ReadDistanceCM(Ultrasonic_Sensor sensor);
+
+/**
+ * @brief The Ultrasonic_Get_Sample function copies the latest sample of a sensor.
+ *
+ * The copy is taken with interrupts briefly disabled, so all fields belong to the same ping.
+ *
+ * @param sensor The sensor.
+ * @param sample Pointer to the structure that receives the latest sample.
+ *
+ * @return None
+ */
+void Ultrasonic_Get_Sample(Ultrasonic_Sensor sensor, Ultrasonic_Sample *sample);
+
+/**
+ * @brief The Ultrasonic_Set_Sample_Task function selects a task to release for every new sample of a sensor.
+ *
+ * The task is released with Scheduler_Signal from the interrupt service routine that stores
+ * the sample, so it can act on each ping as soon as it completes instead of polling.
+ *
+ * @param sensor The sensor.
+ * @param task_id The identifier returned by Scheduler_Add_Task, or -1 for none.
+ *
+ * @return None
+ */
+void Ultrasonic_Set_Sample_Task(Ultrasonic_Sensor sensor, int task_id);
+
+/**
+ * @brief The WTIMER0A_Handler function is the interrupt service routine for the slot timer.
+ *
+ * At the start of a slot (time-out), it reports the pings of the previous slot that received
+ * no echo, then raises the trigger pins of the new slot and arms their echo captures. At the
+ * match, ULTRASONIC_TRIGGER_PULSE_US later, it lowers the trigger pins.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void WTIMER0A_Handler(void);
+
+/**
+ * @brief The echo capture interrupt service routines, one for each wide timer half that can
+ * capture an echo pin.
+ *
+ * Each one records the rising edge capture of its sensor, and on the falling edge computes
+ * the pulse width and stores the completed sample.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void WTIMER0B_Handler(void);
+void WTIMER1A_Handler(void);
+void WTIMER1B_Handler(void);
+void WTIMER3A_Handler(void);
+void WTIMER3B_Handler(void);
+void WTIMER4A_Handler(void);
+void WTIMER4B_Handler(void);
+
+#endif
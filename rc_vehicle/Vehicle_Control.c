@@ -0,0 +1,503 @@
+/**
+ * @file Vehicle_Control.c
+ *
+ * @brief Source code for the vehicle control logic.
+ *
+ * The desired motion (command) and the motion applied to the PWM outputs
+ * (applied) are kept separately. The actuation task is the only code that
+ * writes the steering PWM register after initialization. The motor registers
+ * are written by the motion profile (the PWM0_0 interrupt), from the target of
+ * the speed task, and cut at once by the obstacle stops and the deadman.
+ *
+ * The command state is written by the serial commands (main loop), by
+ * Vehicle_Script_Step, which runs in the maneuver interrupt (Timer 2A), and by
+ * the obstacle stops of the sonar and actuation tasks. Every update that
+ * touches more than one field, or tests a field before changing it, runs with
+ * the interrupts disabled, and the actuation task works on a snapshot taken the
+ * same way, so it never applies half of a script step.
+ *
+ * Vehicle_Link_Lost runs in the deadman interrupt (Timer 1A). It does not touch
+ * the command state or the speed controller: it holds the speed controller
+ * output at 0 (Speed_Control_Hold) and stops the motion profile, and the next
+ * command releases the hold through Vehicle_Link_Restored.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Vehicle_Control.h"
+#include "Scheduler.h"
+#include "Motion_Profile.h"
+#include "Speed_Control.h"
+#include "PWM2_2.h"
+#include "Ultra_Sonic.h"
+#include "Timebase.h"
+#include "Latency.h"
+#include "Parameters.h"
+
+// Desired motion, written by the command sources
+typedef struct
+{
+	Vehicle_Direction direction;
+	uint16_t speed_mm_s;
+	int8_t steering_deg;
+} Vehicle_Command;
+
+static Vehicle_Command command;
+
+// Steering currently applied to the PWM output. The motor output is owned by
+// the speed controller and the motion profile generator (see Speed_Control.h)
+static int8_t applied_steering_deg;
+
+// Obstacle state, maintained by the sonar task
+static uint32_t last_distance_cm;
+static uint8_t obstacle_detected;
+static uint32_t obstacle_stop_count;
+
+// Filtered range, updated by the sonar task for every new sample
+static Sonar_Filter sonar_filter;
+static uint32_t last_sample_sequence;
+
+static int actuation_task_id = -1;
+
+// Copies the command state, which Vehicle_Script_Step can change from the maneuver interrupt
+static void Vehicle_Command_Snapshot(Vehicle_Command *snapshot)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq();
+	*snapshot = command;
+	__set_PRIMASK(primask);
+}
+
+// Records the direction and the speed together
+static void Vehicle_Command_Motion(Vehicle_Direction direction, uint16_t speed_mm_s)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq();
+	command.direction = direction;
+	command.speed_mm_s = speed_mm_s;
+	__set_PRIMASK(primask);
+}
+
+// Signed wheel speed for the commanded motion
+static int32_t Vehicle_Speed_Target(const Vehicle_Command *snapshot)
+{
+	if (snapshot->direction == VEHICLE_FORWARD)
+	{
+		return snapshot->speed_mm_s;
+	}
+	
+	if (snapshot->direction == VEHICLE_REVERSE)
+	{
+		return -(int32_t)snapshot->speed_mm_s;
+	}
+	
+	return 0;
+}
+
+// Wheel speed in centimeters per second for a throttle in percent of VEHICLE_MAX_SPEED_MM_S
+static int16_t Vehicle_Throttle_Speed(int8_t throttle_percent)
+{
+	int32_t percent = throttle_percent;
+	
+	if (percent > 100)
+	{
+		percent = 100;
+	}
+	else if (percent < -100)
+	{
+		percent = -100;
+	}
+	
+	return (int16_t)((percent * (VEHICLE_MAX_SPEED_MM_S / 10)) / 100);
+}
+
+// Records the desired wheel speed, without releasing the actuation task
+static void Vehicle_Command_Speed(int16_t speed_cm_s)
+{
+	int32_t magnitude = (speed_cm_s < 0) ? -speed_cm_s : speed_cm_s;
+	
+	if (magnitude > (VEHICLE_MAX_SPEED_MM_S / 10))
+	{
+		magnitude = VEHICLE_MAX_SPEED_MM_S / 10;
+	}
+	
+	if (magnitude == 0)
+	{
+		command.direction = VEHICLE_STOPPED;
+	}
+	else
+	{
+		Vehicle_Command_Motion((speed_cm_s > 0) ? VEHICLE_FORWARD : VEHICLE_REVERSE, (uint16_t)(magnitude * 10));
+	}
+}
+
+// Records the desired steering angle, without releasing the actuation task
+static void Vehicle_Command_Steering(int8_t degrees)
+{
+	if (degrees > VEHICLE_STEERING_MAX_DEG)
+	{
+		degrees = VEHICLE_STEERING_MAX_DEG;
+	}
+	else if (degrees < -VEHICLE_STEERING_MAX_DEG)
+	{
+		degrees = -VEHICLE_STEERING_MAX_DEG;
+	}
+	
+	command.steering_deg = degrees;
+}
+
+// Obstacle stops skip the ramp: the motor output is cut at once. Only forward motion is
+// stopped; returns 1 if it was
+static uint8_t Vehicle_Obstacle_Stop(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint8_t stopped = 0;
+	
+	// A script step can change the direction between the test and the stop
+	__disable_irq();
+	
+	if (command.direction == VEHICLE_FORWARD)
+	{
+		command.direction = VEHICLE_STOPPED;
+		stopped = 1;
+	}
+	
+	__set_PRIMASK(primask);
+	
+	if (stopped)
+	{
+		obstacle_stop_count++;
+		Speed_Control_Stop_Now();
+	}
+	
+	return stopped;
+}
+
+// Closing speed for the safety checks. The wheel speed follows the motor at once, while the
+// filtered range rate lags it by a few pings; the larger of the two is used. The range rate
+// still covers an obstacle that moves towards the vehicle, and an encoder fault
+static int32_t Vehicle_Closing_Speed_MM_S(void)
+{
+	Speed_Control_Status speed;
+	int32_t closing_speed_mm_s = Sonar_Filter_Closing_Speed_MM_S(&sonar_filter);
+	
+	Speed_Control_Get_Status(&speed);
+	
+	if (!speed.encoder_fault && (speed.measured_mm_s > closing_speed_mm_s))
+	{
+		closing_speed_mm_s = speed.measured_mm_s;
+	}
+	
+	return closing_speed_mm_s;
+}
+
+// Distance to the obstacle now for the safety checks: the smaller of the filtered estimate
+// and of the latest gated sample, which has no median delay (see Sonar_Filter_Latest_MM)
+static uint32_t Vehicle_Obstacle_MM(int32_t closing_speed_mm_s)
+{
+	uint64_t now_cycles = Timebase_Now_Cycles();
+	uint32_t predicted_mm = Sonar_Filter_Predict_MM(&sonar_filter, now_cycles);
+	uint32_t latest_mm = Sonar_Filter_Latest_MM(&sonar_filter, now_cycles, closing_speed_mm_s);
+	
+	return (latest_mm < predicted_mm) ? latest_mm : predicted_mm;
+}
+
+// Largest forward speed that can still be stopped before the obstacle: at that speed, the
+// time to collision stays above the largest threshold until the stop distance. It does not
+// depend on the measured closing speed, which is about 0 when the vehicle sets off
+static int32_t Vehicle_Forward_Limit(void)
+{
+	uint32_t predicted_mm;
+	uint32_t stop_mm = (uint32_t)parameters.stop_distance_cm * 10;
+	uint32_t ttc_ms = (parameters.ttc_max_ms > parameters.ttc_min_ms) ? parameters.ttc_max_ms : parameters.ttc_min_ms;
+	uint32_t limit_mm_s;
+	
+	if (Sonar_Filter_Get_State(&sonar_filter) == SONAR_FILTER_LOST)
+	{
+		return 0;
+	}
+	
+	if (!Sonar_Filter_Has_Estimate(&sonar_filter) || (ttc_ms == 0))
+	{
+		return VEHICLE_MAX_SPEED_MM_S;
+	}
+	
+	predicted_mm = Vehicle_Obstacle_MM(Vehicle_Closing_Speed_MM_S());
+	
+	if (predicted_mm <= stop_mm)
+	{
+		return 0;
+	}
+	
+	limit_mm_s = ((predicted_mm - stop_mm) * 1000) / ttc_ms;
+	
+	return (limit_mm_s < VEHICLE_MAX_SPEED_MM_S) ? (int32_t)limit_mm_s : VEHICLE_MAX_SPEED_MM_S;
+}
+
+static uint8_t Vehicle_Path_Blocked(void)
+{
+	uint32_t predicted_mm;
+	int32_t closing_speed_mm_s;
+	uint32_t threshold_ms;
+	
+	// The echo was lost close to an obstacle
+	if (Sonar_Filter_Get_State(&sonar_filter) == SONAR_FILTER_LOST)
+	{
+		return 1;
+	}
+	
+	if (!Sonar_Filter_Has_Estimate(&sonar_filter))
+	{
+		return 0;
+	}
+	
+	// Distance now, extrapolated from the latest samples
+	closing_speed_mm_s = Vehicle_Closing_Speed_MM_S();
+	predicted_mm = Vehicle_Obstacle_MM(closing_speed_mm_s);
+	
+	if (predicted_mm < ((uint32_t)parameters.stop_distance_cm * 10))
+	{
+		return 1;
+	}
+	
+	if (closing_speed_mm_s <= 0)
+	{
+		return 0;
+	}
+	
+	// Faster commands need more time to stop. The thresholds are parameters, so the
+	// interpolation is signed: ttc_max_ms may be set below ttc_min_ms
+	threshold_ms = parameters.ttc_min_ms + (int32_t)(((int64_t)((int32_t)parameters.ttc_max_ms - parameters.ttc_min_ms) * command.speed_mm_s) / VEHICLE_MAX_SPEED_MM_S);
+	
+	// Time to collision (predicted_mm / closing_speed_mm_s) below the threshold
+	return ((uint64_t)predicted_mm * 1000) < ((uint64_t)closing_speed_mm_s * threshold_ms);
+}
+
+static void Vehicle_Sonar_Task(void)
+{
+	Ultrasonic_Sample sample;
+	int32_t limit_mm_s;
+	
+	Ultrasonic_Get_Sample(ULTRASONIC_FRONT, &sample);
+	
+	// Each sample is used once. Between samples, the periodic runs refresh the extrapolation
+	if (sample.sequence != last_sample_sequence)
+	{
+		last_sample_sequence = sample.sequence;
+		Sonar_Filter_Update(&sonar_filter, &sample);
+		last_distance_cm = Sonar_Filter_Predict_MM(&sonar_filter, sample.timestamp_cycles) / 10;
+	}
+	
+	// The sensor faces forward, so only forward motion is stopped. Once stopped, the vehicle
+	// is at rest and the closing speed no longer shows the danger: forward motion stays
+	// blocked until the obstacle is out of range, or far enough to stop from the cruise speed
+	if (Vehicle_Path_Blocked())
+	{
+		obstacle_detected = 1;
+	}
+	else if (obstacle_detected)
+	{
+		limit_mm_s = Vehicle_Forward_Limit();
+		
+		if ((Sonar_Filter_Get_State(&sonar_filter) == SONAR_FILTER_NO_TARGET) ||
+			((limit_mm_s > 0) && (limit_mm_s >= parameters.cruise_speed_mm_s)))
+		{
+			obstacle_detected = 0;
+		}
+	}
+	
+	if (obstacle_detected && Vehicle_Obstacle_Stop())
+	{
+		Scheduler_Signal(actuation_task_id);
+	}
+}
+
+static void Vehicle_Actuation_Task(void)
+{
+	uint8_t registers_written = 0;
+	uint8_t speed_target_changed = 0;
+	Vehicle_Command snapshot;
+	int32_t target_mm_s;
+	int32_t limit_mm_s;
+	
+	Latency_Command_Dispatched();
+	
+	if (obstacle_detected)
+	{
+		Vehicle_Obstacle_Stop();
+	}
+	
+	Vehicle_Command_Snapshot(&snapshot);
+	target_mm_s = Vehicle_Speed_Target(&snapshot);
+	
+	// Forward motion is capped to a speed that can be stopped in the remaining distance. The
+	// cap is refreshed at every periodic run, so the vehicle slows down as it gets closer
+	if (target_mm_s > 0)
+	{
+		limit_mm_s = Vehicle_Forward_Limit();
+		
+		if (target_mm_s > limit_mm_s)
+		{
+			target_mm_s = limit_mm_s;
+		}
+	}
+	
+	// The speed controller drives the motor towards the new target
+	if (target_mm_s != Speed_Control_Get_Target())
+	{
+		Speed_Control_Set_Target(target_mm_s);
+		speed_target_changed = 1;
+		registers_written = 1;
+	}
+	
+	if (snapshot.steering_deg != applied_steering_deg)
+	{
+		PWM2_2_Set_Angle(snapshot.steering_deg);
+		applied_steering_deg = snapshot.steering_deg;
+		registers_written = 1;
+	}
+	
+	// Only commands that changed the outputs are timed. A speed change is timed
+	// up to the motor register write (see Latency.h)
+	if (registers_written)
+	{
+		Latency_Command_Applied(speed_target_changed);
+	}
+	else
+	{
+		Latency_Command_Discarded();
+	}
+}
+
+void Vehicle_Control_Init(void)
+{
+	command.direction = VEHICLE_STOPPED;
+	command.speed_mm_s = parameters.cruise_speed_mm_s;
+	command.steering_deg = 0;
+	
+	// PWM2_2_Init starts the servo centered
+	applied_steering_deg = 0;
+	
+	last_distance_cm = 0;
+	obstacle_detected = 0;
+	obstacle_stop_count = 0;
+	
+	Sonar_Filter_Init(&sonar_filter);
+	last_sample_sequence = 0;
+	
+	Speed_Control_Stop_Now();
+	
+	Ultrasonic_Set_Sample_Task(ULTRASONIC_FRONT, Scheduler_Add_Task("sonar", Vehicle_Sonar_Task,
+		VEHICLE_SONAR_TASK_PERIOD_US, VEHICLE_SONAR_TASK_PERIOD_US));
+	actuation_task_id = Scheduler_Add_Task("actuation", Vehicle_Actuation_Task,
+		VEHICLE_ACTUATION_TASK_PERIOD_US, VEHICLE_ACTUATION_TASK_DEADLINE_US);
+}
+
+void Vehicle_Forward(void)
+{
+	Latency_Command_Parsed();
+	
+	Vehicle_Command_Motion(VEHICLE_FORWARD, parameters.cruise_speed_mm_s);
+	Scheduler_Signal(actuation_task_id);
+}
+
+void Vehicle_Reverse(void)
+{
+	Latency_Command_Parsed();
+	
+	Vehicle_Command_Motion(VEHICLE_REVERSE, parameters.cruise_speed_mm_s);
+	Scheduler_Signal(actuation_task_id);
+}
+
+void Vehicle_Stop(void)
+{
+	Latency_Command_Parsed();
+	
+	command.direction = VEHICLE_STOPPED;
+	Scheduler_Signal(actuation_task_id);
+}
+
+void Vehicle_Drive(int8_t throttle_percent)
+{
+	Vehicle_Drive_Speed(Vehicle_Throttle_Speed(throttle_percent));
+}
+
+void Vehicle_Drive_Speed(int16_t speed_cm_s)
+{
+	Latency_Command_Parsed();
+	
+	Vehicle_Command_Speed(speed_cm_s);
+	Scheduler_Signal(actuation_task_id);
+}
+
+void Vehicle_Steer_Degrees(int8_t degrees)
+{
+	Latency_Command_Parsed();
+	
+	Vehicle_Command_Steering(degrees);
+	Scheduler_Signal(actuation_task_id);
+}
+
+void Vehicle_Script_Step(int8_t throttle_percent, int8_t steering_deg)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	// Called from the maneuver interrupt, but also from the maneuver task when a script
+	// ends: the motion and the steering of the step are recorded together
+	__disable_irq();
+	Vehicle_Command_Speed(Vehicle_Throttle_Speed(throttle_percent));
+	Vehicle_Command_Steering(steering_deg);
+	__set_PRIMASK(primask);
+	
+	Scheduler_Signal(actuation_task_id);
+}
+
+void Vehicle_Link_Lost(uint8_t cut)
+{
+	// The speed task can no longer hand a duty cycle to the motion profile
+	Speed_Control_Hold();
+	
+	if (cut)
+	{
+		Motion_Profile_Stop_Now();
+	}
+	else
+	{
+		// The ramp starts now, without waiting for the speed task
+		Motion_Profile_Set_Target(0);
+	}
+}
+
+void Vehicle_Link_Restored(void)
+{
+	if (!Speed_Control_Output_Held())
+	{
+		return;
+	}
+	
+	// The motion commanded before the loss is not resumed
+	command.direction = VEHICLE_STOPPED;
+	Speed_Control_Release();
+}
+
+void Vehicle_Get_Status(Vehicle_Status *status)
+{
+	int32_t motor_duty = Motion_Profile_Get_Duty();
+	Speed_Control_Status speed;
+	
+	Speed_Control_Get_Status(&speed);
+	
+	status->direction = (motor_duty > 0) ? VEHICLE_FORWARD : ((motor_duty < 0) ? VEHICLE_REVERSE : VEHICLE_STOPPED);
+	status->motor_duty = (uint16_t)((motor_duty < 0) ? -motor_duty : motor_duty);
+	status->servo_duty = PWM2_2_Angle_Duty(applied_steering_deg);
+	status->steering_deg = applied_steering_deg;
+	status->speed_mm_s = speed.measured_mm_s;
+	status->encoder_fault = speed.encoder_fault;
+	status->distance_cm = last_distance_cm;
+	status->closing_speed_mm_s = Sonar_Filter_Closing_Speed_MM_S(&sonar_filter);
+	status->sonar_state = Sonar_Filter_Get_State(&sonar_filter);
+	status->obstacle_detected = obstacle_detected;
+	status->obstacle_stop_count = obstacle_stop_count;
+}
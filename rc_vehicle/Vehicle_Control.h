@@ -0,0 +1,275 @@
+/**
+ * @file Vehicle_Control.h
+ *
+ * @brief Header file for the vehicle control logic.
+ *
+ * The command sources (serial commands and maneuver scripts) only record the desired motion
+ * with the Vehicle_Forward, Vehicle_Reverse, Vehicle_Stop, Vehicle_Drive, Vehicle_Drive_Speed,
+ * Vehicle_Steer_Degrees and Vehicle_Script_Step functions. Motion commands are wheel speeds.
+ * Two scheduler tasks then act on it:
+ *
+ * - The sonar task runs for every new sample of the front ultrasonic sensor. It feeds the
+ *   sample to the range filter (see Sonar_Filter.h), which estimates the distance and the
+ *   closing speed from successive timestamped samples, and stops forward motion when the time to
+ *   collision drops below a threshold that grows with the commanded speed,
+ *   or when the obstacle is closer than VEHICLE_STOP_DISTANCE_CM. The filtered estimate lags
+ *   the vehicle while it accelerates, so these checks take the smaller of the filtered
+ *   distance and of the latest gated sample (Sonar_Filter_Latest_MM), and the larger of the
+ *   filtered closing speed and of the wheel speed. Fast approaches
+ *   therefore start braking far from the obstacle, while a slow approach may creep close.
+ *   Forward motion is also stopped when the filter loses the echo of a near obstacle.
+ *   After a stop, forward commands are refused until the obstacle is out of range, or far
+ *   enough for the cruise speed to be stopped in time (see below): at rest, the closing
+ *   speed is 0 and no longer shows the danger.
+ *
+ * - The actuation task hands the desired wheel speed to the speed controller (see
+ *   Speed_Control.h), which holds it with the wheel encoder feedback through the motor ramp
+ *   (see Motion_Profile.h), and writes the steering servo (PWM2_2). It also runs
+ *   periodically, to cap the forward speed to the one whose time to collision stays above
+ *   the largest threshold until VEHICLE_STOP_DISTANCE_CM, so a forward command given close to
+ *   an obstacle only creeps towards it. Obstacle stops bypass the ramp and cut the motor
+ *   output at once.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef VEHICLE_CONTROL_H
+#define VEHICLE_CONTROL_H
+
+#include "Sonar_Filter.h"
+#include "PWM2_2.h"
+#include "System_Clock.h"
+#include <stdint.h>
+
+/**
+ * @brief PWM frequency shared by the motor and the steering servo (20 ms period)
+ */
+#define VEHICLE_PWM_HZ 50
+
+/**
+ * @brief PWM period constant in PWM clock cycles (50000 at 2.5 MHz)
+ */
+#define VEHICLE_PWM_PERIOD (SYSTEM_CLOCK_PWM_HZ / VEHICLE_PWM_HZ)
+
+/**
+ * @brief Wheel speed used by the forward and reverse commands, and fastest commanded speed,
+ * in millimeters per second. The cruise speed is the default of the cruise_mm_s parameter
+ * (see Parameters.h).
+ */
+#define VEHICLE_CRUISE_SPEED_MM_S 750
+#define VEHICLE_MAX_SPEED_MM_S 1500
+
+/**
+ * @brief Largest motor duty cycle. The compare value must stay below the PWM load value
+ */
+#define VEHICLE_MOTOR_MAX_DUTY (VEHICLE_PWM_PERIOD - 1)
+
+/**
+ * @brief Steering angle, in degrees, that corresponds to full left (negative) or full right (positive).
+ * The servo calibration is in PWM2_2.h.
+ */
+#define VEHICLE_STEERING_MAX_DEG PWM2_2_SERVO_MAX_DEG
+
+/**
+ * @brief Forward motion is stopped when an obstacle is closer than this distance, at any speed.
+ * Default of the stop_cm parameter (see Parameters.h).
+ */
+#define VEHICLE_STOP_DISTANCE_CM 5
+
+/**
+ * @brief Time-to-collision thresholds in milliseconds, at a commanded speed of 0 and of VEHICLE_MAX_SPEED_MM_S.
+ *
+ * Forward motion is stopped when the obstacle would be reached sooner than the threshold,
+ * which is interpolated linearly on the commanded speed. The threshold must cover the
+ * time between two samples plus the time the vehicle takes to come to rest, which both
+ * grow with speed. Defaults of the ttc_min_ms and ttc_max_ms parameters (see Parameters.h).
+ */
+#define VEHICLE_TTC_MIN_MS 250
+#define VEHICLE_TTC_MAX_MS 450
+
+/**
+ * @brief Period and deadline of the sonar task in microseconds.
+ * The task is also released immediately by every new ultrasonic sample.
+ */
+#define VEHICLE_SONAR_TASK_PERIOD_US 10000
+
+/**
+ * @brief Period and deadline of the actuation task in microseconds.
+ * The task is also released immediately whenever the desired motion changes.
+ */
+#define VEHICLE_ACTUATION_TASK_PERIOD_US 20000
+#define VEHICLE_ACTUATION_TASK_DEADLINE_US 1000
+
+/**
+ * @brief Direction of travel
+ */
+typedef enum
+{
+	VEHICLE_STOPPED,
+	VEHICLE_FORWARD,
+	VEHICLE_REVERSE
+} Vehicle_Direction;
+
+/**
+ * @brief Snapshot of the vehicle state.
+ */
+typedef struct
+{
+	/** Direction currently applied to the motor, which lags the command during a ramp */
+	Vehicle_Direction direction;
+	
+	/** Motor duty cycle currently applied to PWM0_0 */
+	uint16_t motor_duty;
+	
+	/** Steering duty cycle currently applied to PWM2_2 */
+	uint16_t servo_duty;
+	
+	/** Steering angle currently applied, in degrees, negative to the left */
+	int8_t steering_deg;
+	
+	/** Measured wheel speed in millimeters per second, positive forward */
+	int32_t speed_mm_s;
+	
+	/** 1 while the wheel encoder is considered disconnected (see Speed_Control.h) */
+	uint8_t encoder_fault;
+	
+	/** Filtered distance at the latest ultrasonic sample in centimeters, 0 without an estimate */
+	uint32_t distance_cm;
+	
+	/** Estimated closing speed in millimeters per second, positive when the obstacle gets closer */
+	int32_t closing_speed_mm_s;
+	
+	/** Validity of the filtered distance */
+	Sonar_Filter_State sonar_state;
+	
+	/** 1 while forward motion is blocked by an obstacle */
+	uint8_t obstacle_detected;
+	
+	/** Number of times forward motion was stopped because of an obstacle */
+	uint32_t obstacle_stop_count;
+} Vehicle_Status;
+
+/**
+ * @brief The Vehicle_Control_Init function initializes the vehicle state and registers its tasks.
+ *
+ * The motor starts stopped. Scheduler_Init, the PWM drivers, Motion_Profile_Init,
+ * Speed_Control_Init and Ultrasonic_Init must have been called before this function.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Vehicle_Control_Init(void);
+
+/**
+ * @brief The Vehicle_Forward function requests forward motion.
+ *
+ * The request is ignored by the actuation task while an obstacle is detected.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Vehicle_Forward(void);
+
+/**
+ * @brief The Vehicle_Reverse function requests reverse motion.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Vehicle_Reverse(void);
+
+/**
+ * @brief The Vehicle_Stop function requests the motor to stop.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Vehicle_Stop(void);
+
+/**
+ * @brief The Vehicle_Drive function requests proportional motion.
+ *
+ * @param throttle_percent Signed throttle from -100 (full reverse) to 100 (full forward), in percent
+ *                         of VEHICLE_MAX_SPEED_MM_S. 0 stops the motor. Values outside the range are clamped.
+ *
+ * @return None
+ */
+void Vehicle_Drive(int8_t throttle_percent);
+
+/**
+ * @brief The Vehicle_Drive_Speed function requests a wheel speed.
+ *
+ * @param speed_cm_s Signed speed in centimeters per second, positive forward. 0 stops the motor.
+ *                   Values beyond VEHICLE_MAX_SPEED_MM_S are clamped.
+ *
+ * @return None
+ */
+void Vehicle_Drive_Speed(int16_t speed_cm_s);
+
+/**
+ * @brief The Vehicle_Steer_Degrees function requests a steering angle.
+ *
+ * The angle is converted to a pulse width by the calibrated table of the servo driver (see PWM2_2.h).
+ *
+ * @param degrees Steering angle from -VEHICLE_STEERING_MAX_DEG (full left) to
+ *                VEHICLE_STEERING_MAX_DEG (full right). Values outside the range are clamped.
+ *
+ * @return None
+ */
+void Vehicle_Steer_Degrees(int8_t degrees);
+
+/**
+ * @brief The Vehicle_Script_Step function requests the motion of a maneuver script step.
+ *
+ * It is called by the maneuver timer interrupt (see Maneuver.h). Like the other commands, the
+ * motion is applied by the actuation task, so a step that drives forward is still stopped by
+ * an obstacle. The speed and the steering of the step are recorded with the interrupts
+ * disabled, so the actuation task applies both or neither. The request is not timed by the latency statistics (see Latency.h).
+ *
+ * @param throttle_percent Signed throttle, as for Vehicle_Drive.
+ * @param steering_deg Steering angle, as for Vehicle_Steer_Degrees.
+ *
+ * @return None
+ */
+void Vehicle_Script_Step(int8_t throttle_percent, int8_t steering_deg);
+
+/**
+ * @brief The Vehicle_Link_Lost function stops the vehicle because the command link was lost.
+ *
+ * It is called by the deadman interrupt (see Deadman.h), so it does not rely on the scheduler
+ * tasks: the speed controller output is held at 0 (Speed_Control_Hold), and the motor is
+ * either ramped down by the motion profile (the PWM0_0 interrupt) or cut at once. The hold
+ * lasts until the next command (Vehicle_Link_Restored).
+ *
+ * @param cut 1 to cut the motor output at once, 0 to ramp it down.
+ *
+ * @return None
+ */
+void Vehicle_Link_Lost(uint8_t cut);
+
+/**
+ * @brief The Vehicle_Link_Restored function ends the hold of Vehicle_Link_Lost, if any.
+ *
+ * It is called by Deadman_Feed for every valid command, before the command is executed. The
+ * commanded motion is cleared, so the vehicle stays at rest until a new motion command.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Vehicle_Link_Restored(void);
+
+/**
+ * @brief The Vehicle_Get_Status function copies the current vehicle state.
+ *
+ * @param status Pointer to the structure that receives the state.
+ *
+ * @return None
+ */
+void Vehicle_Get_Status(Vehicle_Status *status);
+
+#endif
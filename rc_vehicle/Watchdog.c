@@ -0,0 +1,111 @@
+/**
+ * @file Watchdog.c
+ *
+ * @brief Source code for the hardware watchdog (Watchdog Timer 0).
+ *
+ * The configuration follows the Initialization and Configuration steps of the Watchdog Timers
+ * section in the TM4C123G Microcontroller Datasheet. Watchdog Timer 0 runs on the system clock,
+ * so, unlike Watchdog Timer 1, its registers can be written without waiting for WRC.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Watchdog.h"
+#include "Scheduler.h"
+#include "Motion_Profile.h"
+#include "Timebase.h"
+
+// INTEN (Bit 0) and RESEN (Bit 1) bits in the CTL register
+#define WATCHDOG_CTL_INTEN_BIT_MASK 0x01
+#define WATCHDOG_CTL_RESEN_BIT_MASK 0x02
+
+// STALL bit (Bit 8) in the TEST register
+#define WATCHDOG_TEST_STALL_BIT_MASK 0x100
+
+// Writing this key to the LOCK register unlocks the other registers; any other value locks them
+#define WATCHDOG_UNLOCK_KEY 0x1ACCE551
+
+// WDT0 bit (Bit 3) in the RESC register
+#define WATCHDOG_RESC_WDT0_BIT_MASK 0x08
+
+#define WATCHDOG_TIMEOUT_CYCLES TIMEBASE_MS_TO_CYCLES(WATCHDOG_TIMEOUT_MS)
+
+static uint8_t watchdog_reset;
+static volatile uint8_t watchdog_expired;
+static volatile uint32_t watchdog_timeout_count;
+
+static void Watchdog_Task(void)
+{
+	// Reload the counter and clear the time-out interrupt by writing any value to the ICR register
+	WATCHDOG0->LOCK = WATCHDOG_UNLOCK_KEY;
+	WATCHDOG0->ICR = 0;
+	WATCHDOG0->LOCK = 0;
+	
+	// The loop has recovered from a stall: arm the interrupt again
+	if (watchdog_expired)
+	{
+		watchdog_expired = 0;
+		NVIC_EnableIRQ(WATCHDOG0_IRQn);
+	}
+}
+
+void Watchdog_Init(void)
+{
+	// Record and clear the reset cause
+	watchdog_reset = (SYSCTL->RESC & WATCHDOG_RESC_WDT0_BIT_MASK) != 0;
+	SYSCTL->RESC &= ~WATCHDOG_RESC_WDT0_BIT_MASK;
+	
+	watchdog_expired = 0;
+	watchdog_timeout_count = 0;
+	
+	// Enable the clock to Watchdog Timer 0 by setting the
+	// R0 bit (Bit 0) in the RCGCWD register
+	SYSCTL->RCGCWD |= 0x01;
+	
+	// Wait until Watchdog Timer 0 is ready to be accessed
+	while ((SYSCTL->PRWD & 0x01) == 0);
+	
+	WATCHDOG0->LOCK = WATCHDOG_UNLOCK_KEY;
+	
+	// Load the time-out interval in system clock cycles
+	WATCHDOG0->LOAD = (uint32_t)WATCHDOG_TIMEOUT_CYCLES;
+	
+	// Stop counting while a debugger halts the CPU by setting the STALL bit (Bit 8) in the TEST register
+	WATCHDOG0->TEST |= WATCHDOG_TEST_STALL_BIT_MASK;
+	
+	// Reset the microcontroller at the second time-out by setting the RESEN bit (Bit 1),
+	// then start the counter and its interrupt by setting the INTEN bit (Bit 0) in the CTL register.
+	// Once set, INTEN can only be cleared by a reset
+	WATCHDOG0->CTL |= WATCHDOG_CTL_RESEN_BIT_MASK;
+	WATCHDOG0->CTL |= WATCHDOG_CTL_INTEN_BIT_MASK;
+	
+	WATCHDOG0->LOCK = 0;
+	
+	// The motor must be cut even if a handler is stuck
+	NVIC_SetPriority(WATCHDOG0_IRQn, 0);
+	NVIC_EnableIRQ(WATCHDOG0_IRQn);
+	
+	Scheduler_Add_Task("watchdog", Watchdog_Task, WATCHDOG_FEED_PERIOD_US, WATCHDOG_FEED_PERIOD_US);
+}
+
+int Watchdog_Caused_Reset(void)
+{
+	return watchdog_reset;
+}
+
+uint32_t Watchdog_Get_Timeout_Count(void)
+{
+	return watchdog_timeout_count;
+}
+
+void WDT0_Handler(void)
+{
+	Motion_Profile_Stop_Now();
+	
+	watchdog_timeout_count++;
+	watchdog_expired = 1;
+	
+	// The interrupt is left pending so that the next time-out resets the microcontroller.
+	// Disable it in the NVIC until the loop reloads the watchdog, instead of taking it again
+	NVIC_DisableIRQ(WATCHDOG0_IRQn);
+}
@@ -0,0 +1,83 @@
+/**
+ * @file Watchdog.h
+ *
+ * @brief Header file for the hardware watchdog (Watchdog Timer 0).
+ *
+ * Watchdog Timer 0 counts down WATCHDOG_TIMEOUT_MS on the system clock. A scheduler task
+ * reloads it every WATCHDOG_FEED_PERIOD_US, so it only expires when the scheduler loop stops
+ * dispatching: a task that never returns, or interrupts that leave no time to the loop.
+ *
+ * - At the first time-out, the WDT0 interrupt cuts the motor output at once.
+ * - At the second time-out, the watchdog resets the microcontroller.
+ *
+ * The registers are locked between two reloads, and the watchdog is stalled while a debugger
+ * halts the CPU.
+ *
+ * @note Idle_Init must be called after Watchdog_Init, so that the watchdog keeps its clock
+ * while the CPU sleeps (see Idle.h).
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief Time without a reload after which the motor is cut, in milliseconds.
+ * The microcontroller is reset after twice this time.
+ */
+#define WATCHDOG_TIMEOUT_MS 250
+
+/**
+ * @brief Period and deadline of the task that reloads the watchdog, in microseconds
+ */
+#define WATCHDOG_FEED_PERIOD_US 50000
+
+/**
+ * @brief The Watchdog_Init function starts Watchdog Timer 0 and registers the task that reloads it.
+ *
+ * It also records whether the previous reset was caused by the watchdog.
+ * Scheduler_Init and Motion_Profile_Init must have been called before this function.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Watchdog_Init(void);
+
+/**
+ * @brief The Watchdog_Caused_Reset function reports the cause of the latest reset.
+ *
+ * @param None
+ *
+ * @return 1 if the microcontroller was reset by the watchdog, 0 otherwise.
+ */
+int Watchdog_Caused_Reset(void);
+
+/**
+ * @brief The Watchdog_Get_Timeout_Count function returns the number of first time-outs.
+ *
+ * Each one means that the scheduler loop stalled for WATCHDOG_TIMEOUT_MS, and cut the motor.
+ *
+ * @param None
+ *
+ * @return The number of time-outs since Watchdog_Init.
+ */
+uint32_t Watchdog_Get_Timeout_Count(void);
+
+/**
+ * @brief The WDT0_Handler function is the interrupt service routine of the watchdog.
+ *
+ * It cuts the motor output and leaves the interrupt pending, so that the watchdog resets the
+ * microcontroller at the next time-out unless the loop reloads it first.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void WDT0_Handler(void);
+
+#endif
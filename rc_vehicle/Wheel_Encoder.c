@@ -0,0 +1,138 @@
+/**
+ * @file Wheel_Encoder.c
+ *
+ * @brief Source file for the wheel encoder driver.
+ *
+ * QEI0 is clocked by the system clock, which also times the velocity windows.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Wheel_Encoder.h"
+#include "Timebase.h"
+#include "Scheduler.h"
+
+// Velocity timer interrupt bit (INTTIMER, Bit 1) in the INTEN, RIS and ISC registers
+#define WHEEL_ENCODER_TIMER_BIT_MASK 0x02
+
+// Direction bit (Bit 1) in the STAT register: set while the count decreases
+#define WHEEL_ENCODER_DIRECTION_BIT_MASK 0x02
+
+#define WHEEL_ENCODER_WINDOW_CYCLES ((uint32_t)(TIMEBASE_CYCLES_PER_US * 1000000UL / WHEEL_ENCODER_SAMPLE_HZ))
+
+// Value of the GPIOLOCK register that unlocks the GPIOCR register
+#define WHEEL_ENCODER_GPIO_UNLOCK_KEY 0x4C4F434B
+
+// Number of windows completed since initialization
+static uint32_t window_count;
+
+// Latest sample, written only by the QEI0 interrupt service routine
+static Wheel_Encoder_Sample latest_sample;
+
+// Task released for every new sample, -1 for none
+static int sample_task_id = -1;
+
+void Wheel_Encoder_Init(void)
+{
+	// The sample timestamps are taken from the timebase
+	Timebase_Init();
+	
+	// Enable the clock to Port D by setting the
+	// R3 bit (Bit 3) in the RCGCGPIO register
+	SYSCTL->RCGCGPIO |= 0x08;
+	
+	// Enable the clock to QEI Module 0 by setting the
+	// R0 bit (Bit 0) in the RCGCQEI register
+	SYSCTL->RCGCQEI |= 0x01;
+	
+	// Wait until Port D and QEI Module 0 are ready
+	while ((SYSCTL->PRGPIO & 0x08) == 0);
+	while ((SYSCTL->PRQEI & 0x01) == 0);
+	
+	// PD7 is locked after reset: write the key to the LOCK register, then
+	// allow changes to PD7 by setting Bit 7 in the CR register
+	GPIOD->LOCK = WHEEL_ENCODER_GPIO_UNLOCK_KEY;
+	GPIOD->CR |= 0x80;
+	
+	// Configure PD6 (PhA0) and PD7 (PhB0) to use the alternate function
+	// by setting Bits 7 to 6 in the AFSEL register
+	GPIOD->AFSEL |= 0xC0;
+	
+	// Clear the PMC7 (Bits 31 to 28) and PMC6 (Bits 27 to 24) fields in the PCTL register
+	GPIOD->PCTL &= ~0xFF000000;
+	
+	// Configure PD6 as PhA0 and PD7 as PhB0 by writing 0x6 to the PMC6 and PMC7 fields
+	// The 0x6 value is derived from Table 23-5 in the TM4C123G Microcontroller Datasheet
+	GPIOD->PCTL |= 0x66000000;
+	
+	// Enable the digital functionality for PD6 and PD7
+	// by setting Bits 7 to 6 in the DEN register
+	GPIOD->DEN |= 0xC0;
+	
+	// Lock the GPIOCR register again
+	GPIOD->LOCK = 0;
+	
+	// Disable QEI0 before configuration by clearing the CTL register
+	QEI0->CTL = 0;
+	
+	// Configure QEI0: count the edges of both phases (CAPMODE, Bit 3), enable the velocity
+	// capture (VELEN, Bit 5) without predivider (VELDIV = 0x0, Bits 8 to 6), and swap the
+	// phases (SWAP, Bit 1) if the encoder is wired for the opposite direction
+	QEI0->CTL = 0x28 | (WHEEL_ENCODER_SWAP_PHASES ? 0x02 : 0x00);
+	
+	// Let the position count through the full 32-bit range and start it from 0
+	QEI0->MAXPOS = 0xFFFFFFFF;
+	QEI0->POS = 0;
+	
+	// Set the length of the velocity window in system clock cycles
+	QEI0->LOAD = WHEEL_ENCODER_WINDOW_CYCLES - 1;
+	
+	window_count = 0;
+	
+	// Clear and enable the velocity timer interrupt (INTTIMER, Bit 1)
+	QEI0->ISC = WHEEL_ENCODER_TIMER_BIT_MASK;
+	QEI0->INTEN |= WHEEL_ENCODER_TIMER_BIT_MASK;
+	
+	NVIC_SetPriority(QEI0_IRQn, 3);
+	NVIC_EnableIRQ(QEI0_IRQn);
+	
+	// Enable QEI0 by setting the ENABLE bit (Bit 0) in the CTL register
+	QEI0->CTL |= 0x01;
+}
+
+void Wheel_Encoder_Get_Sample(Wheel_Encoder_Sample *sample)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq();
+	*sample = latest_sample;
+	__set_PRIMASK(primask);
+}
+
+void Wheel_Encoder_Set_Sample_Task(int task_id)
+{
+	sample_task_id = task_id;
+}
+
+void QEI0_Handler(void)
+{
+	// SPEED holds the number of edges counted during the window that has just ended
+	uint32_t edges = QEI0->SPEED;
+	uint32_t speed_mm_s = (uint32_t)(((uint64_t)edges * WHEEL_ENCODER_SAMPLE_HZ * WHEEL_ENCODER_CIRCUMFERENCE_UM) / ((uint64_t)WHEEL_ENCODER_EDGES_PER_REV * 1000));
+	
+	// Acknowledge the velocity timer interrupt
+	QEI0->ISC = WHEEL_ENCODER_TIMER_BIT_MASK;
+	
+	window_count++;
+	
+	latest_sample.timestamp_cycles = Timebase_Now_Cycles();
+	latest_sample.speed_mm_s = (QEI0->STAT & WHEEL_ENCODER_DIRECTION_BIT_MASK) ? -(int32_t)speed_mm_s : (int32_t)speed_mm_s;
+	latest_sample.edges = edges;
+	latest_sample.position = QEI0->POS;
+	latest_sample.sequence = window_count;
+	
+	if (sample_task_id >= 0)
+	{
+		Scheduler_Signal(sample_task_id);
+	}
+}
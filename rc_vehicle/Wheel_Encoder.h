@@ -0,0 +1,111 @@
+/**
+ * @file Wheel_Encoder.h
+ *
+ * @brief Header file for the wheel encoder driver, using the Quadrature Encoder Interface (QEI0).
+ *
+ * The encoder of the drive motor is connected to PD6 (PhA0) and PD7 (PhB0). QEI0 counts every
+ * edge of both phases (4x decoding) and its velocity timer captures the number of edges seen in
+ * each WHEEL_ENCODER_SAMPLE_HZ window, without any CPU involvement. At the end of every window,
+ * the interrupt service routine converts the count into a signed wheel speed and stores it,
+ * with the position and a timestamp, into a latest-sample slot that the application reads
+ * without blocking.
+ *
+ * @note PD7 is a locked pin (NMI); this driver unlocks it.
+ *
+ * @note The timing is derived from the system clock frequency (SYSTEM_CLOCK_HZ, see System_Clock.h).
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef WHEEL_ENCODER_H
+#define WHEEL_ENCODER_H
+
+#include "TM4C123GH6PM.h"
+#include <stdint.h>
+
+/**
+ * @brief Number of speed samples per second (length of the QEI velocity window)
+ */
+#define WHEEL_ENCODER_SAMPLE_HZ 50
+
+/**
+ * @brief Encoder edges per wheel revolution: 11 pulses per motor revolution,
+ * 4 edges per pulse, 34:1 gearbox
+ */
+#define WHEEL_ENCODER_EDGES_PER_REV 1496
+
+/**
+ * @brief Wheel circumference in micrometers (65 mm wheel)
+ */
+#define WHEEL_ENCODER_CIRCUMFERENCE_UM 204204
+
+/**
+ * @brief Set to 1 if the encoder counts down when the vehicle drives forward
+ */
+#define WHEEL_ENCODER_SWAP_PHASES 0
+
+/**
+ * @brief A single speed measurement.
+ */
+typedef struct
+{
+	/** Timebase count (see Timebase.h) at the end of the velocity window */
+	uint64_t timestamp_cycles;
+	
+	/** Wheel speed over the window in millimeters per second, positive when driving forward */
+	int32_t speed_mm_s;
+	
+	/** Number of encoder edges counted during the window */
+	uint32_t edges;
+	
+	/** Encoder position in edges since Wheel_Encoder_Init (wraps) */
+	uint32_t position;
+	
+	/** Number of windows completed since Wheel_Encoder_Init, 0 if no sample is available yet */
+	uint32_t sequence;
+} Wheel_Encoder_Sample;
+
+/**
+ * @brief The Wheel_Encoder_Init function starts the encoder and the velocity capture.
+ *
+ * This function configures PD6 as PhA0 and PD7 as PhB0, sets up QEI0 for 4x decoding with
+ * velocity capture, and enables its interrupt. It also starts the timebase.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Wheel_Encoder_Init(void);
+
+/**
+ * @brief The Wheel_Encoder_Get_Sample function copies the latest sample.
+ *
+ * The copy is taken with interrupts briefly disabled, so all fields belong to the same window.
+ *
+ * @param sample Pointer to the structure that receives the latest sample.
+ *
+ * @return None
+ */
+void Wheel_Encoder_Get_Sample(Wheel_Encoder_Sample *sample);
+
+/**
+ * @brief The Wheel_Encoder_Set_Sample_Task function selects a task to release for every new sample.
+ *
+ * @param task_id The identifier returned by Scheduler_Add_Task, or -1 for none.
+ *
+ * @return None
+ */
+void Wheel_Encoder_Set_Sample_Task(int task_id);
+
+/**
+ * @brief The QEI0_Handler function is the interrupt service routine for the velocity timer.
+ *
+ * It runs at the end of each velocity window and stores the new sample.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void QEI0_Handler(void);
+
+#endif
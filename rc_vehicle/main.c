@@ -1,88 +1,744 @@
 /*
  * @file main.c
  *
+ * Main program for the RC vehicle. After the peripherals are initialized,
+ * the vehicle is run by the cooperative scheduler (see Scheduler.h):
  *
+ * - command: reads commands from UART0, either single characters (Tera Term)
+ *   or binary frames (see Protocol.h)
+ * - sonar: stops forward motion when an obstacle is too close (Vehicle_Control.c)
+ * - actuation: applies the commanded motion to the PWM outputs (Vehicle_Control.c)
+ * - speed: holds the commanded wheel speed with the encoder feedback (Speed_Control.c),
+ *   through the motor ramp run by the PWM0_0 interrupt (Motion_Profile.c)
+ * - report: prints status messages to UART0
+ * - telemetry: streams binary status records over UART0 in framed mode (Telemetry.c)
+ * - watchdog: reloads the hardware watchdog (Watchdog.c)
+ * - maneuver: checks the distance conditions of the running maneuver script, whose
+ *   steps are applied by the Timer 2A interrupt (Maneuver.c)
+ * - blackbox: records the recent history and copies it into flash after an obstacle
+ *   stop (Black_Box.c)
+ * - trace: prints the event trace, only while a dump is in progress (Trace.c)
+ * - memory: measures the stack high-water mark and prints the memory report (Memory_Profile.c)
+ * - status: prints the '?' status, only while it is in progress
+ *
+ * None of the tasks wait on the serial line or the ultrasonic sensor, so the
+ * vehicle can be stopped, steered or reversed at any time while it is driving.
+ * Between the tasks, the CPU sleeps (see Idle.h).
+ *
+ * Every valid command feeds the deadman (see Deadman.h), which stops the vehicle from a
+ * timer interrupt when no command arrives for DEADMAN_TIMEOUT_MS. In character mode,
+ * hold the key down (auto-repeat) to keep driving. A running maneuver script feeds the
+ * deadman itself, and any motion command aborts it.
+ *
+ * Commands:
+ *   'A' forward, 'B' reverse, ' ' stop,
+ *   'R' run the maneuver script uploaded in framed mode (see Maneuver.h),
+ *   'D' steer left, 'm' steer to the middle, 'C' steer right,
+ *   '?' print the scheduler statistics, the CPU load, the deadman, watchdog, maneuver and
+ *       black box and event trace statistics, where the parameters were loaded from, the
+ *       stack high-water mark and the latest sample of each ultrasonic sensor,
+ *   'L' print the command latency statistics,
+ *   'K' copy the recent history into the black box flash log, 'P' print the flash log,
+ *   'Y' print the runtime parameters, 'W' save them to the EEPROM (see Parameters.h),
+ *   'Z' print the event trace (see Trace.h),
+ *   'M' print the RAM usage of the stack and of each module (see Memory_Profile.h),
+ *   'F' switch to the framed binary protocol,
+ *   T<+/-percent> proportional throttle (e.g. T-40), S<+/-degrees> steering angle (e.g. S+15),
+ *   V<+/-cm/s> wheel speed (e.g. V60), #<index> print a parameter (e.g. #3),
+ *   #<index>=<+/-value> change a parameter (e.g. #4=-12), each ended by Enter
  *
  * @author Jonathan Penaloza, Ricardo Zaragoza
  */
 
 #include "TM4C123GH6PM.h"
+#include "System_Clock.h"
 #include "SysTick_Delay.h"
 #include "PWM0_0.h"
 #include "PWM_Clock.h"
 #include "PWM2_2.h"
 #include "UART0.h"
 #include "Ultra_Sonic.h"
-#include "Buzzer.h"
+#include "Scheduler.h"
+#include "Vehicle_Control.h"
+#include "Protocol.h"
+#include "Command_Parser.h"
+#include "Telemetry.h"
+#include "Latency.h"
+#include "Motion_Profile.h"
+#include "Wheel_Encoder.h"
+#include "Speed_Control.h"
+#include "Idle.h"
+#include "Deadman.h"
+#include "Watchdog.h"
+#include "Maneuver.h"
+#include "Black_Box.h"
+#include "Parameters.h"
+#include "Trace.h"
+#include "Memory_Profile.h"
 
-char command; //to store value from UART0 to control vechicle
-int main(void)
+// Period and deadline of the command task in microseconds
+#define COMMAND_TASK_PERIOD_US 2000
+
+// Period and deadline of the report task in microseconds
+#define REPORT_TASK_PERIOD_US 100000
+
+// Maximum number of bytes handled by one run of the command task, which
+// bounds its execution time no matter how much data arrives at once
+#define COMMAND_MAX_BYTES_PER_RUN 32
+
+// Period and deadline of the status task while the '?' status is printed, in microseconds
+#define STATUS_TASK_PERIOD_US 5000
+
+// Free space in the UART0 transmit buffer needed to write one section of the status
+#define STATUS_STEP_MAX 192
+
+// Largest number of status sections written by one run of the status task
+#define STATUS_STEPS_PER_RUN 4
+
+// Parser for the T, S, V and # numeric commands in character mode
+static Command_Parser command_parser;
+
+// '?' status: status_step is the next section to print, or -1 when no status is in progress
+static int status_task_id = -1;
+static int16_t status_step = -1;
+
+static void Output_Signed_Decimal(int32_t value)
+{
+	if (value < 0)
+	{
+		UART0_Output_Character('-');
+		value = -value;
+	}
+	
+	UART0_Output_Unsigned_Decimal((uint32_t)value);
+}
+
+// Prints the name and the current value of a parameter, which must exist
+static void Print_Parameter(uint8_t index)
 {
-    // Initialize your peripherals
-    SysTick_Delay_Init();      // For blocking delays
-    PWM_Clock_Init();          // Initialize PWM clock
-    PWM0_0_Init(62500, 31250); // Initialize motor 1 PWM
-    PWM2_2_Init(62500, 0);     // Initialize motor 2 PWM
-    UART0_Init();               // Initialize UART0 for Tera Term
-    Ultrasonic_Init();          // Optional: ultrasonic sensor
+	UART0_Output_String((char *)Parameters_Get_Info(index)->name);
+	UART0_Output_Character(' ');
+	Output_Signed_Decimal(Parameters_Get(index));
+	UART0_Output_Newline();
+}
 
+static void Print_Parameters(void)
+{
+	const Parameter_Info *info;
+	uint8_t i;
 	
-    UART0_Output_String("RC Ready to Control \r\n");
-    PWM0_0_Stop();
+	UART0_Output_String("param index value default min max\r\n");
+	
+	for (i = 0; i < Parameters_Count(); i++)
+	{
+		info = Parameters_Get_Info(i);
+		
+		UART0_Output_String((char *)info->name);
+		UART0_Output_Character(' ');
+		UART0_Output_Unsigned_Decimal(i);
+		UART0_Output_Character(' ');
+		Output_Signed_Decimal(Parameters_Get(i));
+		UART0_Output_Character(' ');
+		Output_Signed_Decimal(info->default_value);
+		UART0_Output_Character(' ');
+		Output_Signed_Decimal(info->minimum);
+		UART0_Output_Character(' ');
+		Output_Signed_Decimal(info->maximum);
+		UART0_Output_Newline();
+	}
+}
 
-while(1)
+static int8_t Clamp_To_Int8(int16_t value, int16_t limit)
 {
+	if (value > limit)
+	{
+		return (int8_t)limit;
+	}
+	if (value < -limit)
+	{
+		return (int8_t)-limit;
+	}
+	return (int8_t)value;
+}
+
+// Sections of the '?' status, one per run of Print_Status_Step. The sonar samples and the
+// task table follow, one line per sensor and per task
+typedef enum
+{
+	STATUS_STEP_CLOCK = 0,
+	STATUS_STEP_DEADMAN,
+	STATUS_STEP_WATCHDOG,
+	STATUS_STEP_SCRIPT,
+	STATUS_STEP_BLACK_BOX,
+	STATUS_STEP_PARAMETERS,
+	STATUS_STEP_STACK,
+	STATUS_STEP_TRACE,
+	STATUS_STEP_SONAR_HEADER,
+	STATUS_STEP_COUNT
+} Status_Step;
+
+// Writes one section of the status (at most STATUS_STEP_MAX bytes), and returns 0 once the status is complete
+static int Print_Status_Step(int16_t step)
+{
+	Scheduler_Task_Statistics stats;
+	Deadman_Statistics deadman;
+	Maneuver_Statistics maneuver;
+	Black_Box_Statistics black_box;
+	Memory_Profile_Statistics memory;
+	Ultrasonic_Sample sample;
+#if TRACE_ENABLED
+	Trace_Statistics trace;
+#endif
+	uint16_t load_permille;
+	
+	switch (step)
+	{
+		case STATUS_STEP_CLOCK:
+			UART0_Output_String("clock_hz ");
+			UART0_Output_Unsigned_Decimal(System_Clock_Get_Hz());
+			UART0_Output_Newline();
+			
+			UART0_Output_String("baud ");
+			UART0_Output_Unsigned_Decimal(UART0_Get_Baud_Rate());
+			UART0_Output_Newline();
+			
+			load_permille = Idle_Get_Load_Permille();
+			UART0_Output_String("cpu_load_percent ");
+			UART0_Output_Unsigned_Decimal(load_permille / 10);
+			UART0_Output_Character('.');
+			UART0_Output_Unsigned_Decimal(load_permille % 10);
+			UART0_Output_Newline();
+			return 1;
+		
+		case STATUS_STEP_DEADMAN:
+			Deadman_Get_Statistics(&deadman);
+			UART0_Output_String("deadman timeout_ms trips max_detect_us max_stop_us ramp_cuts\r\n");
+			UART0_Output_String("deadman ");
+			UART0_Output_Unsigned_Decimal(Deadman_Get_Timeout());
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(deadman.trip_count);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(deadman.max_detect_us);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(deadman.max_stop_us);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(deadman.ramp_cut_count);
+			UART0_Output_Newline();
+			return 1;
+		
+		case STATUS_STEP_WATCHDOG:
+			UART0_Output_String("watchdog_timeouts ");
+			UART0_Output_Unsigned_Decimal(Watchdog_Get_Timeout_Count());
+			UART0_Output_String(Watchdog_Caused_Reset() ? " (reset by watchdog)\r\n" : "\r\n");
+			return 1;
+		
+		case STATUS_STEP_SCRIPT:
+			Maneuver_Get_Statistics(&maneuver);
+			UART0_Output_String("script steps runs steps_run max_late_us\r\n");
+			UART0_Output_String("script ");
+			UART0_Output_Unsigned_Decimal(Maneuver_Get_Step_Count());
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(maneuver.run_count);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(maneuver.step_count);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(maneuver.max_boundary_late_us);
+			UART0_Output_Newline();
+			return 1;
+		
+		case STATUS_STEP_BLACK_BOX:
+			Black_Box_Get_Statistics(&black_box);
+			UART0_Output_String("blackbox records history_ms flushes blocks sectors lost slots max_capture_cycles\r\n");
+			UART0_Output_String("blackbox ");
+			UART0_Output_Unsigned_Decimal(black_box.record_count);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(black_box.history_ms);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(black_box.flush_count);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(black_box.blocks_written);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(black_box.sectors_erased);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(black_box.blocks_lost);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(black_box.slots_used);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(black_box.max_capture_cycles);
+			UART0_Output_Newline();
+			return 1;
+		
+		case STATUS_STEP_PARAMETERS:
+			UART0_Output_String("params source load_cycles\r\n");
+			UART0_Output_String("params ");
+			UART0_Output_String((Parameters_Get_Source() == PARAMETERS_SOURCE_EEPROM) ? "eeprom " :
+				((Parameters_Get_Source() == PARAMETERS_SOURCE_DEFAULTS) ? "defaults " : "no_eeprom "));
+			UART0_Output_Unsigned_Decimal(Parameters_Get_Load_Cycles());
+			UART0_Output_Newline();
+			return 1;
+		
+		case STATUS_STEP_STACK:
+			Memory_Profile_Get_Statistics(&memory);
+			UART0_Output_String("stack size used stray\r\n");
+			UART0_Output_String("stack ");
+			UART0_Output_Unsigned_Decimal(memory.size_bytes);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(memory.used_bytes);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(memory.stray_bytes);
+			UART0_Output_Newline();
+			return 1;
+		
+		case STATUS_STEP_TRACE:
+#if TRACE_ENABLED
+			Trace_Get_Statistics(&trace);
+			UART0_Output_String("trace events overwritten itm_drops event_cycles\r\n");
+			UART0_Output_String("trace ");
+			UART0_Output_Unsigned_Decimal(trace.event_count);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(trace.overwritten_count);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(trace.itm_drop_count);
+			UART0_Output_Character(' ');
+			UART0_Output_Unsigned_Decimal(trace.event_cycles);
+			UART0_Output_Newline();
+#endif
+			return 1;
+		
+		case STATUS_STEP_SONAR_HEADER:
+			UART0_Output_String("sonar_ping_period_us ");
+			UART0_Output_Unsigned_Decimal(Ultrasonic_Get_Ping_Period_US());
+			UART0_Output_Newline();
+			UART0_Output_String("sonar pings distance_cm\r\n");
+			return 1;
+		
+		default:
+			break;
+	}
+	
+	step -= STATUS_STEP_COUNT;
+	
+	if (step < ULTRASONIC_SENSOR_COUNT)
+	{
+		Ultrasonic_Get_Sample((Ultrasonic_Sensor)step, &sample);
 		
-	uint32_t distance = Ultrasonic_ReadDistanceCM();  //read distance
-        if(distance >= 1 && distance < 10)   // if distance is betweeen 1cm-10cm, dont move vehicle
-        {
-            PWM0_0_Stop();
-            UART0_Output_String("Motion Detected \r\n"); //output to UART0
-             
-        }
+		UART0_Output_String((char *)Ultrasonic_Get_Config((Ultrasonic_Sensor)step)->name);
+		UART0_Output_Character(' ');
+		UART0_Output_Unsigned_Decimal(sample.sequence);
+		UART0_Output_Character(' ');
+		UART0_Output_Unsigned_Decimal(sample.distance_cm);
+		UART0_Output_Newline();
+		return 1;
+	}
+	
+	step -= ULTRASONIC_SENSOR_COUNT;
+	
+	if (step == 0)
+	{
+		UART0_Output_String("task runs misses max_latency_us max_execution_us\r\n");
+		return 1;
+	}
+	
+	step--;
+	
+	if (step >= Scheduler_Task_Count())
+	{
+		return 0;
+	}
+	
+	Scheduler_Get_Task_Statistics(step, &stats);
+	
+	UART0_Output_String((char *)stats.name);
+	UART0_Output_Character(' ');
+	UART0_Output_Unsigned_Decimal(stats.run_count);
+	UART0_Output_Character(' ');
+	UART0_Output_Unsigned_Decimal(stats.deadline_miss_count);
+	UART0_Output_Character(' ');
+	UART0_Output_Unsigned_Decimal(stats.max_latency_us);
+	UART0_Output_Character(' ');
+	UART0_Output_Unsigned_Decimal(stats.max_execution_us);
+	UART0_Output_Newline();
+	
+	return 1;
+}
 
+// Prints the '?' status while one is in progress. UART0_Write drops what does not fit in the
+// transmit buffer, so each section waits until the buffer has room for it
+static void Status_Task(void)
+{
+	uint8_t steps;
+	
+	if (status_step < 0)
+	{
+		return;
+	}
+	
+	for (steps = 0; (steps < STATUS_STEPS_PER_RUN) && (UART0_TX_Free() >= STATUS_STEP_MAX); steps++)
+	{
+		if (!Print_Status_Step(status_step))
+		{
+			status_step = -1;
+			Scheduler_Set_Period(status_task_id, 0, STATUS_TASK_PERIOD_US);
+			return;
+		}
+		
+		status_step++;
+	}
+}
 
-        if(UART0_Available())     // Only read if character exists
-        {
-            command = UART0_Input_Character();
-            UART0_Output_Character(command);
-            UART0_Output_String("\r\n");
+// Starts printing the '?' status, and returns 0 if it is already in progress
+static int Print_Status(void)
+{
+	if ((status_step >= 0) || (status_task_id < 0))
+	{
+		return 0;
+	}
+	
+	status_step = 0;
+	Scheduler_Set_Period(status_task_id, STATUS_TASK_PERIOD_US, STATUS_TASK_PERIOD_US);
 	
+	return 1;
+}
 
-    if(command == 'A') //move forward
-    {
-			while(Ultrasonic_ReadDistanceCM() > 10)
+static void Handle_Character_Command(char command)
+{
+	UART0_Output_Character(command);
+	UART0_Output_String("\r\n");
+	
+	if (command == 'A') //move forward
+	{
+		Maneuver_Abort();
+		Vehicle_Forward();
+		UART0_Output_String("Motor in Drive \r\n");
+	}
+	else if (command == 'B')
+	{
+		Maneuver_Abort();
+		Vehicle_Reverse(); //mover reverse
+		UART0_Output_String("Reverse \r\n");
+	}
+	else if (command == ' ')
+	{
+		Maneuver_Abort();
+		Vehicle_Stop(); //stop vehicle
+		UART0_Output_String("Motor Stoped \r\n");
+	}
+	else if (command == 'D')
+	{
+		Maneuver_Abort();
+		Vehicle_Steer_Degrees(-VEHICLE_STEERING_MAX_DEG);
+		UART0_Output_String("Turning Left\r\n"); //turn left
+	}
+	else if (command == 'm')
+	{
+		Maneuver_Abort();
+		Vehicle_Steer_Degrees(0);
+		UART0_Output_String("Steering in the Middle \r\n");  //turn wheel straight
+	}
+	else if (command == 'C')
+	{
+		Maneuver_Abort();
+		Vehicle_Steer_Degrees(VEHICLE_STEERING_MAX_DEG);
+		UART0_Output_String("Turning Right \r\n");  //turn right
+	}
+	else if (command == 'R')
+	{
+		if (Maneuver_Start())
+		{
+			UART0_Output_String("Running Script \r\n");
+		}
+		else
+		{
+			UART0_Output_String("No Script \r\n");
+		}
+	}
+	else if (command == '?')
+	{
+		if (!Print_Status())
+		{
+			UART0_Output_String("Status Busy \r\n");
+		}
+	}
+	else if (command == 'L')
+	{
+		Latency_Print();
+	}
+	else if (command == 'K')
+	{
+		Black_Box_Flush();
+		UART0_Output_String("Black Box Flush \r\n");
+	}
+	else if (command == 'P')
+	{
+		if (!Black_Box_Dump())
+		{
+			UART0_Output_String("Black Box Busy \r\n");
+		}
+	}
+	else if (command == 'Y')
+	{
+		Print_Parameters();
+	}
+	else if (command == 'W')
+	{
+		if (Parameters_Save())
+		{
+			UART0_Output_String("Parameters Saved \r\n");
+		}
+		else
+		{
+			UART0_Output_String("EEPROM Error \r\n");
+		}
+	}
+	else if (command == 'M')
+	{
+		if (!Memory_Profile_Report())
+		{
+			UART0_Output_String("Memory Busy \r\n");
+		}
+	}
+#if TRACE_ENABLED
+	else if (command == 'Z')
+	{
+		if (!Trace_Dump())
+		{
+			UART0_Output_String("Trace Busy \r\n");
+		}
+	}
+#endif
+	else if (command == 'F')
+	{
+		UART0_Output_String("Framed Mode \r\n");
+		Protocol_Set_Mode(PROTOCOL_MODE_FRAMED);
+	}
+}
+
+static void Handle_Character(char character)
+{
+	int16_t value;
+	
+	switch (Command_Parser_Feed(&command_parser, character, &value))
+	{
+		case COMMAND_PARSER_CHARACTER:
+			Deadman_Feed();
+			Black_Box_Record_Command((uint8_t)character, 0);
+			Handle_Character_Command(character);
+			break;
+		
+		case COMMAND_PARSER_NONE:
+			UART0_Output_Character(character);  //echo the numeric command as it is typed
+			break;
+		
+		case COMMAND_PARSER_THROTTLE:
+			Deadman_Feed();
+			value = Clamp_To_Int8(value, 100);
+			Black_Box_Record_Command('T', value);
+			Maneuver_Abort();
+			Vehicle_Drive((int8_t)value);
+			UART0_Output_String("\r\nThrottle ");
+			Output_Signed_Decimal(value);
+			UART0_Output_Newline();
+			break;
+		
+		case COMMAND_PARSER_STEERING:
+			Deadman_Feed();
+			value = Clamp_To_Int8(value, VEHICLE_STEERING_MAX_DEG);
+			Black_Box_Record_Command('S', value);
+			Maneuver_Abort();
+			Vehicle_Steer_Degrees((int8_t)value);
+			UART0_Output_String("\r\nSteering ");
+			Output_Signed_Decimal(value);
+			UART0_Output_Newline();
+			break;
+		
+		case COMMAND_PARSER_SPEED:
+			Deadman_Feed();
+			
+			// Clamped here too, so that the echo shows the speed actually requested
+			if (value > (VEHICLE_MAX_SPEED_MM_S / 10))
+			{
+				value = VEHICLE_MAX_SPEED_MM_S / 10;
+			}
+			else if (value < -(VEHICLE_MAX_SPEED_MM_S / 10))
 			{
-        PWM0_0_Forward();
-        UART0_Output_String("Motor in Drive \r\n");
+				value = -(VEHICLE_MAX_SPEED_MM_S / 10);
 			}
+			Black_Box_Record_Command('V', value);
+			Maneuver_Abort();
+			Vehicle_Drive_Speed(value);
+			UART0_Output_String("\r\nSpeed ");
+			Output_Signed_Decimal(value);
+			UART0_Output_String(" cm/s\r\n");
+			break;
+		
+		case COMMAND_PARSER_PARAMETER_GET:
+			Deadman_Feed();
+			UART0_Output_Newline();
 			
-} 
-    else if(command == 'B')
-    {
-        PWM0_0_Reverse(); //mover reverse
-        UART0_Output_String("Reverse \r\n");
-    }
-    else if(command == ' ')
-    {
-        PWM0_0_Stop(); //stop vehicle
-        UART0_Output_String("Motor Stoped \r\n");
-    }
-		else if(command == 'D')
+			if (Parameters_Get_Info(command_parser.parameter_index) != 0)
+			{
+				Print_Parameter(command_parser.parameter_index);
+			}
+			else
+			{
+				UART0_Output_String("Invalid Parameter \r\n");
+			}
+			break;
+		
+		case COMMAND_PARSER_PARAMETER_SET:
+			Deadman_Feed();
+			Black_Box_Record_Command('#', command_parser.parameter_index);
+			UART0_Output_Newline();
+			
+			if (Parameters_Set(command_parser.parameter_index, command_parser.parameter_value))
+			{
+				Print_Parameter(command_parser.parameter_index);
+			}
+			else
+			{
+				UART0_Output_String("Invalid Parameter \r\n");
+			}
+			break;
+		
+		case COMMAND_PARSER_ERROR:
+			UART0_Output_String("\r\nInvalid Command \r\n");
+			break;
+	}
+}
+
+static void Command_Task(void)
+{
+	char buffer[COMMAND_MAX_BYTES_PER_RUN]; //to store values from UART0 to control vechicle
+	uint32_t rx_cycles[COMMAND_MAX_BYTES_PER_RUN];
+	uint16_t length = UART0_Read_Timestamped(buffer, rx_cycles, COMMAND_MAX_BYTES_PER_RUN);
+	uint16_t i;
+	
+	for (i = 0; i < length; i++)
+	{
+		// A command completed by this byte is timed from its arrival
+		Latency_Set_RX_Timestamp(rx_cycles[i]);
+		
+		// The mode is checked for every byte, since a command may switch it
+		if (Protocol_Get_Mode() == PROTOCOL_MODE_FRAMED)
 		{
-			PWM2_2_Update_Duty_Cycle(1500);
-			UART0_Output_String("Turning Left\r\n"); //turn left
+			Protocol_Receive_Byte((uint8_t)buffer[i]);
 		}
-		else if(command == 'm')
+		else
 		{
-			PWM2_2_Update_Duty_Cycle(4688);
-			UART0_Output_String("Steering in the Middle \r\n");  //turn wheel straight
+			Handle_Character(buffer[i]);
 		}
-		else if(command == 'C')
+	}
+}
+
+static void Report_Task(void)
+{
+	static uint32_t reported_obstacle_stops = 0;
+	static uint8_t reported_stack_low = 0;
+	static uint8_t report_sequence = 0;
+	Vehicle_Status status;
+	Maneuver_Report script;
+	
+	Vehicle_Get_Status(&status);
+	
+	// Report each obstacle stop once
+	if (status.obstacle_stop_count != reported_obstacle_stops)
+	{
+		reported_obstacle_stops = status.obstacle_stop_count;
+		
+		if (Protocol_Get_Mode() == PROTOCOL_MODE_FRAMED)
+		{
+			uint8_t payload[2];
+			
+			payload[0] = (uint8_t)(status.distance_cm & 0xFF);
+			payload[1] = (uint8_t)((status.distance_cm >> 8) & 0xFF);
+			Protocol_Send(PROTOCOL_OBSTACLE, report_sequence++, payload, 2);
+		}
+		else
 		{
-			PWM2_2_Update_Duty_Cycle(7812);
-			UART0_Output_String("Turning Right \r\n");  //turn right
+			UART0_Output_String("Motion Detected \r\n"); //output to UART0
+		}
+	}
+	
+	// Report the end of each maneuver script once
+	if (Maneuver_Take_Report(&script))
+	{
+		if (Protocol_Get_Mode() == PROTOCOL_MODE_FRAMED)
+		{
+			uint8_t payload[2];
+			
+			payload[0] = (uint8_t)script.result;
+			payload[1] = script.steps_run;
+			Protocol_Send(PROTOCOL_SCRIPT_DONE, report_sequence++, payload, 2);
+		}
+		else
+		{
+			UART0_Output_String((script.result == MANEUVER_RESULT_COMPLETED) ? "Script Done, " :
+				((script.result == MANEUVER_RESULT_OBSTACLE) ? "Script Stopped by Obstacle, " : "Script Aborted, "));
+			UART0_Output_Unsigned_Decimal(script.steps_run);
+			UART0_Output_String(" steps\r\n");
+		}
+	}
+	
+	// Report once that the stack came close to its end
+	if (!reported_stack_low && Memory_Profile_Stack_Low())
+	{
+		reported_stack_low = 1;
+		
+		if (Protocol_Get_Mode() != PROTOCOL_MODE_FRAMED)
+		{
+			UART0_Output_String("Stack Low \r\n");
+		}
 	}
- }
 }
+
+int main(void)
+{
+	Memory_Profile_Paint();     // Paint the unused stack and RAM, to measure their use later
+	
+	// Initialize your peripherals
+	System_Clock_Init();       // Run the system clock from the PLL at SYSTEM_CLOCK_HZ
+	Latency_Init();            // Start the DWT cycle counter used to time the commands
+	SysTick_Delay_Init();      // Start the timebase used for delays and scheduling
+	PWM_Clock_Init();          // Initialize PWM clock
+	PWM0_0_Init(VEHICLE_PWM_PERIOD, 0); // Initialize motor 1 PWM
+	Motion_Profile_Init(VEHICLE_MOTOR_MAX_DUTY); // Ramp the motor duty cycle from the PWM0_0 interrupt
+	PWM2_2_Init(VEHICLE_PWM_PERIOD, PWM2_2_Angle_Duty(0)); // Initialize the steering servo, centered
+	Parameters_Init();          // Load the runtime parameters from the EEPROM, before the modules that read them
+	UART0_Init(UART0_BAUD_RATE); // Initialize UART0 for Tera Term
+	Ultrasonic_Init();          // Start background ranging on the sensor array
+	Wheel_Encoder_Init();       // Start the wheel speed measurement
+	
+	Protocol_Init();
+	Command_Parser_Init(&command_parser);
+	Scheduler_Init();
+	Speed_Control_Init(VEHICLE_MOTOR_MAX_DUTY); // Registers the speed task
+	Vehicle_Control_Init();     // Registers the sonar and actuation tasks
+	Scheduler_Add_Task("command", Command_Task, COMMAND_TASK_PERIOD_US, COMMAND_TASK_PERIOD_US);
+	Scheduler_Add_Task("report", Report_Task, REPORT_TASK_PERIOD_US, REPORT_TASK_PERIOD_US);
+	Telemetry_Init();           // Registers the telemetry task
+	Deadman_Init();             // Stop the vehicle from the Timer 1A interrupt when the commands stop
+	Watchdog_Init();            // Registers the watchdog task, reset if the loop hangs
+	Maneuver_Init();            // Run the maneuver script steps from the Timer 2A interrupt
+	Black_Box_Init();           // Registers the black box task, finds the end of the flash log
+#if TRACE_ENABLED
+	Trace_Init();               // Registers the trace task
+#endif
+	Memory_Profile_Init();      // Registers the memory task
+	status_task_id = Scheduler_Add_Task("status", Status_Task, 0, STATUS_TASK_PERIOD_US);
+	Idle_Init();                // Gate the unused clocks in sleep, once every driver has enabled its own
+	
+	// A task that did not fit in the scheduler table would never run: the vehicle is not
+	// started, and the watchdog resets it, which repeats the message
+	if (Scheduler_Rejected_Task_Count() > 0)
+	{
+		UART0_Output_String("Scheduler Table Full \r\n");
+		
+		while (1)
+		{
+		}
+	}
+	
+	UART0_Output_String("RC Ready to Control \r\n");
+	
+	Scheduler_Run();
 }
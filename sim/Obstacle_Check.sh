@@ -0,0 +1,36 @@
+#!/bin/sh
+#
+# Drives the simulated vehicle towards the obstacle by repeating the forward command every
+# 200 ms, like a held 'A' key, from several distances, and checks that it never reaches it:
+#
+#   sh Obstacle_Check.sh build/rc_vehicle_sim
+#
+# Each run lasts SIM_RUN_MS (7000 ms by default), long enough for the vehicle to stop and
+# for the command to keep coming at rest. The other settings of the simulator (for example
+# SIM_SONAR_NOISE_CM) are passed through. The exit status is the number of failed runs.
+
+SIM=${1:-build/rc_vehicle_sim}
+DISTANCES=${DISTANCES:-"20 40 60 80 100 120 150 200"}
+SIM_RUN_MS=${SIM_RUN_MS:-7000}
+
+export SIM_RUN_MS
+
+failures=0
+
+for distance in $DISTANCES
+do
+	result=$( (sleep 0.3; while true; do printf 'A'; sleep 0.2; done) |
+		SIM_OBSTACLE_CM=$distance "$SIM" 2>&1 >/dev/null | grep -a "vehicle travelled")
+
+	case "$result" in
+		*" 0 collisions"*)
+			echo "obstacle at $distance cm: ok (${result#sim: })"
+			;;
+		*)
+			echo "obstacle at $distance cm: FAILED (${result#sim: })"
+			failures=$((failures + 1))
+			;;
+	esac
+done
+
+exit $failures
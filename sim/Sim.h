@@ -0,0 +1,328 @@
+/**
+ * @file Sim.h
+ *
+ * @brief Internal interface shared by the modules of the host simulator.
+ *
+ * The simulator runs the unmodified firmware as a Linux process:
+ *
+ * - Sim_MMIO.c maps the peripheral address space at the real TM4C123 addresses and traps
+ *   every register access into the peripheral models.
+ * - Sim_Core.c keeps the simulated time, the NVIC and PRIMASK state, and calls the
+ *   firmware interrupt handlers from a periodic host timer signal.
+ * - Sim_System.c, Sim_UART.c, Sim_Timer.c, Sim_Flash.c and Sim_Vehicle.c model the
+ *   peripherals and the world around the vehicle.
+ *
+ * Simulated time is the host's monotonic clock, scaled to system clock cycles.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include "TM4C123GH6PM.h"
+
+/**
+ * @brief Called before a trapped access, with the register offset within the page.
+ * It refreshes the value that the firmware is about to read.
+ */
+typedef void (*Sim_Pre_Access_Hook)(uint32_t offset);
+
+/**
+ * @brief Called after a trapped access. It carries out the side effects of the access.
+ */
+typedef void (*Sim_Post_Access_Hook)(uint32_t offset, int is_write);
+
+/**
+ * @brief Called on every update of the simulation, with the current time in cycles.
+ */
+typedef void (*Sim_Update_Hook)(uint64_t now);
+
+/**
+ * @brief The Sim_MMIO_Init function maps the peripheral address space.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Sim_MMIO_Init(void);
+
+/**
+ * @brief The Sim_MMIO_Register function attaches a peripheral model to a 4 KB register page.
+ *
+ * Accesses to pages without a model behave as plain memory.
+ *
+ * @param base Base address of the page.
+ * @param pre Hook called before each access, or 0.
+ * @param post Hook called after each access, or 0.
+ *
+ * @return None
+ */
+void Sim_MMIO_Register(uint32_t base, Sim_Pre_Access_Hook pre, Sim_Post_Access_Hook post);
+
+/**
+ * @brief The Sim_MMIO_Alias function returns a pointer through which the models access a register page.
+ *
+ * The alias is always accessible and never traps.
+ *
+ * @param address Address inside the page, as seen by the firmware.
+ *
+ * @return The corresponding address in the alias mapping.
+ */
+void *Sim_MMIO_Alias(uint32_t address);
+
+/**
+ * @brief Pointer to a peripheral register block in the alias mapping
+ */
+#define SIM_REGISTERS(type, base) ((type *)Sim_MMIO_Alias(base))
+
+/**
+ * @brief The Sim_MMIO_In_Access function checks if a trapped access is in progress.
+ *
+ * @param None
+ *
+ * @return 1 between the access fault and the end of the accessing instruction, 0 otherwise.
+ */
+int Sim_MMIO_In_Access(void);
+
+/**
+ * @brief The Sim_MMIO_Access_Count function returns the number of trapped register accesses.
+ *
+ * @param None
+ *
+ * @return The number of trapped register accesses.
+ */
+uint64_t Sim_MMIO_Access_Count(void);
+
+/**
+ * @brief The Sim_Now function returns the simulated time.
+ *
+ * @param None
+ *
+ * @return The number of system clock cycles since the simulation started.
+ */
+uint64_t Sim_Now(void);
+
+/**
+ * @brief The Sim_Clock_Hz function returns the simulated system clock frequency.
+ *
+ * @param None
+ *
+ * @return The system clock frequency in Hz.
+ */
+uint32_t Sim_Clock_Hz(void);
+
+/**
+ * @brief The Sim_Set_Clock_Hz function changes the simulated system clock frequency.
+ *
+ * Simulated time stays continuous: the cycle count carries on from its current value.
+ *
+ * @param hz The new system clock frequency in Hz.
+ *
+ * @return None
+ */
+void Sim_Set_Clock_Hz(uint32_t hz);
+
+/**
+ * @brief The Sim_Add_Update_Hook function registers a model that advances with time.
+ *
+ * @param hook The function to call on every update.
+ *
+ * @return None
+ */
+void Sim_Add_Update_Hook(Sim_Update_Hook hook);
+
+/**
+ * @brief The Sim_Update function advances every model to the current time.
+ *
+ * It must be called with the host timer signal blocked.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Sim_Update(void);
+
+/**
+ * @brief The Sim_Set_IRQ_Line function drives the interrupt request line of a peripheral.
+ *
+ * As on the target, the interrupt stays pending for as long as the line is asserted.
+ *
+ * @param irq The interrupt number.
+ * @param level 1 to assert the line, 0 to release it.
+ *
+ * @return None
+ */
+void Sim_Set_IRQ_Line(IRQn_Type irq, int level);
+
+/**
+ * @brief The Sim_Pend_IRQ function pends an interrupt once, like a pulse on its request line.
+ *
+ * @param irq The interrupt number.
+ *
+ * @return None
+ */
+void Sim_Pend_IRQ(IRQn_Type irq);
+
+/**
+ * @brief The Sim_Deliver_Interrupts function calls the handlers of the pending interrupts.
+ *
+ * Handlers are run in priority order, and only if PRIMASK is clear and their priority
+ * is higher than the one of the running code. It must be called with the host timer
+ * signal blocked.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Sim_Deliver_Interrupts(void);
+
+/**
+ * @brief The Sim_Service function updates the models and delivers the pending interrupts.
+ *
+ * It is called from the access trap when the host timer signal was deferred.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Sim_Service(void);
+
+/**
+ * @brief The Sim_Stop function ends the simulation and writes the summary, for example when
+ * the firmware resets the microcontroller.
+ *
+ * @param reason Short description of the cause, written to the summary.
+ *
+ * @return None (the function does not return)
+ */
+void Sim_Stop(const char *reason);
+
+/**
+ * @brief The Sim_NVIC_Is_Enabled function checks if an interrupt is enabled in the NVIC.
+ *
+ * @param irq The interrupt number.
+ *
+ * @return 1 if the interrupt is enabled, 0 otherwise.
+ */
+int Sim_NVIC_Is_Enabled(IRQn_Type irq);
+
+/**
+ * @brief The Sim_Env_Int function reads a numeric setting from the environment.
+ *
+ * @param name Name of the environment variable.
+ * @param default_value Value used when the variable is not set.
+ *
+ * @return The value of the setting.
+ */
+long Sim_Env_Int(const char *name, long default_value);
+
+/**
+ * @brief The Sim_Log function writes a message to the simulator log (standard error).
+ *
+ * It is safe to call from the trap and timer signal handlers.
+ *
+ * @param format printf-style format.
+ *
+ * @return None
+ */
+void Sim_Log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Model initialization functions, called once at startup by Sim_Core.c
+ */
+void Sim_System_Init(void);
+void Sim_UART_Init(void);
+void Sim_Timer_Init(void);
+void Sim_Vehicle_Init(void);
+void Sim_Flash_Init(void);
+
+/**
+ * @brief Model summaries, printed when the simulation ends
+ */
+void Sim_UART_Report(void);
+void Sim_Vehicle_Report(void);
+void Sim_Flash_Report(void);
+
+/**
+ * @brief The Sim_UART_Restore function releases the host terminal used by the UART model.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Sim_UART_Restore(void);
+
+/**
+ * @brief The Sim_GPIO_Output function returns the levels driven on the pins of a GPIO port.
+ *
+ * @param port Port index, 0 for port A to 5 for port F.
+ *
+ * @return The output data latch, masked by the direction register.
+ */
+uint8_t Sim_GPIO_Output(int port);
+
+/**
+ * @brief The Sim_GPIO_Set_Input function sets the levels applied to input pins of a GPIO port.
+ *
+ * @param port Port index, 0 for port A to 5 for port F.
+ * @param mask Pins to change.
+ * @param levels New levels of those pins.
+ *
+ * @return None
+ */
+void Sim_GPIO_Set_Input(int port, uint8_t mask, uint8_t levels);
+
+/**
+ * @brief Called by the GPIO model when a write to the DATA register changes the output levels of a port.
+ */
+typedef void (*Sim_GPIO_Output_Hook)(int port, uint64_t time, uint8_t previous, uint8_t levels);
+
+/**
+ * @brief The Sim_GPIO_Set_Output_Hook function connects a model to the GPIO outputs.
+ *
+ * @param hook The function to call for every change of the output levels.
+ *
+ * @return None
+ */
+void Sim_GPIO_Set_Output_Hook(Sim_GPIO_Output_Hook hook);
+
+/**
+ * @brief The Sim_UDMA_Request function lets a peripheral pull one item from a uDMA channel.
+ *
+ * @param channel The uDMA channel number.
+ * @param data Receives the item.
+ *
+ * @return 1 if an item was transferred, 2 if it was the last item of the transfer,
+ * 0 if the channel is disabled or masked.
+ */
+int Sim_UDMA_Request(int channel, uint32_t *data);
+
+/**
+ * @brief The Sim_Timer_Capture_Edge function applies an edge to the capture pin of a timer.
+ *
+ * @param timer_base Base address of the timer module.
+ * @param half 0 for timer A (CCP0), 1 for timer B (CCP1).
+ * @param time Time of the edge in cycles.
+ * @param level Level after the edge.
+ *
+ * @return None
+ */
+void Sim_Timer_Capture_Edge(uint32_t timer_base, int half, uint64_t time, int level);
+
+/**
+ * @brief Called by the timer model for every edge on a PWM output (CCP pin) of a timer.
+ */
+typedef void (*Sim_Timer_Output_Hook)(uint32_t timer_base, int half, uint64_t time, int level);
+
+/**
+ * @brief The Sim_Timer_Set_Output_Hook function connects a model to the timer PWM outputs.
+ *
+ * @param hook The function to call for every output edge.
+ *
+ * @return None
+ */
+void Sim_Timer_Set_Output_Hook(Sim_Timer_Output_Hook hook);
+
+#endif
@@ -0,0 +1,879 @@
+/**
+ * @file Sim_Core.c
+ *
+ * @brief Source code for the simulated Cortex-M4 core: time, NVIC, PRIMASK and interrupt delivery.
+ *
+ * The firmware's main function runs as the host's main thread. Interrupt handlers are
+ * called from a periodic host timer signal (SIGALRM, every SIM_TICK_US microseconds)
+ * and right after any register access that raised an interrupt. A handler only runs when
+ * PRIMASK is clear and its priority is higher than the one of the running code, so the
+ * handlers preempt each other as they would on the target.
+ *
+ * The core peripherals on the private peripheral bus are modelled here as well: the
+ * NVIC and SCB registers (including the VECTACTIVE field and the SysTick pending bits of
+ * ICSR), the SysTick timer, the DWT cycle counter and the ITM stimulus ports (which are
+ * always ready). What is written to the stimulus ports is discarded, or appended to a file
+ * as the SWO packets a debug probe would capture. __get_IPSR returns the exception number of
+ * the running handler. __WFI sleeps until the next host timer signal, and the share of the
+ * time spent there is reported.
+ *
+ * Settings (environment variables):
+ * - SIM_RUN_MS: stop after this many milliseconds (default 0, run until interrupted)
+ * - SIM_TICK_US: period of the host timer signal in microseconds (default 100)
+ * - SIM_HANG_MS: after this many milliseconds, the firmware's main thread stops as if a task
+ *   were stuck in an endless loop with the interrupts enabled (default 0, never)
+ * - SIM_ITM_FILE: file that receives the ITM stimulus port writes, as SWO packets (header
+ *   byte (port << 3) | 0x03, then the 32-bit value, least significant byte first). When it is
+ *   set, the ITM and all its ports are enabled at reset, as a debugger would do (default none)
+ *
+ * When the simulation stops, a summary of the interrupt activity and of each model is
+ * written to standard error.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#define _GNU_SOURCE
+
+#include "Sim.h"
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+// Exception numbers are IRQn + 16
+#define SIM_EXCEPTION_COUNT (SIM_IRQ_COUNT + 16)
+
+// Execution priority of thread mode, lower than any configurable priority
+#define SIM_THREAD_PRIORITY 8
+
+#define SIM_MAX_UPDATE_HOOKS 16
+
+typedef void (*Sim_Handler)(void);
+
+#define SIM_VECTOR(number, name) extern void name(void) __attribute__((weak));
+#include "Sim_Vectors.h"
+#undef SIM_VECTOR
+
+static const Sim_Handler vector_table[SIM_EXCEPTION_COUNT] =
+{
+#define SIM_VECTOR(number, name) [number] = name,
+#include "Sim_Vectors.h"
+#undef SIM_VECTOR
+};
+
+static const char *const vector_names[SIM_EXCEPTION_COUNT] =
+{
+#define SIM_VECTOR(number, name) [number] = #name,
+#include "Sim_Vectors.h"
+#undef SIM_VECTOR
+};
+
+uint32_t SystemCoreClock = 50000000UL;
+
+static uint64_t start_ns;
+
+// Simulated system clock: the time was clock_base_cycles at clock_base_ns, and runs at clock_hz since
+static uint32_t clock_hz = 50000000UL;
+static uint64_t clock_base_ns;
+static uint64_t clock_base_cycles = 0;
+
+static Sim_Update_Hook update_hooks[SIM_MAX_UPDATE_HOOKS];
+static int update_hook_count = 0;
+
+static volatile uint8_t irq_enabled[SIM_EXCEPTION_COUNT];
+static volatile uint8_t irq_pending[SIM_EXCEPTION_COUNT];
+static volatile uint8_t irq_line[SIM_EXCEPTION_COUNT];
+static uint64_t irq_count[SIM_EXCEPTION_COUNT];
+
+static volatile uint32_t primask = 0;
+static volatile int active_priority = SIM_THREAD_PRIORITY;
+
+// Exception number of the running handler, 0 in thread mode (ICSR VECTACTIVE)
+static volatile int active_exception = 0;
+
+// Host time spent in __WFI
+static uint64_t sleep_ns = 0;
+
+// SysTick counter: periods start at systick_start_cycles, and systick_wraps have been counted
+static uint64_t systick_start_cycles = 0;
+static uint64_t systick_wraps = 0;
+
+// DWT cycle counter: CYCCNT was dwt_base_count at dwt_base_cycles
+static uint32_t dwt_base_count = 0;
+static uint64_t dwt_base_cycles = 0;
+
+// End of the stack region of the firmware (see Sim_Stack_Limit)
+static uint32_t *stack_limit;
+
+// File receiving the ITM stimulus port writes, or -1
+static int itm_fd = -1;
+static uint64_t itm_bytes = 0;
+
+static uint64_t run_ns = 0;
+static uint64_t hang_ns = 0;
+static volatile sig_atomic_t stop_requested = 0;
+
+static uint64_t Sim_Host_NS(void)
+{
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// Blocks the host timer signal and returns the previous signal mask
+static sigset_t Sim_Lock(void)
+{
+	sigset_t block;
+	sigset_t previous;
+	
+	sigemptyset(&block);
+	sigaddset(&block, SIGALRM);
+	sigprocmask(SIG_BLOCK, &block, &previous);
+	
+	return previous;
+}
+
+static void Sim_Unlock(sigset_t previous)
+{
+	sigprocmask(SIG_SETMASK, &previous, 0);
+}
+
+static int Sim_Exception_Number(IRQn_Type irq)
+{
+	int number = (int)irq + 16;
+	
+	return ((number > 0) && (number < SIM_EXCEPTION_COUNT)) ? number : 0;
+}
+
+// Configured priority of an exception, 0 (highest) to 7, as stored in the NVIC and SCB registers
+static int Sim_Priority(int number)
+{
+	if (number >= 16)
+	{
+		return SIM_REGISTERS(NVIC_Type, NVIC_BASE)->IP[number - 16] >> 5;
+	}
+	
+	if (number >= 4)
+	{
+		return SIM_REGISTERS(SCB_Type, SCB_BASE)->SHP[number - 4] >> 5;
+	}
+	
+	return -1;
+}
+
+static void Sim_Finish(const char *reason)
+{
+	int i;
+	
+	Sim_UART_Restore();
+	
+	Sim_Log("\nsim: stopped (%s) after %.3f s, system clock %u MHz\n", reason,
+	        (double)(Sim_Host_NS() - start_ns) / 1e9, (unsigned int)(Sim_Clock_Hz() / 1000000U));
+	Sim_Log("sim: %llu register accesses trapped\n", (unsigned long long)Sim_MMIO_Access_Count());
+	Sim_Log("sim: CPU asleep (WFI) %.1f%% of the time\n",
+	        (100.0 * (double)sleep_ns) / (double)(Sim_Host_NS() - start_ns + 1));
+	
+	for (i = 0; i < SIM_EXCEPTION_COUNT; i++)
+	{
+		if (irq_count[i] != 0)
+		{
+			Sim_Log("sim: %-20s %llu calls\n", vector_names[i], (unsigned long long)irq_count[i]);
+		}
+	}
+	
+	if (itm_fd >= 0)
+	{
+		Sim_Log("sim: itm wrote %llu bytes\n", (unsigned long long)itm_bytes);
+	}
+	
+	Sim_UART_Report();
+	Sim_Vehicle_Report();
+	Sim_Flash_Report();
+	
+	_exit(0);
+}
+
+void Sim_Stop(const char *reason)
+{
+	sigset_t previous = Sim_Lock();
+	
+	(void)previous;
+	
+	Sim_Finish(reason);
+}
+
+static void Sim_Timer_Signal(int signal_number)
+{
+	(void)signal_number;
+	
+	if (stop_requested)
+	{
+		Sim_Finish("interrupted");
+	}
+	
+	if ((run_ns != 0) && ((Sim_Host_NS() - start_ns) >= run_ns))
+	{
+		Sim_Finish("SIM_RUN_MS elapsed");
+	}
+	
+	// The trap that ends the access delivers the interrupts
+	if (!Sim_MMIO_In_Access())
+	{
+		Sim_Service();
+	}
+}
+
+static void Sim_Stop_Signal(int signal_number)
+{
+	(void)signal_number;
+	
+	stop_requested = 1;
+}
+
+uint64_t Sim_Now(void)
+{
+	return clock_base_cycles + (Sim_Host_NS() - clock_base_ns) * (clock_hz / 1000U) / 1000000U;
+}
+
+uint32_t Sim_Clock_Hz(void)
+{
+	return clock_hz;
+}
+
+void Sim_Set_Clock_Hz(uint32_t hz)
+{
+	sigset_t previous;
+	uint64_t now_ns;
+	
+	if ((hz == clock_hz) || (hz < 1000U))
+	{
+		return;
+	}
+	
+	// The cycle count carries on from its current value at the new rate
+	previous = Sim_Lock();
+	now_ns = Sim_Host_NS();
+	clock_base_cycles += (now_ns - clock_base_ns) * (clock_hz / 1000U) / 1000000U;
+	clock_base_ns = now_ns;
+	clock_hz = hz;
+	Sim_Unlock(previous);
+}
+
+void Sim_Add_Update_Hook(Sim_Update_Hook hook)
+{
+	if (update_hook_count < SIM_MAX_UPDATE_HOOKS)
+	{
+		update_hooks[update_hook_count++] = hook;
+	}
+}
+
+void Sim_Update(void)
+{
+	uint64_t now = Sim_Now();
+	int i;
+	
+	for (i = 0; i < update_hook_count; i++)
+	{
+		update_hooks[i](now);
+	}
+}
+
+void Sim_Set_IRQ_Line(IRQn_Type irq, int level)
+{
+	irq_line[Sim_Exception_Number(irq)] = (uint8_t)(level != 0);
+}
+
+void Sim_Pend_IRQ(IRQn_Type irq)
+{
+	irq_pending[Sim_Exception_Number(irq)] = 1;
+}
+
+int Sim_NVIC_Is_Enabled(IRQn_Type irq)
+{
+	return irq_enabled[Sim_Exception_Number(irq)];
+}
+
+void Sim_Deliver_Interrupts(void)
+{
+	while (primask == 0)
+	{
+		int selected = 0;
+		int selected_priority = active_priority;
+		int saved_priority;
+		int saved_exception;
+		int number;
+		
+		for (number = 1; number < SIM_EXCEPTION_COUNT; number++)
+		{
+			if ((irq_pending[number] || irq_line[number]) && irq_enabled[number])
+			{
+				int priority = Sim_Priority(number);
+				
+				if (priority < selected_priority)
+				{
+					selected = number;
+					selected_priority = priority;
+				}
+			}
+		}
+		
+		if (selected == 0)
+		{
+			return;
+		}
+		
+		irq_pending[selected] = 0;
+		
+		if (vector_table[selected] == 0)
+		{
+			Sim_Log("sim: no handler for exception %d, disabling it\n", selected);
+			irq_enabled[selected] = 0;
+			continue;
+		}
+		
+		saved_priority = active_priority;
+		saved_exception = active_exception;
+		active_priority = selected_priority;
+		active_exception = selected;
+		irq_count[selected]++;
+		
+		vector_table[selected]();
+		
+		active_priority = saved_priority;
+		active_exception = saved_exception;
+	}
+}
+
+void Sim_Service(void)
+{
+	Sim_Update();
+	Sim_Deliver_Interrupts();
+}
+
+// Length of a SysTick period, in system clock cycles
+static uint64_t Sim_SysTick_Period(void)
+{
+	SysTick_Type *systick = SIM_REGISTERS(SysTick_Type, SysTick_BASE);
+	uint64_t period = (uint64_t)(systick->LOAD & 0x00FFFFFF) + 1;
+	
+	// CLKSOURCE (Bit 2) clear selects the precision internal oscillator divided by 4 (4 MHz)
+	if ((systick->CTRL & 0x04) == 0)
+	{
+		period = period * Sim_Clock_Hz() / 4000000U;
+	}
+	
+	return period;
+}
+
+static void Sim_SysTick_Update(uint64_t now)
+{
+	SysTick_Type *systick = SIM_REGISTERS(SysTick_Type, SysTick_BASE);
+	uint64_t wraps;
+	
+	if ((systick->CTRL & 0x01) == 0)
+	{
+		return;
+	}
+	
+	wraps = (now - systick_start_cycles) / Sim_SysTick_Period();
+	
+	if (wraps != systick_wraps)
+	{
+		systick_wraps = wraps;
+		
+		// COUNTFLAG (Bit 16), and the exception if TICKINT (Bit 1) is set
+		systick->CTRL |= 0x10000;
+		
+		if (systick->CTRL & 0x02)
+		{
+			irq_pending[SysTick_IRQn + 16] = 1;
+		}
+	}
+}
+
+static void Sim_SCS_Pre_Access(uint32_t offset)
+{
+	SysTick_Type *systick = SIM_REGISTERS(SysTick_Type, SysTick_BASE);
+	NVIC_Type *nvic = SIM_REGISTERS(NVIC_Type, NVIC_BASE);
+	SCB_Type *scb = SIM_REGISTERS(SCB_Type, SCB_BASE);
+	uint32_t bank;
+	int bit;
+	
+	if (offset == 0xD04)
+	{
+		// ICSR: VECTACTIVE (Bits 8 to 0) and PENDSTSET (Bit 26)
+		scb->ICSR = (uint32_t)active_exception | (irq_pending[SysTick_IRQn + 16] ? 0x04000000UL : 0);
+	}
+	else if (offset == 0x018)
+	{
+		// SysTick VAL counts down from LOAD
+		if (systick->CTRL & 0x01)
+		{
+			uint64_t period = Sim_SysTick_Period();
+			uint64_t phase = (Sim_Now() - systick_start_cycles) % period;
+			
+			systick->VAL = (uint32_t)((period - 1 - phase) * (systick->LOAD + 1) / period);
+		}
+	}
+	else if ((offset >= 0x100) && (offset < 0x300))
+	{
+		// ISER, ICER, ISPR and ICPR report the enable and pending state of 32 interrupts each
+		bank = ((offset - 0x100) & 0x7F) / 4;
+		
+		if (bank < 8)
+		{
+			uint32_t value = 0;
+			
+			for (bit = 0; bit < 32; bit++)
+			{
+				int number = 16 + (int)bank * 32 + bit;
+				
+				if ((number < SIM_EXCEPTION_COUNT) &&
+				    ((offset < 0x200) ? irq_enabled[number] : (irq_pending[number] || irq_line[number])))
+				{
+					value |= 1UL << bit;
+				}
+			}
+			
+			if (offset < 0x180)
+			{
+				nvic->ISER[bank] = value;
+			}
+			else if (offset < 0x200)
+			{
+				nvic->ICER[bank] = value;
+			}
+			else if (offset < 0x280)
+			{
+				nvic->ISPR[bank] = value;
+			}
+			else
+			{
+				nvic->ICPR[bank] = value;
+			}
+		}
+	}
+}
+
+static void Sim_SCS_Post_Access(uint32_t offset, int is_write)
+{
+	SysTick_Type *systick = SIM_REGISTERS(SysTick_Type, SysTick_BASE);
+	SCB_Type *scb = SIM_REGISTERS(SCB_Type, SCB_BASE);
+	uint32_t *word = Sim_MMIO_Alias(0xE000E000UL + (offset & ~3UL));
+	int bit;
+	
+	if (offset == 0x010)
+	{
+		if (is_write)
+		{
+			// Enabling the counter starts a new period
+			systick_start_cycles = Sim_Now();
+			systick_wraps = 0;
+		}
+		else
+		{
+			// Reading CTRL clears COUNTFLAG
+			systick->CTRL &= ~0x10000UL;
+		}
+	}
+	else if ((offset == 0x018) && is_write)
+	{
+		// Any write to VAL clears it and COUNTFLAG, and restarts the period
+		systick->VAL = 0;
+		systick->CTRL &= ~0x10000UL;
+		systick_start_cycles = Sim_Now();
+		systick_wraps = 0;
+	}
+	else if ((offset >= 0x100) && (offset < 0x300) && is_write)
+	{
+		uint32_t bank = ((offset - 0x100) & 0x7F) / 4;
+		uint32_t value = *word;
+		
+		for (bit = 0; bit < 32; bit++)
+		{
+			int number = 16 + (int)bank * 32 + bit;
+			
+			if ((bank >= 8) || (number >= SIM_EXCEPTION_COUNT) || ((value & (1UL << bit)) == 0))
+			{
+				continue;
+			}
+			
+			if (offset < 0x180)
+			{
+				irq_enabled[number] = 1;
+			}
+			else if (offset < 0x200)
+			{
+				irq_enabled[number] = 0;
+			}
+			else if (offset < 0x280)
+			{
+				irq_pending[number] = 1;
+			}
+			else
+			{
+				irq_pending[number] = 0;
+			}
+		}
+	}
+	else if ((offset == 0xD04) && is_write)
+	{
+		// ICSR: PENDSTSET (Bit 26) and PENDSTCLR (Bit 25) set and clear the SysTick exception
+		if (scb->ICSR & 0x04000000UL)
+		{
+			irq_pending[SysTick_IRQn + 16] = 1;
+		}
+		else if (scb->ICSR & 0x02000000UL)
+		{
+			irq_pending[SysTick_IRQn + 16] = 0;
+		}
+		
+		scb->ICSR = 0;
+	}
+	else if ((offset == 0xD0C) && is_write)
+	{
+		// AIRCR: SYSRESETREQ (Bit 2) with the 0x05FA key
+		if (((scb->AIRCR >> SCB_AIRCR_VECTKEY_Pos) == 0x05FA) && (scb->AIRCR & SCB_AIRCR_SYSRESETREQ_Msk))
+		{
+			Sim_Finish("system reset requested");
+		}
+		
+		scb->AIRCR = 0xFA050000UL;
+	}
+}
+
+static void Sim_DWT_Pre_Access(uint32_t offset)
+{
+	DWT_Type *dwt = SIM_REGISTERS(DWT_Type, DWT_BASE);
+	
+	if ((offset == 0x004) && (dwt->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+	{
+		dwt->CYCCNT = dwt_base_count + (uint32_t)(Sim_Now() - dwt_base_cycles);
+	}
+}
+
+static void Sim_DWT_Post_Access(uint32_t offset, int is_write)
+{
+	DWT_Type *dwt = SIM_REGISTERS(DWT_Type, DWT_BASE);
+	
+	// Writing CYCCNT or enabling the counter restarts the count from the current value
+	if (is_write && ((offset == 0x000) || (offset == 0x004)))
+	{
+		dwt_base_count = dwt->CYCCNT;
+		dwt_base_cycles = Sim_Now();
+	}
+}
+
+static void Sim_ITM_Pre_Access(uint32_t offset)
+{
+	ITM_Type *itm = SIM_REGISTERS(ITM_Type, ITM_BASE);
+	
+	// The stimulus ports always read as ready
+	if (offset < 0x80)
+	{
+		itm->PORT[offset / 4].u32 = 1;
+	}
+}
+
+static void Sim_ITM_Post_Access(uint32_t offset, int is_write)
+{
+	ITM_Type *itm = SIM_REGISTERS(ITM_Type, ITM_BASE);
+	uint8_t packet[5];
+	uint32_t value;
+	
+	if (!is_write || (offset >= 0x80) || (itm_fd < 0))
+	{
+		return;
+	}
+	
+	// A write to a disabled port is ignored, as on the target
+	if (((itm->TCR & ITM_TCR_ITMENA_Msk) == 0) || ((itm->TER & (1UL << (offset / 4))) == 0))
+	{
+		return;
+	}
+	
+	value = itm->PORT[offset / 4].u32;
+	
+	// Software source packet with a 4-byte payload
+	packet[0] = (uint8_t)(((offset / 4) << 3) | 0x03);
+	packet[1] = (uint8_t)value;
+	packet[2] = (uint8_t)(value >> 8);
+	packet[3] = (uint8_t)(value >> 16);
+	packet[4] = (uint8_t)(value >> 24);
+	
+	if (write(itm_fd, packet, sizeof(packet)) == (ssize_t)sizeof(packet))
+	{
+		itm_bytes += sizeof(packet);
+	}
+}
+
+static void Sim_ITM_Init(void)
+{
+	ITM_Type *itm = SIM_REGISTERS(ITM_Type, ITM_BASE);
+	const char *path = getenv("SIM_ITM_FILE");
+	
+	if ((path == 0) || (*path == '\0'))
+	{
+		return;
+	}
+	
+	itm_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	
+	if (itm_fd < 0)
+	{
+		Sim_Log("sim: cannot create the ITM file\n");
+		exit(1);
+	}
+	
+	itm->TCR = ITM_TCR_ITMENA_Msk;
+	itm->TER = 0xFFFFFFFFUL;
+}
+
+long Sim_Env_Int(const char *name, long default_value)
+{
+	const char *value = getenv(name);
+	
+	return ((value != 0) && (*value != '\0')) ? strtol(value, 0, 0) : default_value;
+}
+
+void Sim_Log(const char *format, ...)
+{
+	char buffer[512];
+	va_list arguments;
+	int length;
+	
+	va_start(arguments, format);
+	length = vsnprintf(buffer, sizeof(buffer), format, arguments);
+	va_end(arguments);
+	
+	if (length > (int)sizeof(buffer) - 1)
+	{
+		length = sizeof(buffer) - 1;
+	}
+	
+	if (length > 0)
+	{
+		ssize_t written = write(STDERR_FILENO, buffer, (size_t)length);
+		(void)written;
+	}
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+	sigset_t previous = Sim_Lock();
+	
+	irq_enabled[Sim_Exception_Number(IRQn)] = 1;
+	Sim_Service();
+	
+	Sim_Unlock(previous);
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+	irq_enabled[Sim_Exception_Number(IRQn)] = 0;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+	sigset_t previous = Sim_Lock();
+	
+	Sim_Pend_IRQ(IRQn);
+	Sim_Deliver_Interrupts();
+	
+	Sim_Unlock(previous);
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+	irq_pending[Sim_Exception_Number(IRQn)] = 0;
+}
+
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+	int number = Sim_Exception_Number(IRQn);
+	
+	// The TM4C123 implements the 3 most significant bits of each priority byte
+	if (number >= 16)
+	{
+		SIM_REGISTERS(NVIC_Type, NVIC_BASE)->IP[number - 16] = (uint8_t)((priority << 5) & 0xE0);
+	}
+	else if (number >= 4)
+	{
+		SIM_REGISTERS(SCB_Type, SCB_BASE)->SHP[number - 4] = (uint8_t)((priority << 5) & 0xE0);
+	}
+}
+
+void NVIC_SystemReset(void)
+{
+	sigset_t previous = Sim_Lock();
+	
+	(void)previous;
+	
+	Sim_Finish("system reset requested");
+}
+
+void __enable_irq(void)
+{
+	sigset_t previous = Sim_Lock();
+	
+	primask = 0;
+	Sim_Deliver_Interrupts();
+	
+	Sim_Unlock(previous);
+}
+
+void __disable_irq(void)
+{
+	primask = 1;
+}
+
+uint32_t __get_PRIMASK(void)
+{
+	return primask;
+}
+
+void __set_PRIMASK(uint32_t value)
+{
+	if (value & 1)
+	{
+		__disable_irq();
+	}
+	else
+	{
+		__enable_irq();
+	}
+}
+
+uint32_t *Sim_Stack_Limit(void)
+{
+	return stack_limit;
+}
+
+uint32_t __get_IPSR(void)
+{
+	return (uint32_t)active_exception;
+}
+
+uint32_t __get_MSP(void)
+{
+	return (uint32_t)(uintptr_t)__builtin_frame_address(0);
+}
+
+void __WFI(void)
+{
+	sigset_t previous = Sim_Lock();
+	int number;
+	
+	// The idle loop calls __WFI often, which makes it a convenient place to hang the main
+	// thread: from then on, only the interrupt handlers run
+	if ((hang_ns != 0) && ((Sim_Host_NS() - start_ns) >= hang_ns))
+	{
+		Sim_Log("sim: main thread stuck (SIM_HANG_MS)\n");
+		primask = 0;
+		
+		// Outside the idle loop, the SysTick wake-up timer would not be running
+		SIM_REGISTERS(SysTick_Type, SysTick_BASE)->CTRL = 0;
+		
+		while (1)
+		{
+			Sim_Service();
+			sigsuspend(&previous);
+		}
+	}
+	
+	Sim_Service();
+	
+	// Sleep until the next host timer signal unless an enabled interrupt is already pending,
+	// even if PRIMASK prevents it from being taken
+	for (number = 1; number < SIM_EXCEPTION_COUNT; number++)
+	{
+		if ((irq_pending[number] || irq_line[number]) && irq_enabled[number])
+		{
+			break;
+		}
+	}
+	
+	if (number == SIM_EXCEPTION_COUNT)
+	{
+		uint64_t sleep_start_ns = Sim_Host_NS();
+		
+		sigsuspend(&previous);
+		sleep_ns += Sim_Host_NS() - sleep_start_ns;
+	}
+	
+	Sim_Unlock(previous);
+}
+
+void __WFE(void)
+{
+	__WFI();
+}
+
+void __SEV(void)
+{
+}
+
+__attribute__((constructor)) static void Sim_Start(void)
+{
+	struct sigaction action;
+	struct itimerval tick;
+	long tick_us = Sim_Env_Int("SIM_TICK_US", 100);
+	int number;
+	
+	start_ns = Sim_Host_NS();
+	clock_base_ns = start_ns;
+	
+	// main is called from the same frame as this constructor, so its stack starts near here
+	stack_limit = (uint32_t *)((uintptr_t)__builtin_frame_address(0) & ~(uintptr_t)15);
+	
+	Sim_MMIO_Init();
+	
+	Sim_MMIO_Register(ITM_BASE, Sim_ITM_Pre_Access, Sim_ITM_Post_Access);
+	Sim_MMIO_Register(DWT_BASE, Sim_DWT_Pre_Access, Sim_DWT_Post_Access);
+	Sim_MMIO_Register(0xE000E000UL, Sim_SCS_Pre_Access, Sim_SCS_Post_Access);
+	Sim_Add_Update_Hook(Sim_SysTick_Update);
+	*(volatile uint32_t *)Sim_MMIO_Alias(SCB_BASE) = 0x410FC241UL;
+	SIM_REGISTERS(SCB_Type, SCB_BASE)->AIRCR = 0xFA050000UL;
+	
+	// System exceptions are always enabled
+	for (number = 1; number < 16; number++)
+	{
+		irq_enabled[number] = 1;
+	}
+	
+	Sim_System_Init();
+	Sim_UART_Init();
+	Sim_Timer_Init();
+	Sim_Vehicle_Init();
+	Sim_Flash_Init();
+	Sim_ITM_Init();
+	
+	run_ns = (uint64_t)Sim_Env_Int("SIM_RUN_MS", 0) * 1000000ULL;
+	hang_ns = (uint64_t)Sim_Env_Int("SIM_HANG_MS", 0) * 1000000ULL;
+	
+	memset(&action, 0, sizeof(action));
+	sigemptyset(&action.sa_mask);
+	
+	action.sa_handler = Sim_Stop_Signal;
+	sigaction(SIGINT, &action, 0);
+	sigaction(SIGTERM, &action, 0);
+	
+	action.sa_handler = Sim_Timer_Signal;
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGALRM, &action, 0);
+	
+	tick.it_interval.tv_sec = tick_us / 1000000;
+	tick.it_interval.tv_usec = tick_us % 1000000;
+	tick.it_value = tick.it_interval;
+	setitimer(ITIMER_REAL, &tick, 0);
+	
+	Sim_Log("sim: TM4C123GH6PM at %u MHz\n", (unsigned int)(Sim_Clock_Hz() / 1000000U));
+}
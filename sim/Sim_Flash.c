@@ -0,0 +1,277 @@
+/**
+ * @file Sim_Flash.c
+ *
+ * @brief Source code for the Flash memory controller and EEPROM models.
+ *
+ * The upper half of the flash memory (0x00020000 to 0x0003FFFF) is mapped read-only at its
+ * real address, backed by a file when SIM_FLASH_FILE names one, so that its contents survive
+ * from one run to the next, and by an anonymous memory object otherwise. The firmware itself
+ * is not in it: it only holds the data that the firmware programs at run time.
+ *
+ * Writes to FMC with the right key (WRKEY, selected by the KEY bit of BOOTCFG) program the
+ * word at FMA with FMD (WRITE), which can only clear bits as on the target, or erase the
+ * 1 KB sector at FMA to 0xFF (ERASE). The operations complete at once, so the firmware
+ * never sees the WRITE and ERASE bits set.
+ *
+ * The 2 KB of EEPROM are kept in the same file, after the flash memory, or in the same
+ * anonymous memory object. A file that only holds the flash memory, from an older run, gets
+ * an erased EEPROM. Accesses to EERDWR and EERDWRINC read or write the word selected by
+ * EEBLOCK and EEOFFSET, and EERDWRINC accesses advance EEOFFSET within the block. Writes
+ * complete at once, so EEDONE always reads as 0.
+ *
+ * @note The write buffer (FWBVAL, FWBN and FMC2), the protection registers and the
+ * interrupts are not modelled, nor are the EEPROM protection, password and hiding registers.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#define _GNU_SOURCE
+
+#include "Sim.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SIM_FLASH_BASE 0x00020000UL
+#define SIM_FLASH_SIZE 0x00020000UL
+#define SIM_FLASH_SECTOR_SIZE 1024UL
+#define SIM_FLASH_SECTOR_COUNT (SIM_FLASH_SIZE / SIM_FLASH_SECTOR_SIZE)
+
+#define SIM_EEPROM_SIZE 2048UL
+#define SIM_EEPROM_BLOCK_WORDS 16
+#define SIM_EEPROM_WORDS (SIM_EEPROM_SIZE / 4)
+
+// WRITE (Bit 0) and ERASE (Bit 1) in the FMC register, and the WRKEY field (Bits 31 to 16)
+#define SIM_FLASH_FMC_WRITE 0x01
+#define SIM_FLASH_FMC_ERASE 0x02
+#define SIM_FLASH_FMC_WRKEY_MASK 0xFFFF0000UL
+
+// Write keys selected by the KEY bit (Bit 4) of the BOOTCFG register
+#define SIM_FLASH_BOOTCFG_KEY 0x10
+#define SIM_FLASH_KEY_SET   0xA4420000UL
+#define SIM_FLASH_KEY_CLEAR 0x71D50000UL
+
+// Writable alias of the flash memory, used by the controller model
+static uint8_t *flash_alias = 0;
+
+static uint64_t words_programmed = 0;
+static uint64_t sectors_erased = 0;
+static uint64_t rejected_operations = 0;
+static uint32_t sector_erase_count[SIM_FLASH_SECTOR_COUNT];
+
+// EEPROM contents, after the flash memory in the same memory object
+static uint32_t *eeprom_words = 0;
+
+static uint64_t eeprom_words_read = 0;
+static uint64_t eeprom_words_written = 0;
+
+// Index of the word selected by EEBLOCK and EEOFFSET, or -1 if the block does not exist
+static int32_t Sim_EEPROM_Word_Index(const EEPROM_Type *eeprom)
+{
+	uint32_t index = (eeprom->EEBLOCK * SIM_EEPROM_BLOCK_WORDS) + (eeprom->EEOFFSET % SIM_EEPROM_BLOCK_WORDS);
+	
+	return (index < SIM_EEPROM_WORDS) ? (int32_t)index : -1;
+}
+
+static void Sim_EEPROM_Pre_Access(uint32_t offset)
+{
+	EEPROM_Type *eeprom = SIM_REGISTERS(EEPROM_Type, EEPROM_BASE);
+	int32_t index = Sim_EEPROM_Word_Index(eeprom);
+	
+	// The selected word is loaded before every access: a write overwrites it anyway
+	if ((offset == offsetof(EEPROM_Type, EERDWR)) || (offset == offsetof(EEPROM_Type, EERDWRINC)))
+	{
+		if (index < 0)
+		{
+			eeprom->EERDWR = 0;
+			eeprom->EERDWRINC = 0;
+			return;
+		}
+		
+		eeprom->EERDWR = eeprom_words[index];
+		eeprom->EERDWRINC = eeprom_words[index];
+	}
+}
+
+static void Sim_EEPROM_Post_Access(uint32_t offset, int is_write)
+{
+	EEPROM_Type *eeprom = SIM_REGISTERS(EEPROM_Type, EEPROM_BASE);
+	int32_t index = Sim_EEPROM_Word_Index(eeprom);
+	
+	if ((offset != offsetof(EEPROM_Type, EERDWR)) && (offset != offsetof(EEPROM_Type, EERDWRINC)))
+	{
+		return;
+	}
+	
+	if (index >= 0)
+	{
+		if (is_write)
+		{
+			eeprom_words[index] = (offset == offsetof(EEPROM_Type, EERDWR)) ? eeprom->EERDWR : eeprom->EERDWRINC;
+			eeprom_words_written++;
+		}
+		else
+		{
+			eeprom_words_read++;
+		}
+	}
+	
+	// The offset wraps around within the block
+	if (offset == offsetof(EEPROM_Type, EERDWRINC))
+	{
+		eeprom->EEOFFSET = (eeprom->EEOFFSET + 1) % SIM_EEPROM_BLOCK_WORDS;
+	}
+}
+
+static void Sim_Flash_Post_Access(uint32_t offset, int is_write)
+{
+	FLASH_CTRL_Type *flash = SIM_REGISTERS(FLASH_CTRL_Type, FLASH_CTRL_BASE);
+	uint32_t command = flash->FMC;
+	uint32_t key = (flash->BOOTCFG & SIM_FLASH_BOOTCFG_KEY) ? SIM_FLASH_KEY_SET : SIM_FLASH_KEY_CLEAR;
+	uint32_t address = flash->FMA;
+	uint32_t sector;
+	uint32_t data;
+	
+	if (!is_write || (offset != offsetof(FLASH_CTRL_Type, FMC)))
+	{
+		return;
+	}
+	
+	// The bits read back as 0 once the operation is complete, and WRKEY always reads as 0
+	flash->FMC = 0;
+	
+	if ((command & (SIM_FLASH_FMC_WRITE | SIM_FLASH_FMC_ERASE)) == 0)
+	{
+		return;
+	}
+	
+	if (((command & SIM_FLASH_FMC_WRKEY_MASK) != key) || (address < SIM_FLASH_BASE) ||
+		(address >= SIM_FLASH_BASE + SIM_FLASH_SIZE))
+	{
+		if (rejected_operations++ == 0)
+		{
+			Sim_Log("sim: flash operation rejected (FMC 0x%08X, FMA 0x%08X)\n", (unsigned int)command, (unsigned int)address);
+		}
+		return;
+	}
+	
+	if (command & SIM_FLASH_FMC_ERASE)
+	{
+		sector = (address - SIM_FLASH_BASE) / SIM_FLASH_SECTOR_SIZE;
+		memset(flash_alias + sector * SIM_FLASH_SECTOR_SIZE, 0xFF, SIM_FLASH_SECTOR_SIZE);
+		sector_erase_count[sector]++;
+		sectors_erased++;
+	}
+	else
+	{
+		// Programming can only clear bits: a word must be erased before it is rewritten
+		memcpy(&data, flash_alias + ((address - SIM_FLASH_BASE) & ~3UL), 4);
+		data &= flash->FMD;
+		memcpy(flash_alias + ((address - SIM_FLASH_BASE) & ~3UL), &data, 4);
+		words_programmed++;
+	}
+}
+
+void Sim_Flash_Report(void)
+{
+	uint32_t most_erased = 0;
+	uint32_t i;
+	
+	for (i = 0; i < SIM_FLASH_SECTOR_COUNT; i++)
+	{
+		if (sector_erase_count[i] > most_erased)
+		{
+			most_erased = sector_erase_count[i];
+		}
+	}
+	
+	Sim_Log("sim: flash programmed %llu words, erased %llu sectors (at most %u times the same), %llu operations rejected\n",
+	        (unsigned long long)words_programmed, (unsigned long long)sectors_erased,
+	        (unsigned int)most_erased, (unsigned long long)rejected_operations);
+	Sim_Log("sim: eeprom read %llu words, wrote %llu words\n",
+	        (unsigned long long)eeprom_words_read, (unsigned long long)eeprom_words_written);
+}
+
+void Sim_Flash_Init(void)
+{
+	FLASH_CTRL_Type *flash = SIM_REGISTERS(FLASH_CTRL_Type, FLASH_CTRL_BASE);
+	EEPROM_Type *eeprom = SIM_REGISTERS(EEPROM_Type, EEPROM_BASE);
+	const char *path = getenv("SIM_FLASH_FILE");
+	struct stat file_status;
+	int is_new = 1;
+	int is_new_eeprom = 1;
+	void *mapping;
+	int fd;
+	
+	if ((path != 0) && (*path != '\0'))
+	{
+		fd = open(path, O_RDWR | O_CREAT, 0644);
+		
+		if ((fd >= 0) && (fstat(fd, &file_status) == 0))
+		{
+			is_new = (file_status.st_size != (off_t)SIM_FLASH_SIZE) &&
+				(file_status.st_size != (off_t)(SIM_FLASH_SIZE + SIM_EEPROM_SIZE));
+			is_new_eeprom = (file_status.st_size != (off_t)(SIM_FLASH_SIZE + SIM_EEPROM_SIZE));
+		}
+	}
+	else
+	{
+		fd = memfd_create("tm4c123_flash", 0);
+	}
+	
+	if ((fd < 0) || (ftruncate(fd, SIM_FLASH_SIZE + SIM_EEPROM_SIZE) != 0))
+	{
+		Sim_Log("sim: cannot create the flash file\n");
+		exit(1);
+	}
+	
+	mapping = mmap((void *)SIM_FLASH_BASE, SIM_FLASH_SIZE, PROT_READ, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+	
+	if (mapping != (void *)SIM_FLASH_BASE)
+	{
+		Sim_Log("sim: cannot map the flash memory at 0x%08X\n", (unsigned int)SIM_FLASH_BASE);
+		exit(1);
+	}
+	
+	// The alias covers the EEPROM too
+	mapping = mmap(0, SIM_FLASH_SIZE + SIM_EEPROM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	
+	if (mapping == MAP_FAILED)
+	{
+		Sim_Log("sim: cannot map the flash alias\n");
+		exit(1);
+	}
+	
+	close(fd);
+	flash_alias = mapping;
+	eeprom_words = (uint32_t *)(flash_alias + SIM_FLASH_SIZE);
+	
+	// A new device comes erased
+	if (is_new)
+	{
+		memset(flash_alias, 0xFF, SIM_FLASH_SIZE);
+	}
+	
+	if (is_new_eeprom)
+	{
+		memset(eeprom_words, 0xFF, SIM_EEPROM_SIZE);
+	}
+	
+	// Reset values: 256 KB of flash (FSIZE), 32 KB of SRAM (SSIZE), KEY set in BOOTCFG
+	flash->FSIZE = 0x7F;
+	flash->SSIZE = 0x7F;
+	flash->BOOTCFG = 0xFFFFFFFEUL;
+	
+	// Reset values: 32 blocks of 16 words (EESIZE), no operation in progress or to retry
+	eeprom->EESIZE = 0x00200200UL;
+	eeprom->EEDONE = 0;
+	eeprom->EESUPP = 0;
+	
+	Sim_MMIO_Register(FLASH_CTRL_BASE, 0, Sim_Flash_Post_Access);
+	Sim_MMIO_Register(EEPROM_BASE, Sim_EEPROM_Pre_Access, Sim_EEPROM_Post_Access);
+}
@@ -0,0 +1,292 @@
+/**
+ * @file Sim_MMIO.c
+ *
+ * @brief Source code for the simulated peripheral address space.
+ *
+ * The peripheral region (0x40000000 to 0x400FFFFF) and the private peripheral bus
+ * (0xE0000000 to 0xE000FFFF) are backed by one shared memory object, mapped twice:
+ *
+ * - at the real TM4C123 addresses, where the firmware accesses them. Pages that have a
+ *   peripheral model attached are kept inaccessible (PROT_NONE).
+ * - at an alias address chosen by the kernel, which is always accessible and is used
+ *   by the peripheral models to read and write the register values.
+ *
+ * A firmware access to a modelled page raises SIGSEGV. The fault handler advances the
+ * models, calls the pre-access hook so that the register holds its current value,
+ * opens the page and sets the x86 trap flag. The access instruction is then executed
+ * once more and raises SIGTRAP, whose handler closes the page again, calls the post-access
+ * hook to carry out the side effects (FIFO pops, write-1-to-clear bits, ...) and delivers
+ * any interrupt that became pending.
+ *
+ * @note This requires Linux on x86-64.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#define _GNU_SOURCE
+
+#include "Sim.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#define SIM_PAGE_SIZE 0x1000UL
+
+// x86 EFLAGS trap flag (single-step)
+#define SIM_TRAP_FLAG 0x100
+
+// x86 page fault error code: the access was a write
+#define SIM_PAGE_FAULT_WRITE 0x2
+
+// Largest number of pages touched by a single instruction
+#define SIM_MAX_OPEN_ACCESSES 4
+
+typedef struct
+{
+	uint32_t base;
+	uint32_t size;
+	uint32_t first_page;
+	uint8_t *alias;
+} Sim_Region;
+
+typedef struct
+{
+	Sim_Pre_Access_Hook pre;
+	Sim_Post_Access_Hook post;
+	uint8_t modelled;
+} Sim_Page;
+
+typedef struct
+{
+	Sim_Page *page;
+	uint32_t address;
+	int is_write;
+} Sim_Open_Access;
+
+static Sim_Region regions[] =
+{
+	{ 0x40000000UL, 0x100000UL, 0, 0 },   // peripherals
+	{ 0xE0000000UL, 0x010000UL, 0, 0 }    // ITM, DWT, SysTick, NVIC, SCB
+};
+
+#define SIM_REGION_COUNT (sizeof(regions) / sizeof(regions[0]))
+#define SIM_PAGE_COUNT   ((0x100000UL + 0x010000UL) / SIM_PAGE_SIZE)
+
+static Sim_Page pages[SIM_PAGE_COUNT];
+
+static Sim_Open_Access open_accesses[SIM_MAX_OPEN_ACCESSES];
+static volatile int open_count = 0;
+
+static volatile uint64_t access_count = 0;
+
+static Sim_Region *Sim_MMIO_Find_Region(uintptr_t address)
+{
+	unsigned int i;
+	
+	for (i = 0; i < SIM_REGION_COUNT; i++)
+	{
+		if ((address >= regions[i].base) && (address < (uintptr_t)regions[i].base + regions[i].size))
+		{
+			return &regions[i];
+		}
+	}
+	
+	return 0;
+}
+
+static Sim_Page *Sim_MMIO_Find_Page(uintptr_t address)
+{
+	Sim_Region *region = Sim_MMIO_Find_Region(address);
+	
+	if (region == 0)
+	{
+		return 0;
+	}
+	
+	return &pages[region->first_page + (address - region->base) / SIM_PAGE_SIZE];
+}
+
+static void Sim_MMIO_Protect(uint32_t address, int accessible)
+{
+	void *page_address = (void *)(uintptr_t)(address & ~(SIM_PAGE_SIZE - 1));
+	
+	mprotect(page_address, SIM_PAGE_SIZE, accessible ? (PROT_READ | PROT_WRITE) : PROT_NONE);
+}
+
+static void Sim_MMIO_Fault(int signal_number, siginfo_t *info, void *context)
+{
+	ucontext_t *ucontext = context;
+	uintptr_t address = (uintptr_t)info->si_addr;
+	Sim_Page *page = Sim_MMIO_Find_Page(address);
+	Sim_Open_Access *access;
+	
+	(void)signal_number;
+	
+	// Not a register access: let the fault kill the process as usual
+	if ((page == 0) || (open_count >= SIM_MAX_OPEN_ACCESSES))
+	{
+		signal(SIGSEGV, SIG_DFL);
+		return;
+	}
+	
+	// Unmodelled pages behave as plain memory from their first access on
+	if (!page->modelled)
+	{
+		Sim_MMIO_Protect((uint32_t)address, 1);
+		return;
+	}
+	
+	if (open_count == 0)
+	{
+		Sim_Update();
+	}
+	
+	access = &open_accesses[open_count++];
+	access->page = page;
+	access->address = (uint32_t)address;
+	access->is_write = (ucontext->uc_mcontext.gregs[REG_ERR] & SIM_PAGE_FAULT_WRITE) != 0;
+	access_count++;
+	
+	if (page->pre)
+	{
+		page->pre((uint32_t)address & (SIM_PAGE_SIZE - 1));
+	}
+	
+	Sim_MMIO_Protect((uint32_t)address, 1);
+	
+	// Stop again right after the access instruction
+	ucontext->uc_mcontext.gregs[REG_EFL] |= SIM_TRAP_FLAG;
+}
+
+static void Sim_MMIO_Trap(int signal_number, siginfo_t *info, void *context)
+{
+	ucontext_t *ucontext = context;
+	Sim_Open_Access accesses[SIM_MAX_OPEN_ACCESSES];
+	int count = open_count;
+	int i;
+	
+	(void)signal_number;
+	(void)info;
+	
+	if (count == 0)
+	{
+		signal(SIGTRAP, SIG_DFL);
+		return;
+	}
+	
+	ucontext->uc_mcontext.gregs[REG_EFL] &= ~SIM_TRAP_FLAG;
+	
+	memcpy(accesses, open_accesses, sizeof(accesses));
+	
+	for (i = 0; i < count; i++)
+	{
+		Sim_MMIO_Protect(accesses[i].address, 0);
+	}
+	
+	open_count = 0;
+	
+	for (i = 0; i < count; i++)
+	{
+		if (accesses[i].page->post)
+		{
+			accesses[i].page->post(accesses[i].address & (SIM_PAGE_SIZE - 1), accesses[i].is_write);
+		}
+	}
+	
+	// An interrupt raised by the access is taken right after the instruction, as on the target
+	Sim_Deliver_Interrupts();
+}
+
+void Sim_MMIO_Init(void)
+{
+	struct sigaction action;
+	uint32_t first_page = 0;
+	unsigned int i;
+	int fd;
+	
+	for (i = 0; i < SIM_REGION_COUNT; i++)
+	{
+		void *mapping;
+		
+		fd = memfd_create("tm4c123_registers", 0);
+		
+		if ((fd < 0) || (ftruncate(fd, regions[i].size) != 0))
+		{
+			Sim_Log("sim: cannot create the register file\n");
+			exit(1);
+		}
+		
+		mapping = mmap((void *)(uintptr_t)regions[i].base, regions[i].size, PROT_NONE,
+		               MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+		
+		if (mapping != (void *)(uintptr_t)regions[i].base)
+		{
+			Sim_Log("sim: cannot map the peripherals at 0x%08X\n", (unsigned int)regions[i].base);
+			exit(1);
+		}
+		
+		mapping = mmap(0, regions[i].size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		
+		if (mapping == MAP_FAILED)
+		{
+			Sim_Log("sim: cannot map the register alias\n");
+			exit(1);
+		}
+		
+		close(fd);
+		
+		regions[i].alias = mapping;
+		regions[i].first_page = first_page;
+		first_page += regions[i].size / SIM_PAGE_SIZE;
+	}
+	
+	// SA_NODEFER: interrupt handlers called from the trap access registers themselves
+	memset(&action, 0, sizeof(action));
+	action.sa_flags = SA_SIGINFO | SA_NODEFER;
+	sigemptyset(&action.sa_mask);
+	sigaddset(&action.sa_mask, SIGALRM);
+	
+	action.sa_sigaction = Sim_MMIO_Fault;
+	sigaction(SIGSEGV, &action, 0);
+	
+	action.sa_sigaction = Sim_MMIO_Trap;
+	sigaction(SIGTRAP, &action, 0);
+}
+
+void Sim_MMIO_Register(uint32_t base, Sim_Pre_Access_Hook pre, Sim_Post_Access_Hook post)
+{
+	Sim_Page *page = Sim_MMIO_Find_Page(base);
+	
+	if (page != 0)
+	{
+		page->pre = pre;
+		page->post = post;
+		page->modelled = 1;
+	}
+}
+
+void *Sim_MMIO_Alias(uint32_t address)
+{
+	Sim_Region *region = Sim_MMIO_Find_Region(address);
+	
+	if (region == 0)
+	{
+		return 0;
+	}
+	
+	return region->alias + (address - region->base);
+}
+
+int Sim_MMIO_In_Access(void)
+{
+	return (open_count != 0);
+}
+
+uint64_t Sim_MMIO_Access_Count(void)
+{
+	return access_count;
+}
@@ -0,0 +1,369 @@
+/**
+ * @file Sim_System.c
+ *
+ * @brief Source code for the System Control, Watchdog Timer 0 and GPIO models.
+ *
+ * System Control: every peripheral reports ready (PRxxx) as soon as its clock is enabled
+ * (RCGCxxx), and the PLL always reports lock. The system clock frequency follows the RCC
+ * and RCC2 registers (16 MHz crystal, 400 MHz PLL). RCC starts with the configuration of
+ * SystemInit, 50 MHz from the PLL, and RESC reports a power-on reset.
+ *
+ * Watchdog Timer 0: the counter runs on the system clock once INTEN is set, and is reloaded
+ * by writes to LOAD and ICR. The first time-out raises the interrupt; a time-out while the
+ * interrupt is still pending ends the simulation if RESEN is set, as the reset would. Writes
+ * are ignored while the registers are locked (LOCK).
+ *
+ * GPIO: ports A to F are modelled with the address-masked DATA register. Reads of output
+ * pins return the data latch, and reads of input pins return the levels applied by the
+ * other models (see Sim_GPIO_Set_Input). Changes of the output levels are reported to the
+ * output hook (see Sim_GPIO_Set_Output_Hook). Changes of the input levels raise the port
+ * interrupt as selected by the IS, IBE and IEV registers (edge or level, both edges,
+ * rising or falling), masked by IM and acknowledged through ICR.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Sim.h"
+
+#include <stddef.h>
+
+#define SIM_GPIO_PORT_COUNT 6
+
+static const uint32_t gpio_bases[SIM_GPIO_PORT_COUNT] =
+{
+	GPIOA_BASE, GPIOB_BASE, GPIOC_BASE, GPIOD_BASE, GPIOE_BASE, GPIOF_BASE
+};
+
+static const IRQn_Type gpio_irqs[SIM_GPIO_PORT_COUNT] =
+{
+	GPIOA_IRQn, GPIOB_IRQn, GPIOC_IRQn, GPIOD_IRQn, GPIOE_IRQn, GPIOF_IRQn
+};
+
+static uint8_t gpio_data[SIM_GPIO_PORT_COUNT];
+static uint8_t gpio_input[SIM_GPIO_PORT_COUNT];
+static Sim_GPIO_Output_Hook gpio_output_hook = 0;
+
+// Watchdog Timer 0: the counter was reloaded at wdt_start_cycles
+#define SIM_WDT_UNLOCK_KEY 0x1ACCE551UL
+#define SIM_WDT_INTEN 0x01
+#define SIM_WDT_RESEN 0x02
+
+static uint64_t wdt_start_cycles = 0;
+static int wdt_running = 0;
+static int wdt_locked = 0;
+static uint32_t wdt_saved_word = 0;
+
+static void Sim_SYSCTL_Pre_Access(uint32_t offset)
+{
+	SYSCTL_Type *sysctl = SIM_REGISTERS(SYSCTL_Type, SYSCTL_BASE);
+	const uint32_t first_ready = offsetof(SYSCTL_Type, PRWD);
+	const uint32_t first_clock = offsetof(SYSCTL_Type, RCGCWD);
+	
+	// PRxxx mirrors RCGCxxx: the peripherals are ready as soon as they are clocked
+	if ((offset >= first_ready) && (offset <= offsetof(SYSCTL_Type, PRWTIMER)))
+	{
+		volatile uint32_t *registers = (volatile uint32_t *)sysctl;
+		
+		registers[offset / 4] = registers[(offset - first_ready + first_clock) / 4];
+	}
+	else if (offset == offsetof(SYSCTL_Type, RIS))
+	{
+		// PLLLRIS (Bit 6): the PLL is locked
+		sysctl->RIS |= 0x40;
+	}
+	else if (offset == offsetof(SYSCTL_Type, PLLSTAT))
+	{
+		sysctl->PLLSTAT = 0x01;
+	}
+}
+
+// System clock frequency selected by the RCC and RCC2 registers
+static uint32_t Sim_SYSCTL_Clock_Hz(void)
+{
+	SYSCTL_Type *sysctl = SIM_REGISTERS(SYSCTL_Type, SYSCTL_BASE);
+	uint32_t rcc = sysctl->RCC;
+	uint32_t rcc2 = sysctl->RCC2;
+	int use_rcc2 = (rcc2 & 0x80000000UL) != 0;
+	int div400 = use_rcc2 && ((rcc2 & 0x40000000UL) != 0);
+	int bypass = use_rcc2 ? ((rcc2 & 0x800) != 0) : ((rcc & 0x800) != 0);
+	uint32_t source = use_rcc2 ? ((rcc2 >> 4) & 0x07) : ((rcc >> 4) & 0x03);
+	uint32_t divisor = 1;
+	uint32_t frequency;
+	
+	if (!bypass)
+	{
+		frequency = div400 ? 400000000UL : 200000000UL;
+	}
+	else
+	{
+		// OSCSRC: main oscillator, PIOSC, PIOSC / 4, then the low-frequency oscillators
+		frequency = (source <= 1) ? 16000000UL : ((source == 2) ? 4000000UL : 30000UL);
+	}
+	
+	// USESYSDIV (Bit 22)
+	if (rcc & 0x00400000UL)
+	{
+		if (div400)
+		{
+			divisor = ((rcc2 >> 22) & 0x7F) + 1;
+		}
+		else
+		{
+			divisor = use_rcc2 ? (((rcc2 >> 23) & 0x3F) + 1) : (((rcc >> 23) & 0x0F) + 1);
+		}
+	}
+	
+	return frequency / divisor;
+}
+
+static void Sim_SYSCTL_Post_Access(uint32_t offset, int is_write)
+{
+	if (is_write && ((offset == offsetof(SYSCTL_Type, RCC)) || (offset == offsetof(SYSCTL_Type, RCC2))))
+	{
+		Sim_Set_Clock_Hz(Sim_SYSCTL_Clock_Hz());
+	}
+}
+
+static void Sim_WDT_Update_Line(void)
+{
+	WATCHDOG0_Type *wdt = SIM_REGISTERS(WATCHDOG0_Type, WATCHDOG0_BASE);
+	
+	Sim_Set_IRQ_Line(WATCHDOG0_IRQn, (wdt->RIS & 0x01) && (wdt->CTL & SIM_WDT_INTEN));
+}
+
+static void Sim_WDT_Update(uint64_t now)
+{
+	WATCHDOG0_Type *wdt = SIM_REGISTERS(WATCHDOG0_Type, WATCHDOG0_BASE);
+	uint64_t period = (wdt->LOAD != 0) ? wdt->LOAD : 1;
+	
+	if (!wdt_running)
+	{
+		return;
+	}
+	
+	while ((now - wdt_start_cycles) >= period)
+	{
+		wdt_start_cycles += period;
+		
+		if ((wdt->RIS & 0x01) == 0)
+		{
+			wdt->RIS |= 0x01;
+			Sim_Log("sim: watchdog time-out at %.1f ms\n", (double)wdt_start_cycles * 1000.0 / (double)Sim_Clock_Hz());
+		}
+		else if (wdt->CTL & SIM_WDT_RESEN)
+		{
+			Sim_Stop("watchdog reset");
+		}
+	}
+	
+	Sim_WDT_Update_Line();
+}
+
+static void Sim_WDT_Pre_Access(uint32_t offset)
+{
+	WATCHDOG0_Type *wdt = SIM_REGISTERS(WATCHDOG0_Type, WATCHDOG0_BASE);
+	
+	// Keep the previous value, to undo writes to a locked register
+	wdt_saved_word = *(uint32_t *)Sim_MMIO_Alias(WATCHDOG0_BASE + (offset & ~3UL));
+	
+	if (offset == offsetof(WATCHDOG0_Type, VALUE))
+	{
+		wdt->VALUE = wdt_running ? (uint32_t)(wdt->LOAD - (Sim_Now() - wdt_start_cycles)) : wdt->LOAD;
+	}
+	else if (offset == offsetof(WATCHDOG0_Type, MIS))
+	{
+		wdt->MIS = (wdt->CTL & SIM_WDT_INTEN) ? (wdt->RIS & 0x01) : 0;
+	}
+	else if (offset == offsetof(WATCHDOG0_Type, LOCK))
+	{
+		wdt->LOCK = wdt_locked ? 1 : 0;
+	}
+}
+
+static void Sim_WDT_Post_Access(uint32_t offset, int is_write)
+{
+	WATCHDOG0_Type *wdt = SIM_REGISTERS(WATCHDOG0_Type, WATCHDOG0_BASE);
+	
+	if (!is_write)
+	{
+		return;
+	}
+	
+	if (offset == offsetof(WATCHDOG0_Type, LOCK))
+	{
+		wdt_locked = (wdt->LOCK != SIM_WDT_UNLOCK_KEY);
+		wdt->LOCK = wdt_locked ? 1 : 0;
+		return;
+	}
+	
+	if (wdt_locked)
+	{
+		*(uint32_t *)Sim_MMIO_Alias(WATCHDOG0_BASE + (offset & ~3UL)) = wdt_saved_word;
+		return;
+	}
+	
+	if (offset == offsetof(WATCHDOG0_Type, LOAD))
+	{
+		wdt_start_cycles = Sim_Now();
+	}
+	else if (offset == offsetof(WATCHDOG0_Type, CTL))
+	{
+		// INTEN (Bit 0) can only be cleared by a reset, and setting it starts the counter
+		wdt->CTL |= wdt_saved_word & SIM_WDT_INTEN;
+		
+		if ((wdt->CTL & SIM_WDT_INTEN) && !wdt_running)
+		{
+			wdt_running = 1;
+			wdt_start_cycles = Sim_Now();
+		}
+	}
+	else if (offset == offsetof(WATCHDOG0_Type, ICR))
+	{
+		// Any write clears the interrupt and reloads the counter
+		wdt->RIS = 0;
+		wdt->ICR = 0;
+		wdt_start_cycles = Sim_Now();
+	}
+	
+	Sim_WDT_Update_Line();
+}
+
+// Current level of every pin of a port: the data latch for outputs, the applied level for inputs
+static uint8_t Sim_GPIO_Levels(int port)
+{
+	GPIOA_Type *gpio = SIM_REGISTERS(GPIOA_Type, gpio_bases[port]);
+	uint8_t direction = (uint8_t)gpio->DIR;
+	
+	return (uint8_t)((gpio_data[port] & direction) | (gpio_input[port] & ~direction));
+}
+
+// Level-sensitive pins (IS) flag their interrupt for as long as the level matches IEV,
+// then the port interrupt line follows the unmasked flags
+static void Sim_GPIO_Update_Interrupt(int port)
+{
+	GPIOA_Type *gpio = SIM_REGISTERS(GPIOA_Type, gpio_bases[port]);
+	uint8_t inputs = (uint8_t)~gpio->DIR;
+	uint8_t level_pins = (uint8_t)(gpio->IS & inputs);
+	uint8_t active = (uint8_t)~(gpio_input[port] ^ gpio->IEV);
+	
+	gpio->RIS = (gpio->RIS & ~level_pins & 0xFF) | (level_pins & active);
+	
+	Sim_Set_IRQ_Line(gpio_irqs[port], (gpio->RIS & gpio->IM & 0xFF) != 0);
+}
+
+static void Sim_GPIO_Pre_Access(int port, uint32_t offset)
+{
+	GPIOA_Type *gpio = SIM_REGISTERS(GPIOA_Type, gpio_bases[port]);
+	
+	// Address bits 9 to 2 of a DATA access select the pins that are read or written
+	if (offset < 0x400)
+	{
+		gpio->DATA_Bits[offset / 4] = Sim_GPIO_Levels(port) & ((offset >> 2) & 0xFF);
+	}
+	else if (offset == offsetof(GPIOA_Type, MIS))
+	{
+		gpio->MIS = gpio->RIS & gpio->IM;
+	}
+}
+
+static void Sim_GPIO_Post_Access(int port, uint32_t offset, int is_write)
+{
+	GPIOA_Type *gpio = SIM_REGISTERS(GPIOA_Type, gpio_bases[port]);
+	
+	if ((offset < 0x400) && is_write)
+	{
+		uint8_t mask = (uint8_t)((offset >> 2) & 0xFF);
+		uint8_t previous = Sim_GPIO_Output(port);
+		
+		gpio_data[port] = (uint8_t)((gpio_data[port] & ~mask) | (gpio->DATA_Bits[offset / 4] & mask));
+		
+		if (gpio_output_hook && (Sim_GPIO_Output(port) != previous))
+		{
+			gpio_output_hook(port, Sim_Now(), previous, Sim_GPIO_Output(port));
+		}
+	}
+	else if ((offset == offsetof(GPIOA_Type, ICR)) && is_write)
+	{
+		// Writing 1 clears the edge flags; level flags are raised again while the level persists
+		gpio->RIS &= ~gpio->ICR;
+		gpio->ICR = 0;
+		Sim_GPIO_Update_Interrupt(port);
+	}
+	else if ((offset >= offsetof(GPIOA_Type, IS)) && (offset <= offsetof(GPIOA_Type, IM)) && is_write)
+	{
+		Sim_GPIO_Update_Interrupt(port);
+	}
+}
+
+#define SIM_GPIO_HOOKS(letter, index) \
+	static void Sim_GPIO##letter##_Pre_Access(uint32_t offset) { Sim_GPIO_Pre_Access(index, offset); } \
+	static void Sim_GPIO##letter##_Post_Access(uint32_t offset, int is_write) { Sim_GPIO_Post_Access(index, offset, is_write); }
+
+SIM_GPIO_HOOKS(A, 0)
+SIM_GPIO_HOOKS(B, 1)
+SIM_GPIO_HOOKS(C, 2)
+SIM_GPIO_HOOKS(D, 3)
+SIM_GPIO_HOOKS(E, 4)
+SIM_GPIO_HOOKS(F, 5)
+
+uint8_t Sim_GPIO_Output(int port)
+{
+	GPIOA_Type *gpio = SIM_REGISTERS(GPIOA_Type, gpio_bases[port]);
+	
+	return (uint8_t)(gpio_data[port] & gpio->DIR);
+}
+
+void Sim_GPIO_Set_Output_Hook(Sim_GPIO_Output_Hook hook)
+{
+	gpio_output_hook = hook;
+}
+
+void Sim_GPIO_Set_Input(int port, uint8_t mask, uint8_t levels)
+{
+	GPIOA_Type *gpio = SIM_REGISTERS(GPIOA_Type, gpio_bases[port]);
+	uint8_t previous = gpio_input[port];
+	uint8_t changed;
+	uint8_t rising;
+	uint8_t edges;
+	
+	gpio_input[port] = (uint8_t)((previous & ~mask) | (levels & mask));
+	
+	// Edge-sensitive input pins: both edges (IBE), or the rising (IEV set) or falling edge only
+	changed = (uint8_t)((previous ^ gpio_input[port]) & ~gpio->DIR & ~gpio->IS);
+	rising = (uint8_t)(changed & gpio_input[port]);
+	edges = (uint8_t)((changed & gpio->IBE) | (rising & gpio->IEV & ~gpio->IBE) | (changed & ~rising & ~gpio->IEV & ~gpio->IBE));
+	
+	gpio->RIS |= edges;
+	
+	Sim_GPIO_Update_Interrupt(port);
+}
+
+void Sim_System_Init(void)
+{
+	SYSCTL_Type *sysctl = SIM_REGISTERS(SYSCTL_Type, SYSCTL_BASE);
+	
+	// Device identification of the TM4C123GH6PM
+	sysctl->DID0 = 0x18050102UL;
+	sysctl->DID1 = 0x10A1606EUL;
+	
+	// RCC as left by SystemInit: 16 MHz crystal, PLL divided by 4 (50 MHz). RCC2 at its reset value
+	sysctl->RCC = 0x01CE0540UL;
+	sysctl->RCC2 = 0x07C06810UL;
+	
+	// Power-on reset (POR, Bit 1)
+	sysctl->RESC = 0x02;
+	
+	// Watchdog load register at its reset value
+	SIM_REGISTERS(WATCHDOG0_Type, WATCHDOG0_BASE)->LOAD = 0xFFFFFFFFUL;
+	
+	Sim_MMIO_Register(SYSCTL_BASE, Sim_SYSCTL_Pre_Access, Sim_SYSCTL_Post_Access);
+	Sim_MMIO_Register(WATCHDOG0_BASE, Sim_WDT_Pre_Access, Sim_WDT_Post_Access);
+	Sim_Add_Update_Hook(Sim_WDT_Update);
+	
+	Sim_MMIO_Register(GPIOA_BASE, Sim_GPIOA_Pre_Access, Sim_GPIOA_Post_Access);
+	Sim_MMIO_Register(GPIOB_BASE, Sim_GPIOB_Pre_Access, Sim_GPIOB_Post_Access);
+	Sim_MMIO_Register(GPIOC_BASE, Sim_GPIOC_Pre_Access, Sim_GPIOC_Post_Access);
+	Sim_MMIO_Register(GPIOD_BASE, Sim_GPIOD_Pre_Access, Sim_GPIOD_Post_Access);
+	Sim_MMIO_Register(GPIOE_BASE, Sim_GPIOE_Pre_Access, Sim_GPIOE_Post_Access);
+	Sim_MMIO_Register(GPIOF_BASE, Sim_GPIOF_Pre_Access, Sim_GPIOF_Post_Access);
+}
@@ -0,0 +1,522 @@
+/**
+ * @file Sim_Timer.c
+ *
+ * @brief Source code for the General-Purpose Timer model (TIMER0 to TIMER5, WTIMER0 to WTIMER5).
+ *
+ * The counters are not stepped: their value is computed from the simulated time elapsed
+ * since they were enabled, so that reads of TnV and captured values are exact to the cycle.
+ *
+ * Supported modes:
+ * - concatenated (CFG = 0) and split (CFG = 4) configurations
+ * - one-shot and periodic modes, counting up or down, with time-out and match interrupts
+ * - PWM mode, with the PWM output events (TnPWMIE) and an output hook for other models
+ * - edge-time capture mode, with the edges applied by Sim_Timer_Capture_Edge
+ *
+ * @note The prescalers, the edge-count mode and the RTC mode are not modelled.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Sim.h"
+
+#define SIM_TIMER_COUNT 12
+
+// Largest number of PWM periods whose edges are reported in one update
+#define SIM_TIMER_MAX_PWM_PERIODS 16
+
+// Interrupt bits of timer A in the IMR, RIS, MIS and ICR registers; timer B uses the same bits shifted by 8
+#define SIM_TIMER_TIMEOUT 0x01
+#define SIM_TIMER_CAPTURE_EVENT 0x04
+#define SIM_TIMER_MATCH 0x10
+
+typedef struct
+{
+	uint64_t start;   // time at which the counter was enabled
+	uint64_t last;    // time up to which the events have been generated
+	int running;
+} Sim_Timer_Half;
+
+typedef struct
+{
+	uint32_t base;
+	IRQn_Type irq_a;
+	IRQn_Type irq_b;
+	int wide;
+	Sim_Timer_Half half[2];
+} Sim_Timer;
+
+static Sim_Timer timers[SIM_TIMER_COUNT] =
+{
+	{ TIMER0_BASE, TIMER0A_IRQn, TIMER0B_IRQn, 0, { { 0 } } },
+	{ TIMER1_BASE, TIMER1A_IRQn, TIMER1B_IRQn, 0, { { 0 } } },
+	{ TIMER2_BASE, TIMER2A_IRQn, TIMER2B_IRQn, 0, { { 0 } } },
+	{ TIMER3_BASE, TIMER3A_IRQn, TIMER3B_IRQn, 0, { { 0 } } },
+	{ TIMER4_BASE, TIMER4A_IRQn, TIMER4B_IRQn, 0, { { 0 } } },
+	{ TIMER5_BASE, TIMER5A_IRQn, TIMER5B_IRQn, 0, { { 0 } } },
+	{ WTIMER0_BASE, WTIMER0A_IRQn, WTIMER0B_IRQn, 1, { { 0 } } },
+	{ WTIMER1_BASE, WTIMER1A_IRQn, WTIMER1B_IRQn, 1, { { 0 } } },
+	{ WTIMER2_BASE, WTIMER2A_IRQn, WTIMER2B_IRQn, 1, { { 0 } } },
+	{ WTIMER3_BASE, WTIMER3A_IRQn, WTIMER3B_IRQn, 1, { { 0 } } },
+	{ WTIMER4_BASE, WTIMER4A_IRQn, WTIMER4B_IRQn, 1, { { 0 } } },
+	{ WTIMER5_BASE, WTIMER5A_IRQn, WTIMER5B_IRQn, 1, { { 0 } } }
+};
+
+static Sim_Timer_Output_Hook output_hook = 0;
+
+static TIMER0_Type *Sim_Timer_Registers(const Sim_Timer *timer)
+{
+	return SIM_REGISTERS(TIMER0_Type, timer->base);
+}
+
+static Sim_Timer *Sim_Timer_Find(uint32_t base)
+{
+	int i;
+	
+	for (i = 0; i < SIM_TIMER_COUNT; i++)
+	{
+		if (timers[i].base == base)
+		{
+			return &timers[i];
+		}
+	}
+	
+	return 0;
+}
+
+static int Sim_Timer_Concatenated(const Sim_Timer *timer)
+{
+	return (Sim_Timer_Registers(timer)->CFG & 0x07) == 0;
+}
+
+// Mode register of a half: TAMR or TBMR. In the concatenated configuration, TAMR controls the whole timer
+static uint32_t Sim_Timer_Mode(const Sim_Timer *timer, int half)
+{
+	TIMER0_Type *registers = Sim_Timer_Registers(timer);
+	
+	return (half == 0) ? registers->TAMR : registers->TBMR;
+}
+
+// Counter reload value: the interval load registers, masked to the width of the counter
+static uint64_t Sim_Timer_Load(const Sim_Timer *timer, int half)
+{
+	TIMER0_Type *registers = Sim_Timer_Registers(timer);
+	
+	if (Sim_Timer_Concatenated(timer))
+	{
+		return timer->wide ? (((uint64_t)registers->TBILR << 32) | registers->TAILR) : registers->TAILR;
+	}
+	
+	if (timer->wide)
+	{
+		return (half == 0) ? registers->TAILR : registers->TBILR;
+	}
+	
+	return ((half == 0) ? registers->TAILR : registers->TBILR) & 0xFFFF;
+}
+
+// Counter period in cycles, or 0 if it is 2^64 (the counter never wraps)
+static uint64_t Sim_Timer_Period(const Sim_Timer *timer, int half)
+{
+	return Sim_Timer_Load(timer, half) + 1;
+}
+
+static int Sim_Timer_Counts_Up(const Sim_Timer *timer, int half)
+{
+	uint32_t mode = Sim_Timer_Mode(timer, half);
+	
+	// TnAMS (Bit 3): PWM mode always counts down. TnCDIR (Bit 4): count up
+	return ((mode & 0x08) == 0) && ((mode & 0x10) != 0);
+}
+
+static int Sim_Timer_One_Shot(const Sim_Timer *timer, int half)
+{
+	return (Sim_Timer_Mode(timer, half) & 0x03) == 0x01;
+}
+
+// Value of the counter of a half at a given time
+static uint64_t Sim_Timer_Value(const Sim_Timer *timer, int half, uint64_t time)
+{
+	const Sim_Timer_Half *state = &timer->half[half];
+	uint64_t load = Sim_Timer_Load(timer, half);
+	uint64_t period = Sim_Timer_Period(timer, half);
+	uint64_t elapsed = (time > state->start) ? (time - state->start) : 0;
+	uint64_t count;
+	
+	if (!state->running && (state->last < time))
+	{
+		elapsed = (state->last > state->start) ? (state->last - state->start) : 0;
+	}
+	
+	if (Sim_Timer_One_Shot(timer, half) && (period != 0) && (elapsed >= period))
+	{
+		count = load;
+	}
+	else
+	{
+		count = (period != 0) ? (elapsed % period) : elapsed;
+	}
+	
+	return Sim_Timer_Counts_Up(timer, half) ? count : (load - count);
+}
+
+// Number of times the counter of a half has reached its match value since it was enabled, up to a given time
+static uint64_t Sim_Timer_Match_Count(const Sim_Timer *timer, int half, uint64_t time)
+{
+	TIMER0_Type *registers = Sim_Timer_Registers(timer);
+	uint64_t load = Sim_Timer_Load(timer, half);
+	uint64_t period = Sim_Timer_Period(timer, half);
+	uint64_t elapsed = time - timer->half[half].start;
+	uint64_t match;
+	uint64_t offset;
+	
+	if (Sim_Timer_Concatenated(timer))
+	{
+		match = timer->wide ? (((uint64_t)registers->TBMATCHR << 32) | registers->TAMATCHR) : registers->TAMATCHR;
+	}
+	else
+	{
+		match = (half == 0) ? registers->TAMATCHR : registers->TBMATCHR;
+	}
+	
+	if ((period == 0) || (match > load))
+	{
+		return 0;
+	}
+	
+	// Time from the start of each period to the match: the counter starts from 0 counting up, from the load value counting down
+	offset = Sim_Timer_Counts_Up(timer, half) ? match : (load - match);
+	
+	return (elapsed < offset) ? 0 : (((elapsed - offset) / period) + 1);
+}
+
+static void Sim_Timer_Update_Lines(const Sim_Timer *timer)
+{
+	TIMER0_Type *registers = Sim_Timer_Registers(timer);
+	uint32_t pending = registers->RIS & registers->IMR;
+	
+	// In the concatenated configuration, all the events are reported on the timer A interrupt
+	if (Sim_Timer_Concatenated(timer))
+	{
+		Sim_Set_IRQ_Line(timer->irq_a, pending != 0);
+		Sim_Set_IRQ_Line(timer->irq_b, 0);
+	}
+	else
+	{
+		Sim_Set_IRQ_Line(timer->irq_a, (pending & 0x001F) != 0);
+		Sim_Set_IRQ_Line(timer->irq_b, (pending & 0x0F00) != 0);
+	}
+}
+
+// Checks if an edge matches the TnEVENT field of the CTL register
+static int Sim_Timer_Event_Matches(const Sim_Timer *timer, int half, int level)
+{
+	uint32_t event = (Sim_Timer_Registers(timer)->CTL >> (2 + half * 8)) & 0x03;
+	
+	return (event == 0x03) || ((event == 0x00) && level) || ((event == 0x01) && !level);
+}
+
+static void Sim_Timer_Output_Edge(Sim_Timer *timer, int half, uint64_t time, int level)
+{
+	TIMER0_Type *registers = Sim_Timer_Registers(timer);
+	
+	// TnPWML (Bit 6 for timer A, Bit 14 for timer B) inverts the output
+	if (registers->CTL & (0x40UL << (half * 8)))
+	{
+		level = !level;
+	}
+	
+	// TnPWMIE (Bit 9): the selected output edges raise the capture event
+	if ((Sim_Timer_Mode(timer, half) & 0x200) && Sim_Timer_Event_Matches(timer, half, level))
+	{
+		registers->RIS |= SIM_TIMER_CAPTURE_EVENT << (half * 8);
+	}
+	
+	if (output_hook)
+	{
+		output_hook(timer->base, half, time, level);
+	}
+}
+
+static void Sim_Timer_Update_PWM(Sim_Timer *timer, int half, uint64_t now)
+{
+	Sim_Timer_Half *state = &timer->half[half];
+	TIMER0_Type *registers = Sim_Timer_Registers(timer);
+	uint64_t period = Sim_Timer_Period(timer, half);
+	uint64_t match = (half == 0) ? registers->TAMATCHR : registers->TBMATCHR;
+	uint64_t high_cycles = Sim_Timer_Load(timer, half) - match;
+	uint64_t first;
+	uint64_t last;
+	uint64_t k;
+	
+	if ((period == 0) || (match >= period))
+	{
+		return;
+	}
+	
+	// The output rises at every reload (start of period k) and falls when the counter reaches the match value
+	first = (state->last - state->start) / period;
+	last = (now - state->start) / period;
+	
+	if (last - first > SIM_TIMER_MAX_PWM_PERIODS)
+	{
+		first = last - SIM_TIMER_MAX_PWM_PERIODS;
+	}
+	
+	for (k = first; k <= last; k++)
+	{
+		uint64_t rise = state->start + k * period;
+		uint64_t fall = rise + high_cycles;
+		
+		if ((rise > state->last) && (rise <= now))
+		{
+			Sim_Timer_Output_Edge(timer, half, rise, 1);
+		}
+		
+		if ((fall > state->last) && (fall <= now))
+		{
+			Sim_Timer_Output_Edge(timer, half, fall, 0);
+		}
+	}
+}
+
+static void Sim_Timer_Update_Half(Sim_Timer *timer, int half, uint64_t now)
+{
+	Sim_Timer_Half *state = &timer->half[half];
+	TIMER0_Type *registers = Sim_Timer_Registers(timer);
+	uint32_t mode = Sim_Timer_Mode(timer, half);
+	uint64_t period = Sim_Timer_Period(timer, half);
+	
+	if (!state->running || (now <= state->last))
+	{
+		return;
+	}
+	
+	if ((mode & 0x03) == 0x03)
+	{
+		// Capture mode: the events come from Sim_Timer_Capture_Edge
+	}
+	else if (mode & 0x08)
+	{
+		Sim_Timer_Update_PWM(timer, half, now);
+	}
+	else
+	{
+		// TnMIE (Bit 5): the counter reaching the match value raises the match interrupt
+		if ((mode & 0x20) && (Sim_Timer_Match_Count(timer, half, now) != Sim_Timer_Match_Count(timer, half, state->last)))
+		{
+			registers->RIS |= SIM_TIMER_MATCH << (half * 8);
+		}
+		
+		if ((period != 0) && ((now - state->start) / period != (state->last - state->start) / period))
+		{
+			registers->RIS |= SIM_TIMER_TIMEOUT << (half * 8);
+			
+			// A one-shot timer stops at its first time-out and clears TnEN
+			if (Sim_Timer_One_Shot(timer, half))
+			{
+				state->running = 0;
+				state->last = state->start + period;
+				registers->CTL &= ~(0x01UL << (half * 8));
+				return;
+			}
+		}
+	}
+	
+	state->last = now;
+}
+
+static void Sim_Timer_Update(uint64_t now)
+{
+	int i;
+	
+	for (i = 0; i < SIM_TIMER_COUNT; i++)
+	{
+		Sim_Timer_Update_Half(&timers[i], 0, now);
+		
+		if (!Sim_Timer_Concatenated(&timers[i]))
+		{
+			Sim_Timer_Update_Half(&timers[i], 1, now);
+		}
+		
+		Sim_Timer_Update_Lines(&timers[i]);
+	}
+}
+
+static void Sim_Timer_Pre_Access(Sim_Timer *timer, uint32_t offset)
+{
+	TIMER0_Type *registers = Sim_Timer_Registers(timer);
+	uint64_t now = Sim_Now();
+	
+	switch (offset)
+	{
+		case 0x020:
+			registers->MIS = registers->RIS & registers->IMR;
+			break;
+		
+		case 0x048:
+		case 0x050:
+			if (Sim_Timer_Concatenated(timer))
+			{
+				uint64_t value = Sim_Timer_Value(timer, 0, now);
+				
+				registers->TAV = (uint32_t)value;
+				registers->TBV = (uint32_t)(value >> 32);
+			}
+			else
+			{
+				registers->TAV = (uint32_t)Sim_Timer_Value(timer, 0, now);
+			}
+			
+			// In the periodic and one-shot modes, TnR holds the counter value as well
+			if (((registers->TAMR & 0x03) != 0x03) && (offset == 0x048))
+			{
+				registers->TAR = registers->TAV;
+			}
+			break;
+		
+		case 0x04C:
+		case 0x054:
+			if (Sim_Timer_Concatenated(timer))
+			{
+				registers->TBV = (uint32_t)(Sim_Timer_Value(timer, 0, now) >> 32);
+			}
+			else
+			{
+				registers->TBV = (uint32_t)Sim_Timer_Value(timer, 1, now);
+			}
+			
+			if (((registers->TBMR & 0x03) != 0x03) && (offset == 0x04C))
+			{
+				registers->TBR = registers->TBV;
+			}
+			break;
+	}
+}
+
+static void Sim_Timer_Post_Access(Sim_Timer *timer, uint32_t offset, int is_write)
+{
+	TIMER0_Type *registers = Sim_Timer_Registers(timer);
+	uint64_t now = Sim_Now();
+	int half;
+	
+	if (!is_write)
+	{
+		return;
+	}
+	
+	switch (offset)
+	{
+		case 0x00C:
+			// TAEN (Bit 0) and TBEN (Bit 8): the counter starts from its reload value when enabled
+			for (half = 0; half < 2; half++)
+			{
+				int enabled = (registers->CTL & (0x01UL << (half * 8))) != 0;
+				Sim_Timer_Half *state = &timer->half[half];
+				
+				if (enabled && !state->running)
+				{
+					state->start = now;
+					state->last = now;
+					state->running = 1;
+				}
+				else if (!enabled && state->running)
+				{
+					state->last = now;
+					state->running = 0;
+				}
+			}
+			break;
+		
+		case 0x024:
+			registers->RIS &= ~registers->ICR;
+			registers->ICR = 0;
+			break;
+	}
+	
+	Sim_Timer_Update_Lines(timer);
+}
+
+#define SIM_TIMER_HOOKS(index) \
+	static void Sim_Timer##index##_Pre_Access(uint32_t offset) { Sim_Timer_Pre_Access(&timers[index], offset); } \
+	static void Sim_Timer##index##_Post_Access(uint32_t offset, int is_write) { Sim_Timer_Post_Access(&timers[index], offset, is_write); }
+
+SIM_TIMER_HOOKS(0)
+SIM_TIMER_HOOKS(1)
+SIM_TIMER_HOOKS(2)
+SIM_TIMER_HOOKS(3)
+SIM_TIMER_HOOKS(4)
+SIM_TIMER_HOOKS(5)
+SIM_TIMER_HOOKS(6)
+SIM_TIMER_HOOKS(7)
+SIM_TIMER_HOOKS(8)
+SIM_TIMER_HOOKS(9)
+SIM_TIMER_HOOKS(10)
+SIM_TIMER_HOOKS(11)
+
+void Sim_Timer_Capture_Edge(uint32_t timer_base, int half, uint64_t time, int level)
+{
+	Sim_Timer *timer = Sim_Timer_Find(timer_base);
+	TIMER0_Type *registers;
+	uint32_t mode;
+	
+	if ((timer == 0) || Sim_Timer_Concatenated(timer) || !timer->half[half].running || (time < timer->half[half].start))
+	{
+		return;
+	}
+	
+	registers = Sim_Timer_Registers(timer);
+	mode = Sim_Timer_Mode(timer, half);
+	
+	// Edge-time capture mode: TnMR = 0x3 and TnCMR (Bit 2) set
+	if (((mode & 0x03) != 0x03) || ((mode & 0x04) == 0) || !Sim_Timer_Event_Matches(timer, half, level))
+	{
+		return;
+	}
+	
+	if (half == 0)
+	{
+		registers->TAR = (uint32_t)Sim_Timer_Value(timer, 0, time);
+	}
+	else
+	{
+		registers->TBR = (uint32_t)Sim_Timer_Value(timer, 1, time);
+	}
+	
+	registers->RIS |= SIM_TIMER_CAPTURE_EVENT << (half * 8);
+	Sim_Timer_Update_Lines(timer);
+}
+
+void Sim_Timer_Set_Output_Hook(Sim_Timer_Output_Hook hook)
+{
+	output_hook = hook;
+}
+
+void Sim_Timer_Init(void)
+{
+	static const Sim_Pre_Access_Hook pre_hooks[SIM_TIMER_COUNT] =
+	{
+		Sim_Timer0_Pre_Access, Sim_Timer1_Pre_Access, Sim_Timer2_Pre_Access, Sim_Timer3_Pre_Access,
+		Sim_Timer4_Pre_Access, Sim_Timer5_Pre_Access, Sim_Timer6_Pre_Access, Sim_Timer7_Pre_Access,
+		Sim_Timer8_Pre_Access, Sim_Timer9_Pre_Access, Sim_Timer10_Pre_Access, Sim_Timer11_Pre_Access
+	};
+	static const Sim_Post_Access_Hook post_hooks[SIM_TIMER_COUNT] =
+	{
+		Sim_Timer0_Post_Access, Sim_Timer1_Post_Access, Sim_Timer2_Post_Access, Sim_Timer3_Post_Access,
+		Sim_Timer4_Post_Access, Sim_Timer5_Post_Access, Sim_Timer6_Post_Access, Sim_Timer7_Post_Access,
+		Sim_Timer8_Post_Access, Sim_Timer9_Post_Access, Sim_Timer10_Post_Access, Sim_Timer11_Post_Access
+	};
+	int i;
+	
+	for (i = 0; i < SIM_TIMER_COUNT; i++)
+	{
+		TIMER0_Type *registers = Sim_Timer_Registers(&timers[i]);
+		
+		// Reset values: the interval load registers are all ones
+		registers->TAILR = 0xFFFFFFFF;
+		registers->TBILR = timers[i].wide ? 0xFFFFFFFF : 0xFFFF;
+		
+		Sim_MMIO_Register(timers[i].base, pre_hooks[i], post_hooks[i]);
+	}
+	
+	Sim_Add_Update_Hook(Sim_Timer_Update);
+}
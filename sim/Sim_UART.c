@@ -0,0 +1,737 @@
+/**
+ * @file Sim_UART.c
+ *
+ * @brief Source code for the UART0 and uDMA models.
+ *
+ * UART0 has 16-entry receive and transmit FIFOs. Characters move at the configured baud
+ * rate (IBRD, FBRD, HSE and LCRH), the interrupt flags follow the FIFO trigger levels
+ * (IFLS), the receive timeout fires after 32 idle bit periods, and a character that arrives
+ * while the receive FIFO is full is lost and reported as an overrun.
+ *
+ * The serial line is connected to the host (environment variable SIM_UART):
+ * - stdio (default): standard input and output. A terminal is switched to raw mode.
+ * - pty: a new pseudo-terminal, whose name is printed at startup. Connect a terminal
+ *   program or a script to it.
+ *
+ * The host side of the line runs at SIM_UART_BAUD (default 0: always the rate programmed
+ * in UART0). When the two rates differ by more than SIM_UART_BAUD_TOLERANCE_PERCENT, every
+ * character is garbled: received characters carry a framing error and transmitted ones
+ * are not written to the host. While PA0 is not routed to UART0 (AFSEL), the host bytes
+ * are played on the PA0 input instead, as 8N1 waveforms at the host rate, which lets the
+ * firmware measure them (automatic baud rate detection).
+ *
+ * The uDMA model supports basic-mode transfers on the primary control structures. When
+ * UART0 has TXDMAE set, its transmit FIFO is refilled from uDMA channel 9, and the end of
+ * the transfer raises the UART0 interrupt, as on the TM4C123.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#define _GNU_SOURCE
+
+#include "Sim.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define SIM_UART_FIFO_SIZE 16
+
+// Interrupt bits in the RIS, MIS, IM and ICR registers
+#define SIM_UART_RX 0x010
+#define SIM_UART_TX 0x020
+#define SIM_UART_RT 0x040
+#define SIM_UART_OE 0x400
+
+#define SIM_UART0_TX_DMA_CHANNEL 9
+
+// Framing error flag in the DR register, and its interrupt bit in RIS
+#define SIM_UART_DATA_FE 0x100
+#define SIM_UART_FE 0x080
+
+// Host rate of the PA0 waveforms when SIM_UART_BAUD is 0 and UART0 has no rate yet
+#define SIM_UART_DEFAULT_BAUD 115200
+
+// Largest difference between the host and UART0 rates that still gives valid characters
+#define SIM_UART_BAUD_TOLERANCE_PERCENT 3
+
+static uint16_t rx_fifo[SIM_UART_FIFO_SIZE];
+static int rx_head = 0;
+static int rx_count = 0;
+
+static uint8_t tx_fifo[SIM_UART_FIFO_SIZE];
+static int tx_head = 0;
+static int tx_count = 0;
+
+// A character is being shifted out until tx_busy_until
+static int tx_shifting = 0;
+static uint64_t tx_busy_until = 0;
+
+// Earliest arrival time of the next received character, and arrival time of the previous one
+static uint64_t rx_next_cycles = 0;
+static uint64_t rx_last_cycles = 0;
+static int rx_timeout_raised = 0;
+static uint16_t rx_overrun_flag = 0;
+
+// Bytes read from the host and not yet received, and bytes transmitted but not yet written to the host
+static uint8_t input_buffer[4096];
+static int input_head = 0;
+static int input_count = 0;
+static uint8_t output_buffer[4096];
+static int output_count = 0;
+
+static int input_fd = -1;
+static int output_fd = -1;
+static int terminal_fd = -1;
+static int input_flags = 0;
+static struct termios saved_terminal;
+
+// Host side of the line: baud rate (0 to follow UART0), and the byte being played on PA0
+static uint32_t host_baud = 0;
+static int wave_active = 0;
+static uint8_t wave_byte = 0;
+static uint64_t wave_start_cycles = 0;
+
+static uint64_t tx_bytes = 0;
+static uint64_t rx_bytes = 0;
+static uint64_t rx_overruns = 0;
+static uint64_t dma_bytes = 0;
+static uint64_t garbled_bytes = 0;
+static uint64_t wave_bytes = 0;
+
+// uDMA channel state: enabled, request masked, alternate, high priority, burst only, done
+static uint32_t udma_enable = 0;
+static uint32_t udma_request_mask = 0;
+static uint32_t udma_alternate = 0;
+static uint32_t udma_priority = 0;
+static uint32_t udma_use_burst = 0;
+static uint32_t udma_done = 0;
+
+static UART0_Type *Sim_UART0(void)
+{
+	return SIM_REGISTERS(UART0_Type, UART0_BASE);
+}
+
+static int Sim_UART_Enabled(uint32_t direction_bit)
+{
+	UART0_Type *uart = Sim_UART0();
+	
+	return ((uart->CTL & 0x01) != 0) && ((uart->CTL & direction_bit) != 0) && (uart->IBRD != 0);
+}
+
+// Length of one character on the line, in system clock cycles
+static uint64_t Sim_UART_Character_Cycles(void)
+{
+	UART0_Type *uart = Sim_UART0();
+	uint64_t divisor_64ths = (uint64_t)uart->IBRD * 64 + (uart->FBRD & 0x3F);
+	uint64_t clocks_per_bit = (uart->CTL & 0x20) ? 8 : 16;
+	uint64_t bits = 1 + 5 + ((uart->LCRH >> 5) & 0x03) + ((uart->LCRH & 0x02) ? 1 : 0) + ((uart->LCRH & 0x08) ? 2 : 1);
+	
+	return bits * clocks_per_bit * divisor_64ths / 64;
+}
+
+// Baud rate programmed in UART0, 0 if none
+static uint32_t Sim_UART_Baud_Rate(void)
+{
+	UART0_Type *uart = Sim_UART0();
+	uint64_t divisor_64ths = (uint64_t)uart->IBRD * 64 + (uart->FBRD & 0x3F);
+	uint64_t clocks_per_bit = (uart->CTL & 0x20) ? 8 : 16;
+	
+	return (uart->IBRD != 0) ? (uint32_t)((uint64_t)Sim_Clock_Hz() * 64 / (clocks_per_bit * divisor_64ths)) : 0;
+}
+
+// Baud rate of the host side of the line
+static uint32_t Sim_UART_Host_Baud_Rate(void)
+{
+	uint32_t baud_rate = Sim_UART_Baud_Rate();
+	
+	if (host_baud != 0)
+	{
+		return host_baud;
+	}
+	
+	return (baud_rate != 0) ? baud_rate : SIM_UART_DEFAULT_BAUD;
+}
+
+// The host and UART0 rates are too far apart for any character to get through
+static int Sim_UART_Rate_Mismatch(void)
+{
+	uint32_t baud_rate = Sim_UART_Baud_Rate();
+	uint32_t difference;
+	
+	if (host_baud == 0)
+	{
+		return 0;
+	}
+	
+	difference = (baud_rate > host_baud) ? (baud_rate - host_baud) : (host_baud - baud_rate);
+	
+	return (uint64_t)difference * 100 > (uint64_t)host_baud * SIM_UART_BAUD_TOLERANCE_PERCENT;
+}
+
+// PA0 is routed to U0RX: alternate function (AFSEL) with the UART function (PMC0 = 1) selected
+static int Sim_UART_RX_Pin_Connected(void)
+{
+	GPIOA_Type *gpio = SIM_REGISTERS(GPIOA_Type, GPIOA_BASE);
+	
+	return ((gpio->AFSEL & 0x01) != 0) && ((gpio->PCTL & 0x0F) == 0x01);
+}
+
+// FIFO trigger levels selected by IFLS: 1/8, 1/4, 1/2, 3/4 or 7/8 of the FIFO
+static int Sim_UART_Trigger_Level(uint32_t field)
+{
+	static const int levels[8] = { 2, 4, 8, 12, 14, 14, 14, 14 };
+	
+	return levels[field & 0x07];
+}
+
+static void Sim_UART_Update_Line(void)
+{
+	UART0_Type *uart = Sim_UART0();
+	
+	Sim_Set_IRQ_Line(UART0_IRQn, (uart->RIS & uart->IM) != 0);
+}
+
+static void Sim_UART_Flush_Output(void)
+{
+	int offset = 0;
+	
+	while (offset < output_count)
+	{
+		ssize_t written = write(output_fd, output_buffer + offset, (size_t)(output_count - offset));
+		
+		if (written <= 0)
+		{
+			break;
+		}
+		
+		offset += (int)written;
+	}
+	
+	output_count = 0;
+}
+
+static void Sim_UART_Push_Transmit(uint8_t data)
+{
+	UART0_Type *uart = Sim_UART0();
+	
+	if (tx_count >= SIM_UART_FIFO_SIZE)
+	{
+		return;
+	}
+	
+	tx_fifo[(tx_head + tx_count) % SIM_UART_FIFO_SIZE] = data;
+	tx_count++;
+	
+	// TXRIS is cleared by filling the FIFO above the trigger level
+	if (tx_count > Sim_UART_Trigger_Level(uart->IFLS))
+	{
+		uart->RIS &= ~SIM_UART_TX;
+	}
+}
+
+static void Sim_UART_DMA_Fill(void)
+{
+	UART0_Type *uart = Sim_UART0();
+	uint32_t data;
+	int result;
+	
+	if ((uart->DMACTL & 0x02) == 0)
+	{
+		return;
+	}
+	
+	while (tx_count < SIM_UART_FIFO_SIZE)
+	{
+		result = Sim_UDMA_Request(SIM_UART0_TX_DMA_CHANNEL, &data);
+		
+		if (result == 0)
+		{
+			break;
+		}
+		
+		Sim_UART_Push_Transmit((uint8_t)data);
+		dma_bytes++;
+		
+		// The end of the transfer is signaled on the UART0 interrupt
+		if (result == 2)
+		{
+			Sim_Pend_IRQ(UART0_IRQn);
+			break;
+		}
+	}
+}
+
+static void Sim_UART_Update_Transmit(uint64_t now, uint64_t character_cycles)
+{
+	UART0_Type *uart = Sim_UART0();
+	
+	while (1)
+	{
+		if (tx_shifting && (tx_busy_until <= now))
+		{
+			tx_shifting = 0;
+		}
+		
+		Sim_UART_DMA_Fill();
+		
+		if (tx_shifting || (tx_count == 0))
+		{
+			break;
+		}
+		
+		// The next character starts when the previous one ends, or now if the line was idle
+		if (tx_busy_until + character_cycles < now)
+		{
+			tx_busy_until = now;
+		}
+		
+		if (output_count >= (int)sizeof(output_buffer))
+		{
+			Sim_UART_Flush_Output();
+		}
+		
+		// A character sent at the wrong rate is garbage for the host
+		if (Sim_UART_Rate_Mismatch())
+		{
+			garbled_bytes++;
+		}
+		else
+		{
+			output_buffer[output_count++] = tx_fifo[tx_head];
+		}
+		
+		tx_head = (tx_head + 1) % SIM_UART_FIFO_SIZE;
+		tx_count--;
+		tx_bytes++;
+		
+		tx_shifting = 1;
+		tx_busy_until += character_cycles;
+		
+		if (tx_count == Sim_UART_Trigger_Level(uart->IFLS))
+		{
+			uart->RIS |= SIM_UART_TX;
+		}
+	}
+}
+
+// Reads the next bytes from the host once the previous ones have all been received
+static void Sim_UART_Read_Host(uint64_t now)
+{
+	if ((input_count == 0) && (input_fd >= 0))
+	{
+		ssize_t received = read(input_fd, input_buffer, sizeof(input_buffer));
+		
+		if (received > 0)
+		{
+			input_head = 0;
+			input_count = (int)received;
+			
+			if (rx_next_cycles < now)
+			{
+				rx_next_cycles = now;
+			}
+		}
+	}
+}
+
+// PA0 is a GPIO input: the host bytes are played on it, start bit first, at the host rate
+static void Sim_UART_Update_Waveform(uint64_t now)
+{
+	uint64_t bit_cycles = Sim_Clock_Hz() / Sim_UART_Host_Baud_Rate();
+	uint64_t bit;
+	uint8_t level = 0x01;
+	
+	if (!wave_active)
+	{
+		Sim_UART_Read_Host(now);
+		
+		if ((input_count == 0) || (rx_next_cycles > now))
+		{
+			return;
+		}
+		
+		wave_byte = input_buffer[input_head];
+		input_head++;
+		input_count--;
+		wave_bytes++;
+		
+		// The start bit begins when the pin is updated, so that the bit periods
+		// seen by the firmware do not depend on how late this update runs
+		wave_start_cycles = now;
+		wave_active = 1;
+	}
+	
+	bit = (now - wave_start_cycles) / bit_cycles;
+	
+	// Bit 0 is the start bit, bits 1 to 8 the data bits and bit 9 the stop bit
+	if (bit < 9)
+	{
+		level = (bit == 0) ? 0x00 : ((wave_byte >> (bit - 1)) & 0x01);
+	}
+	else if (bit >= 10)
+	{
+		// The stop bit stays on the pin until the next update, so that the firmware can
+		// hand PA0 back to UART0 before the next start bit
+		wave_active = 0;
+		rx_next_cycles = wave_start_cycles + 10 * bit_cycles;
+	}
+	
+	Sim_GPIO_Set_Input(0, 0x01, level);
+}
+
+static void Sim_UART_Update_Receive(uint64_t now, uint64_t character_cycles)
+{
+	UART0_Type *uart = Sim_UART0();
+	int level = Sim_UART_Trigger_Level(uart->IFLS >> 3);
+	uint32_t host_rate = Sim_UART_Host_Baud_Rate();
+	uint64_t host_character_cycles = (host_baud != 0) ? ((uint64_t)Sim_Clock_Hz() * 10 / host_rate) : character_cycles;
+	
+	Sim_UART_Read_Host(now);
+	
+	while ((input_count > 0) && (rx_next_cycles <= now))
+	{
+		uint16_t data = input_buffer[input_head];
+		
+		input_head++;
+		input_count--;
+		rx_bytes++;
+		
+		rx_last_cycles = rx_next_cycles;
+		rx_next_cycles += host_character_cycles;
+		rx_timeout_raised = 0;
+		
+		// A character sent at the wrong rate has no valid stop bit
+		if (Sim_UART_Rate_Mismatch())
+		{
+			data |= SIM_UART_DATA_FE;
+			uart->RIS |= SIM_UART_FE;
+			garbled_bytes++;
+		}
+		
+		// A character that arrives while the FIFO is full is lost
+		if (rx_count >= SIM_UART_FIFO_SIZE)
+		{
+			uart->RIS |= SIM_UART_OE;
+			rx_overrun_flag = 0x800;
+			rx_overruns++;
+			continue;
+		}
+		
+		rx_fifo[(rx_head + rx_count) % SIM_UART_FIFO_SIZE] = data | rx_overrun_flag;
+		rx_overrun_flag = 0;
+		rx_count++;
+		
+		if (rx_count == level)
+		{
+			uart->RIS |= SIM_UART_RX;
+		}
+	}
+	
+	// Receive timeout: data in the FIFO and nothing received for 32 bit periods
+	if ((rx_count > 0) && !rx_timeout_raised && (now - rx_last_cycles >= character_cycles * 32 / 10))
+	{
+		uart->RIS |= SIM_UART_RT;
+		rx_timeout_raised = 1;
+	}
+}
+
+static void Sim_UART_Update(uint64_t now)
+{
+	uint64_t character_cycles;
+	
+	if (Sim_UART_Enabled(0x100))
+	{
+		character_cycles = Sim_UART_Character_Cycles();
+		Sim_UART_Update_Transmit(now, character_cycles);
+	}
+	
+	// A byte already started on PA0 is played to its end
+	if (wave_active || !Sim_UART_RX_Pin_Connected())
+	{
+		Sim_UART_Update_Waveform(now);
+	}
+	else if (Sim_UART_Enabled(0x200))
+	{
+		character_cycles = Sim_UART_Character_Cycles();
+		Sim_UART_Update_Receive(now, character_cycles);
+	}
+	
+	Sim_UART_Update_Line();
+	Sim_UART_Flush_Output();
+}
+
+static void Sim_UART_Pre_Access(uint32_t offset)
+{
+	UART0_Type *uart = Sim_UART0();
+	uint32_t flags = 0;
+	
+	switch (offset)
+	{
+		case 0x000:
+			uart->DR = (rx_count > 0) ? rx_fifo[rx_head] : 0;
+			break;
+		
+		case 0x018:
+			// TXFE (Bit 7), RXFF (Bit 6), TXFF (Bit 5), RXFE (Bit 4), BUSY (Bit 3)
+			flags |= (tx_count == 0) ? 0x80 : 0;
+			flags |= (rx_count == SIM_UART_FIFO_SIZE) ? 0x40 : 0;
+			flags |= (tx_count == SIM_UART_FIFO_SIZE) ? 0x20 : 0;
+			flags |= (rx_count == 0) ? 0x10 : 0;
+			flags |= (tx_shifting || (tx_count > 0)) ? 0x08 : 0;
+			uart->FR = flags;
+			break;
+		
+		case 0x040:
+			uart->MIS = uart->RIS & uart->IM;
+			break;
+	}
+}
+
+static void Sim_UART_Post_Access(uint32_t offset, int is_write)
+{
+	UART0_Type *uart = Sim_UART0();
+	
+	switch (offset)
+	{
+		case 0x000:
+			if (is_write)
+			{
+				// A character written to a full FIFO is lost
+				Sim_UART_Push_Transmit((uint8_t)uart->DR);
+			}
+			else if (rx_count > 0)
+			{
+				rx_head = (rx_head + 1) % SIM_UART_FIFO_SIZE;
+				rx_count--;
+				
+				// RXRIS is cleared by reading the FIFO below the trigger level, and RTRIS by emptying it
+				if (rx_count < Sim_UART_Trigger_Level(uart->IFLS >> 3))
+				{
+					uart->RIS &= ~SIM_UART_RX;
+				}
+				
+				if (rx_count == 0)
+				{
+					uart->RIS &= ~SIM_UART_RT;
+				}
+			}
+			break;
+		
+		case 0x044:
+			if (is_write)
+			{
+				uart->RIS &= ~uart->ICR;
+				uart->ICR = 0;
+			}
+			break;
+		
+		case 0x030:
+			if (is_write && !tx_shifting)
+			{
+				tx_busy_until = Sim_Now();
+			}
+			break;
+	}
+	
+	// Start moving the new data right away
+	Sim_UART_Update(Sim_Now());
+}
+
+static void Sim_UDMA_Pre_Access(uint32_t offset)
+{
+	UDMA_Type *udma = SIM_REGISTERS(UDMA_Type, UDMA_BASE);
+	
+	switch (offset)
+	{
+		case 0x018: case 0x01C: udma->USEBURSTSET = udma->USEBURSTCLR = udma_use_burst; break;
+		case 0x020: case 0x024: udma->REQMASKSET = udma->REQMASKCLR = udma_request_mask; break;
+		case 0x028: case 0x02C: udma->ENASET = udma->ENACLR = udma_enable; break;
+		case 0x030: case 0x034: udma->ALTSET = udma->ALTCLR = udma_alternate; break;
+		case 0x038: case 0x03C: udma->PRIOSET = udma->PRIOCLR = udma_priority; break;
+		case 0x504: udma->CHIS = udma_done; break;
+	}
+}
+
+static void Sim_UDMA_Post_Access(uint32_t offset, int is_write)
+{
+	UDMA_Type *udma = SIM_REGISTERS(UDMA_Type, UDMA_BASE);
+	
+	if (!is_write)
+	{
+		return;
+	}
+	
+	switch (offset)
+	{
+		case 0x018: udma_use_burst |= udma->USEBURSTSET; break;
+		case 0x01C: udma_use_burst &= ~udma->USEBURSTCLR; break;
+		case 0x020: udma_request_mask |= udma->REQMASKSET; break;
+		case 0x024: udma_request_mask &= ~udma->REQMASKCLR; break;
+		case 0x028: udma_enable |= udma->ENASET; break;
+		case 0x02C: udma_enable &= ~udma->ENACLR; break;
+		case 0x030: udma_alternate |= udma->ALTSET; break;
+		case 0x034: udma_alternate &= ~udma->ALTCLR; break;
+		case 0x038: udma_priority |= udma->PRIOSET; break;
+		case 0x03C: udma_priority &= ~udma->PRIOCLR; break;
+		case 0x504: udma_done &= ~udma->CHIS; break;
+	}
+	
+	// A newly enabled channel may be serviced right away
+	Sim_UART_Update(Sim_Now());
+}
+
+int Sim_UDMA_Request(int channel, uint32_t *data)
+{
+	UDMA_Type *udma = SIM_REGISTERS(UDMA_Type, UDMA_BASE);
+	uint32_t channel_bit = 1UL << channel;
+	volatile uint32_t *entry;
+	uint32_t control;
+	uint32_t remaining;
+	uint32_t size;
+	uint32_t increment;
+	uintptr_t source;
+	
+	if (((udma->CFG & 0x01) == 0) || (udma->CTLBASE == 0) ||
+	    ((udma_enable & channel_bit) == 0) || (udma_request_mask & channel_bit))
+	{
+		return 0;
+	}
+	
+	// Primary control structure: source end pointer, destination end pointer, control word
+	entry = (volatile uint32_t *)(uintptr_t)(udma->CTLBASE + (uint32_t)channel * 16);
+	control = entry[2];
+	
+	if ((control & 0x07) == 0)
+	{
+		udma_enable &= ~channel_bit;
+		return 0;
+	}
+	
+	remaining = ((control >> 4) & 0x3FF) + 1;
+	size = 1U << ((control >> 24) & 0x03);
+	increment = (((control >> 26) & 0x03) == 0x03) ? 0 : (1U << ((control >> 26) & 0x03));
+	source = (uintptr_t)entry[0] - (uintptr_t)(remaining - 1) * increment;
+	
+	switch (size)
+	{
+		case 1: *data = *(const uint8_t *)source; break;
+		case 2: *data = *(const uint16_t *)source; break;
+		default: *data = *(const uint32_t *)source; break;
+	}
+	
+	remaining--;
+	
+	if (remaining > 0)
+	{
+		entry[2] = (control & ~(0x3FFUL << 4)) | ((remaining - 1) << 4);
+		return 1;
+	}
+	
+	// The transfer is complete: the mode changes to stop and the channel is disabled
+	entry[2] = control & ~((0x3FFUL << 4) | 0x07UL);
+	udma_enable &= ~channel_bit;
+	udma_done |= channel_bit;
+	
+	return 2;
+}
+
+static void Sim_UART_Open_Host(void)
+{
+	const char *mode = getenv("SIM_UART");
+	
+	if ((mode != 0) && (strcmp(mode, "pty") == 0))
+	{
+		struct termios settings;
+		int slave_fd;
+		
+		input_fd = posix_openpt(O_RDWR | O_NOCTTY);
+		
+		if ((input_fd < 0) || (grantpt(input_fd) != 0) || (unlockpt(input_fd) != 0))
+		{
+			Sim_Log("sim: cannot create a pseudo-terminal\n");
+			exit(1);
+		}
+		
+		// Keep the slave side open so that reads do not fail while no client is connected
+		slave_fd = open(ptsname(input_fd), O_RDWR | O_NOCTTY);
+		
+		if (slave_fd >= 0)
+		{
+			tcgetattr(slave_fd, &settings);
+			cfmakeraw(&settings);
+			tcsetattr(slave_fd, TCSANOW, &settings);
+		}
+		
+		output_fd = input_fd;
+		fcntl(input_fd, F_SETFL, fcntl(input_fd, F_GETFL) | O_NONBLOCK);
+		
+		Sim_Log("sim: UART0 on %s\n", ptsname(input_fd));
+		return;
+	}
+	
+	input_fd = STDIN_FILENO;
+	output_fd = STDOUT_FILENO;
+	
+	if (isatty(input_fd))
+	{
+		struct termios settings;
+		
+		tcgetattr(input_fd, &saved_terminal);
+		settings = saved_terminal;
+		settings.c_lflag &= ~(ICANON | ECHO);
+		tcsetattr(input_fd, TCSANOW, &settings);
+		terminal_fd = input_fd;
+	}
+	
+	input_flags = fcntl(input_fd, F_GETFL);
+	fcntl(input_fd, F_SETFL, input_flags | O_NONBLOCK);
+}
+
+void Sim_UART_Restore(void)
+{
+	Sim_UART_Flush_Output();
+	
+	if (input_fd == STDIN_FILENO)
+	{
+		fcntl(input_fd, F_SETFL, input_flags);
+	}
+	
+	if (terminal_fd >= 0)
+	{
+		tcsetattr(terminal_fd, TCSANOW, &saved_terminal);
+	}
+}
+
+void Sim_UART_Report(void)
+{
+	Sim_Log("sim: UART0 transmitted %llu bytes (%llu by uDMA), received %llu bytes, %llu overruns\n",
+	        (unsigned long long)tx_bytes, (unsigned long long)dma_bytes,
+	        (unsigned long long)rx_bytes, (unsigned long long)rx_overruns);
+	Sim_Log("sim: UART0 at %u baud%s, host line at %u baud, %llu characters garbled, %llu bytes played on PA0\n",
+	        (unsigned int)Sim_UART_Baud_Rate(), (Sim_UART0()->CTL & 0x20) ? " (HSE)" : "",
+	        (unsigned int)Sim_UART_Host_Baud_Rate(), (unsigned long long)garbled_bytes, (unsigned long long)wave_bytes);
+}
+
+void Sim_UART_Init(void)
+{
+	UART0_Type *uart = Sim_UART0();
+	
+	// Reset values: transmit and receive enabled (CTL), both FIFOs empty (FR), half-full trigger levels (IFLS)
+	uart->CTL = 0x300;
+	uart->FR = 0x90;
+	uart->IFLS = 0x12;
+	
+	host_baud = (uint32_t)Sim_Env_Int("SIM_UART_BAUD", 0);
+	
+	// The line idles high
+	Sim_GPIO_Set_Input(0, 0x01, 0x01);
+	
+	Sim_UART_Open_Host();
+	
+	Sim_MMIO_Register(UART0_BASE, Sim_UART_Pre_Access, Sim_UART_Post_Access);
+	Sim_MMIO_Register(UDMA_BASE, Sim_UDMA_Pre_Access, Sim_UDMA_Post_Access);
+	Sim_Add_Update_Hook(Sim_UART_Update);
+}
@@ -0,0 +1,129 @@
+/**
+ * @file Sim_Vectors.h
+ *
+ * @brief Exception and interrupt handler names of the vector table in startup_TM4C123.s.
+ *
+ * Each line expands SIM_VECTOR(exception_number, handler_name), where the exception
+ * number is the interrupt number (IRQn) plus 16. Sim_Core.c uses this list to find
+ * the handlers defined by the firmware.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+SIM_VECTOR(2, NMI_Handler)
+SIM_VECTOR(3, HardFault_Handler)
+SIM_VECTOR(4, MemManage_Handler)
+SIM_VECTOR(5, BusFault_Handler)
+SIM_VECTOR(6, UsageFault_Handler)
+SIM_VECTOR(11, SVC_Handler)
+SIM_VECTOR(12, DebugMon_Handler)
+SIM_VECTOR(14, PendSV_Handler)
+SIM_VECTOR(15, SysTick_Handler)
+SIM_VECTOR(16, GPIOA_Handler)
+SIM_VECTOR(17, GPIOB_Handler)
+SIM_VECTOR(18, GPIOC_Handler)
+SIM_VECTOR(19, GPIOD_Handler)
+SIM_VECTOR(20, GPIOE_Handler)
+SIM_VECTOR(21, UART0_Handler)
+SIM_VECTOR(22, UART1_Handler)
+SIM_VECTOR(23, SSI0_Handler)
+SIM_VECTOR(24, I2C0_Handler)
+SIM_VECTOR(25, PMW0_FAULT_Handler)
+SIM_VECTOR(26, PWM0_0_Handler)
+SIM_VECTOR(27, PWM0_1_Handler)
+SIM_VECTOR(28, PWM0_2_Handler)
+SIM_VECTOR(29, QEI0_Handler)
+SIM_VECTOR(30, ADC0SS0_Handler)
+SIM_VECTOR(31, ADC0SS1_Handler)
+SIM_VECTOR(32, ADC0SS2_Handler)
+SIM_VECTOR(33, ADC0SS3_Handler)
+SIM_VECTOR(34, WDT0_Handler)
+SIM_VECTOR(35, TIMER0A_Handler)
+SIM_VECTOR(36, TIMER0B_Handler)
+SIM_VECTOR(37, TIMER1A_Handler)
+SIM_VECTOR(38, TIMER1B_Handler)
+SIM_VECTOR(39, TIMER2A_Handler)
+SIM_VECTOR(40, TIMER2B_Handler)
+SIM_VECTOR(41, COMP0_Handler)
+SIM_VECTOR(42, COMP1_Handler)
+SIM_VECTOR(43, COMP2_Handler)
+SIM_VECTOR(44, SYSCTL_Handler)
+SIM_VECTOR(45, FLASH_Handler)
+SIM_VECTOR(46, GPIOF_Handler)
+SIM_VECTOR(47, GPIOG_Handler)
+SIM_VECTOR(48, GPIOH_Handler)
+SIM_VECTOR(49, UART2_Handler)
+SIM_VECTOR(50, SSI1_Handler)
+SIM_VECTOR(51, TIMER3A_Handler)
+SIM_VECTOR(52, TIMER3B_Handler)
+SIM_VECTOR(53, I2C1_Handler)
+SIM_VECTOR(54, QEI1_Handler)
+SIM_VECTOR(55, CAN0_Handler)
+SIM_VECTOR(56, CAN1_Handler)
+SIM_VECTOR(57, CAN2_Handler)
+SIM_VECTOR(59, HIB_Handler)
+SIM_VECTOR(60, USB0_Handler)
+SIM_VECTOR(61, PWM0_3_Handler)
+SIM_VECTOR(62, UDMA_Handler)
+SIM_VECTOR(63, UDMAERR_Handler)
+SIM_VECTOR(64, ADC1SS0_Handler)
+SIM_VECTOR(65, ADC1SS1_Handler)
+SIM_VECTOR(66, ADC1SS2_Handler)
+SIM_VECTOR(67, ADC1SS3_Handler)
+SIM_VECTOR(70, GPIOJ_Handler)
+SIM_VECTOR(71, GPIOK_Handler)
+SIM_VECTOR(72, GPIOL_Handler)
+SIM_VECTOR(73, SSI2_Handler)
+SIM_VECTOR(74, SSI3_Handler)
+SIM_VECTOR(75, UART3_Handler)
+SIM_VECTOR(76, UART4_Handler)
+SIM_VECTOR(77, UART5_Handler)
+SIM_VECTOR(78, UART6_Handler)
+SIM_VECTOR(79, UART7_Handler)
+SIM_VECTOR(84, I2C2_Handler)
+SIM_VECTOR(85, I2C3_Handler)
+SIM_VECTOR(86, TIMER4A_Handler)
+SIM_VECTOR(87, TIMER4B_Handler)
+SIM_VECTOR(108, TIMER5A_Handler)
+SIM_VECTOR(109, TIMER5B_Handler)
+SIM_VECTOR(110, WTIMER0A_Handler)
+SIM_VECTOR(111, WTIMER0B_Handler)
+SIM_VECTOR(112, WTIMER1A_Handler)
+SIM_VECTOR(113, WTIMER1B_Handler)
+SIM_VECTOR(114, WTIMER2A_Handler)
+SIM_VECTOR(115, WTIMER2B_Handler)
+SIM_VECTOR(116, WTIMER3A_Handler)
+SIM_VECTOR(117, WTIMER3B_Handler)
+SIM_VECTOR(118, WTIMER4A_Handler)
+SIM_VECTOR(119, WTIMER4B_Handler)
+SIM_VECTOR(120, WTIMER5A_Handler)
+SIM_VECTOR(121, WTIMER5B_Handler)
+SIM_VECTOR(122, FPU_Handler)
+SIM_VECTOR(125, I2C4_Handler)
+SIM_VECTOR(126, I2C5_Handler)
+SIM_VECTOR(127, GPIOM_Handler)
+SIM_VECTOR(128, GPION_Handler)
+SIM_VECTOR(129, QEI2_Handler)
+SIM_VECTOR(132, GPIOP0_Handler)
+SIM_VECTOR(133, GPIOP1_Handler)
+SIM_VECTOR(134, GPIOP2_Handler)
+SIM_VECTOR(135, GPIOP3_Handler)
+SIM_VECTOR(136, GPIOP4_Handler)
+SIM_VECTOR(137, GPIOP5_Handler)
+SIM_VECTOR(138, GPIOP6_Handler)
+SIM_VECTOR(139, GPIOP7_Handler)
+SIM_VECTOR(140, GPIOQ0_Handler)
+SIM_VECTOR(141, GPIOQ1_Handler)
+SIM_VECTOR(142, GPIOQ2_Handler)
+SIM_VECTOR(143, GPIOQ3_Handler)
+SIM_VECTOR(144, GPIOQ4_Handler)
+SIM_VECTOR(145, GPIOQ5_Handler)
+SIM_VECTOR(146, GPIOQ6_Handler)
+SIM_VECTOR(147, GPIOQ7_Handler)
+SIM_VECTOR(148, GPIOR_Handler)
+SIM_VECTOR(149, GPIOS_Handler)
+SIM_VECTOR(150, PMW1_0_Handler)
+SIM_VECTOR(151, PWM1_1_Handler)
+SIM_VECTOR(152, PWM1_2_Handler)
+SIM_VECTOR(153, PWM1_3_Handler)
+SIM_VECTOR(154, PWM1_FAULT_Handler)
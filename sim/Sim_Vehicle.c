@@ -0,0 +1,712 @@
+/**
+ * @file Sim_Vehicle.c
+ *
+ * @brief Source code for the PWM model and the simulated vehicle.
+ *
+ * PWM: the four generators of PWM0 count down from LOAD at the PWM clock (RCC USEPWMDIV
+ * and PWMDIV). The duty cycle of each A output is derived from LOAD, CMPA and the GENA
+ * actions, and the counter load and zero events raise the generator interrupts
+ * (PWM0_0_IRQn to PWM0_3_IRQn) when enabled in _n_INTEN and INTEN.
+ *
+ * QEI: QEI0 counts the edges of the wheel encoder (1496 per revolution of a 204.2 mm wheel
+ * in 4x mode, half as many with CAPMODE clear) into POS, and its velocity timer copies the
+ * edges of each LOAD + 1 cycle window into SPEED and raises INTTIMER (QEI0_IRQn).
+ *
+ * Vehicle: the motor (PB6, generator 0) drives the vehicle at a speed proportional to its
+ * duty cycle, forward when PB7 is high, with a first-order response. An obstacle lies ahead
+ * of the vehicle, a wall behind it, and walls on both sides.
+ *
+ * Sonar: four HC-SR04 face the front (trigger PC4, echo PC5 on WTIMER0 B), the rear (PE1, PC6
+ * on WTIMER1 A), the left (PE2, PC7 on WTIMER1 B) and the right (PE3, PD2 on WTIMER3 A). Each
+ * one answers the falling edge of a trigger pulse of at least 10 us with an echo pulse that is
+ * 58 us long per centimeter of distance. The burst of a sensor is heard by every sensor that
+ * does not face away from it: a sensor that is listening when the echo of another one comes
+ * back ends its own echo there (crosstalk).
+ *
+ * Settings (environment variables):
+ * - SIM_OBSTACLE_CM: initial distance to the obstacle, 200 cm by default.
+ * - SIM_REAR_CM: initial distance to the rear wall, 100 cm by default.
+ * - SIM_LEFT_CM, SIM_RIGHT_CM: distance to the side walls, 60 and 90 cm by default.
+ * - SIM_MAX_SPEED_CM_S: speed at 100% duty cycle, 150 cm/s by default.
+ * - SIM_MOTOR_TAU_MS: time constant of the motor response, 150 ms by default.
+ * - SIM_SONAR_NOISE_CM: uniform noise added to each echo, 0 by default.
+ * - SIM_SONAR_DROPOUT: percentage of pings that get no echo at all, 0 by default.
+ * - SIM_SONAR_SPURIOUS: percentage of pings answered by a short echo (3 to 20 cm), 0 by default.
+ * - SIM_ENCODER_DISCONNECTED: set to 1 to let the encoder report no edge at all, 0 by default.
+ * - SIM_SEED: seed of the noise generator.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Sim.h"
+#include <math.h>
+#include <stddef.h>
+
+#define SIM_PWM_GENERATOR_COUNT 4
+
+// Sonar timing of the HC-SR04: shortest trigger pulse, echo delay after the trigger,
+// echo length per cm, echo length without obstacle
+#define SIM_SONAR_TRIGGER_US     10
+#define SIM_SONAR_DELAY_US       460
+#define SIM_SONAR_US_PER_CM      58
+#define SIM_SONAR_MAX_RANGE_CM   400
+#define SIM_SONAR_NO_ECHO_US     38000
+
+#define SIM_SONAR_COUNT 4
+
+// Wheel encoder: edges per wheel revolution in 4x mode, and wheel circumference
+#define SIM_ENCODER_EDGES_PER_REV 1496.0
+#define SIM_WHEEL_CIRCUMFERENCE_CM 20.4204
+
+typedef struct
+{
+	uint64_t start;    // time at which the generator was enabled, in PWM clock ticks
+	uint64_t last;     // time up to which the events have been generated, in PWM clock ticks
+	int running;
+} Sim_PWM_Generator;
+
+typedef struct
+{
+	uint64_t rise;
+	uint64_t fall;
+	int rise_applied;
+	int fall_applied;
+	int active;
+} Sim_Echo;
+
+// Direction a sensor faces. Two sensors face away from each other when their directions differ in bit 0 only
+typedef enum
+{
+	SIM_FACING_FRONT,
+	SIM_FACING_REAR,
+	SIM_FACING_LEFT,
+	SIM_FACING_RIGHT
+} Sim_Facing;
+
+typedef struct
+{
+	uint64_t trigger_rise;      // time of the rising edge of the trigger
+	uint64_t arrival;           // time at which the echo of the latest burst comes back, 0 for none
+	Sim_Echo echo;
+	uint32_t pings;
+	uint32_t echoes;
+	uint32_t crosstalk;
+	uint32_t short_triggers;
+} Sim_Sonar_State;
+
+typedef struct
+{
+	const char *name;
+	Sim_Facing facing;
+	int trigger_port;
+	uint8_t trigger_pin;
+	int echo_port;
+	uint8_t echo_pin;
+	uint32_t capture_base;
+	int capture_half;
+	Sim_Sonar_State state;
+} Sim_Sonar;
+
+static Sim_PWM_Generator generators[SIM_PWM_GENERATOR_COUNT];
+
+static const IRQn_Type generator_irqs[SIM_PWM_GENERATOR_COUNT] =
+{
+	PWM0_0_IRQn, PWM0_1_IRQn, PWM0_2_IRQn, PWM0_3_IRQn
+};
+
+static double distance_cm;
+static double speed_cm_s = 0.0;
+static double min_distance_cm;
+static double travelled_cm = 0.0;
+static uint64_t last_update = 0;
+static uint32_t collisions = 0;
+static int touching = 0;
+static double last_motor_duty = 0.0;
+static double max_motor_duty_step = 0.0;
+
+static double max_speed_cm_s;
+static double motor_tau_s;
+static long sonar_noise_cm;
+static long sonar_dropout;
+static long sonar_spurious;
+static uint32_t random_state;
+
+static double obstacle_start_cm;
+static double rear_cm;
+static double left_cm;
+static double right_cm;
+
+static Sim_Sonar sonars[SIM_SONAR_COUNT] =
+{
+	{ "front", SIM_FACING_FRONT, 2, 0x10, 2, 0x20, WTIMER0_BASE, 1, { 0 } },
+	{ "rear",  SIM_FACING_REAR,  4, 0x02, 2, 0x40, WTIMER1_BASE, 0, { 0 } },
+	{ "left",  SIM_FACING_LEFT,  4, 0x04, 2, 0x80, WTIMER1_BASE, 1, { 0 } },
+	{ "right", SIM_FACING_RIGHT, 4, 0x08, 3, 0x04, WTIMER3_BASE, 0, { 0 } }
+};
+
+static long encoder_disconnected;
+static int qei_running = 0;
+static uint64_t qei_window_start;
+static uint32_t qei_window_edges;
+static double qei_edge_fraction = 0.0;
+static uint64_t qei_total_edges = 0;
+
+// Register offsets of generator n
+#define SIM_PWM_GENERATOR_OFFSET(n) (0x040 + (n) * 0x040)
+
+static volatile uint32_t *Sim_PWM_Generator_Registers(int generator)
+{
+	return (volatile uint32_t *)SIM_REGISTERS(uint8_t, PWM0_BASE + SIM_PWM_GENERATOR_OFFSET(generator));
+}
+
+// Generator registers, as word indexes from the generator base
+enum { GEN_CTL, GEN_INTEN, GEN_RIS, GEN_ISC, GEN_LOAD, GEN_COUNT, GEN_CMPA, GEN_CMPB, GEN_GENA, GEN_GENB };
+
+static uint32_t Sim_Random(void)
+{
+	random_state = random_state * 1103515245UL + 12345UL;
+	
+	return (random_state >> 16) & 0x7FFF;
+}
+
+// PWM clock divider: USEPWMDIV (Bit 20) and PWMDIV (Bits 19 to 17) of the RCC register
+static uint32_t Sim_PWM_Divider(void)
+{
+	SYSCTL_Type *sysctl = SIM_REGISTERS(SYSCTL_Type, SYSCTL_BASE);
+	uint32_t divider_field = (sysctl->RCC >> 17) & 0x07;
+	
+	if ((sysctl->RCC & 0x00100000) == 0)
+	{
+		return 1;
+	}
+	
+	return (divider_field >= 5) ? 64 : (2U << divider_field);
+}
+
+static uint64_t Sim_PWM_Ticks(uint64_t cycles)
+{
+	return cycles / Sim_PWM_Divider();
+}
+
+// Fraction of the period during which output A of a generator is high, in count-down mode
+static double Sim_PWM_Duty(int generator)
+{
+	PWM0_Type *pwm = SIM_REGISTERS(PWM0_Type, PWM0_BASE);
+	volatile uint32_t *registers = Sim_PWM_Generator_Registers(generator);
+	uint32_t load = registers[GEN_LOAD] & 0xFFFF;
+	uint32_t compare = registers[GEN_CMPA] & 0xFFFF;
+	uint32_t action_load = (registers[GEN_GENA] >> 2) & 0x03;
+	uint32_t action_compare = (registers[GEN_GENA] >> 6) & 0x03;
+	int level_after_load = (action_load == 0x03);
+	int level_after_compare = level_after_load;
+	double high = 0.0;
+	double duty;
+	
+	if (!generators[generator].running || ((pwm->ENABLE & (0x01UL << (generator * 2))) == 0) || (compare > load))
+	{
+		return 0.0;
+	}
+	
+	// ACTCMPAD: 0x1 inverts, 0x2 drives low, 0x3 drives high
+	if (action_compare == 0x01)
+	{
+		level_after_compare = !level_after_load;
+	}
+	else if (action_compare >= 0x02)
+	{
+		level_after_compare = (action_compare == 0x03);
+	}
+	
+	high += level_after_load ? (double)(load - compare) : 0.0;
+	high += level_after_compare ? (double)(compare + 1) : 0.0;
+	duty = high / (double)(load + 1);
+	
+	return (pwm->INVERT & (0x01UL << (generator * 2))) ? (1.0 - duty) : duty;
+}
+
+static void Sim_PWM_Update_Lines(void)
+{
+	PWM0_Type *pwm = SIM_REGISTERS(PWM0_Type, PWM0_BASE);
+	int generator;
+	
+	for (generator = 0; generator < SIM_PWM_GENERATOR_COUNT; generator++)
+	{
+		volatile uint32_t *registers = Sim_PWM_Generator_Registers(generator);
+		int pending = ((registers[GEN_RIS] & registers[GEN_INTEN] & 0x3F) != 0);
+		
+		if (pending)
+		{
+			pwm->RIS |= 0x01UL << generator;
+		}
+		else
+		{
+			pwm->RIS &= ~(0x01UL << generator);
+		}
+		
+		Sim_Set_IRQ_Line(generator_irqs[generator], pending && (pwm->INTEN & (0x01UL << generator)));
+	}
+}
+
+static void Sim_PWM_Update(uint64_t now)
+{
+	uint64_t ticks = Sim_PWM_Ticks(now);
+	int generator;
+	
+	for (generator = 0; generator < SIM_PWM_GENERATOR_COUNT; generator++)
+	{
+		Sim_PWM_Generator *state = &generators[generator];
+		volatile uint32_t *registers = Sim_PWM_Generator_Registers(generator);
+		uint64_t period = (registers[GEN_LOAD] & 0xFFFF) + 1;
+		
+		if (!state->running || (ticks <= state->last))
+		{
+			continue;
+		}
+		
+		// The counter reaches zero at the end of each period and reloads right after
+		if ((ticks - state->start) / period != (state->last - state->start) / period)
+		{
+			// INTCNTZERO (Bit 0) and INTCNTLOAD (Bit 1)
+			registers[GEN_RIS] |= 0x03;
+		}
+		
+		state->last = ticks;
+	}
+	
+	Sim_PWM_Update_Lines();
+}
+
+static void Sim_PWM_Pre_Access(uint32_t offset)
+{
+	PWM0_Type *pwm = SIM_REGISTERS(PWM0_Type, PWM0_BASE);
+	int generator = ((int)offset - SIM_PWM_GENERATOR_OFFSET(0)) / 0x40;
+	
+	if (offset == 0x01C)
+	{
+		// ISC reads the masked generator interrupt status
+		pwm->ISC = pwm->RIS & pwm->INTEN;
+	}
+	else if ((offset >= SIM_PWM_GENERATOR_OFFSET(0)) && (generator < SIM_PWM_GENERATOR_COUNT))
+	{
+		volatile uint32_t *registers = Sim_PWM_Generator_Registers(generator);
+		uint32_t word = (offset & 0x3F) / 4;
+		
+		if (word == GEN_ISC)
+		{
+			registers[GEN_ISC] = registers[GEN_RIS] & registers[GEN_INTEN];
+		}
+		else if ((word == GEN_COUNT) && generators[generator].running)
+		{
+			uint64_t period = (registers[GEN_LOAD] & 0xFFFF) + 1;
+			uint64_t elapsed = Sim_PWM_Ticks(Sim_Now()) - generators[generator].start;
+			
+			registers[GEN_COUNT] = (uint32_t)((period - 1) - (elapsed % period));
+		}
+	}
+}
+
+static void Sim_PWM_Post_Access(uint32_t offset, int is_write)
+{
+	int generator = ((int)offset - SIM_PWM_GENERATOR_OFFSET(0)) / 0x40;
+	
+	if (!is_write || (offset < SIM_PWM_GENERATOR_OFFSET(0)) || (generator >= SIM_PWM_GENERATOR_COUNT))
+	{
+		Sim_PWM_Update_Lines();
+		return;
+	}
+	
+	{
+		volatile uint32_t *registers = Sim_PWM_Generator_Registers(generator);
+		Sim_PWM_Generator *state = &generators[generator];
+		uint32_t word = (offset & 0x3F) / 4;
+		
+		if (word == GEN_CTL)
+		{
+			// ENABLE (Bit 0) of the generator control register starts the counter
+			int enabled = (registers[GEN_CTL] & 0x01) != 0;
+			
+			if (enabled && !state->running)
+			{
+				state->start = Sim_PWM_Ticks(Sim_Now());
+				state->last = state->start;
+				state->running = 1;
+			}
+			else if (!enabled)
+			{
+				state->running = 0;
+			}
+		}
+		else if (word == GEN_ISC)
+		{
+			// Write 1 to clear
+			registers[GEN_RIS] &= ~registers[GEN_ISC];
+			registers[GEN_ISC] = 0;
+		}
+	}
+	
+	Sim_PWM_Update_Lines();
+}
+
+// Distance from a sensor to the wall it faces; the rear wall recedes as the vehicle moves forward
+static double Sim_Sonar_Distance(const Sim_Sonar *sonar)
+{
+	switch (sonar->facing)
+	{
+		case SIM_FACING_FRONT:
+			return distance_cm;
+		
+		case SIM_FACING_REAR:
+			return rear_cm + (obstacle_start_cm - distance_cm);
+		
+		case SIM_FACING_LEFT:
+			return left_cm;
+		
+		default:
+			return right_cm;
+	}
+}
+
+// The burst of a sensor is heard by the sensors that are listening when its echo comes back,
+// unless they face away from it. The earliest echo ends the pulse of the listening sensor
+static void Sim_Sonar_Crosstalk(Sim_Sonar *sonar)
+{
+	int i;
+	
+	for (i = 0; i < SIM_SONAR_COUNT; i++)
+	{
+		Sim_Sonar *other = &sonars[i];
+		
+		if ((other == sonar) || ((other->facing ^ sonar->facing) == 1))
+		{
+			continue;
+		}
+		
+		if (other->state.echo.active && !other->state.echo.fall_applied && (sonar->state.arrival != 0)
+		    && (sonar->state.arrival > other->state.echo.rise) && (sonar->state.arrival < other->state.echo.fall))
+		{
+			other->state.echo.fall = sonar->state.arrival;
+			other->state.crosstalk++;
+		}
+		
+		if (sonar->state.echo.active && (other->state.arrival != 0)
+		    && (other->state.arrival > sonar->state.echo.rise) && (other->state.arrival < sonar->state.echo.fall))
+		{
+			sonar->state.echo.fall = other->state.arrival;
+			sonar->state.crosstalk++;
+		}
+	}
+}
+
+static void Sim_Sonar_Ping(Sim_Sonar *sonar, uint64_t time)
+{
+	uint32_t cycles_per_us = Sim_Clock_Hz() / 1000000;
+	double true_cm = Sim_Sonar_Distance(sonar);
+	double measured_cm;
+	uint64_t pulse_us;
+	
+	sonar->state.pings++;
+	
+	// The burst comes back from the wall, whether or not the sensor hears its own echo
+	sonar->state.arrival = 0;
+	
+	if (true_cm <= SIM_SONAR_MAX_RANGE_CM)
+	{
+		sonar->state.arrival = time + ((uint64_t)SIM_SONAR_DELAY_US + (uint64_t)(true_cm * SIM_SONAR_US_PER_CM)) * cycles_per_us;
+	}
+	
+	if ((sonar_dropout > 0) && ((long)(Sim_Random() % 100) < sonar_dropout))
+	{
+		Sim_Sonar_Crosstalk(sonar);
+		return;
+	}
+	
+	measured_cm = true_cm;
+	
+	if ((sonar_spurious > 0) && ((long)(Sim_Random() % 100) < sonar_spurious))
+	{
+		measured_cm = (double)(3 + Sim_Random() % 18);
+	}
+	else if (sonar_noise_cm > 0)
+	{
+		measured_cm += (double)((long)(Sim_Random() % (uint32_t)(2 * sonar_noise_cm + 1)) - sonar_noise_cm);
+	}
+	
+	if (measured_cm < 2.0)
+	{
+		measured_cm = 2.0;
+	}
+	
+	pulse_us = (measured_cm > SIM_SONAR_MAX_RANGE_CM) ? SIM_SONAR_NO_ECHO_US : (uint64_t)(measured_cm * SIM_SONAR_US_PER_CM);
+	
+	sonar->state.echo.rise = time + (uint64_t)SIM_SONAR_DELAY_US * cycles_per_us;
+	sonar->state.echo.fall = sonar->state.echo.rise + pulse_us * cycles_per_us;
+	sonar->state.echo.rise_applied = 0;
+	sonar->state.echo.fall_applied = 0;
+	sonar->state.echo.active = 1;
+	
+	Sim_Sonar_Crosstalk(sonar);
+}
+
+static void Sim_Sonar_Trigger(int port, uint64_t time, uint8_t previous, uint8_t levels)
+{
+	uint32_t cycles_per_us = Sim_Clock_Hz() / 1000000;
+	int i;
+	
+	for (i = 0; i < SIM_SONAR_COUNT; i++)
+	{
+		Sim_Sonar *sonar = &sonars[i];
+		uint8_t changed = (uint8_t)((previous ^ levels) & sonar->trigger_pin);
+		
+		if ((sonar->trigger_port != port) || (changed == 0))
+		{
+			continue;
+		}
+		
+		if (levels & sonar->trigger_pin)
+		{
+			sonar->state.trigger_rise = time;
+		}
+		else if ((time - sonar->state.trigger_rise) < (uint64_t)SIM_SONAR_TRIGGER_US * cycles_per_us)
+		{
+			sonar->state.short_triggers++;
+		}
+		else if (!sonar->state.echo.active)
+		{
+			// The sensor starts a measurement on the falling edge of the trigger, unless it is still busy
+			Sim_Sonar_Ping(sonar, time);
+		}
+	}
+}
+
+static void Sim_Sonar_Update(uint64_t now)
+{
+	int i;
+	
+	for (i = 0; i < SIM_SONAR_COUNT; i++)
+	{
+		Sim_Sonar *sonar = &sonars[i];
+		Sim_Echo *echo = &sonar->state.echo;
+		
+		if (!echo->active)
+		{
+			continue;
+		}
+		
+		if (!echo->rise_applied && (echo->rise <= now))
+		{
+			Sim_GPIO_Set_Input(sonar->echo_port, sonar->echo_pin, sonar->echo_pin);
+			Sim_Timer_Capture_Edge(sonar->capture_base, sonar->capture_half, echo->rise, 1);
+			echo->rise_applied = 1;
+		}
+		
+		if (!echo->fall_applied && (echo->fall <= now))
+		{
+			Sim_GPIO_Set_Input(sonar->echo_port, sonar->echo_pin, 0x00);
+			Sim_Timer_Capture_Edge(sonar->capture_base, sonar->capture_half, echo->fall, 0);
+			echo->fall_applied = 1;
+			echo->active = 0;
+			sonar->state.echoes++;
+		}
+	}
+}
+
+static void Sim_QEI_Update_Line(void)
+{
+	QEI0_Type *qei = SIM_REGISTERS(QEI0_Type, QEI0_BASE);
+	
+	Sim_Set_IRQ_Line(QEI0_IRQn, (qei->RIS & qei->INTEN & 0x0F) != 0);
+}
+
+// Counts the encoder edges of a signed wheel travel, then closes the velocity windows that have ended
+static void Sim_QEI_Update(uint64_t now, double travel_cm)
+{
+	QEI0_Type *qei = SIM_REGISTERS(QEI0_Type, QEI0_BASE);
+	uint64_t window = (uint64_t)qei->LOAD + 1;
+	double edges_per_cm = SIM_ENCODER_EDGES_PER_REV / SIM_WHEEL_CIRCUMFERENCE_CM;
+	long edges;
+	
+	if (!qei_running)
+	{
+		return;
+	}
+	
+	// CAPMODE (Bit 3) clear: only the edges of PhA are counted
+	if ((qei->CTL & 0x08) == 0)
+	{
+		edges_per_cm /= 2.0;
+	}
+	
+	if (!encoder_disconnected)
+	{
+		qei_edge_fraction += travel_cm * edges_per_cm;
+	}
+	
+	edges = (long)qei_edge_fraction;
+	qei_edge_fraction -= (double)edges;
+	
+	// SWAP (Bit 1) reverses the counting direction
+	if (qei->CTL & 0x02)
+	{
+		edges = -edges;
+	}
+	
+	if (edges != 0)
+	{
+		// DIRECTION (Bit 1) of STAT is set while the position decreases
+		qei->POS += (uint32_t)edges;
+		qei->STAT = (edges < 0) ? (qei->STAT | 0x02) : (qei->STAT & ~0x02UL);
+		qei_window_edges += (uint32_t)((edges < 0) ? -edges : edges);
+		qei_total_edges += (uint64_t)((edges < 0) ? -edges : edges);
+	}
+	
+	// VELEN (Bit 5): SPEED receives the edges of each window, and INTTIMER (Bit 1) is raised
+	while ((qei->CTL & 0x20) && (now >= qei_window_start + window))
+	{
+		qei->SPEED = qei_window_edges;
+		qei->RIS |= 0x02;
+		qei_window_edges = 0;
+		qei_window_start += window;
+	}
+	
+	Sim_QEI_Update_Line();
+}
+
+static void Sim_QEI_Pre_Access(uint32_t offset)
+{
+	QEI0_Type *qei = SIM_REGISTERS(QEI0_Type, QEI0_BASE);
+	
+	if (offset == offsetof(QEI0_Type, ISC))
+	{
+		// ISC reads the masked interrupt status
+		qei->ISC = qei->RIS & qei->INTEN;
+	}
+}
+
+static void Sim_QEI_Post_Access(uint32_t offset, int is_write)
+{
+	QEI0_Type *qei = SIM_REGISTERS(QEI0_Type, QEI0_BASE);
+	
+	if (is_write && (offset == offsetof(QEI0_Type, CTL)))
+	{
+		// ENABLE (Bit 0) starts the position counter and the velocity timer
+		int enabled = (qei->CTL & 0x01) != 0;
+		
+		if (enabled && !qei_running)
+		{
+			qei_window_start = Sim_Now();
+			qei_window_edges = 0;
+			qei_edge_fraction = 0.0;
+		}
+		
+		qei_running = enabled;
+	}
+	else if (is_write && (offset == offsetof(QEI0_Type, ISC)))
+	{
+		// Write 1 to clear
+		qei->RIS &= ~qei->ISC;
+		qei->ISC = 0;
+	}
+	
+	Sim_QEI_Update_Line();
+}
+
+static void Sim_Vehicle_Update(uint64_t now)
+{
+	double dt = (double)(now - last_update) / (double)Sim_Clock_Hz();
+	double motor_duty = Sim_PWM_Duty(0);
+	double target_cm_s;
+	double response;
+	
+	Sim_PWM_Update(now);
+	
+	// Direction pin PB7: high drives the vehicle forward, towards the obstacle
+	if ((Sim_GPIO_Output(1) & 0x80) == 0)
+	{
+		motor_duty = -motor_duty;
+	}
+	
+	// Sudden changes of the signed duty cycle cause the current spikes of a real H-bridge
+	if (fabs(motor_duty - last_motor_duty) > max_motor_duty_step)
+	{
+		max_motor_duty_step = fabs(motor_duty - last_motor_duty);
+	}
+	
+	last_motor_duty = motor_duty;
+	target_cm_s = motor_duty * max_speed_cm_s;
+	
+	// First-order response of the motor and vehicle
+	response = (motor_tau_s > 0.0) ? (dt / (motor_tau_s + dt)) : 1.0;
+	speed_cm_s += (target_cm_s - speed_cm_s) * response;
+	
+	distance_cm -= speed_cm_s * dt;
+	Sim_QEI_Update(now, speed_cm_s * dt);
+	travelled_cm += (speed_cm_s >= 0.0) ? (speed_cm_s * dt) : (-speed_cm_s * dt);
+	
+	if (distance_cm <= 0.0)
+	{
+		distance_cm = 0.0;
+		speed_cm_s = 0.0;
+		
+		if (!touching)
+		{
+			collisions++;
+			touching = 1;
+			Sim_Log("sim: collision with the obstacle at %.3f s\n", (double)now / (double)Sim_Clock_Hz());
+		}
+	}
+	else
+	{
+		touching = 0;
+	}
+	
+	if (distance_cm < min_distance_cm)
+	{
+		min_distance_cm = distance_cm;
+	}
+	
+	last_update = now;
+	
+	Sim_Sonar_Update(now);
+}
+
+void Sim_Vehicle_Report(void)
+{
+	int i;
+	
+	Sim_Log("sim: vehicle travelled %.1f cm, obstacle at %.1f cm (closest %.1f cm), %u collisions\n",
+	        travelled_cm, distance_cm, min_distance_cm, (unsigned int)collisions);
+	
+	for (i = 0; i < SIM_SONAR_COUNT; i++)
+	{
+		Sim_Log("sim: sonar %s answered %u of %u pings, %u crosstalk, %u short triggers\n", sonars[i].name,
+		        (unsigned int)sonars[i].state.echoes, (unsigned int)sonars[i].state.pings,
+		        (unsigned int)sonars[i].state.crosstalk, (unsigned int)sonars[i].state.short_triggers);
+	}
+	
+	Sim_Log("sim: largest motor duty cycle step %.1f%%\n", max_motor_duty_step * 100.0);
+	Sim_Log("sim: steering servo pulse %.3f ms\n", Sim_PWM_Duty(1) * (double)((Sim_PWM_Generator_Registers(1)[GEN_LOAD] & 0xFFFF) + 1)
+	        * (double)Sim_PWM_Divider() * 1000.0 / (double)Sim_Clock_Hz());
+	Sim_Log("sim: encoder counted %llu edges, final speed %.1f cm/s\n", (unsigned long long)qei_total_edges, speed_cm_s);
+}
+
+void Sim_Vehicle_Init(void)
+{
+	distance_cm = (double)Sim_Env_Int("SIM_OBSTACLE_CM", 200);
+	min_distance_cm = distance_cm;
+	obstacle_start_cm = distance_cm;
+	rear_cm = (double)Sim_Env_Int("SIM_REAR_CM", 100);
+	left_cm = (double)Sim_Env_Int("SIM_LEFT_CM", 60);
+	right_cm = (double)Sim_Env_Int("SIM_RIGHT_CM", 90);
+	max_speed_cm_s = (double)Sim_Env_Int("SIM_MAX_SPEED_CM_S", 150);
+	motor_tau_s = (double)Sim_Env_Int("SIM_MOTOR_TAU_MS", 150) / 1000.0;
+	sonar_noise_cm = Sim_Env_Int("SIM_SONAR_NOISE_CM", 0);
+	sonar_dropout = Sim_Env_Int("SIM_SONAR_DROPOUT", 0);
+	sonar_spurious = Sim_Env_Int("SIM_SONAR_SPURIOUS", 0);
+	encoder_disconnected = Sim_Env_Int("SIM_ENCODER_DISCONNECTED", 0);
+	random_state = (uint32_t)Sim_Env_Int("SIM_SEED", 1);
+	
+	Sim_MMIO_Register(PWM0_BASE, Sim_PWM_Pre_Access, Sim_PWM_Post_Access);
+	Sim_MMIO_Register(QEI0_BASE, Sim_QEI_Pre_Access, Sim_QEI_Post_Access);
+	Sim_GPIO_Set_Output_Hook(Sim_Sonar_Trigger);
+	Sim_Add_Update_Hook(Sim_Vehicle_Update);
+}
@@ -0,0 +1,837 @@
+/**
+ * @file TM4C123GH6PM.h
+ *
+ * @brief Host simulation stand-in for the TM4C123GH6PM device header.
+ *
+ * This header mirrors the register structures, base addresses, interrupt numbers
+ * and CMSIS core helpers of the Keil TM4C123GH6PM.h device header closely enough
+ * that the unmodified firmware sources in rc_vehicle/ compile natively on Linux.
+ *
+ * The peripherals are mapped at their real TM4C123 addresses by the simulator
+ * (see Sim_MMIO.c). Pages that belong to modelled peripherals are access-protected,
+ * so every register read or write traps into the peripheral models exactly like a
+ * bus access would on the target.
+ *
+ * @note Only the registers used by the firmware are guaranteed to be modelled.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#ifndef TM4C123GH6PM_H
+#define TM4C123GH6PM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __I  volatile const
+#define __O  volatile
+#define __IO volatile
+
+/**
+ * @brief Interrupt numbers, matching the vector table in startup_TM4C123.s
+ */
+typedef enum
+{
+	Reset_IRQn            = -15,
+	NonMaskableInt_IRQn   = -14,
+	HardFault_IRQn        = -13,
+	MemoryManagement_IRQn = -12,
+	BusFault_IRQn         = -11,
+	UsageFault_IRQn       = -10,
+	SVCall_IRQn           = -5,
+	DebugMonitor_IRQn     = -4,
+	PendSV_IRQn           = -2,
+	SysTick_IRQn          = -1,
+	GPIOA_IRQn            = 0,
+	GPIOB_IRQn            = 1,
+	GPIOC_IRQn            = 2,
+	GPIOD_IRQn            = 3,
+	GPIOE_IRQn            = 4,
+	UART0_IRQn            = 5,
+	UART1_IRQn            = 6,
+	PWM0_FAULT_IRQn       = 9,
+	PWM0_0_IRQn           = 10,
+	PWM0_1_IRQn           = 11,
+	PWM0_2_IRQn           = 12,
+	QEI0_IRQn             = 13,
+	WATCHDOG0_IRQn        = 18,
+	TIMER0A_IRQn          = 19,
+	TIMER0B_IRQn          = 20,
+	TIMER1A_IRQn          = 21,
+	TIMER1B_IRQn          = 22,
+	TIMER2A_IRQn          = 23,
+	TIMER2B_IRQn          = 24,
+	SYSCTL_IRQn           = 28,
+	FLASH_CTRL_IRQn       = 29,
+	GPIOF_IRQn            = 30,
+	TIMER3A_IRQn          = 35,
+	TIMER3B_IRQn          = 36,
+	QEI1_IRQn             = 38,
+	PWM0_3_IRQn           = 45,
+	UDMA_IRQn             = 46,
+	UDMAERR_IRQn          = 47,
+	TIMER4A_IRQn          = 70,
+	TIMER4B_IRQn          = 71,
+	TIMER5A_IRQn          = 92,
+	TIMER5B_IRQn          = 93,
+	WTIMER0A_IRQn         = 94,
+	WTIMER0B_IRQn         = 95,
+	WTIMER1A_IRQn         = 96,
+	WTIMER1B_IRQn         = 97,
+	WTIMER2A_IRQn         = 98,
+	WTIMER2B_IRQn         = 99,
+	WTIMER3A_IRQn         = 100,
+	WTIMER3B_IRQn         = 101,
+	WTIMER4A_IRQn         = 102,
+	WTIMER4B_IRQn         = 103,
+	WTIMER5A_IRQn         = 104,
+	WTIMER5B_IRQn         = 105,
+	SIM_IRQ_COUNT         = 139
+} IRQn_Type;
+
+/* ---------------------------------------------------------------------------
+ * Cortex-M4 core peripherals (subset of core_cm4.h)
+ * ------------------------------------------------------------------------ */
+
+/**
+ * @brief System Tick timer register map
+ */
+typedef struct
+{
+	__IO uint32_t CTRL;
+	__IO uint32_t LOAD;
+	__IO uint32_t VAL;
+	__I  uint32_t CALIB;
+} SysTick_Type;
+
+/**
+ * @brief Nested Vectored Interrupt Controller register map
+ */
+typedef struct
+{
+	__IO uint32_t ISER[8];
+	__I  uint32_t RESERVED0[24];
+	__IO uint32_t ICER[8];
+	__I  uint32_t RESERVED1[24];
+	__IO uint32_t ISPR[8];
+	__I  uint32_t RESERVED2[24];
+	__IO uint32_t ICPR[8];
+	__I  uint32_t RESERVED3[24];
+	__IO uint32_t IABR[8];
+	__I  uint32_t RESERVED4[56];
+	__IO uint8_t  IP[240];
+	__I  uint32_t RESERVED5[644];
+	__O  uint32_t STIR;
+} NVIC_Type;
+
+/**
+ * @brief System Control Block register map
+ */
+typedef struct
+{
+	__I  uint32_t CPUID;
+	__IO uint32_t ICSR;
+	__IO uint32_t VTOR;
+	__IO uint32_t AIRCR;
+	__IO uint32_t SCR;
+	__IO uint32_t CCR;
+	__IO uint8_t  SHP[12];
+	__IO uint32_t SHCSR;
+	__IO uint32_t CFSR;
+	__IO uint32_t HFSR;
+	__IO uint32_t DFSR;
+	__IO uint32_t MMFAR;
+	__IO uint32_t BFAR;
+	__IO uint32_t AFSR;
+	__I  uint32_t PFR[2];
+	__I  uint32_t DFR;
+	__I  uint32_t ADR;
+	__I  uint32_t MMFR[4];
+	__I  uint32_t ISAR[5];
+	__I  uint32_t RESERVED0[5];
+	__IO uint32_t CPACR;
+} SCB_Type;
+
+/**
+ * @brief Core Debug register map
+ */
+typedef struct
+{
+	__IO uint32_t DHCSR;
+	__O  uint32_t DCRSR;
+	__IO uint32_t DCRDR;
+	__IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+/**
+ * @brief Data Watchpoint and Trace register map
+ */
+typedef struct
+{
+	__IO uint32_t CTRL;
+	__IO uint32_t CYCCNT;
+	__IO uint32_t CPICNT;
+	__IO uint32_t EXCCNT;
+	__IO uint32_t SLEEPCNT;
+	__IO uint32_t LSUCNT;
+	__IO uint32_t FOLDCNT;
+	__I  uint32_t PCSR;
+} DWT_Type;
+
+/**
+ * @brief Instrumentation Trace Macrocell register map
+ */
+typedef struct
+{
+	__O  union
+	{
+		__O  uint8_t  u8;
+		__O  uint16_t u16;
+		__O  uint32_t u32;
+	} PORT[32];
+	__I  uint32_t RESERVED0[864];
+	__IO uint32_t TER;
+	__I  uint32_t RESERVED1[15];
+	__IO uint32_t TPR;
+	__I  uint32_t RESERVED2[15];
+	__IO uint32_t TCR;
+	__I  uint32_t RESERVED3[75];
+	__O  uint32_t LAR;
+} ITM_Type;
+
+#define SCB_SCR_SLEEPDEEP_Msk          (1UL << 2)
+#define SCB_SCR_SLEEPONEXIT_Msk        (1UL << 1)
+#define SCB_AIRCR_VECTKEY_Pos          16U
+#define SCB_AIRCR_SYSRESETREQ_Msk      (1UL << 2)
+#define CoreDebug_DEMCR_TRCENA_Msk     (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk         (1UL << 0)
+#define ITM_TCR_ITMENA_Msk             (1UL << 0)
+
+#define ITM_BASE            (0xE0000000UL)
+#define DWT_BASE            (0xE0001000UL)
+#define SysTick_BASE        (0xE000E010UL)
+#define NVIC_BASE           (0xE000E100UL)
+#define SCB_BASE            (0xE000ED00UL)
+#define CoreDebug_BASE      (0xE000EDF0UL)
+
+#define ITM                 ((ITM_Type       *) ITM_BASE)
+#define DWT                 ((DWT_Type       *) DWT_BASE)
+#define SysTick             ((SysTick_Type   *) SysTick_BASE)
+#define NVIC                ((NVIC_Type      *) NVIC_BASE)
+#define SCB                 ((SCB_Type       *) SCB_BASE)
+#define CoreDebug           ((CoreDebug_Type *) CoreDebug_BASE)
+
+/* ---------------------------------------------------------------------------
+ * CMSIS core functions, implemented by the simulator (Sim_Core.c)
+ * ------------------------------------------------------------------------ */
+
+void     NVIC_EnableIRQ(IRQn_Type IRQn);
+void     NVIC_DisableIRQ(IRQn_Type IRQn);
+void     NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void     NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+void     NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+void     NVIC_SystemReset(void);
+
+void     __enable_irq(void);
+void     __disable_irq(void);
+uint32_t __get_PRIMASK(void);
+void     __set_PRIMASK(uint32_t primask);
+uint32_t __get_MSP(void);
+uint32_t __get_IPSR(void);
+void     __WFI(void);
+void     __WFE(void);
+void     __SEV(void);
+
+#define __NOP()             __asm__ volatile ("nop")
+#define __DSB()             __sync_synchronize()
+#define __ISB()             __sync_synchronize()
+#define __DMB()             __sync_synchronize()
+
+/**
+ * @brief System clock frequency in Hz, as maintained by SystemInit/SystemCoreClockUpdate.
+ */
+extern uint32_t SystemCoreClock;
+
+/* ---------------------------------------------------------------------------
+ * Memory regions, placed by the linker on the target (see Memory_Profile.c). The firmware
+ * and the interrupt handlers run on the host stack of the main thread: the stack region is
+ * the SIM_STACK_SIZE bytes below the frame of the simulator's startup code. Its usage is
+ * the one of the host code, not the one of the target. There is no heap and no free SRAM.
+ * ------------------------------------------------------------------------ */
+
+#define SIM_STACK_SIZE 0x10000UL
+
+uint32_t *Sim_Stack_Limit(void);
+
+/* ---------------------------------------------------------------------------
+ * Device peripherals
+ * ------------------------------------------------------------------------ */
+
+/**
+ * @brief Watchdog Timer register map
+ */
+typedef struct
+{
+	__IO uint32_t LOAD;
+	__IO uint32_t VALUE;
+	__IO uint32_t CTL;
+	__IO uint32_t ICR;
+	__IO uint32_t RIS;
+	__IO uint32_t MIS;
+	__I  uint32_t RESERVED[256];
+	__IO uint32_t TEST;
+	__I  uint32_t RESERVED1[505];
+	__IO uint32_t LOCK;
+} WATCHDOG0_Type;
+
+/**
+ * @brief General-Purpose Input/Output register map
+ */
+typedef struct
+{
+	__IO uint32_t DATA_Bits[255];
+	__IO uint32_t DATA;
+	__IO uint32_t DIR;
+	__IO uint32_t IS;
+	__IO uint32_t IBE;
+	__IO uint32_t IEV;
+	__IO uint32_t IM;
+	__IO uint32_t RIS;
+	__IO uint32_t MIS;
+	__IO uint32_t ICR;
+	__IO uint32_t AFSEL;
+	__I  uint32_t RESERVED[55];
+	__IO uint32_t DR2R;
+	__IO uint32_t DR4R;
+	__IO uint32_t DR8R;
+	__IO uint32_t ODR;
+	__IO uint32_t PUR;
+	__IO uint32_t PDR;
+	__IO uint32_t SLR;
+	__IO uint32_t DEN;
+	__IO uint32_t LOCK;
+	__IO uint32_t CR;
+	__IO uint32_t AMSEL;
+	__IO uint32_t PCTL;
+	__IO uint32_t ADCCTL;
+	__IO uint32_t DMACTL;
+} GPIOA_Type;
+
+/**
+ * @brief Universal Asynchronous Receiver/Transmitter register map
+ */
+typedef struct
+{
+	__IO uint32_t DR;
+	__IO uint32_t RSR;
+	__I  uint32_t RESERVED[4];
+	__IO uint32_t FR;
+	__I  uint32_t RESERVED1[1];
+	__IO uint32_t ILPR;
+	__IO uint32_t IBRD;
+	__IO uint32_t FBRD;
+	__IO uint32_t LCRH;
+	__IO uint32_t CTL;
+	__IO uint32_t IFLS;
+	__IO uint32_t IM;
+	__IO uint32_t RIS;
+	__IO uint32_t MIS;
+	__IO uint32_t ICR;
+	__IO uint32_t DMACTL;
+	__I  uint32_t RESERVED2[989];
+	__IO uint32_t PP;
+	__I  uint32_t RESERVED3[1];
+	__IO uint32_t CC;
+} UART0_Type;
+
+/**
+ * @brief Pulse Width Modulator register map
+ */
+typedef struct
+{
+	__IO uint32_t CTL;
+	__IO uint32_t SYNC;
+	__IO uint32_t ENABLE;
+	__IO uint32_t INVERT;
+	__IO uint32_t FAULT;
+	__IO uint32_t INTEN;
+	__IO uint32_t RIS;
+	__IO uint32_t ISC;
+	__IO uint32_t STATUS;
+	__IO uint32_t FAULTVAL;
+	__IO uint32_t ENUPD;
+	__I  uint32_t RESERVED[5];
+	__IO uint32_t _0_CTL;
+	__IO uint32_t _0_INTEN;
+	__IO uint32_t _0_RIS;
+	__IO uint32_t _0_ISC;
+	__IO uint32_t _0_LOAD;
+	__IO uint32_t _0_COUNT;
+	__IO uint32_t _0_CMPA;
+	__IO uint32_t _0_CMPB;
+	__IO uint32_t _0_GENA;
+	__IO uint32_t _0_GENB;
+	__IO uint32_t _0_DBCTL;
+	__IO uint32_t _0_DBRISE;
+	__IO uint32_t _0_DBFALL;
+	__IO uint32_t _0_FLTSRC0;
+	__IO uint32_t _0_FLTSRC1;
+	__IO uint32_t _0_MINFLTPER;
+	__IO uint32_t _1_CTL;
+	__IO uint32_t _1_INTEN;
+	__IO uint32_t _1_RIS;
+	__IO uint32_t _1_ISC;
+	__IO uint32_t _1_LOAD;
+	__IO uint32_t _1_COUNT;
+	__IO uint32_t _1_CMPA;
+	__IO uint32_t _1_CMPB;
+	__IO uint32_t _1_GENA;
+	__IO uint32_t _1_GENB;
+	__IO uint32_t _1_DBCTL;
+	__IO uint32_t _1_DBRISE;
+	__IO uint32_t _1_DBFALL;
+	__IO uint32_t _1_FLTSRC0;
+	__IO uint32_t _1_FLTSRC1;
+	__IO uint32_t _1_MINFLTPER;
+	__IO uint32_t _2_CTL;
+	__IO uint32_t _2_INTEN;
+	__IO uint32_t _2_RIS;
+	__IO uint32_t _2_ISC;
+	__IO uint32_t _2_LOAD;
+	__IO uint32_t _2_COUNT;
+	__IO uint32_t _2_CMPA;
+	__IO uint32_t _2_CMPB;
+	__IO uint32_t _2_GENA;
+	__IO uint32_t _2_GENB;
+	__IO uint32_t _2_DBCTL;
+	__IO uint32_t _2_DBRISE;
+	__IO uint32_t _2_DBFALL;
+	__IO uint32_t _2_FLTSRC0;
+	__IO uint32_t _2_FLTSRC1;
+	__IO uint32_t _2_MINFLTPER;
+	__IO uint32_t _3_CTL;
+	__IO uint32_t _3_INTEN;
+	__IO uint32_t _3_RIS;
+	__IO uint32_t _3_ISC;
+	__IO uint32_t _3_LOAD;
+	__IO uint32_t _3_COUNT;
+	__IO uint32_t _3_CMPA;
+	__IO uint32_t _3_CMPB;
+	__IO uint32_t _3_GENA;
+	__IO uint32_t _3_GENB;
+	__IO uint32_t _3_DBCTL;
+	__IO uint32_t _3_DBRISE;
+	__IO uint32_t _3_DBFALL;
+	__IO uint32_t _3_FLTSRC0;
+	__IO uint32_t _3_FLTSRC1;
+	__IO uint32_t _3_MINFLTPER;
+	__I  uint32_t RESERVED1[928];
+	__IO uint32_t PP;
+	__I  uint32_t RESERVED2[1];
+	__IO uint32_t CC;
+} PWM0_Type;
+
+/**
+ * @brief Quadrature Encoder Interface register map
+ */
+typedef struct
+{
+	__IO uint32_t CTL;
+	__IO uint32_t STAT;
+	__IO uint32_t POS;
+	__IO uint32_t MAXPOS;
+	__IO uint32_t LOAD;
+	__IO uint32_t TIME;
+	__IO uint32_t COUNT;
+	__IO uint32_t SPEED;
+	__IO uint32_t INTEN;
+	__IO uint32_t RIS;
+	__IO uint32_t ISC;
+} QEI0_Type;
+
+/**
+ * @brief General-Purpose Timer register map (16/32-bit and 32/64-bit wide blocks)
+ */
+typedef struct
+{
+	__IO uint32_t CFG;
+	__IO uint32_t TAMR;
+	__IO uint32_t TBMR;
+	__IO uint32_t CTL;
+	__IO uint32_t SYNC;
+	__I  uint32_t RESERVED[1];
+	__IO uint32_t IMR;
+	__IO uint32_t RIS;
+	__IO uint32_t MIS;
+	__IO uint32_t ICR;
+	__IO uint32_t TAILR;
+	__IO uint32_t TBILR;
+	__IO uint32_t TAMATCHR;
+	__IO uint32_t TBMATCHR;
+	__IO uint32_t TAPR;
+	__IO uint32_t TBPR;
+	__IO uint32_t TAPMR;
+	__IO uint32_t TBPMR;
+	__IO uint32_t TAR;
+	__IO uint32_t TBR;
+	__IO uint32_t TAV;
+	__IO uint32_t TBV;
+	__IO uint32_t RTCPD;
+	__IO uint32_t TAPS;
+	__IO uint32_t TBPS;
+	__IO uint32_t TAPV;
+	__IO uint32_t TBPV;
+	__I  uint32_t RESERVED1[981];
+	__IO uint32_t PP;
+} TIMER0_Type;
+
+/**
+ * @brief EEPROM controller register map
+ */
+typedef struct
+{
+	__IO uint32_t EESIZE;
+	__IO uint32_t EEBLOCK;
+	__IO uint32_t EEOFFSET;
+	__I  uint32_t RESERVED[1];
+	__IO uint32_t EERDWR;
+	__IO uint32_t EERDWRINC;
+	__IO uint32_t EEDONE;
+	__IO uint32_t EESUPP;
+	__IO uint32_t EEUNLOCK;
+	__I  uint32_t RESERVED1[3];
+	__IO uint32_t EEPROT;
+	__IO uint32_t EEPASS0;
+	__IO uint32_t EEPASS1;
+	__IO uint32_t EEPASS2;
+	__IO uint32_t EEINT;
+	__I  uint32_t RESERVED2[3];
+	__IO uint32_t EEHIDE;
+	__I  uint32_t RESERVED3[11];
+	__IO uint32_t EEDBGME;
+	__I  uint32_t RESERVED4[975];
+	__IO uint32_t PP;
+} EEPROM_Type;
+
+/**
+ * @brief Flash memory controller register map
+ */
+typedef struct
+{
+	__IO uint32_t FMA;
+	__IO uint32_t FMD;
+	__IO uint32_t FMC;
+	__IO uint32_t FCRIS;
+	__IO uint32_t FCIM;
+	__IO uint32_t FCMISC;
+	__I  uint32_t RESERVED[2];
+	__IO uint32_t FMC2;
+	__I  uint32_t RESERVED1[3];
+	__IO uint32_t FWBVAL;
+	__I  uint32_t RESERVED2[51];
+	__IO uint32_t FWBN[32];
+	__I  uint32_t RESERVED3[912];
+	__IO uint32_t FSIZE;
+	__IO uint32_t SSIZE;
+	__I  uint32_t RESERVED4[1];
+	__IO uint32_t ROMSWMAP;
+	__I  uint32_t RESERVED5[72];
+	__IO uint32_t RMCTL;
+	__I  uint32_t RESERVED6[55];
+	__IO uint32_t BOOTCFG;
+} FLASH_CTRL_Type;
+
+/**
+ * @brief System Control register map
+ */
+typedef struct
+{
+	__IO uint32_t DID0;
+	__IO uint32_t DID1;
+	__I  uint32_t RESERVED[10];
+	__IO uint32_t PBORCTL;
+	__I  uint32_t RESERVED1[7];
+	__IO uint32_t RIS;
+	__IO uint32_t IMC;
+	__IO uint32_t MISC;
+	__IO uint32_t RESC;
+	__IO uint32_t RCC;
+	__I  uint32_t RESERVED2[2];
+	__IO uint32_t GPIOHBCTL;
+	__IO uint32_t RCC2;
+	__I  uint32_t RESERVED3[2];
+	__IO uint32_t MOSCCTL;
+	__I  uint32_t RESERVED4[32];
+	__IO uint32_t RCGC0;
+	__IO uint32_t RCGC1;
+	__IO uint32_t RCGC2;
+	__I  uint32_t RESERVED5[1];
+	__IO uint32_t SCGC0;
+	__IO uint32_t SCGC1;
+	__IO uint32_t SCGC2;
+	__I  uint32_t RESERVED6[1];
+	__IO uint32_t DCGC0;
+	__IO uint32_t DCGC1;
+	__IO uint32_t DCGC2;
+	__I  uint32_t RESERVED7[6];
+	__IO uint32_t DSLPCLKCFG;
+	__I  uint32_t RESERVED8[1];
+	__IO uint32_t SYSPROP;
+	__IO uint32_t PIOSCCAL;
+	__IO uint32_t PIOSCSTAT;
+	__I  uint32_t RESERVED9[2];
+	__IO uint32_t PLLFREQ0;
+	__IO uint32_t PLLFREQ1;
+	__IO uint32_t PLLSTAT;
+	__I  uint32_t RESERVED10[7];
+	__IO uint32_t SLPPWRCFG;
+	__IO uint32_t DSLPPWRCFG;
+	__I  uint32_t RESERVED11[9];
+	__IO uint32_t LDOSPCTL;
+	__IO uint32_t LDOSPCAL;
+	__IO uint32_t LDODPCTL;
+	__IO uint32_t LDODPCAL;
+	__I  uint32_t RESERVED12[2];
+	__IO uint32_t SDPMST;
+	__I  uint32_t RESERVED13[76];
+	__IO uint32_t PPWD;
+	__IO uint32_t PPTIMER;
+	__IO uint32_t PPGPIO;
+	__IO uint32_t PPDMA;
+	__I  uint32_t RESERVED14[1];
+	__IO uint32_t PPHIB;
+	__IO uint32_t PPUART;
+	__IO uint32_t PPSSI;
+	__IO uint32_t PPI2C;
+	__I  uint32_t RESERVED15[1];
+	__IO uint32_t PPUSB;
+	__I  uint32_t RESERVED16[2];
+	__IO uint32_t PPCAN;
+	__IO uint32_t PPADC;
+	__IO uint32_t PPACMP;
+	__IO uint32_t PPPWM;
+	__IO uint32_t PPQEI;
+	__I  uint32_t RESERVED17[4];
+	__IO uint32_t PPEEPROM;
+	__IO uint32_t PPWTIMER;
+	__I  uint32_t RESERVED18[104];
+	__IO uint32_t SRWD;
+	__IO uint32_t SRTIMER;
+	__IO uint32_t SRGPIO;
+	__IO uint32_t SRDMA;
+	__I  uint32_t RESERVED19[1];
+	__IO uint32_t SRHIB;
+	__IO uint32_t SRUART;
+	__IO uint32_t SRSSI;
+	__IO uint32_t SRI2C;
+	__I  uint32_t RESERVED20[1];
+	__IO uint32_t SRUSB;
+	__I  uint32_t RESERVED21[2];
+	__IO uint32_t SRCAN;
+	__IO uint32_t SRADC;
+	__IO uint32_t SRACMP;
+	__IO uint32_t SRPWM;
+	__IO uint32_t SRQEI;
+	__I  uint32_t RESERVED22[4];
+	__IO uint32_t SREEPROM;
+	__IO uint32_t SRWTIMER;
+	__I  uint32_t RESERVED23[40];
+	__IO uint32_t RCGCWD;
+	__IO uint32_t RCGCTIMER;
+	__IO uint32_t RCGCGPIO;
+	__IO uint32_t RCGCDMA;
+	__I  uint32_t RESERVED24[1];
+	__IO uint32_t RCGCHIB;
+	__IO uint32_t RCGCUART;
+	__IO uint32_t RCGCSSI;
+	__IO uint32_t RCGCI2C;
+	__I  uint32_t RESERVED25[1];
+	__IO uint32_t RCGCUSB;
+	__I  uint32_t RESERVED26[2];
+	__IO uint32_t RCGCCAN;
+	__IO uint32_t RCGCADC;
+	__IO uint32_t RCGCACMP;
+	__IO uint32_t RCGCPWM;
+	__IO uint32_t RCGCQEI;
+	__I  uint32_t RESERVED27[4];
+	__IO uint32_t RCGCEEPROM;
+	__IO uint32_t RCGCWTIMER;
+	__I  uint32_t RESERVED28[40];
+	__IO uint32_t SCGCWD;
+	__IO uint32_t SCGCTIMER;
+	__IO uint32_t SCGCGPIO;
+	__IO uint32_t SCGCDMA;
+	__I  uint32_t RESERVED29[1];
+	__IO uint32_t SCGCHIB;
+	__IO uint32_t SCGCUART;
+	__IO uint32_t SCGCSSI;
+	__IO uint32_t SCGCI2C;
+	__I  uint32_t RESERVED30[1];
+	__IO uint32_t SCGCUSB;
+	__I  uint32_t RESERVED31[2];
+	__IO uint32_t SCGCCAN;
+	__IO uint32_t SCGCADC;
+	__IO uint32_t SCGCACMP;
+	__IO uint32_t SCGCPWM;
+	__IO uint32_t SCGCQEI;
+	__I  uint32_t RESERVED32[4];
+	__IO uint32_t SCGCEEPROM;
+	__IO uint32_t SCGCWTIMER;
+	__I  uint32_t RESERVED33[40];
+	__IO uint32_t DCGCWD;
+	__IO uint32_t DCGCTIMER;
+	__IO uint32_t DCGCGPIO;
+	__IO uint32_t DCGCDMA;
+	__I  uint32_t RESERVED34[1];
+	__IO uint32_t DCGCHIB;
+	__IO uint32_t DCGCUART;
+	__IO uint32_t DCGCSSI;
+	__IO uint32_t DCGCI2C;
+	__I  uint32_t RESERVED35[1];
+	__IO uint32_t DCGCUSB;
+	__I  uint32_t RESERVED36[2];
+	__IO uint32_t DCGCCAN;
+	__IO uint32_t DCGCADC;
+	__IO uint32_t DCGCACMP;
+	__IO uint32_t DCGCPWM;
+	__IO uint32_t DCGCQEI;
+	__I  uint32_t RESERVED37[4];
+	__IO uint32_t DCGCEEPROM;
+	__IO uint32_t DCGCWTIMER;
+	__I  uint32_t RESERVED38[104];
+	__IO uint32_t PRWD;
+	__IO uint32_t PRTIMER;
+	__IO uint32_t PRGPIO;
+	__IO uint32_t PRDMA;
+	__I  uint32_t RESERVED39[1];
+	__IO uint32_t PRHIB;
+	__IO uint32_t PRUART;
+	__IO uint32_t PRSSI;
+	__IO uint32_t PRI2C;
+	__I  uint32_t RESERVED40[1];
+	__IO uint32_t PRUSB;
+	__I  uint32_t RESERVED41[2];
+	__IO uint32_t PRCAN;
+	__IO uint32_t PRADC;
+	__IO uint32_t PRACMP;
+	__IO uint32_t PRPWM;
+	__IO uint32_t PRQEI;
+	__I  uint32_t RESERVED42[4];
+	__IO uint32_t PREEPROM;
+	__IO uint32_t PRWTIMER;
+} SYSCTL_Type;
+
+/**
+ * @brief Micro Direct Memory Access controller register map
+ */
+typedef struct
+{
+	__IO uint32_t STAT;
+	__IO uint32_t CFG;
+	__IO uint32_t CTLBASE;
+	__IO uint32_t ALTBASE;
+	__IO uint32_t WAITSTAT;
+	__IO uint32_t SWREQ;
+	__IO uint32_t USEBURSTSET;
+	__IO uint32_t USEBURSTCLR;
+	__IO uint32_t REQMASKSET;
+	__IO uint32_t REQMASKCLR;
+	__IO uint32_t ENASET;
+	__IO uint32_t ENACLR;
+	__IO uint32_t ALTSET;
+	__IO uint32_t ALTCLR;
+	__IO uint32_t PRIOSET;
+	__IO uint32_t PRIOCLR;
+	__I  uint32_t RESERVED[3];
+	__IO uint32_t ERRCLR;
+	__I  uint32_t RESERVED1[300];
+	__IO uint32_t CHASGN;
+	__IO uint32_t CHIS;
+	__I  uint32_t RESERVED2[2];
+	__IO uint32_t CHMAP0;
+	__IO uint32_t CHMAP1;
+	__IO uint32_t CHMAP2;
+	__IO uint32_t CHMAP3;
+} UDMA_Type;
+
+typedef GPIOA_Type      GPIOB_Type;
+typedef GPIOA_Type      GPIOC_Type;
+typedef GPIOA_Type      GPIOD_Type;
+typedef GPIOA_Type      GPIOE_Type;
+typedef GPIOA_Type      GPIOF_Type;
+typedef UART0_Type      UART1_Type;
+typedef PWM0_Type       PWM1_Type;
+typedef QEI0_Type       QEI1_Type;
+typedef TIMER0_Type     WTIMER0_Type;
+typedef WATCHDOG0_Type  WATCHDOG1_Type;
+
+#define WATCHDOG0_BASE      (0x40000000UL)
+#define WATCHDOG1_BASE      (0x40001000UL)
+#define GPIOA_BASE          (0x40004000UL)
+#define GPIOB_BASE          (0x40005000UL)
+#define GPIOC_BASE          (0x40006000UL)
+#define GPIOD_BASE          (0x40007000UL)
+#define UART0_BASE          (0x4000C000UL)
+#define UART1_BASE          (0x4000D000UL)
+#define GPIOE_BASE          (0x40024000UL)
+#define GPIOF_BASE          (0x40025000UL)
+#define PWM0_BASE           (0x40028000UL)
+#define PWM1_BASE           (0x40029000UL)
+#define QEI0_BASE           (0x4002C000UL)
+#define QEI1_BASE           (0x4002D000UL)
+#define TIMER0_BASE         (0x40030000UL)
+#define TIMER1_BASE         (0x40031000UL)
+#define TIMER2_BASE         (0x40032000UL)
+#define TIMER3_BASE         (0x40033000UL)
+#define TIMER4_BASE         (0x40034000UL)
+#define TIMER5_BASE         (0x40035000UL)
+#define WTIMER0_BASE        (0x40036000UL)
+#define WTIMER1_BASE        (0x40037000UL)
+#define WTIMER2_BASE        (0x4004C000UL)
+#define WTIMER3_BASE        (0x4004D000UL)
+#define WTIMER4_BASE        (0x4004E000UL)
+#define WTIMER5_BASE        (0x4004F000UL)
+#define EEPROM_BASE         (0x400AF000UL)
+#define FLASH_CTRL_BASE     (0x400FD000UL)
+#define SYSCTL_BASE         (0x400FE000UL)
+#define UDMA_BASE           (0x400FF000UL)
+
+#define WATCHDOG0           ((WATCHDOG0_Type  *) WATCHDOG0_BASE)
+#define WATCHDOG1           ((WATCHDOG1_Type  *) WATCHDOG1_BASE)
+#define GPIOA               ((GPIOA_Type      *) GPIOA_BASE)
+#define GPIOB               ((GPIOB_Type      *) GPIOB_BASE)
+#define GPIOC               ((GPIOC_Type      *) GPIOC_BASE)
+#define GPIOD               ((GPIOD_Type      *) GPIOD_BASE)
+#define GPIOE               ((GPIOE_Type      *) GPIOE_BASE)
+#define GPIOF               ((GPIOF_Type      *) GPIOF_BASE)
+#define UART0               ((UART0_Type      *) UART0_BASE)
+#define UART1               ((UART1_Type      *) UART1_BASE)
+#define PWM0                ((PWM0_Type       *) PWM0_BASE)
+#define PWM1                ((PWM1_Type       *) PWM1_BASE)
+#define QEI0                ((QEI0_Type       *) QEI0_BASE)
+#define QEI1                ((QEI1_Type       *) QEI1_BASE)
+#define TIMER0              ((TIMER0_Type     *) TIMER0_BASE)
+#define TIMER1              ((TIMER0_Type     *) TIMER1_BASE)
+#define TIMER2              ((TIMER0_Type     *) TIMER2_BASE)
+#define TIMER3              ((TIMER0_Type     *) TIMER3_BASE)
+#define TIMER4              ((TIMER0_Type     *) TIMER4_BASE)
+#define TIMER5              ((TIMER0_Type     *) TIMER5_BASE)
+#define WTIMER0             ((WTIMER0_Type    *) WTIMER0_BASE)
+#define WTIMER1             ((WTIMER0_Type    *) WTIMER1_BASE)
+#define WTIMER2             ((WTIMER0_Type    *) WTIMER2_BASE)
+#define WTIMER3             ((WTIMER0_Type    *) WTIMER3_BASE)
+#define WTIMER4             ((WTIMER0_Type    *) WTIMER4_BASE)
+#define WTIMER5             ((WTIMER0_Type    *) WTIMER5_BASE)
+#define EEPROM              ((EEPROM_Type     *) EEPROM_BASE)
+#define FLASH_CTRL          ((FLASH_CTRL_Type *) FLASH_CTRL_BASE)
+#define SYSCTL              ((SYSCTL_Type     *) SYSCTL_BASE)
+#define UDMA                ((UDMA_Type       *) UDMA_BASE)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,51 @@
+#!/bin/sh
+#
+# Generates the table of the static RAM of each firmware module (see rc_vehicle/Memory_Profile.h)
+# from the object files, and writes it to standard output as a C source file:
+#
+#   sh Memory_Modules.sh build/firmware/*.o > Memory_Modules.c
+#
+# SIZE selects the size command, for example SIZE=arm-none-eabi-size for the target objects
+# (default: size). The .data and .bss sections of each object are added up, including the
+# per-symbol sections of -fdata-sections. Read-only data after relocation (.data.rel.ro) is
+# not counted: on the target, it stays in flash.
+#
+# Arguments that are not files (a pattern that matched nothing, before the first build) and
+# the object of the table itself are skipped. Without any object, the file defines no table,
+# and Memory_Profile.c reports no module (the table is a weak reference, see Memory_Profile.h).
+
+SIZE=${SIZE:-size}
+
+count=0
+entries=""
+
+for object in "$@"
+do
+	[ -f "$object" ] || continue
+	[ "$(basename "$object")" = "Memory_Modules.o" ] && continue
+
+	entry=$($SIZE -A "$object" | awk -v name="$(basename "$object" .o)" '
+		$1 ~ /^\.data\.rel\.ro/ { next }
+		$1 ~ /^\.data/ { data += $2 }
+		$1 ~ /^\.bss/ || $1 == "COMMON" { bss += $2 }
+		END { printf "\t{ \"%s\", %d, %d },", name, data, bss }') || exit 1
+
+	entries="$entries$entry
+"
+	count=$((count + 1))
+done
+
+echo "/* Generated by tools/Memory_Modules.sh from the object files: do not edit */"
+echo
+echo "#include \"Memory_Profile.h\""
+
+if [ "$count" -gt 0 ]
+then
+	echo
+	echo "const Memory_Module memory_modules[] ="
+	echo "{"
+	printf "%s" "$entries"
+	echo "};"
+	echo
+	echo "const uint8_t memory_module_count = $count;"
+fi
@@ -0,0 +1,467 @@
+/**
+ * @file Trace_Decode.c
+ *
+ * @brief Host decoder of the rc_vehicle event trace (see Trace.h).
+ *
+ * The input is either a capture of the UART0 output that holds a trace dump ('Z' command),
+ * or with --itm, a capture of the SWO output of the ITM stimulus ports (firmware built with
+ * TRACE_ITM set to 1, or the SIM_ITM_FILE of the simulator). Other lines of a UART0 capture
+ * are ignored, so the whole session can be passed as it is.
+ *
+ * The decoder prints one line per record: the time since the first record and since the
+ * previous one, in microseconds, the context (thread or handler name), the event and its
+ * argument. With --chrome, it also writes a Chrome trace JSON file (chrome://tracing or
+ * https://ui.perfetto.dev) where each context is a thread, the tasks, the sleeps and the
+ * handlers are intervals, and the other events are instants.
+ *
+ * Usage:
+ *
+ *   Trace_Decode [--itm] [--clock hz] [--chrome output.json] input
+ *
+ * The clock defaults to the one in the dump header, or 80 MHz for an ITM capture. An input
+ * of - is read from standard input.
+ *
+ * @author Jonathan Penaloza, Ricardo Zaragoza
+ */
+
+#include "Trace.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DECODE_DEFAULT_CLOCK_HZ 80000000UL
+
+#define DECODE_MAX_TASKS 32
+#define DECODE_TASK_NAME_MAX 16
+
+#define DECODE_CONTEXT_COUNT 256
+
+typedef struct
+{
+	uint64_t cycles;
+	uint32_t argument;
+	uint16_t event;
+	uint16_t context;
+} Decode_Record;
+
+static const char *const event_names[] = TRACE_EVENT_NAMES;
+
+typedef char Decode_Event_Names_Check[(sizeof(event_names) / sizeof(event_names[0]) == TRACE_EVENT_COUNT) ? 1 : -1];
+
+static const char *const vector_names[DECODE_CONTEXT_COUNT] =
+{
+#define SIM_VECTOR(number, name) [number] = #name,
+#include "Sim_Vectors.h"
+#undef SIM_VECTOR
+};
+
+static Decode_Record *records;
+static size_t record_count;
+static size_t record_capacity;
+
+// The cycle count of the last record, to unwrap the 32-bit counter
+static uint32_t last_cycles;
+static uint64_t unwrapped_cycles;
+
+static char task_names[DECODE_MAX_TASKS][DECODE_TASK_NAME_MAX];
+
+static unsigned long clock_hz;
+
+static void Decode_Add_Record(uint32_t cycles, uint16_t event, uint16_t context, uint32_t argument)
+{
+	Decode_Record *record;
+	
+	if (record_count == record_capacity)
+	{
+		record_capacity = (record_capacity != 0) ? (record_capacity * 2) : 1024;
+		records = realloc(records, record_capacity * sizeof(Decode_Record));
+		
+		if (records == 0)
+		{
+			fprintf(stderr, "Trace_Decode: out of memory\n");
+			exit(1);
+		}
+	}
+	
+	// Consecutive records are assumed to be less than one counter wrap apart
+	if (record_count != 0)
+	{
+		unwrapped_cycles += (uint32_t)(cycles - last_cycles);
+	}
+	else
+	{
+		unwrapped_cycles = cycles;
+	}
+	
+	last_cycles = cycles;
+	
+	record = &records[record_count++];
+	record->cycles = unwrapped_cycles;
+	record->argument = argument;
+	record->event = event;
+	record->context = context;
+}
+
+// Reads the dump lines of a UART0 capture. A second dump in the capture follows the first one
+static void Decode_Read_Text(FILE *input)
+{
+	char line[256];
+	unsigned long hz;
+	unsigned int records_dumped;
+	unsigned int task;
+	char name[DECODE_TASK_NAME_MAX];
+	unsigned int cycles;
+	unsigned int event;
+	unsigned int context;
+	unsigned int argument;
+	
+	while (fgets(line, sizeof(line), input) != 0)
+	{
+		if (sscanf(line, "@ %x %x %x %x", &cycles, &event, &context, &argument) == 4)
+		{
+			Decode_Add_Record(cycles, (uint16_t)event, (uint16_t)context, argument);
+		}
+		else if (sscanf(line, "trace_task %u %15s", &task, name) == 2)
+		{
+			if (task < DECODE_MAX_TASKS)
+			{
+				strcpy(task_names[task], name);
+			}
+		}
+		else if (sscanf(line, "trace_dump %lu %u", &hz, &records_dumped) == 2)
+		{
+			if (clock_hz == 0)
+			{
+				clock_hz = hz;
+			}
+		}
+	}
+}
+
+// Reads the software source packets of an SWO capture: a record is the event and context word
+// (TRACE_ITM_PORT_EVENT), the cycle count and the argument, in that order
+static void Decode_Read_ITM(FILE *input)
+{
+	static const uint8_t payload_sizes[4] = { 0, 1, 2, 4 };
+	int header;
+	int byte;
+	uint8_t size;
+	uint8_t i;
+	uint8_t port;
+	uint32_t value;
+	uint32_t event_word = 0;
+	uint32_t cycles = 0;
+	int received = 0;
+	
+	while ((header = fgetc(input)) != EOF)
+	{
+		size = payload_sizes[header & 0x03];
+		
+		// Synchronization, overflow and timestamp packets carry no stimulus port data
+		if (size == 0)
+		{
+			continue;
+		}
+		
+		value = 0;
+		
+		for (i = 0; i < size; i++)
+		{
+			if ((byte = fgetc(input)) == EOF)
+			{
+				return;
+			}
+			
+			value |= (uint32_t)byte << (8 * i);
+		}
+		
+		// Hardware source packets (Bit 2 set) come from the DWT, not from the firmware
+		if ((header & 0x04) != 0)
+		{
+			continue;
+		}
+		
+		port = (uint8_t)(header >> 3);
+		
+		if (port == TRACE_ITM_PORT_EVENT)
+		{
+			event_word = value;
+			received = 1;
+		}
+		else if ((port == TRACE_ITM_PORT_CYCLES) && (received == 1))
+		{
+			cycles = value;
+			received = 2;
+		}
+		else if ((port == TRACE_ITM_PORT_ARGUMENT) && (received == 2))
+		{
+			Decode_Add_Record(cycles, (uint16_t)(event_word & 0xFFFF), (uint16_t)(event_word >> 16), value);
+			received = 0;
+		}
+		else
+		{
+			// A word was lost: wait for the next event word
+			received = 0;
+		}
+	}
+}
+
+static const char *Decode_Event_Name(uint16_t event)
+{
+	return (event < TRACE_EVENT_COUNT) ? event_names[event] : "unknown";
+}
+
+static void Decode_Context_Name(uint16_t context, char *name, size_t size)
+{
+	if (context == 0)
+	{
+		snprintf(name, size, "thread");
+	}
+	else if ((context < DECODE_CONTEXT_COUNT) && (vector_names[context] != 0))
+	{
+		snprintf(name, size, "%s", vector_names[context]);
+	}
+	else
+	{
+		snprintf(name, size, "exception_%u", (unsigned int)context);
+	}
+}
+
+static void Decode_Task_Name(uint32_t task, char *name, size_t size)
+{
+	if ((task < DECODE_MAX_TASKS) && (task_names[task][0] != '\0'))
+	{
+		snprintf(name, size, "%s", task_names[task]);
+	}
+	else
+	{
+		snprintf(name, size, "task_%" PRIu32, task);
+	}
+}
+
+static void Decode_Argument(const Decode_Record *record, char *text, size_t size)
+{
+	switch (record->event)
+	{
+		case TRACE_TASK_BEGIN:
+		case TRACE_TASK_END:
+			Decode_Task_Name(record->argument, text, size);
+			break;
+		
+		case TRACE_UART_IRQ_BEGIN:
+			snprintf(text, size, "mis=0x%03" PRIx32, record->argument);
+			break;
+		
+		case TRACE_SONAR_SAMPLE:
+			snprintf(text, size, "sensor=%" PRIu32 " pulse_us=%" PRIu32, record->argument >> 24,
+			         record->argument & 0x00FFFFFF);
+			break;
+		
+		case TRACE_PWM_IRQ_BEGIN:
+		case TRACE_PWM_IRQ_END:
+			snprintf(text, size, "%" PRId32, (int32_t)record->argument);
+			break;
+		
+		default:
+			snprintf(text, size, "%" PRIu32, record->argument);
+			break;
+	}
+}
+
+static double Decode_Microseconds(uint64_t cycles)
+{
+	return ((double)cycles * 1e6) / (double)clock_hz;
+}
+
+static void Decode_Print_Timeline(void)
+{
+	char context[32];
+	char argument[64];
+	size_t i;
+	
+	printf("%12s %10s  %-18s %-16s %s\n", "time_us", "delta_us", "context", "event", "argument");
+	
+	for (i = 0; i < record_count; i++)
+	{
+		Decode_Context_Name(records[i].context, context, sizeof(context));
+		Decode_Argument(&records[i], argument, sizeof(argument));
+		
+		printf("%12.3f %10.3f  %-18s %-16s %s\n",
+		       Decode_Microseconds(records[i].cycles - records[0].cycles),
+		       Decode_Microseconds((i != 0) ? (records[i].cycles - records[i - 1].cycles) : 0),
+		       context, Decode_Event_Name(records[i].event), argument);
+	}
+}
+
+// Name of the interval opened or closed by a record, or 0 if the record is an instant
+static int Decode_Interval_Name(const Decode_Record *record, char *name, size_t size)
+{
+	switch (record->event)
+	{
+		case TRACE_TASK_BEGIN:
+		case TRACE_TASK_END:
+			Decode_Task_Name(record->argument, name, size);
+			return 1;
+		
+		case TRACE_IDLE_BEGIN:
+		case TRACE_IDLE_END:
+			snprintf(name, size, "sleep");
+			return 1;
+		
+		case TRACE_UART_IRQ_BEGIN:
+		case TRACE_UART_IRQ_END:
+		case TRACE_PWM_IRQ_BEGIN:
+		case TRACE_PWM_IRQ_END:
+			Decode_Context_Name(record->context, name, size);
+			return 1;
+		
+		default:
+			return 0;
+	}
+}
+
+static int Decode_Is_Begin(uint16_t event)
+{
+	return (event == TRACE_TASK_BEGIN) || (event == TRACE_IDLE_BEGIN) ||
+		(event == TRACE_UART_IRQ_BEGIN) || (event == TRACE_PWM_IRQ_BEGIN);
+}
+
+static int Decode_Write_Chrome(const char *path)
+{
+	FILE *output = fopen(path, "w");
+	uint8_t context_seen[DECODE_CONTEXT_COUNT] = { 0 };
+	char name[32];
+	char argument[64];
+	const char *separator = "";
+	size_t i;
+	
+	if (output == 0)
+	{
+		fprintf(stderr, "Trace_Decode: cannot create %s\n", path);
+		return 0;
+	}
+	
+	fprintf(output, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	
+	for (i = 0; i < record_count; i++)
+	{
+		const Decode_Record *record = &records[i];
+		double ts = Decode_Microseconds(record->cycles - records[0].cycles);
+		
+		// One thread per context, sorted by exception number
+		if ((record->context < DECODE_CONTEXT_COUNT) && !context_seen[record->context])
+		{
+			context_seen[record->context] = 1;
+			Decode_Context_Name(record->context, name, sizeof(name));
+			
+			fprintf(output, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n"
+			        "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"sort_index\":%u}}",
+			        separator, (unsigned int)record->context, name,
+			        (unsigned int)record->context, (unsigned int)record->context);
+			separator = ",\n";
+		}
+		
+		Decode_Argument(record, argument, sizeof(argument));
+		
+		if (Decode_Interval_Name(record, name, sizeof(name)))
+		{
+			fprintf(output, "%s{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"%s\":\"%s\"}}",
+			        separator, name, Decode_Is_Begin(record->event) ? "B" : "E", (unsigned int)record->context, ts,
+			        Decode_Event_Name(record->event), argument);
+		}
+		else
+		{
+			fprintf(output, "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"argument\":\"%s\"}}",
+			        separator, Decode_Event_Name(record->event), (unsigned int)record->context, ts, argument);
+		}
+		
+		separator = ",\n";
+	}
+	
+	fprintf(output, "\n]}\n");
+	
+	return fclose(output) == 0;
+}
+
+static void Decode_Usage(void)
+{
+	fprintf(stderr, "usage: Trace_Decode [--itm] [--clock hz] [--chrome output.json] input\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const char *input_path = 0;
+	const char *chrome_path = 0;
+	int itm = 0;
+	FILE *input;
+	int i;
+	
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--itm") == 0)
+		{
+			itm = 1;
+		}
+		else if ((strcmp(argv[i], "--clock") == 0) && (i + 1 < argc))
+		{
+			clock_hz = strtoul(argv[++i], 0, 0);
+		}
+		else if ((strcmp(argv[i], "--chrome") == 0) && (i + 1 < argc))
+		{
+			chrome_path = argv[++i];
+		}
+		else if ((input_path == 0) && ((argv[i][0] != '-') || (argv[i][1] == '\0')))
+		{
+			input_path = argv[i];
+		}
+		else
+		{
+			Decode_Usage();
+		}
+	}
+	
+	if (input_path == 0)
+	{
+		Decode_Usage();
+	}
+	
+	input = (strcmp(input_path, "-") == 0) ? stdin : fopen(input_path, itm ? "rb" : "r");
+	
+	if (input == 0)
+	{
+		fprintf(stderr, "Trace_Decode: cannot open %s\n", input_path);
+		return 1;
+	}
+	
+	if (itm)
+	{
+		Decode_Read_ITM(input);
+	}
+	else
+	{
+		Decode_Read_Text(input);
+	}
+	
+	if (clock_hz == 0)
+	{
+		clock_hz = DECODE_DEFAULT_CLOCK_HZ;
+	}
+	
+	if (record_count == 0)
+	{
+		fprintf(stderr, "Trace_Decode: no trace records in %s\n", input_path);
+		return 1;
+	}
+	
+	Decode_Print_Timeline();
+	
+	if ((chrome_path != 0) && !Decode_Write_Chrome(chrome_path))
+	{
+		return 1;
+	}
+	
+	return 0;
+}